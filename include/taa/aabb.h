@@ -0,0 +1,372 @@
+/**
+ * @brief     inlined axis aligned bounding box functions header
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_AABB_H_
+#define taa_AABB_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+
+typedef struct taa_aabb_s taa_aabb;
+typedef struct taa_aabb_minmax_s taa_aabb_minmax;
+typedef struct taa_aabbx4_s taa_aabbx4;
+
+/**
+ * @brief axis aligned box in center and half size form
+ * @details This structure MUST BE aligned on 16 byte boundaries. center.w
+ *          must be 1 and extent.w must be 0, so that the center transforms
+ *          as a point and the extent as a vector.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_aabb_s
+{
+    taa_vec4 center;
+    taa_vec4 extent;
+} taa_ATTRIB_ALIGN(16);
+
+/**
+ * @brief axis aligned box in minimum and maximum corner form
+ * @details This structure MUST BE aligned on 16 byte boundaries. The w
+ *          components are ignored.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_aabb_minmax_s
+{
+    taa_vec4 min;
+    taa_vec4 max;
+} taa_ATTRIB_ALIGN(16);
+
+/**
+ * @brief four boxes in minimum and maximum corner structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_aabbx4_s
+{
+    taa_vec3x4 min;
+    taa_vec3x4 max;
+} taa_ATTRIB_ALIGN(16);
+
+//****************************************************************************
+// forward declarations
+
+taa_INLINE static void taa_aabb_from_minmax(
+    const taa_aabb_minmax* a,
+    taa_aabb* aabb_out);
+
+taa_INLINE static void taa_aabb_to_minmax(
+    const taa_aabb* a,
+    taa_aabb_minmax* mm_out);
+
+/**
+ * @brief computes the bounds of a box transformed by a matrix
+ * @details uses Arvo's method: the center is transformed by m and the
+ *          extent by the absolute value of m, which gives the bounds of the
+ *          eight transformed corners without transforming each of them.
+ *          a and aabb_out may be the same.
+ */
+taa_INLINE static void taa_aabb_transform(
+    const taa_mat44* m,
+    const taa_aabb* a,
+    taa_aabb* aabb_out);
+
+/**
+ * @brief transforms an array of boxes, each by its own matrix
+ * @details four boxes and their matrices are transposed into structure of
+ *          arrays registers, so each row of the four matrices goes through
+ *          a single taa_vpu_mat44_abs. Any remainder is transformed with
+ *          taa_aabb_transform. a and aabb_out may point to the same array.
+ */
+taa_INLINE static void taa_aabb_transform_array(
+    const taa_mat44* m,
+    const taa_aabb* a,
+    uint32_t n,
+    taa_aabb* aabb_out);
+
+/**
+ * @brief converts an array of boxes into structure of arrays format
+ * @details b_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element repeat the last box, so results for those lanes
+ *          must be masked off by the caller.
+ */
+taa_INLINE static void taa_aabbx4_from_minmax(
+    const taa_aabb_minmax* b,
+    uint32_t n,
+    taa_aabbx4* b_out);
+
+/**
+ * @brief tests four boxes for overlap with a single box
+ * @details boxes that only touch are considered overlapping.
+ * @return bit mask of the lanes that overlap a
+ */
+taa_INLINE static int taa_aabbx4_overlap_aabb(
+    const taa_aabbx4* b,
+    const taa_aabb_minmax* a);
+
+/**
+ * @brief tests four boxes for overlap with a sphere
+ * @details the sphere center is stored in xyz and its radius in w.
+ * @return bit mask of the lanes that overlap the sphere
+ */
+taa_INLINE static int taa_aabbx4_overlap_sphere(
+    const taa_aabbx4* b,
+    const taa_vec4* sphere);
+
+//****************************************************************************
+taa_INLINE static void taa_aabb_from_minmax(
+    const taa_aabb_minmax* a,
+    taa_aabb* aabb_out)
+{
+    taa_vpu_vec4 mn;
+    taa_vpu_vec4 mx;
+    taa_vpu_vec4 half;
+    taa_vpu_vec4 c;
+    taa_vpu_vec4 e;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) aabb_out) & 15) == 0);
+    taa_vpu_load(&a->min.x, mn);
+    taa_vpu_load(&a->max.x, mx);
+    taa_vpu_set1(0.5f, half);
+    taa_vpu_add(mx, mn, c);
+    taa_vpu_mul(c, half, c);
+    taa_vpu_sub(mx, mn, e);
+    taa_vpu_mul(e, half, e);
+    taa_vpu_store(c, &aabb_out->center.x);
+    taa_vpu_store(e, &aabb_out->extent.x);
+    aabb_out->center.w = 1.0f;
+    aabb_out->extent.w = 0.0f;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_aabb_to_minmax(
+    const taa_aabb* a,
+    taa_aabb_minmax* mm_out)
+{
+    taa_vpu_vec4 c;
+    taa_vpu_vec4 e;
+    taa_vpu_vec4 v;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) mm_out) & 15) == 0);
+    taa_vpu_load(&a->center.x, c);
+    taa_vpu_load(&a->extent.x, e);
+    taa_vpu_sub(c, e, v);
+    taa_vpu_store(v, &mm_out->min.x);
+    taa_vpu_add(c, e, v);
+    taa_vpu_store(v, &mm_out->max.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_aabb_transform(
+    const taa_mat44* m,
+    const taa_aabb* a,
+    taa_aabb* aabb_out)
+{
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 c3;
+    taa_vpu_vec4 a0;
+    taa_vpu_vec4 a1;
+    taa_vpu_vec4 a2;
+    taa_vpu_vec4 a3;
+    taa_vpu_vec4 c;
+    taa_vpu_vec4 e;
+    taa_vpu_vec4 tc;
+    taa_vpu_vec4 te;
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) aabb_out) & 15) == 0);
+    assert(a->center.w == 1.0f && a->extent.w == 0.0f);
+    taa_vpu_load(&m->x.x, c0);
+    taa_vpu_load(&m->y.x, c1);
+    taa_vpu_load(&m->z.x, c2);
+    taa_vpu_load(&m->w.x, c3);
+    taa_vpu_load(&a->center.x, c);
+    taa_vpu_load(&a->extent.x, e);
+    taa_vpu_mat44_abs(c0, c1, c2, c3, a0, a1, a2, a3);
+    taa_vpu_mat44_mul_vec4(c0, c1, c2, c3, c, tc);
+    taa_vpu_mat44_mul_vec4(a0, a1, a2, a3, e, te);
+    taa_vpu_store(tc, &aabb_out->center.x);
+    taa_vpu_store(te, &aabb_out->extent.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_aabb_transform_array(
+    const taa_mat44* m,
+    const taa_aabb* a,
+    uint32_t n,
+    taa_aabb* aabb_out)
+{
+    const taa_aabb* aend = a + (n & ~3);
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) aabb_out) & 15) == 0);
+    while(a != aend)
+    {
+        // col[k][c] holds column c of matrix k, and r[c][j] holds row j of
+        // column c for each of the four matrices
+        taa_vpu_vec4 col[4][4];
+        taa_vpu_vec4 r[4][4];
+        taa_vpu_vec4 c[4];
+        taa_vpu_vec4 e[4];
+        taa_vpu_vec4 tc[4];
+        taa_vpu_vec4 te[4];
+        int j;
+        int k;
+        for(k = 0; k < 4; ++k)
+        {
+            assert(a[k].center.w == 1.0f && a[k].extent.w == 0.0f);
+            taa_vpu_load(&m[k].x.x, col[k][0]);
+            taa_vpu_load(&m[k].y.x, col[k][1]);
+            taa_vpu_load(&m[k].z.x, col[k][2]);
+            taa_vpu_load(&m[k].w.x, col[k][3]);
+            taa_vpu_load(&a[k].center.x, tc[k]);
+            taa_vpu_load(&a[k].extent.x, te[k]);
+        }
+        for(j = 0; j < 4; ++j)
+        {
+            taa_vpu_mat44_transpose(
+                col[0][j], col[1][j], col[2][j], col[3][j],
+                r[j][0], r[j][1], r[j][2], r[j][3]);
+        }
+        taa_vpu_mat44_transpose(tc[0],tc[1],tc[2],tc[3], c[0],c[1],c[2],c[3]);
+        taa_vpu_mat44_transpose(te[0],te[1],te[2],te[3], e[0],e[1],e[2],e[3]);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_vpu_vec4 a0;
+            taa_vpu_vec4 a1;
+            taa_vpu_vec4 a2;
+            taa_vpu_vec4 a3;
+            taa_vpu_vec4 tmp;
+            // row j of the center is transformed by m, and of the extent by
+            // the absolute value of m
+            taa_vpu_mat44_abs(r[0][j], r[1][j], r[2][j], r[3][j], a0,a1,a2,a3);
+            taa_vpu_mul(r[0][j], c[0], tc[j]);
+            taa_vpu_mul(r[1][j], c[1], tmp);
+            taa_vpu_add(tc[j], tmp, tc[j]);
+            taa_vpu_mul(r[2][j], c[2], tmp);
+            taa_vpu_add(tc[j], tmp, tc[j]);
+            taa_vpu_mul(r[3][j], c[3], tmp);
+            taa_vpu_add(tc[j], tmp, tc[j]);
+            taa_vpu_mul(a0, e[0], te[j]);
+            taa_vpu_mul(a1, e[1], tmp);
+            taa_vpu_add(te[j], tmp, te[j]);
+            taa_vpu_mul(a2, e[2], tmp);
+            taa_vpu_add(te[j], tmp, te[j]);
+            taa_vpu_mul(a3, e[3], tmp);
+            taa_vpu_add(te[j], tmp, te[j]);
+        }
+        taa_vpu_mat44_transpose(tc[0],tc[1],tc[2],tc[3], c[0],c[1],c[2],c[3]);
+        taa_vpu_mat44_transpose(te[0],te[1],te[2],te[3], e[0],e[1],e[2],e[3]);
+        for(k = 0; k < 4; ++k)
+        {
+            taa_vpu_store(c[k], &aabb_out[k].center.x);
+            taa_vpu_store(e[k], &aabb_out[k].extent.x);
+        }
+        m += 4;
+        a += 4;
+        aabb_out += 4;
+    }
+    for(n &= 3; n > 0; --n)
+    {
+        taa_aabb_transform(m, a, aabb_out);
+        ++m;
+        ++a;
+        ++aabb_out;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_aabbx4_from_minmax(
+    const taa_aabb_minmax* b,
+    uint32_t n,
+    taa_aabbx4* b_out)
+{
+    uint32_t i;
+    assert(n > 0);
+    for(i = 0; i < ((n + 3) & ~3); ++i)
+    {
+        const taa_aabb_minmax* bi = b + ((i < n) ? i : n - 1);
+        taa_aabbx4* bo = b_out + (i >> 2);
+        uint32_t lane = i & 3;
+        bo->min.x[lane] = bi->min.x;
+        bo->min.y[lane] = bi->min.y;
+        bo->min.z[lane] = bi->min.z;
+        bo->max.x[lane] = bi->max.x;
+        bo->max.y[lane] = bi->max.y;
+        bo->max.z[lane] = bi->max.z;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static int taa_aabbx4_overlap_aabb(
+    const taa_aabbx4* b,
+    const taa_aabb_minmax* a)
+{
+    const float* amin = &a->min.x;
+    const float* amax = &a->max.x;
+    taa_vpu_vec4 miss;
+    int bits;
+    int i;
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) a) & 15) == 0);
+    taa_vpu_set1(0.0f, miss);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 bmin;
+        taa_vpu_vec4 bmax;
+        taa_vpu_vec4 lo;
+        taa_vpu_vec4 hi;
+        taa_vpu_load(b->min.x + i*4, bmin);
+        taa_vpu_load(b->max.x + i*4, bmax);
+        taa_vpu_set1(amin[i], lo);
+        taa_vpu_set1(amax[i], hi);
+        taa_vpu_cmpgt(bmin, hi, hi);
+        taa_vpu_cmpgt(lo, bmax, lo);
+        taa_vpu_or(miss, hi, miss);
+        taa_vpu_or(miss, lo, miss);
+    }
+    taa_vpu_movemask(miss, bits);
+    return ~bits & 15;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_aabbx4_overlap_sphere(
+    const taa_aabbx4* b,
+    const taa_vec4* sphere)
+{
+    const float* c = &sphere->x;
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 d2;
+    taa_vpu_vec4 r2;
+    int bits;
+    int i;
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) sphere) & 15) == 0);
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(0.0f, d2);
+    taa_vpu_set1(sphere->w * sphere->w, r2);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 vc;
+        taa_vpu_vec4 lo;
+        taa_vpu_vec4 hi;
+        // distance from the center to the box along this axis
+        taa_vpu_set1(c[i], vc);
+        taa_vpu_load(b->min.x + i*4, lo);
+        taa_vpu_load(b->max.x + i*4, hi);
+        taa_vpu_sub(lo, vc, lo);
+        taa_vpu_sub(vc, hi, hi);
+        taa_vpu_max(lo, zero, lo);
+        taa_vpu_max(hi, zero, hi);
+        taa_vpu_add(lo, hi, lo);
+        taa_vpu_mul(lo, lo, lo);
+        taa_vpu_add(d2, lo, d2);
+    }
+    taa_vpu_cmpgt(d2, r2, d2);
+    taa_vpu_movemask(d2, bits);
+    return ~bits & 15;
+}
+
+#endif // taa_AABB_H_
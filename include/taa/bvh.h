@@ -0,0 +1,866 @@
+/**
+ * @brief     bounding volume hierarchy header
+ * @details   four wide hierarchy over an array of primitive bounds. Each
+ *            node stores the bounds of its four children in structure of
+ *            arrays format, so one node is tested against a query with a
+ *            single set of vector operations. Nodes are split with a binned
+ *            surface area heuristic. For large inputs, the top of the tree
+ *            may be built first and the remaining subtrees built as
+ *            independent tasks on several threads.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_BVH_H_
+#define taa_BVH_H_
+
+#include "ray.h"
+#include "stream.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** child index of unused node lanes */
+#define taa_BVH_EMPTY ((uint32_t) 0xffffffff)
+/** maximum primitives per leaf, bounded by the width of a node */
+#define taa_BVH_MAX_LEAF 4
+/** maximum depth. past half of it, nodes are split by count, not cost */
+#define taa_BVH_MAX_DEPTH 64
+#define taa_BVH_NUM_BINS 16
+#define taa_BVH_STACK_SIZE (taa_BVH_MAX_DEPTH*3 + 4)
+
+typedef struct taa_bvh_node_s taa_bvh_node;
+typedef struct taa_bvh_task_s taa_bvh_task;
+typedef struct taa_bvh_s taa_bvh;
+
+/**
+ * @details This structure MUST BE aligned on 16 byte boundaries.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_bvh_node_s
+{
+    taa_aabbx4 bounds;
+    /** child node index, first leaf primitive, or taa_BVH_EMPTY */
+    uint32_t child[4];
+    /** number of primitives for leaf lanes, zero for node lanes */
+    uint32_t count[4];
+} taa_ATTRIB_ALIGN(16);
+
+/**
+ * @brief subtree deferred by taa_bvh_build_top
+ */
+struct taa_bvh_task_s
+{
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t depth;
+};
+
+struct taa_bvh_s
+{
+    /** nodes, 64 byte aligned. the root is node 0 */
+    taa_bvh_node* nodes;
+    /** primitive bounds in their original order */
+    taa_aabb_minmax* bounds;
+    /** primitive centroids, only used while building */
+    taa_vec4* centroids;
+    /** primitive indices in leaf order */
+    uint32_t* indices;
+    /** unaligned allocation containing all the arrays */
+    void* buffer;
+    uint32_t size;
+    uint32_t numnodes;
+    uint32_t maxleaf;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief builds the hierarchy from an array of bvh->size primitive bounds
+ */
+taa_INLINE static void taa_bvh_build(
+    taa_bvh* bvh,
+    const taa_aabb_minmax* bounds);
+
+/**
+ * @brief builds a node and the subtree below it
+ * @details subtrees of at most grain primitives are appended to tasks
+ *          instead of being built. next is the next unused node index.
+ */
+taa_INLINE static void taa_bvh_build_node(
+    taa_bvh* bvh,
+    uint32_t node,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t depth,
+    uint32_t* next,
+    uint32_t grain,
+    taa_bvh_task* tasks,
+    uint32_t* numtasks);
+
+/**
+ * @brief builds one subtree deferred by taa_bvh_build_top
+ * @details tasks write to disjoint nodes and index ranges, so different
+ *          tasks may be built concurrently.
+ */
+taa_INLINE static void taa_bvh_build_task(
+    taa_bvh* bvh,
+    const taa_bvh_task* task);
+
+/**
+ * @brief builds the top of the hierarchy
+ * @details subtrees containing at most grain primitives are not built, but
+ *          written to tasks_out to be completed with taa_bvh_build_task.
+ *          tasks_out must have room for bvh->size elements. A grain of zero
+ *          builds the entire hierarchy.
+ * @return the number of tasks written to tasks_out
+ */
+taa_INLINE static uint32_t taa_bvh_build_top(
+    taa_bvh* bvh,
+    const taa_aabb_minmax* bounds,
+    uint32_t grain,
+    taa_bvh_task* tasks_out);
+
+/**
+ * @brief allocates a hierarchy for n primitives
+ * @param maxleaf maximum number of primitives per leaf, 1 to 4
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_bvh_create(
+    uint32_t n,
+    uint32_t maxleaf,
+    taa_bvh* bvh_out);
+
+taa_INLINE static void taa_bvh_destroy(
+    taa_bvh* bvh);
+
+/**
+ * @brief finds the nearest intersection of a ray with indexed triangles
+ * @details primitive i of the hierarchy is the triangle formed by
+ *          tri_indices[i*3 + 0..2]. hit_out->index is the primitive index.
+ *          Otherwise the same as taa_ray_intersect_trianglex4.
+ * @return 1 if a triangle was hit, 0 otherwise
+ */
+taa_INLINE static int taa_bvh_intersect_ray_triangles(
+    const taa_bvh* bvh,
+    const taa_ray* r,
+    const taa_vec4* pos,
+    const uint32_t* tri_indices,
+    float tmax,
+    taa_ray_hit* hit_out);
+
+/**
+ * @brief gathers the bounds of the primitives in a leaf
+ * @details unused lanes repeat the last primitive.
+ */
+taa_INLINE static void taa_bvh_leaf_bounds(
+    const taa_bvh* bvh,
+    uint32_t first,
+    uint32_t count,
+    taa_aabbx4* b_out);
+
+/**
+ * @brief finds the primitives whose bounds overlap a box
+ * @details at most maxindices primitive indices are written to indices_out.
+ * @return the total number of overlapping primitives
+ */
+taa_INLINE static uint32_t taa_bvh_query_aabb(
+    const taa_bvh* bvh,
+    const taa_aabb_minmax* box,
+    uint32_t* indices_out,
+    uint32_t maxindices);
+
+/**
+ * @brief finds the primitives whose bounds are hit by a ray in [0, tmax]
+ * @details at most maxindices primitive indices are written to indices_out.
+ * @return the total number of primitives hit
+ */
+taa_INLINE static uint32_t taa_bvh_query_ray(
+    const taa_bvh* bvh,
+    const taa_ray* r,
+    float tmax,
+    uint32_t* indices_out,
+    uint32_t maxindices);
+
+/**
+ * @brief finds the primitives whose bounds overlap a sphere
+ * @details the sphere center is stored in xyz and its radius in w. At most
+ *          maxindices primitive indices are written to indices_out.
+ * @return the total number of overlapping primitives
+ */
+taa_INLINE static uint32_t taa_bvh_query_sphere(
+    const taa_bvh* bvh,
+    const taa_vec4* sphere,
+    uint32_t* indices_out,
+    uint32_t maxindices);
+
+/**
+ * @brief partitions bvh->indices[begin, end) into two non empty halves
+ * @return the index of the first primitive of the second half
+ */
+taa_INLINE static uint32_t taa_bvh_split(
+    taa_bvh* bvh,
+    uint32_t begin,
+    uint32_t end,
+    int median);
+
+//****************************************************************************
+taa_INLINE static void taa_bvh_build(
+    taa_bvh* bvh,
+    const taa_aabb_minmax* bounds)
+{
+    taa_bvh_build_top(bvh, bounds, 0, NULL);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_bvh_build_node(
+    taa_bvh* bvh,
+    uint32_t node,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t depth,
+    uint32_t* next,
+    uint32_t grain,
+    taa_bvh_task* tasks,
+    uint32_t* numtasks)
+{
+    const uint32_t* indices = bvh->indices;
+    const taa_aabb_minmax* bounds = bvh->bounds;
+    taa_bvh_node* nd = bvh->nodes + node;
+    uint32_t cb[4];
+    uint32_t ce[4];
+    uint32_t nc = 1;
+    uint32_t k;
+    cb[0] = begin;
+    ce[0] = end;
+    // split the largest cluster until there are four or none can be split
+    while(nc < 4)
+    {
+        uint32_t best = nc;
+        for(k = 0; k < nc; ++k)
+        {
+            uint32_t m = ce[k] - cb[k];
+            if(m > bvh->maxleaf && (best == nc || m > ce[best] - cb[best]))
+            {
+                best = k;
+            }
+        }
+        if(best == nc)
+        {
+            break;
+        }
+        cb[nc] = taa_bvh_split(
+            bvh,
+            cb[best],
+            ce[best],
+            depth >= taa_BVH_MAX_DEPTH/2);
+        ce[nc] = ce[best];
+        ce[best] = cb[nc];
+        ++nc;
+    }
+    for(k = 0; k < 4; ++k)
+    {
+        if(k < nc)
+        {
+            float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+            float mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            uint32_t m = ce[k] - cb[k];
+            uint32_t i;
+            int j;
+            for(i = cb[k]; i < ce[k]; ++i)
+            {
+                const taa_aabb_minmax* b = bounds + indices[i];
+                for(j = 0; j < 3; ++j)
+                {
+                    float bmin = (&b->min.x)[j];
+                    float bmax = (&b->max.x)[j];
+                    mn[j] = (bmin < mn[j]) ? bmin : mn[j];
+                    mx[j] = (bmax > mx[j]) ? bmax : mx[j];
+                }
+            }
+            nd->bounds.min.x[k] = mn[0];
+            nd->bounds.min.y[k] = mn[1];
+            nd->bounds.min.z[k] = mn[2];
+            nd->bounds.max.x[k] = mx[0];
+            nd->bounds.max.y[k] = mx[1];
+            nd->bounds.max.z[k] = mx[2];
+            if(m <= bvh->maxleaf)
+            {
+                nd->child[k] = cb[k];
+                nd->count[k] = m;
+            }
+            else if(grain != 0 && m <= grain)
+            {
+                // reserve enough nodes for any subtree of m primitives
+                taa_bvh_task* t = tasks + *numtasks;
+                t->node = *next;
+                t->begin = cb[k];
+                t->end = ce[k];
+                t->depth = depth + 1;
+                nd->child[k] = *next;
+                nd->count[k] = 0;
+                *next += m;
+                ++(*numtasks);
+            }
+            else
+            {
+                uint32_t child = (*next)++;
+                nd->child[k] = child;
+                nd->count[k] = 0;
+                taa_bvh_build_node(
+                    bvh,
+                    child,
+                    cb[k],
+                    ce[k],
+                    depth + 1,
+                    next,
+                    grain,
+                    tasks,
+                    numtasks);
+            }
+        }
+        else
+        {
+            nd->bounds.min.x[k] = nd->bounds.min.x[0];
+            nd->bounds.min.y[k] = nd->bounds.min.y[0];
+            nd->bounds.min.z[k] = nd->bounds.min.z[0];
+            nd->bounds.max.x[k] = nd->bounds.max.x[0];
+            nd->bounds.max.y[k] = nd->bounds.max.y[0];
+            nd->bounds.max.z[k] = nd->bounds.max.z[0];
+            nd->child[k] = taa_BVH_EMPTY;
+            nd->count[k] = 0;
+        }
+    }
+    assert(*next <= bvh->size*2);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_bvh_build_task(
+    taa_bvh* bvh,
+    const taa_bvh_task* task)
+{
+    uint32_t next = task->node + 1;
+    taa_bvh_build_node(
+        bvh,
+        task->node,
+        task->begin,
+        task->end,
+        task->depth,
+        &next,
+        0,
+        NULL,
+        NULL);
+    assert(next <= task->node + (task->end - task->begin));
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_bvh_build_top(
+    taa_bvh* bvh,
+    const taa_aabb_minmax* bounds,
+    uint32_t grain,
+    taa_bvh_task* tasks_out)
+{
+    uint32_t numtasks = 0;
+    uint32_t next = 1;
+    uint32_t i;
+    memcpy(bvh->bounds, bounds, bvh->size * sizeof(*bounds));
+    for(i = 0; i < bvh->size; ++i)
+    {
+        taa_vpu_vec4 mn;
+        taa_vpu_vec4 mx;
+        taa_vpu_vec4 half;
+        taa_vpu_load(&bounds[i].min.x, mn);
+        taa_vpu_load(&bounds[i].max.x, mx);
+        taa_vpu_set1(0.5f, half);
+        taa_vpu_add(mn, mx, mn);
+        taa_vpu_mul(mn, half, mn);
+        taa_vpu_store(mn, &bvh->centroids[i].x);
+        bvh->indices[i] = i;
+    }
+    bvh->numnodes = 0;
+    if(bvh->size > 0)
+    {
+        taa_bvh_build_node(
+            bvh,
+            0,
+            0,
+            bvh->size,
+            0,
+            &next,
+            grain,
+            tasks_out,
+            &numtasks);
+        bvh->numnodes = next;
+    }
+    return numtasks;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_bvh_create(
+    uint32_t n,
+    uint32_t maxleaf,
+    taa_bvh* bvh_out)
+{
+    void* aligned = NULL;
+    size_t nodesize = (n*2 + 1) * sizeof(taa_bvh_node);
+    size_t boundsize = n * sizeof(taa_aabb_minmax);
+    size_t centersize = n * sizeof(taa_vec4);
+    int err;
+    assert(maxleaf > 0 && maxleaf <= taa_BVH_MAX_LEAF);
+    memset(bvh_out, 0, sizeof(*bvh_out));
+    err = taa_stream_realloc(
+        &bvh_out->buffer,
+        &aligned,
+        0,
+        nodesize + boundsize + centersize + n*sizeof(uint32_t));
+    if(err == 0)
+    {
+        char* p = (char*) aligned;
+        bvh_out->nodes = (taa_bvh_node*) p;
+        bvh_out->bounds = (taa_aabb_minmax*) (p + nodesize);
+        bvh_out->centroids = (taa_vec4*) (p + nodesize + boundsize);
+        bvh_out->indices = (uint32_t*) (p+nodesize+boundsize+centersize);
+        bvh_out->size = n;
+        bvh_out->maxleaf = maxleaf;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_bvh_destroy(
+    taa_bvh* bvh)
+{
+    free(bvh->buffer);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+//****************************************************************************
+taa_INLINE static int taa_bvh_intersect_ray_triangles(
+    const taa_bvh* bvh,
+    const taa_ray* r,
+    const taa_vec4* pos,
+    const uint32_t* tri_indices,
+    float tmax,
+    taa_ray_hit* hit_out)
+{
+    uint32_t stack[taa_BVH_STACK_SIZE];
+    float tstack[taa_BVH_STACK_SIZE];
+    uint32_t sp = 0;
+    int result = 0;
+    if(bvh->numnodes > 0)
+    {
+        stack[sp] = 0;
+        tstack[sp] = 0.0f;
+        ++sp;
+    }
+    while(sp > 0)
+    {
+        const taa_bvh_node* nd;
+        taa_vec4 t;
+        uint32_t order[4];
+        uint32_t numorder = 0;
+        int mask;
+        int k;
+        --sp;
+        if(tstack[sp] > tmax)
+        {
+            continue;
+        }
+        nd = bvh->nodes + stack[sp];
+        mask = taa_ray_intersect_aabbx4(r, &nd->bounds, tmax, &t);
+        for(k = 0; k < 4; ++k)
+        {
+            if((mask & (1 << k)) != 0 && nd->child[k] != taa_BVH_EMPTY)
+            {
+                if(nd->count[k] > 0)
+                {
+                    const uint32_t* leaf = bvh->indices + nd->child[k];
+                    uint32_t idx[taa_BVH_MAX_LEAF * 3];
+                    taa_trianglex4 tri;
+                    taa_ray_hit hit;
+                    uint32_t i;
+                    for(i = 0; i < nd->count[k]; ++i)
+                    {
+                        const uint32_t* ti = tri_indices + leaf[i]*3;
+                        idx[i*3 + 0] = ti[0];
+                        idx[i*3 + 1] = ti[1];
+                        idx[i*3 + 2] = ti[2];
+                    }
+                    taa_trianglex4_from_indexed(pos, idx, nd->count[k], &tri);
+                    if(taa_ray_intersect_trianglex4(
+                        r,
+                        &tri,
+                        nd->count[k],
+                        tmax,
+                        &hit))
+                    {
+                        tmax = hit.t;
+                        *hit_out = hit;
+                        hit_out->index = leaf[hit.index];
+                        result = 1;
+                    }
+                }
+                else
+                {
+                    // insertion sort the child nodes by descending distance
+                    uint32_t j = numorder++;
+                    while(j > 0 && (&t.x)[order[j - 1]] < (&t.x)[k])
+                    {
+                        order[j] = order[j - 1];
+                        --j;
+                    }
+                    order[j] = k;
+                }
+            }
+        }
+        // push the nearest child last so it is visited first
+        for(k = 0; k < (int) numorder; ++k)
+        {
+            assert(sp < taa_BVH_STACK_SIZE);
+            stack[sp] = nd->child[order[k]];
+            tstack[sp] = (&t.x)[order[k]];
+            ++sp;
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_bvh_leaf_bounds(
+    const taa_bvh* bvh,
+    uint32_t first,
+    uint32_t count,
+    taa_aabbx4* b_out)
+{
+    const uint32_t* indices = bvh->indices + first;
+    uint32_t i;
+    assert(count > 0 && count <= 4);
+    for(i = 0; i < 4; ++i)
+    {
+        const taa_aabb_minmax* b;
+        b = bvh->bounds + indices[(i < count) ? i : count - 1];
+        b_out->min.x[i] = b->min.x;
+        b_out->min.y[i] = b->min.y;
+        b_out->min.z[i] = b->min.z;
+        b_out->max.x[i] = b->max.x;
+        b_out->max.y[i] = b->max.y;
+        b_out->max.z[i] = b->max.z;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_bvh_query_aabb(
+    const taa_bvh* bvh,
+    const taa_aabb_minmax* box,
+    uint32_t* indices_out,
+    uint32_t maxindices)
+{
+    uint32_t stack[taa_BVH_STACK_SIZE];
+    uint32_t sp = 0;
+    uint32_t count = 0;
+    if(bvh->numnodes > 0)
+    {
+        stack[sp++] = 0;
+    }
+    while(sp > 0)
+    {
+        const taa_bvh_node* nd = bvh->nodes + stack[--sp];
+        int mask = taa_aabbx4_overlap_aabb(&nd->bounds, box);
+        int k;
+        for(k = 0; k < 4; ++k)
+        {
+            if((mask & (1 << k)) != 0 && nd->child[k] != taa_BVH_EMPTY)
+            {
+                uint32_t first = nd->child[k];
+                uint32_t n = nd->count[k];
+                if(n > 0)
+                {
+                    taa_aabbx4 leaf;
+                    int lmask;
+                    uint32_t i;
+                    taa_bvh_leaf_bounds(bvh, first, n, &leaf);
+                    lmask = taa_aabbx4_overlap_aabb(&leaf, box);
+                    for(i = 0; i < n; ++i)
+                    {
+                        if((lmask & (1 << i)) != 0)
+                        {
+                            if(count < maxindices)
+                            {
+                                indices_out[count] = bvh->indices[first + i];
+                            }
+                            ++count;
+                        }
+                    }
+                }
+                else
+                {
+                    assert(sp < taa_BVH_STACK_SIZE);
+                    stack[sp++] = first;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_bvh_query_ray(
+    const taa_bvh* bvh,
+    const taa_ray* r,
+    float tmax,
+    uint32_t* indices_out,
+    uint32_t maxindices)
+{
+    uint32_t stack[taa_BVH_STACK_SIZE];
+    uint32_t sp = 0;
+    uint32_t count = 0;
+    if(bvh->numnodes > 0)
+    {
+        stack[sp++] = 0;
+    }
+    while(sp > 0)
+    {
+        const taa_bvh_node* nd = bvh->nodes + stack[--sp];
+        taa_vec4 t;
+        int mask = taa_ray_intersect_aabbx4(r, &nd->bounds, tmax, &t);
+        int k;
+        for(k = 0; k < 4; ++k)
+        {
+            if((mask & (1 << k)) != 0 && nd->child[k] != taa_BVH_EMPTY)
+            {
+                uint32_t first = nd->child[k];
+                uint32_t n = nd->count[k];
+                if(n > 0)
+                {
+                    taa_aabbx4 leaf;
+                    int lmask;
+                    uint32_t i;
+                    taa_bvh_leaf_bounds(bvh, first, n, &leaf);
+                    lmask = taa_ray_intersect_aabbx4(r, &leaf, tmax, &t);
+                    for(i = 0; i < n; ++i)
+                    {
+                        if((lmask & (1 << i)) != 0)
+                        {
+                            if(count < maxindices)
+                            {
+                                indices_out[count] = bvh->indices[first + i];
+                            }
+                            ++count;
+                        }
+                    }
+                }
+                else
+                {
+                    assert(sp < taa_BVH_STACK_SIZE);
+                    stack[sp++] = first;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_bvh_query_sphere(
+    const taa_bvh* bvh,
+    const taa_vec4* sphere,
+    uint32_t* indices_out,
+    uint32_t maxindices)
+{
+    uint32_t stack[taa_BVH_STACK_SIZE];
+    uint32_t sp = 0;
+    uint32_t count = 0;
+    if(bvh->numnodes > 0)
+    {
+        stack[sp++] = 0;
+    }
+    while(sp > 0)
+    {
+        const taa_bvh_node* nd = bvh->nodes + stack[--sp];
+        int mask = taa_aabbx4_overlap_sphere(&nd->bounds, sphere);
+        int k;
+        for(k = 0; k < 4; ++k)
+        {
+            if((mask & (1 << k)) != 0 && nd->child[k] != taa_BVH_EMPTY)
+            {
+                uint32_t first = nd->child[k];
+                uint32_t n = nd->count[k];
+                if(n > 0)
+                {
+                    taa_aabbx4 leaf;
+                    int lmask;
+                    uint32_t i;
+                    taa_bvh_leaf_bounds(bvh, first, n, &leaf);
+                    lmask = taa_aabbx4_overlap_sphere(&leaf, sphere);
+                    for(i = 0; i < n; ++i)
+                    {
+                        if((lmask & (1 << i)) != 0)
+                        {
+                            if(count < maxindices)
+                            {
+                                indices_out[count] = bvh->indices[first + i];
+                            }
+                            ++count;
+                        }
+                    }
+                }
+                else
+                {
+                    assert(sp < taa_BVH_STACK_SIZE);
+                    stack[sp++] = first;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_bvh_split(
+    taa_bvh* bvh,
+    uint32_t begin,
+    uint32_t end,
+    int median)
+{
+    uint32_t* indices = bvh->indices;
+    const taa_vec4* centroids = bvh->centroids;
+    const taa_aabb_minmax* bounds = bvh->bounds;
+    taa_aabb_minmax bins[taa_BVH_NUM_BINS];
+    uint32_t bincount[taa_BVH_NUM_BINS];
+    float rarea[taa_BVH_NUM_BINS];
+    float cmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float cmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    float extent;
+    float scale;
+    float bestcost = FLT_MAX;
+    uint32_t bestbin = 0;
+    uint32_t mid = begin + (end - begin)/2;
+    uint32_t i;
+    int axis = 0;
+    int j;
+    assert(end - begin >= 2);
+    for(i = begin; i < end; ++i)
+    {
+        const float* c = &centroids[indices[i]].x;
+        for(j = 0; j < 3; ++j)
+        {
+            cmin[j] = (c[j] < cmin[j]) ? c[j] : cmin[j];
+            cmax[j] = (c[j] > cmax[j]) ? c[j] : cmax[j];
+        }
+    }
+    for(j = 1; j < 3; ++j)
+    {
+        if(cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+        {
+            axis = j;
+        }
+    }
+    extent = cmax[axis] - cmin[axis];
+    if(median || !(extent > 0.0f))
+    {
+        // all centroids coincide, or the tree is too deep. any split works
+        return mid;
+    }
+    scale = (taa_BVH_NUM_BINS * (1.0f - FLT_EPSILON)) / extent;
+    for(j = 0; j < taa_BVH_NUM_BINS; ++j)
+    {
+        bins[j].min.x = bins[j].min.y = bins[j].min.z = FLT_MAX;
+        bins[j].max.x = bins[j].max.y = bins[j].max.z = -FLT_MAX;
+        bincount[j] = 0;
+    }
+    for(i = begin; i < end; ++i)
+    {
+        uint32_t prim = indices[i];
+        const taa_aabb_minmax* b = bounds + prim;
+        float c = (&centroids[prim].x)[axis];
+        int bin = (int) ((c - cmin[axis]) * scale);
+        taa_aabb_minmax* bb;
+        bin = (bin < taa_BVH_NUM_BINS) ? bin : taa_BVH_NUM_BINS - 1;
+        bb = bins + bin;
+        ++bincount[bin];
+        bb->min.x = (b->min.x < bb->min.x) ? b->min.x : bb->min.x;
+        bb->min.y = (b->min.y < bb->min.y) ? b->min.y : bb->min.y;
+        bb->min.z = (b->min.z < bb->min.z) ? b->min.z : bb->min.z;
+        bb->max.x = (b->max.x > bb->max.x) ? b->max.x : bb->max.x;
+        bb->max.y = (b->max.y > bb->max.y) ? b->max.y : bb->max.y;
+        bb->max.z = (b->max.z > bb->max.z) ? b->max.z : bb->max.z;
+    }
+    // sweep from the right and then from the left, evaluating the surface
+    // area cost of splitting in front of each bin
+    {
+        taa_aabb_minmax acc = bins[taa_BVH_NUM_BINS - 1];
+        uint32_t n = 0;
+        for(j = taa_BVH_NUM_BINS - 1; j > 0; --j)
+        {
+            const taa_aabb_minmax* bb = bins + j;
+            float dx;
+            float dy;
+            float dz;
+            n += bincount[j];
+            acc.min.x = (bb->min.x < acc.min.x) ? bb->min.x : acc.min.x;
+            acc.min.y = (bb->min.y < acc.min.y) ? bb->min.y : acc.min.y;
+            acc.min.z = (bb->min.z < acc.min.z) ? bb->min.z : acc.min.z;
+            acc.max.x = (bb->max.x > acc.max.x) ? bb->max.x : acc.max.x;
+            acc.max.y = (bb->max.y > acc.max.y) ? bb->max.y : acc.max.y;
+            acc.max.z = (bb->max.z > acc.max.z) ? bb->max.z : acc.max.z;
+            dx = acc.max.x - acc.min.x;
+            dy = acc.max.y - acc.min.y;
+            dz = acc.max.z - acc.min.z;
+            rarea[j] = (n > 0) ? (dx*dy + dy*dz + dz*dx) * n : 0.0f;
+        }
+        acc = bins[0];
+        n = 0;
+        for(j = 0; j < taa_BVH_NUM_BINS - 1; ++j)
+        {
+            const taa_aabb_minmax* bb = bins + j;
+            float dx;
+            float dy;
+            float dz;
+            float cost;
+            n += bincount[j];
+            acc.min.x = (bb->min.x < acc.min.x) ? bb->min.x : acc.min.x;
+            acc.min.y = (bb->min.y < acc.min.y) ? bb->min.y : acc.min.y;
+            acc.min.z = (bb->min.z < acc.min.z) ? bb->min.z : acc.min.z;
+            acc.max.x = (bb->max.x > acc.max.x) ? bb->max.x : acc.max.x;
+            acc.max.y = (bb->max.y > acc.max.y) ? bb->max.y : acc.max.y;
+            acc.max.z = (bb->max.z > acc.max.z) ? bb->max.z : acc.max.z;
+            dx = acc.max.x - acc.min.x;
+            dy = acc.max.y - acc.min.y;
+            dz = acc.max.z - acc.min.z;
+            cost = (n > 0) ? (dx*dy + dy*dz + dz*dx) * n : 0.0f;
+            cost += rarea[j + 1];
+            if(n > 0 && n < end - begin && cost < bestcost)
+            {
+                bestcost = cost;
+                bestbin = j + 1;
+            }
+        }
+    }
+    if(bestbin != 0)
+    {
+        uint32_t lo = begin;
+        uint32_t hi = end;
+        while(lo < hi)
+        {
+            uint32_t prim = indices[lo];
+            float c = (&centroids[prim].x)[axis];
+            int bin = (int) ((c - cmin[axis]) * scale);
+            if(bin < (int) bestbin)
+            {
+                ++lo;
+            }
+            else
+            {
+                --hi;
+                indices[lo] = indices[hi];
+                indices[hi] = prim;
+            }
+        }
+        mid = lo;
+    }
+    assert(mid > begin && mid < end);
+    return mid;
+}
+
+#endif // taa_BVH_H_
@@ -0,0 +1,433 @@
+/**
+ * @brief     inlined batch camera matrix functions header
+ * @details   builds the view and projection matrices of many cameras at
+ *            once, four cameras at a time in structure of arrays format.
+ *            The view matrices match taa_mat44_lookat, and the
+ *            taa_PROJECTION_PERSPECTIVE matrices match taa_mat44_perspective.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_CAMERA_H_
+#define taa_CAMERA_H_
+
+#include "mat44x4.h"
+#include "vec4x4.h"
+#include <assert.h>
+
+typedef enum taa_projection_e taa_projection;
+typedef struct taa_camera_desc_s taa_camera_desc;
+typedef struct taa_camera_s taa_camera;
+
+enum taa_projection_e
+{
+    /** OpenGL depth range, near maps to -1 and far maps to 1 */
+    taa_PROJECTION_PERSPECTIVE,
+    /** OpenGL depth range with the far plane at infinity */
+    taa_PROJECTION_INFINITE,
+    /** zero to one depth range, near maps to 1 and far maps to 0 */
+    taa_PROJECTION_REVERSED,
+    /** zero to one depth range, near maps to 1 and infinity maps to 0 */
+    taa_PROJECTION_REVERSED_INFINITE
+};
+
+/**
+ * @brief camera parameters, the same as the arguments of taa_mat44_lookat
+ *        and taa_mat44_perspective
+ * @details zfar is ignored by the infinite projections.
+ */
+struct taa_camera_desc_s
+{
+    taa_vec4 eye;
+    taa_vec4 target;
+    taa_vec4 up;
+    float fovy;
+    float aspect;
+    float znear;
+    float zfar;
+    taa_projection projection;
+};
+
+struct taa_camera_s
+{
+    taa_mat44 view;
+    taa_mat44 proj;
+    /** proj * view */
+    taa_mat44 viewproj;
+    taa_mat44 view_inverse;
+    taa_mat44 proj_inverse;
+    taa_mat44 viewproj_inverse;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief builds the matrices for an array of cameras
+ * @details the inverses are computed directly from the camera parameters
+ *          rather than by general matrix inversion. desc and cam_out must
+ *          be 16 byte aligned.
+ */
+taa_INLINE static void taa_camera_build_array(
+    const taa_camera_desc* desc,
+    uint32_t n,
+    taa_camera* cam_out);
+
+//****************************************************************************
+taa_INLINE static void taa_camera_build_array(
+    const taa_camera_desc* desc,
+    uint32_t n,
+    taa_camera* cam_out)
+{
+    const taa_camera_desc* dend = desc + n;
+    taa_vec4x4 coef;
+    taa_mat44x4 m4[6];
+    taa_mat44* out[4][6];
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+    assert((((size_t) desc) & 15) == 0);
+    assert((((size_t) cam_out) & 15) == 0);
+    while(desc != dend)
+    {
+        uint32_t nlanes = (uint32_t) (dend - desc);
+        taa_vpu_vec4 ex;
+        taa_vpu_vec4 ey;
+        taa_vpu_vec4 ez;
+        taa_vpu_vec4 fx;
+        taa_vpu_vec4 fy;
+        taa_vpu_vec4 fz;
+        taa_vpu_vec4 ux;
+        taa_vpu_vec4 uy;
+        taa_vpu_vec4 uz;
+        taa_vpu_vec4 sx;
+        taa_vpu_vec4 sy;
+        taa_vpu_vec4 sz;
+        taa_vpu_vec4 tx;
+        taa_vpu_vec4 ty;
+        taa_vpu_vec4 tz;
+        taa_vpu_vec4 a;
+        taa_vpu_vec4 b;
+        taa_vpu_vec4 c;
+        taa_vpu_vec4 d;
+        taa_vpu_vec4 zero;
+        taa_vpu_vec4 one;
+        taa_vpu_vec4 tmp;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        // projection coefficients. unused lanes repeat the last camera so
+        // that they stay finite.
+        for(i = 0; i < 4; ++i)
+        {
+            const taa_camera_desc* cam = desc + ((i < nlanes) ? i : nlanes-1);
+            float cot = 1.0f/tanf(cam->fovy * 0.5f);
+            float zn = cam->znear;
+            float zf = cam->zfar;
+            coef.x[i] = cot/cam->aspect;
+            coef.y[i] = cot;
+            switch(cam->projection)
+            {
+            default:
+                // an invalid projection falls through to perspective
+                assert(0);
+            case taa_PROJECTION_PERSPECTIVE:
+                coef.z[i] = (zf + zn)/(zn - zf);
+                coef.w[i] = 2.0f*zn*zf/(zn - zf);
+                break;
+            case taa_PROJECTION_INFINITE:
+                coef.z[i] = -1.0f;
+                coef.w[i] = -2.0f*zn;
+                break;
+            case taa_PROJECTION_REVERSED:
+                coef.z[i] = zn/(zf - zn);
+                coef.w[i] = zn*zf/(zf - zn);
+                break;
+            case taa_PROJECTION_REVERSED_INFINITE:
+                coef.z[i] = 0.0f;
+                coef.w[i] = zn;
+                break;
+            }
+        }
+        taa_vpu_load(coef.x, a);
+        taa_vpu_load(coef.y, b);
+        taa_vpu_load(coef.z, c);
+        taa_vpu_load(coef.w, d);
+        // transpose eye, target and up into lane vectors
+        {
+            const taa_camera_desc* d0 = desc;
+            const taa_camera_desc* d1 = desc + ((nlanes > 1) ? 1 : 0);
+            const taa_camera_desc* d2 = desc + ((nlanes > 2) ? 2 : nlanes-1);
+            const taa_camera_desc* d3 = desc + (nlanes - 1);
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 w;
+            taa_vpu_load(&d0->eye.x, c0);
+            taa_vpu_load(&d1->eye.x, c1);
+            taa_vpu_load(&d2->eye.x, c2);
+            taa_vpu_load(&d3->eye.x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, ex, ey, ez, w);
+            taa_vpu_load(&d0->target.x, c0);
+            taa_vpu_load(&d1->target.x, c1);
+            taa_vpu_load(&d2->target.x, c2);
+            taa_vpu_load(&d3->target.x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, fx, fy, fz, w);
+            taa_vpu_load(&d0->up.x, c0);
+            taa_vpu_load(&d1->up.x, c1);
+            taa_vpu_load(&d2->up.x, c2);
+            taa_vpu_load(&d3->up.x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, ux, uy, uz, w);
+            (void) w;
+        }
+        taa_vpu_set1(0.0f, zero);
+        taa_vpu_set1(1.0f, one);
+        // f = |target - eye|
+        taa_vpu_sub(fx, ex, fx);
+        taa_vpu_sub(fy, ey, fy);
+        taa_vpu_sub(fz, ez, fz);
+        taa_vpu_mul(fx, fx, tmp);
+        taa_vpu_mul(fy, fy, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_mul(fz, fz, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_sqrt(tmp, tmp);
+        taa_vpu_div(one, tmp, tmp);
+        taa_vpu_mul(fx, tmp, fx);
+        taa_vpu_mul(fy, tmp, fy);
+        taa_vpu_mul(fz, tmp, fz);
+        // s = |f X up|
+        taa_vpu_mul(fy, uz, sx);
+        taa_vpu_mul(fz, uy, tmp);
+        taa_vpu_sub(sx, tmp, sx);
+        taa_vpu_mul(fz, ux, sy);
+        taa_vpu_mul(fx, uz, tmp);
+        taa_vpu_sub(sy, tmp, sy);
+        taa_vpu_mul(fx, uy, sz);
+        taa_vpu_mul(fy, ux, tmp);
+        taa_vpu_sub(sz, tmp, sz);
+        taa_vpu_mul(sx, sx, tmp);
+        taa_vpu_mul(sy, sy, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_mul(sz, sz, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_sqrt(tmp, tmp);
+        taa_vpu_div(one, tmp, tmp);
+        taa_vpu_mul(sx, tmp, sx);
+        taa_vpu_mul(sy, tmp, sy);
+        taa_vpu_mul(sz, tmp, sz);
+        // u = s X f, which is already unit length
+        taa_vpu_mul(sy, fz, ux);
+        taa_vpu_mul(sz, fy, tmp);
+        taa_vpu_sub(ux, tmp, ux);
+        taa_vpu_mul(sz, fx, uy);
+        taa_vpu_mul(sx, fz, tmp);
+        taa_vpu_sub(uy, tmp, uy);
+        taa_vpu_mul(sx, fy, uz);
+        taa_vpu_mul(sy, fx, tmp);
+        taa_vpu_sub(uz, tmp, uz);
+        // t = (-dot(s, eye), -dot(u, eye), dot(f, eye))
+        taa_vpu_mul(sx, ex, tx);
+        taa_vpu_mul(sy, ey, tmp);
+        taa_vpu_add(tx, tmp, tx);
+        taa_vpu_mul(sz, ez, tmp);
+        taa_vpu_add(tx, tmp, tx);
+        taa_vpu_neg(tx, tx);
+        taa_vpu_mul(ux, ex, ty);
+        taa_vpu_mul(uy, ey, tmp);
+        taa_vpu_add(ty, tmp, ty);
+        taa_vpu_mul(uz, ez, tmp);
+        taa_vpu_add(ty, tmp, ty);
+        taa_vpu_neg(ty, ty);
+        taa_vpu_mul(fx, ex, tz);
+        taa_vpu_mul(fy, ey, tmp);
+        taa_vpu_add(tz, tmp, tz);
+        taa_vpu_mul(fz, ez, tmp);
+        taa_vpu_add(tz, tmp, tz);
+        // view: rows s, u, -f and translation t
+        taa_vpu_store(sx, m4[0].x.x);
+        taa_vpu_store(ux, m4[0].x.y);
+        taa_vpu_neg(fx, tmp);
+        taa_vpu_store(tmp, m4[0].x.z);
+        taa_vpu_store(zero, m4[0].x.w);
+        taa_vpu_store(sy, m4[0].y.x);
+        taa_vpu_store(uy, m4[0].y.y);
+        taa_vpu_neg(fy, tmp);
+        taa_vpu_store(tmp, m4[0].y.z);
+        taa_vpu_store(zero, m4[0].y.w);
+        taa_vpu_store(sz, m4[0].z.x);
+        taa_vpu_store(uz, m4[0].z.y);
+        taa_vpu_neg(fz, tmp);
+        taa_vpu_store(tmp, m4[0].z.z);
+        taa_vpu_store(zero, m4[0].z.w);
+        taa_vpu_store(tx, m4[0].w.x);
+        taa_vpu_store(ty, m4[0].w.y);
+        taa_vpu_store(tz, m4[0].w.z);
+        taa_vpu_store(one, m4[0].w.w);
+        // projection
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_store(zero, m4[1].x.x + j);
+            taa_vpu_store(zero, m4[1].y.x + j);
+            taa_vpu_store(zero, m4[1].z.x + j);
+            taa_vpu_store(zero, m4[1].w.x + j);
+        }
+        taa_vpu_store(a, m4[1].x.x);
+        taa_vpu_store(b, m4[1].y.y);
+        taa_vpu_store(c, m4[1].z.z);
+        taa_vpu_neg(one, tmp);
+        taa_vpu_store(tmp, m4[1].z.w);
+        taa_vpu_store(d, m4[1].w.z);
+        // view projection: column k is (a*v0k, b*v1k, c*v2k + d*v3k, -v2k)
+        taa_vpu_mul(a, sx, tmp);
+        taa_vpu_store(tmp, m4[2].x.x);
+        taa_vpu_mul(b, ux, tmp);
+        taa_vpu_store(tmp, m4[2].x.y);
+        taa_vpu_mul(c, fx, tmp);
+        taa_vpu_neg(tmp, tmp);
+        taa_vpu_store(tmp, m4[2].x.z);
+        taa_vpu_store(fx, m4[2].x.w);
+        taa_vpu_mul(a, sy, tmp);
+        taa_vpu_store(tmp, m4[2].y.x);
+        taa_vpu_mul(b, uy, tmp);
+        taa_vpu_store(tmp, m4[2].y.y);
+        taa_vpu_mul(c, fy, tmp);
+        taa_vpu_neg(tmp, tmp);
+        taa_vpu_store(tmp, m4[2].y.z);
+        taa_vpu_store(fy, m4[2].y.w);
+        taa_vpu_mul(a, sz, tmp);
+        taa_vpu_store(tmp, m4[2].z.x);
+        taa_vpu_mul(b, uz, tmp);
+        taa_vpu_store(tmp, m4[2].z.y);
+        taa_vpu_mul(c, fz, tmp);
+        taa_vpu_neg(tmp, tmp);
+        taa_vpu_store(tmp, m4[2].z.z);
+        taa_vpu_store(fz, m4[2].z.w);
+        taa_vpu_mul(a, tx, tmp);
+        taa_vpu_store(tmp, m4[2].w.x);
+        taa_vpu_mul(b, ty, tmp);
+        taa_vpu_store(tmp, m4[2].w.y);
+        taa_vpu_mul(c, tz, tmp);
+        taa_vpu_add(tmp, d, tmp);
+        taa_vpu_store(tmp, m4[2].w.z);
+        taa_vpu_neg(tz, tmp);
+        taa_vpu_store(tmp, m4[2].w.w);
+        // view inverse: columns s, u, -f and eye
+        taa_vpu_store(sx, m4[3].x.x);
+        taa_vpu_store(sy, m4[3].x.y);
+        taa_vpu_store(sz, m4[3].x.z);
+        taa_vpu_store(zero, m4[3].x.w);
+        taa_vpu_store(ux, m4[3].y.x);
+        taa_vpu_store(uy, m4[3].y.y);
+        taa_vpu_store(uz, m4[3].y.z);
+        taa_vpu_store(zero, m4[3].y.w);
+        taa_vpu_neg(fx, tmp);
+        taa_vpu_store(tmp, m4[3].z.x);
+        taa_vpu_neg(fy, tmp);
+        taa_vpu_store(tmp, m4[3].z.y);
+        taa_vpu_neg(fz, tmp);
+        taa_vpu_store(tmp, m4[3].z.z);
+        taa_vpu_store(zero, m4[3].z.w);
+        taa_vpu_store(ex, m4[3].w.x);
+        taa_vpu_store(ey, m4[3].w.y);
+        taa_vpu_store(ez, m4[3].w.z);
+        taa_vpu_store(one, m4[3].w.w);
+        // projection inverse: columns (1/a,0,0,0), (0,1/b,0,0),
+        // (0,0,0,1/d) and (0,0,-1,c/d)
+        taa_vpu_div(one, a, a);
+        taa_vpu_div(one, b, b);
+        taa_vpu_div(one, d, d);
+        taa_vpu_mul(c, d, c);
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_store(zero, m4[4].x.x + j);
+            taa_vpu_store(zero, m4[4].y.x + j);
+            taa_vpu_store(zero, m4[4].z.x + j);
+            taa_vpu_store(zero, m4[4].w.x + j);
+        }
+        taa_vpu_store(a, m4[4].x.x);
+        taa_vpu_store(b, m4[4].y.y);
+        taa_vpu_store(d, m4[4].z.w);
+        taa_vpu_neg(one, tmp);
+        taa_vpu_store(tmp, m4[4].w.z);
+        taa_vpu_store(c, m4[4].w.w);
+        // view projection inverse: columns s/a, u/b, (eye,1)/d and
+        // (f + eye*c/d, c/d)
+        taa_vpu_mul(sx, a, tmp);
+        taa_vpu_store(tmp, m4[5].x.x);
+        taa_vpu_mul(sy, a, tmp);
+        taa_vpu_store(tmp, m4[5].x.y);
+        taa_vpu_mul(sz, a, tmp);
+        taa_vpu_store(tmp, m4[5].x.z);
+        taa_vpu_store(zero, m4[5].x.w);
+        taa_vpu_mul(ux, b, tmp);
+        taa_vpu_store(tmp, m4[5].y.x);
+        taa_vpu_mul(uy, b, tmp);
+        taa_vpu_store(tmp, m4[5].y.y);
+        taa_vpu_mul(uz, b, tmp);
+        taa_vpu_store(tmp, m4[5].y.z);
+        taa_vpu_store(zero, m4[5].y.w);
+        taa_vpu_mul(ex, d, tmp);
+        taa_vpu_store(tmp, m4[5].z.x);
+        taa_vpu_mul(ey, d, tmp);
+        taa_vpu_store(tmp, m4[5].z.y);
+        taa_vpu_mul(ez, d, tmp);
+        taa_vpu_store(tmp, m4[5].z.z);
+        taa_vpu_store(d, m4[5].z.w);
+        taa_vpu_mul(ex, c, tmp);
+        taa_vpu_add(fx, tmp, tmp);
+        taa_vpu_store(tmp, m4[5].w.x);
+        taa_vpu_mul(ey, c, tmp);
+        taa_vpu_add(fy, tmp, tmp);
+        taa_vpu_store(tmp, m4[5].w.y);
+        taa_vpu_mul(ez, c, tmp);
+        taa_vpu_add(fz, tmp, tmp);
+        taa_vpu_store(tmp, m4[5].w.z);
+        taa_vpu_store(c, m4[5].w.w);
+        // transpose each matrix back into the camera structures, in the
+        // same order as m4
+        for(i = 0; i < nlanes; ++i)
+        {
+            out[i][0] = &cam_out[i].view;
+            out[i][1] = &cam_out[i].proj;
+            out[i][2] = &cam_out[i].viewproj;
+            out[i][3] = &cam_out[i].view_inverse;
+            out[i][4] = &cam_out[i].proj_inverse;
+            out[i][5] = &cam_out[i].viewproj_inverse;
+        }
+        for(k = 0; k < 6; ++k)
+        {
+            // col[j][i] holds column j of the matrix of lane i
+            const taa_vec4x4* src[4];
+            taa_vpu_vec4 col[4][4];
+            src[0] = &m4[k].x;
+            src[1] = &m4[k].y;
+            src[2] = &m4[k].z;
+            src[3] = &m4[k].w;
+            for(j = 0; j < 4; ++j)
+            {
+                taa_vpu_vec4 x;
+                taa_vpu_vec4 y;
+                taa_vpu_vec4 z;
+                taa_vpu_vec4 w;
+                taa_vpu_load(src[j]->x, x);
+                taa_vpu_load(src[j]->y, y);
+                taa_vpu_load(src[j]->z, z);
+                taa_vpu_load(src[j]->w, w);
+                taa_vpu_mat44_transpose(
+                    x, y, z, w,
+                    col[j][0], col[j][1], col[j][2], col[j][3]);
+            }
+            for(i = 0; i < nlanes; ++i)
+            {
+                taa_vpu_store(col[0][i], &out[i][k]->x.x);
+                taa_vpu_store(col[1][i], &out[i][k]->y.x);
+                taa_vpu_store(col[2][i], &out[i][k]->z.x);
+                taa_vpu_store(col[3][i], &out[i][k]->w.x);
+            }
+        }
+        desc += nlanes;
+        cam_out += nlanes;
+    }
+}
+
+#endif // taa_CAMERA_H_
@@ -0,0 +1,384 @@
+/**
+ * @brief     inlined closest point functions header
+ * @details   each function finds the closest points between one query and
+ *            four primitives stored in structure of arrays format, with
+ *            every branch of the scalar algorithm evaluated for all lanes
+ *            and resolved with selects.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_CLOSEST_H_
+#define taa_CLOSEST_H_
+
+#include "ray.h"
+
+typedef struct taa_segmentx4_s taa_segmentx4;
+
+/**
+ * @brief four line segments in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Each
+ *          segment is stored as its start point and the vector from its
+ *          start to its end.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_segmentx4_s
+{
+    taa_vec3x4 p;
+    taa_vec3x4 d;
+} taa_ATTRIB_ALIGN(16);
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief finds the closest points on four triangles to a point
+ * @details uses the Voronoi region method from Ericson's Real-Time
+ *          Collision Detection.
+ */
+taa_INLINE static void taa_closest_point_trianglex4(
+    const taa_vec4* p,
+    const taa_trianglex4* t,
+    taa_vec3x4* closest_out,
+    taa_vec4* dist2_out);
+
+/**
+ * @brief finds the closest points between a segment and four segments
+ * @details the query segment runs from p to q. c1_out receives the closest
+ *          points on the query segment and c2_out the closest points on
+ *          each segment of s. Zero length segments are treated as points.
+ */
+taa_INLINE static void taa_closest_segment_segmentx4(
+    const taa_vec4* p,
+    const taa_vec4* q,
+    const taa_segmentx4* s,
+    taa_vec3x4* c1_out,
+    taa_vec3x4* c2_out,
+    taa_vec4* dist2_out);
+
+/**
+ * @brief converts arrays of segment end points into structure of arrays
+ * @details s_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element repeat the last segment.
+ */
+taa_INLINE static void taa_segmentx4_from_points(
+    const taa_vec4* p,
+    const taa_vec4* q,
+    uint32_t n,
+    taa_segmentx4* s_out);
+
+//****************************************************************************
+taa_INLINE static void taa_closest_point_trianglex4(
+    const taa_vec4* p,
+    const taa_trianglex4* t,
+    taa_vec3x4* closest_out,
+    taa_vec4* dist2_out)
+{
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 ab[3];
+    taa_vpu_vec4 ac[3];
+    taa_vpu_vec4 a[3];
+    taa_vpu_vec4 pv[3];
+    taa_vpu_vec4 d1;
+    taa_vpu_vec4 d2;
+    taa_vpu_vec4 d3;
+    taa_vpu_vec4 d4;
+    taa_vpu_vec4 d5;
+    taa_vpu_vec4 d6;
+    taa_vpu_vec4 va;
+    taa_vpu_vec4 vb;
+    taa_vpu_vec4 vc;
+    taa_vpu_vec4 d43;
+    taa_vpu_vec4 d56;
+    taa_vpu_vec4 sv;
+    taa_vpu_vec4 tv;
+    taa_vpu_vec4 num;
+    taa_vpu_vec4 tmp;
+    taa_vpu_vec4 mask;
+    taa_vpu_vec4 dist2;
+    int i;
+    assert((((size_t) t) & 15) == 0);
+    assert((((size_t) closest_out) & 15) == 0);
+    assert((((size_t) dist2_out) & 15) == 0);
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_mov(zero, d1);
+    taa_vpu_mov(zero, d2);
+    taa_vpu_mov(zero, d3);
+    taa_vpu_mov(zero, d4);
+    taa_vpu_mov(zero, d5);
+    taa_vpu_mov(zero, d6);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 ap;
+        taa_vpu_set1((&p->x)[i], pv[i]);
+        taa_vpu_load(t->v0.x + i*4, a[i]);
+        taa_vpu_load(t->e1.x + i*4, ab[i]);
+        taa_vpu_load(t->e2.x + i*4, ac[i]);
+        taa_vpu_sub(pv[i], a[i], ap);
+        // d1 = ab.ap, d2 = ac.ap
+        taa_vpu_mul(ab[i], ap, tmp);
+        taa_vpu_add(d1, tmp, d1);
+        taa_vpu_mul(ac[i], ap, tmp);
+        taa_vpu_add(d2, tmp, d2);
+        // d3 = ab.bp, d4 = ac.bp, with bp = ap - ab
+        taa_vpu_sub(ap, ab[i], num);
+        taa_vpu_mul(ab[i], num, tmp);
+        taa_vpu_add(d3, tmp, d3);
+        taa_vpu_mul(ac[i], num, tmp);
+        taa_vpu_add(d4, tmp, d4);
+        // d5 = ab.cp, d6 = ac.cp, with cp = ap - ac
+        taa_vpu_sub(ap, ac[i], num);
+        taa_vpu_mul(ab[i], num, tmp);
+        taa_vpu_add(d5, tmp, d5);
+        taa_vpu_mul(ac[i], num, tmp);
+        taa_vpu_add(d6, tmp, d6);
+    }
+    taa_vpu_mul(d1, d4, vc);
+    taa_vpu_mul(d3, d2, tmp);
+    taa_vpu_sub(vc, tmp, vc);
+    taa_vpu_mul(d5, d2, vb);
+    taa_vpu_mul(d1, d6, tmp);
+    taa_vpu_sub(vb, tmp, vb);
+    taa_vpu_mul(d3, d6, va);
+    taa_vpu_mul(d5, d4, tmp);
+    taa_vpu_sub(va, tmp, va);
+    taa_vpu_sub(d4, d3, d43);
+    taa_vpu_sub(d5, d6, d56);
+    // the closest point is a + ab*s + ac*t. start with the interior and
+    // override it region by region, ending with the highest priority.
+    taa_vpu_add(va, vb, tmp);
+    taa_vpu_add(tmp, vc, tmp);
+    taa_vpu_div(vb, tmp, sv);
+    taa_vpu_div(vc, tmp, tv);
+    // edge bc: outside unless va <= 0, d4 - d3 >= 0, d5 - d6 >= 0
+    taa_vpu_cmpgt(va, zero, mask);
+    taa_vpu_cmpgt(zero, d43, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_cmpgt(zero, d56, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_add(d43, d56, tmp);
+    taa_vpu_div(d43, tmp, num);
+    taa_vpu_select(num, tv, mask, tv);
+    taa_vpu_sub(one, num, num);
+    taa_vpu_select(num, sv, mask, sv);
+    // edge ac: vb <= 0, d2 >= 0, d6 <= 0
+    taa_vpu_cmpgt(vb, zero, mask);
+    taa_vpu_cmpgt(zero, d2, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_cmpgt(d6, zero, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_sub(d2, d6, tmp);
+    taa_vpu_div(d2, tmp, num);
+    taa_vpu_select(num, tv, mask, tv);
+    taa_vpu_select(zero, sv, mask, sv);
+    // vertex c: d6 >= 0, d5 <= d6
+    taa_vpu_cmpgt(zero, d6, mask);
+    taa_vpu_cmpgt(d5, d6, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_select(one, tv, mask, tv);
+    taa_vpu_select(zero, sv, mask, sv);
+    // edge ab: vc <= 0, d1 >= 0, d3 <= 0
+    taa_vpu_cmpgt(vc, zero, mask);
+    taa_vpu_cmpgt(zero, d1, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_cmpgt(d3, zero, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_sub(d1, d3, tmp);
+    taa_vpu_div(d1, tmp, num);
+    taa_vpu_select(num, sv, mask, sv);
+    taa_vpu_select(zero, tv, mask, tv);
+    // vertex b: d3 >= 0, d4 <= d3
+    taa_vpu_cmpgt(zero, d3, mask);
+    taa_vpu_cmpgt(d4, d3, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_select(one, sv, mask, sv);
+    taa_vpu_select(zero, tv, mask, tv);
+    // vertex a: d1 <= 0, d2 <= 0
+    taa_vpu_cmpgt(d1, zero, mask);
+    taa_vpu_cmpgt(d2, zero, tmp);
+    taa_vpu_or(mask, tmp, mask);
+    taa_vpu_select(zero, sv, mask, sv);
+    taa_vpu_select(zero, tv, mask, tv);
+    taa_vpu_mov(zero, dist2);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 cp;
+        taa_vpu_mul(ab[i], sv, tmp);
+        taa_vpu_add(a[i], tmp, cp);
+        taa_vpu_mul(ac[i], tv, tmp);
+        taa_vpu_add(cp, tmp, cp);
+        taa_vpu_store(cp, closest_out->x + i*4);
+        taa_vpu_sub(pv[i], cp, tmp);
+        taa_vpu_mul(tmp, tmp, tmp);
+        taa_vpu_add(dist2, tmp, dist2);
+    }
+    taa_vpu_store(dist2, &dist2_out->x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_closest_segment_segmentx4(
+    const taa_vec4* p,
+    const taa_vec4* q,
+    const taa_segmentx4* s,
+    taa_vec3x4* c1_out,
+    taa_vec3x4* c2_out,
+    taa_vec4* dist2_out)
+{
+    float d1x = q->x - p->x;
+    float d1y = q->y - p->y;
+    float d1z = q->z - p->z;
+    float a = d1x*d1x + d1y*d1y + d1z*d1z;
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 tiny;
+    taa_vpu_vec4 va;
+    taa_vpu_vec4 d1[3];
+    taa_vpu_vec4 d2[3];
+    taa_vpu_vec4 p2[3];
+    taa_vpu_vec4 r[3];
+    taa_vpu_vec4 b;
+    taa_vpu_vec4 c;
+    taa_vpu_vec4 e;
+    taa_vpu_vec4 f;
+    taa_vpu_vec4 es;
+    taa_vpu_vec4 sv;
+    taa_vpu_vec4 tv;
+    taa_vpu_vec4 num;
+    taa_vpu_vec4 tmp;
+    taa_vpu_vec4 mask;
+    taa_vpu_vec4 dist2;
+    int i;
+    assert((((size_t) s) & 15) == 0);
+    assert((((size_t) c1_out) & 15) == 0);
+    assert((((size_t) c2_out) & 15) == 0);
+    assert((((size_t) dist2_out) & 15) == 0);
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_set1(FLT_MIN, tiny);
+    taa_vpu_set1((a > FLT_MIN) ? a : 1.0f, va);
+    taa_vpu_set1(d1x, d1[0]);
+    taa_vpu_set1(d1y, d1[1]);
+    taa_vpu_set1(d1z, d1[2]);
+    taa_vpu_set1(0.0f, b);
+    taa_vpu_set1(0.0f, c);
+    taa_vpu_set1(0.0f, e);
+    taa_vpu_set1(0.0f, f);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 p1;
+        taa_vpu_set1((&p->x)[i], p1);
+        taa_vpu_load(s->p.x + i*4, p2[i]);
+        taa_vpu_load(s->d.x + i*4, d2[i]);
+        taa_vpu_sub(p1, p2[i], r[i]);
+        // b = d1.d2, c = d1.r, e = d2.d2, f = d2.r
+        taa_vpu_mul(d1[i], d2[i], tmp);
+        taa_vpu_add(b, tmp, b);
+        taa_vpu_mul(d1[i], r[i], tmp);
+        taa_vpu_add(c, tmp, c);
+        taa_vpu_mul(d2[i], d2[i], tmp);
+        taa_vpu_add(e, tmp, e);
+        taa_vpu_mul(d2[i], r[i], tmp);
+        taa_vpu_add(f, tmp, f);
+    }
+    // substitute 1 for zero length segments to keep the divisions finite
+    taa_vpu_cmpgt(e, tiny, mask);
+    taa_vpu_select(one, e, mask, es);
+    if(a > FLT_MIN)
+    {
+        // s = (b*f - c*e) / (a*e - b*b), or 0 for parallel segments
+        taa_vpu_vec4 denom;
+        taa_vpu_vec4 eps;
+        taa_vpu_set1(FLT_EPSILON, eps);
+        taa_vpu_mul(b, f, num);
+        taa_vpu_mul(c, e, tmp);
+        taa_vpu_sub(num, tmp, num);
+        taa_vpu_mul(va, e, denom);
+        taa_vpu_mul(b, b, tmp);
+        taa_vpu_sub(denom, tmp, denom);
+        taa_vpu_mul(va, e, tmp);
+        taa_vpu_mul(tmp, eps, tmp);
+        taa_vpu_cmpgt(denom, tmp, mask);
+        taa_vpu_select(one, denom, mask, denom);
+        taa_vpu_div(num, denom, sv);
+        taa_vpu_max(sv, zero, sv);
+        taa_vpu_min(sv, one, sv);
+        taa_vpu_select(zero, sv, mask, sv);
+        // t = (b*s + f) / e, then clamp t and recompute s if it changed
+        taa_vpu_mul(b, sv, tv);
+        taa_vpu_add(tv, f, tv);
+        taa_vpu_div(tv, es, tv);
+        taa_vpu_max(tv, zero, tmp);
+        taa_vpu_min(tmp, one, tmp);
+        taa_vpu_cmpgt(tv, one, mask);
+        taa_vpu_cmpgt(zero, tv, num);
+        taa_vpu_or(mask, num, mask);
+        taa_vpu_mov(tmp, tv);
+        taa_vpu_mul(b, tv, num);
+        taa_vpu_sub(num, c, num);
+        taa_vpu_div(num, va, num);
+        taa_vpu_max(num, zero, num);
+        taa_vpu_min(num, one, num);
+        taa_vpu_select(sv, num, mask, sv);
+        // segments of s that are points: t = 0, s = -c/a
+        taa_vpu_cmpgt(e, tiny, mask);
+        taa_vpu_select(zero, tv, mask, tv);
+        taa_vpu_sub(zero, c, num);
+        taa_vpu_div(num, va, num);
+        taa_vpu_max(num, zero, num);
+        taa_vpu_min(num, one, num);
+        taa_vpu_select(num, sv, mask, sv);
+    }
+    else
+    {
+        // the query is a point: s = 0, t = f/e
+        taa_vpu_mov(zero, sv);
+        taa_vpu_div(f, es, tv);
+        taa_vpu_max(tv, zero, tv);
+        taa_vpu_min(tv, one, tv);
+        taa_vpu_cmpgt(e, tiny, mask);
+        taa_vpu_select(zero, tv, mask, tv);
+    }
+    taa_vpu_mov(zero, dist2);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 c1;
+        taa_vpu_vec4 c2;
+        taa_vpu_set1((&p->x)[i], c1);
+        taa_vpu_mul(d1[i], sv, tmp);
+        taa_vpu_add(c1, tmp, c1);
+        taa_vpu_mul(d2[i], tv, tmp);
+        taa_vpu_add(p2[i], tmp, c2);
+        taa_vpu_store(c1, c1_out->x + i*4);
+        taa_vpu_store(c2, c2_out->x + i*4);
+        taa_vpu_sub(c1, c2, tmp);
+        taa_vpu_mul(tmp, tmp, tmp);
+        taa_vpu_add(dist2, tmp, dist2);
+    }
+    taa_vpu_store(dist2, &dist2_out->x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_segmentx4_from_points(
+    const taa_vec4* p,
+    const taa_vec4* q,
+    uint32_t n,
+    taa_segmentx4* s_out)
+{
+    uint32_t i;
+    assert(n > 0);
+    for(i = 0; i < ((n + 3) & ~3); ++i)
+    {
+        uint32_t j = (i < n) ? i : n - 1;
+        taa_segmentx4* so = s_out + (i >> 2);
+        uint32_t lane = i & 3;
+        so->p.x[lane] = p[j].x;
+        so->p.y[lane] = p[j].y;
+        so->p.z[lane] = p[j].z;
+        so->d.x[lane] = q[j].x - p[j].x;
+        so->d.y[lane] = q[j].y - p[j].y;
+        so->d.z[lane] = q[j].z - p[j].z;
+    }
+}
+
+#endif // taa_CLOSEST_H_
@@ -0,0 +1,508 @@
+/**
+ * @brief     inlined dual quaternion functions header
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_DUALQUAT_H_
+#define taa_DUALQUAT_H_
+
+#include "mat44.h"
+#include "quat.h"
+#include "vec3x4.h"
+#include <assert.h>
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief converts a rigid transform matrix to a dual quaternion
+ * @details the upper 3x3 of m must be a rotation.
+ */
+taa_INLINE static void taa_dualquat_from_mat44(
+    const taa_mat44* m,
+    taa_dualquat* dq_out);
+
+/**
+ * @brief creates a dual quaternion from a rotation and a translation
+ * @details the w component of t is ignored.
+ */
+taa_INLINE static void taa_dualquat_from_rt(
+    const taa_quat* r,
+    const taa_vec4* t,
+    taa_dualquat* dq_out);
+
+/**
+ * @brief extracts the translation of a unit dual quaternion
+ * @details t_out.w is set to zero.
+ */
+taa_INLINE static void taa_dualquat_get_translate(
+    const taa_dualquat* a,
+    taa_vec4* t_out);
+
+taa_INLINE static void taa_dualquat_identity(
+    taa_dualquat* dq_out);
+
+/**
+ * @brief dual quaternion product
+ * @details out = a * b, transforming by b and then by a.
+ */
+taa_INLINE static void taa_dualquat_multiply(
+    const taa_dualquat* a,
+    const taa_dualquat* b,
+    taa_dualquat* dq_out);
+
+/**
+ * @brief scales a dual quaternion to unit length
+ * @details the dual part is also made orthogonal to the real part, so that
+ *          the result is a rigid transform. a and dq_out may be the same.
+ */
+taa_INLINE static void taa_dualquat_normalize(
+    const taa_dualquat* a,
+    taa_dualquat* dq_out);
+
+/**
+ * @brief dual quaternion blend skinning of an array of vertices
+ * @details each vertex is influenced by four bones. indices holds four bone
+ *          indices per vertex, and weights holds the matching four weights
+ *          in its x, y, z and w components. The bone dual quaternions are
+ *          blended with their signs matched to the running blend, then
+ *          normalized and applied to the position and the normal. Vertices
+ *          are processed four at a time in structure of arrays format.
+ *          nrm and nrm_out may both be NULL to skip normals. weights must
+ *          be 16 byte aligned.
+ */
+taa_INLINE static void taa_dualquat_skin_array(
+    const taa_dualquat* bones,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+taa_INLINE static void taa_dualquat_to_mat44(
+    const taa_dualquat* a,
+    taa_mat44* m_out);
+
+/**
+ * @brief transforms a point by a unit dual quaternion
+ */
+taa_INLINE static void taa_dualquat_transform_point(
+    const taa_dualquat* a,
+    const taa_vec3* b,
+    taa_vec3* v_out);
+
+/**
+ * @brief transforms a vector by a unit dual quaternion
+ * @details the translation is scaled by b.w, matching the result of
+ *          taa_mat44_transform_vec4 with the equivalent matrix.
+ */
+taa_INLINE static void taa_dualquat_transform_vec4(
+    const taa_dualquat* a,
+    const taa_vec4* b,
+    taa_vec4* v_out);
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_from_mat44(
+    const taa_mat44* m,
+    taa_dualquat* dq_out)
+{
+    taa_quat_from_mat44(m, &dq_out->real);
+    taa_dualquat_from_rt(&dq_out->real, &m->w, dq_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_from_rt(
+    const taa_quat* r,
+    const taa_vec4* t,
+    taa_dualquat* dq_out)
+{
+    taa_vpu_vec4 vr;
+    taa_vpu_vec4 vt;
+    taa_vpu_vec4 half;
+    assert((((size_t) r) & 15) == 0);
+    assert((((size_t) t) & 15) == 0);
+    assert((((size_t) dq_out) & 15) == 0);
+    taa_vpu_load(&r->x, vr);
+    taa_vpu_set(t->x, t->y, t->z, 0.0f, vt);
+    taa_vpu_set1(0.5f, half);
+    taa_vpu_quat_mul(vt, vr, vt);
+    taa_vpu_mul(vt, half, vt);
+    taa_vpu_store(vr, &dq_out->real.x);
+    taa_vpu_store(vt, &dq_out->dual.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_get_translate(
+    const taa_dualquat* a,
+    taa_vec4* t_out)
+{
+    // t = 2 * dual * conjugate(real)
+    taa_quat c;
+    taa_quat t;
+    taa_quat_conjugate(&a->real, &c);
+    taa_quat_multiply(&a->dual, &c, &t);
+    taa_vec4_set(2.0f*t.x, 2.0f*t.y, 2.0f*t.z, 0.0f, t_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_identity(
+    taa_dualquat* dq_out)
+{
+    taa_quat_identity(&dq_out->real);
+    taa_vec4_set(0.0f, 0.0f, 0.0f, 0.0f, &dq_out->dual);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_multiply(
+    const taa_dualquat* a,
+    const taa_dualquat* b,
+    taa_dualquat* dq_out)
+{
+    taa_vpu_vec4 ar;
+    taa_vpu_vec4 ad;
+    taa_vpu_vec4 br;
+    taa_vpu_vec4 bd;
+    taa_vpu_vec4 r;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 tmp;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) dq_out) & 15) == 0);
+    taa_vpu_load(&a->real.x, ar);
+    taa_vpu_load(&a->dual.x, ad);
+    taa_vpu_load(&b->real.x, br);
+    taa_vpu_load(&b->dual.x, bd);
+    taa_vpu_quat_mul(ar, br, r);
+    taa_vpu_quat_mul(ar, bd, d);
+    taa_vpu_quat_mul(ad, br, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_store(r, &dq_out->real.x);
+    taa_vpu_store(d, &dq_out->dual.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_normalize(
+    const taa_dualquat* a,
+    taa_dualquat* dq_out)
+{
+    taa_vpu_vec4 r;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 lensq;
+    taa_vpu_vec4 rd;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 tmp;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) dq_out) & 15) == 0);
+    taa_vpu_load(&a->real.x, r);
+    taa_vpu_load(&a->dual.x, d);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_dot(r, r, lensq);
+    taa_vpu_sqrt(lensq, tmp);
+    taa_vpu_div(one, tmp, tmp);
+    taa_vpu_mul(r, tmp, r);
+    taa_vpu_mul(d, tmp, d);
+    // remove the component of the dual part parallel to the real part
+    taa_vpu_dot(r, d, rd);
+    taa_vpu_mul(r, rd, tmp);
+    taa_vpu_sub(d, tmp, d);
+    taa_vpu_store(r, &dq_out->real.x);
+    taa_vpu_store(d, &dq_out->dual.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_skin_array(
+    const taa_dualquat* bones,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    const taa_vec3* pend = pos + n;
+    taa_vec3x4 p4;
+    taa_vec3x4 n4;
+    uint32_t i;
+    uint32_t k;
+    assert((((size_t) bones) & 15) == 0);
+    assert((((size_t) weights) & 15) == 0);
+    assert((nrm == NULL) == (nrm_out == NULL));
+    while(pos != pend)
+    {
+        uint32_t nlanes = (uint32_t) (pend - pos);
+        uint32_t lane[4];
+        taa_vpu_vec4 w[4];
+        taa_vpu_vec4 rx;
+        taa_vpu_vec4 ry;
+        taa_vpu_vec4 rz;
+        taa_vpu_vec4 rw;
+        taa_vpu_vec4 dx;
+        taa_vpu_vec4 dy;
+        taa_vpu_vec4 dz;
+        taa_vpu_vec4 dw;
+        taa_vpu_vec4 tx;
+        taa_vpu_vec4 ty;
+        taa_vpu_vec4 tz;
+        taa_vpu_vec4 cx;
+        taa_vpu_vec4 cy;
+        taa_vpu_vec4 cz;
+        taa_vpu_vec4 vx;
+        taa_vpu_vec4 vy;
+        taa_vpu_vec4 vz;
+        taa_vpu_vec4 zero;
+        taa_vpu_vec4 one;
+        taa_vpu_vec4 two;
+        taa_vpu_vec4 tmp;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        // unused lanes repeat the last vertex so that they stay finite
+        for(i = 0; i < 4; ++i)
+        {
+            lane[i] = (i < nlanes) ? i : nlanes - 1;
+        }
+        taa_vpu_set1(0.0f, zero);
+        taa_vpu_set1(1.0f, one);
+        taa_vpu_set1(2.0f, two);
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_load(&weights[lane[0]].x, c0);
+            taa_vpu_load(&weights[lane[1]].x, c1);
+            taa_vpu_load(&weights[lane[2]].x, c2);
+            taa_vpu_load(&weights[lane[3]].x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, w[0], w[1], w[2], w[3]);
+        }
+        taa_vpu_mov(zero, rx);
+        taa_vpu_mov(zero, ry);
+        taa_vpu_mov(zero, rz);
+        taa_vpu_mov(zero, rw);
+        taa_vpu_mov(zero, dx);
+        taa_vpu_mov(zero, dy);
+        taa_vpu_mov(zero, dz);
+        taa_vpu_mov(zero, dw);
+        // blend the four influences
+        for(k = 0; k < 4; ++k)
+        {
+            const taa_dualquat* b0 = bones + indices[lane[0]*4 + k];
+            const taa_dualquat* b1 = bones + indices[lane[1]*4 + k];
+            const taa_dualquat* b2 = bones + indices[lane[2]*4 + k];
+            const taa_dualquat* b3 = bones + indices[lane[3]*4 + k];
+            taa_vpu_vec4 qx;
+            taa_vpu_vec4 qy;
+            taa_vpu_vec4 qz;
+            taa_vpu_vec4 qw;
+            taa_vpu_vec4 ex;
+            taa_vpu_vec4 ey;
+            taa_vpu_vec4 ez;
+            taa_vpu_vec4 ew;
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 wk;
+            taa_vpu_vec4 mask;
+            taa_vpu_load(&b0->real.x, c0);
+            taa_vpu_load(&b1->real.x, c1);
+            taa_vpu_load(&b2->real.x, c2);
+            taa_vpu_load(&b3->real.x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, qx, qy, qz, qw);
+            taa_vpu_load(&b0->dual.x, c0);
+            taa_vpu_load(&b1->dual.x, c1);
+            taa_vpu_load(&b2->dual.x, c2);
+            taa_vpu_load(&b3->dual.x, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, ex, ey, ez, ew);
+            // flip the weight of bones in the opposite hemisphere
+            taa_vpu_mul(rx, qx, tmp);
+            taa_vpu_mul(ry, qy, mask);
+            taa_vpu_add(tmp, mask, tmp);
+            taa_vpu_mul(rz, qz, mask);
+            taa_vpu_add(tmp, mask, tmp);
+            taa_vpu_mul(rw, qw, mask);
+            taa_vpu_add(tmp, mask, tmp);
+            taa_vpu_cmpgt(zero, tmp, mask);
+            taa_vpu_neg(w[k], tmp);
+            taa_vpu_select(w[k], tmp, mask, wk);
+            taa_vpu_mul(qx, wk, qx);
+            taa_vpu_mul(qy, wk, qy);
+            taa_vpu_mul(qz, wk, qz);
+            taa_vpu_mul(qw, wk, qw);
+            taa_vpu_add(rx, qx, rx);
+            taa_vpu_add(ry, qy, ry);
+            taa_vpu_add(rz, qz, rz);
+            taa_vpu_add(rw, qw, rw);
+            taa_vpu_mul(ex, wk, ex);
+            taa_vpu_mul(ey, wk, ey);
+            taa_vpu_mul(ez, wk, ez);
+            taa_vpu_mul(ew, wk, ew);
+            taa_vpu_add(dx, ex, dx);
+            taa_vpu_add(dy, ey, dy);
+            taa_vpu_add(dz, ez, dz);
+            taa_vpu_add(dw, ew, dw);
+        }
+        // normalize by the length of the real part
+        taa_vpu_mul(rx, rx, tmp);
+        taa_vpu_mul(ry, ry, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_mul(rz, rz, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_mul(rw, rw, tx);
+        taa_vpu_add(tmp, tx, tmp);
+        taa_vpu_sqrt(tmp, tmp);
+        taa_vpu_div(one, tmp, tmp);
+        taa_vpu_mul(rx, tmp, rx);
+        taa_vpu_mul(ry, tmp, ry);
+        taa_vpu_mul(rz, tmp, rz);
+        taa_vpu_mul(rw, tmp, rw);
+        taa_vpu_mul(dx, tmp, dx);
+        taa_vpu_mul(dy, tmp, dy);
+        taa_vpu_mul(dz, tmp, dz);
+        taa_vpu_mul(dw, tmp, dw);
+        // t = 2 * (rw*d.xyz - dw*r.xyz + r.xyz X d.xyz)
+        taa_vpu_mul(ry, dz, tx);
+        taa_vpu_mul(rz, dy, tmp);
+        taa_vpu_sub(tx, tmp, tx);
+        taa_vpu_mul(rz, dx, ty);
+        taa_vpu_mul(rx, dz, tmp);
+        taa_vpu_sub(ty, tmp, ty);
+        taa_vpu_mul(rx, dy, tz);
+        taa_vpu_mul(ry, dx, tmp);
+        taa_vpu_sub(tz, tmp, tz);
+        taa_vpu_mul(rw, dx, tmp);
+        taa_vpu_add(tx, tmp, tx);
+        taa_vpu_mul(rw, dy, tmp);
+        taa_vpu_add(ty, tmp, ty);
+        taa_vpu_mul(rw, dz, tmp);
+        taa_vpu_add(tz, tmp, tz);
+        taa_vpu_mul(dw, rx, tmp);
+        taa_vpu_sub(tx, tmp, tx);
+        taa_vpu_mul(dw, ry, tmp);
+        taa_vpu_sub(ty, tmp, ty);
+        taa_vpu_mul(dw, rz, tmp);
+        taa_vpu_sub(tz, tmp, tz);
+        taa_vpu_mul(tx, two, tx);
+        taa_vpu_mul(ty, two, ty);
+        taa_vpu_mul(tz, two, tz);
+        // v' = v + 2*cross(r.xyz, cross(r.xyz, v) + rw*v) + t. the dual
+        // part is no longer needed, so d holds the outer cross product.
+        taa_vec3x4_from_vec3(pos, nlanes, &p4);
+        for(k = 0; k < 2; ++k)
+        {
+            taa_vec3x4* v4 = (k == 0) ? &p4 : &n4;
+            if(k == 1)
+            {
+                if(nrm == NULL)
+                {
+                    break;
+                }
+                taa_vec3x4_from_vec3(nrm, nlanes, &n4);
+            }
+            taa_vpu_load(v4->x, vx);
+            taa_vpu_load(v4->y, vy);
+            taa_vpu_load(v4->z, vz);
+            taa_vpu_mul(ry, vz, cx);
+            taa_vpu_mul(rz, vy, tmp);
+            taa_vpu_sub(cx, tmp, cx);
+            taa_vpu_mul(rw, vx, tmp);
+            taa_vpu_add(cx, tmp, cx);
+            taa_vpu_mul(rz, vx, cy);
+            taa_vpu_mul(rx, vz, tmp);
+            taa_vpu_sub(cy, tmp, cy);
+            taa_vpu_mul(rw, vy, tmp);
+            taa_vpu_add(cy, tmp, cy);
+            taa_vpu_mul(rx, vy, cz);
+            taa_vpu_mul(ry, vx, tmp);
+            taa_vpu_sub(cz, tmp, cz);
+            taa_vpu_mul(rw, vz, tmp);
+            taa_vpu_add(cz, tmp, cz);
+            taa_vpu_mul(ry, cz, dx);
+            taa_vpu_mul(rz, cy, tmp);
+            taa_vpu_sub(dx, tmp, dx);
+            taa_vpu_mul(rz, cx, dy);
+            taa_vpu_mul(rx, cz, tmp);
+            taa_vpu_sub(dy, tmp, dy);
+            taa_vpu_mul(rx, cy, dz);
+            taa_vpu_mul(ry, cx, tmp);
+            taa_vpu_sub(dz, tmp, dz);
+            taa_vpu_mul(dx, two, dx);
+            taa_vpu_mul(dy, two, dy);
+            taa_vpu_mul(dz, two, dz);
+            taa_vpu_add(vx, dx, vx);
+            taa_vpu_add(vy, dy, vy);
+            taa_vpu_add(vz, dz, vz);
+            if(k == 0)
+            {
+                taa_vpu_add(vx, tx, vx);
+                taa_vpu_add(vy, ty, vy);
+                taa_vpu_add(vz, tz, vz);
+            }
+            taa_vpu_store(vx, v4->x);
+            taa_vpu_store(vy, v4->y);
+            taa_vpu_store(vz, v4->z);
+        }
+        taa_vec3x4_to_vec3(&p4, nlanes, pos_out);
+        if(nrm != NULL)
+        {
+            taa_vec3x4_to_vec3(&n4, nlanes, nrm_out);
+            nrm += nlanes;
+            nrm_out += nlanes;
+        }
+        pos += nlanes;
+        pos_out += nlanes;
+        indices += nlanes*4;
+        weights += nlanes;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_to_mat44(
+    const taa_dualquat* a,
+    taa_mat44* m_out)
+{
+    taa_mat44_from_quat(&a->real, m_out);
+    taa_dualquat_get_translate(a, &m_out->w);
+    m_out->w.w = 1.0f;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_transform_point(
+    const taa_dualquat* a,
+    const taa_vec3* b,
+    taa_vec3* v_out)
+{
+    taa_vec4 v;
+    taa_vec4 r;
+    assert(b != v_out);
+    taa_vec4_set(b->x, b->y, b->z, 1.0f, &v);
+    taa_dualquat_transform_vec4(a, &v, &r);
+    v_out->x = r.x;
+    v_out->y = r.y;
+    v_out->z = r.z;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_dualquat_transform_vec4(
+    const taa_dualquat* a,
+    const taa_vec4* b,
+    taa_vec4* v_out)
+{
+    taa_vec4 t;
+    assert(b != v_out);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) v_out) & 15) == 0);
+    taa_dualquat_get_translate(a, &t);
+    taa_vpu_quat_rotate(
+        *((taa_vpu_vec4*) &a->real),
+        *((taa_vpu_vec4*) b),
+        *((taa_vpu_vec4*) v_out));
+    v_out->x += t.x*b->w;
+    v_out->y += t.y*b->w;
+    v_out->z += t.z*b->w;
+}
+
+#endif // taa_DUALQUAT_H_
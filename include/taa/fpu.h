@@ -69,6 +69,100 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
         taa_fpu_abs(c3_, c3_out_); \
     } while(0)
 
+//****************************************************************************
+#define taa_fpu_mat44_determinant(c0_, c1_, c2_, c3_, out_) \
+    do { \
+        float s0_ = (c0_).f32[0]*(c1_).f32[1] - (c1_).f32[0]*(c0_).f32[1]; \
+        float s1_ = (c0_).f32[0]*(c1_).f32[2] - (c1_).f32[0]*(c0_).f32[2]; \
+        float s2_ = (c0_).f32[0]*(c1_).f32[3] - (c1_).f32[0]*(c0_).f32[3]; \
+        float s3_ = (c0_).f32[1]*(c1_).f32[2] - (c1_).f32[1]*(c0_).f32[2]; \
+        float s4_ = (c0_).f32[1]*(c1_).f32[3] - (c1_).f32[1]*(c0_).f32[3]; \
+        float s5_ = (c0_).f32[2]*(c1_).f32[3] - (c1_).f32[2]*(c0_).f32[3]; \
+        float t0_ = (c2_).f32[0]*(c3_).f32[1] - (c3_).f32[0]*(c2_).f32[1]; \
+        float t1_ = (c2_).f32[0]*(c3_).f32[2] - (c3_).f32[0]*(c2_).f32[2]; \
+        float t2_ = (c2_).f32[0]*(c3_).f32[3] - (c3_).f32[0]*(c2_).f32[3]; \
+        float t3_ = (c2_).f32[1]*(c3_).f32[2] - (c3_).f32[1]*(c2_).f32[2]; \
+        float t4_ = (c2_).f32[1]*(c3_).f32[3] - (c3_).f32[1]*(c2_).f32[3]; \
+        float t5_ = (c2_).f32[2]*(c3_).f32[3] - (c3_).f32[2]*(c2_).f32[3]; \
+        float d_ = \
+            s0_*t5_ - s1_*t4_ + s2_*t3_ + s3_*t2_ - s4_*t1_ + s5_*t0_; \
+        (out_).f32[0] = d_; \
+        (out_).f32[1] = d_; \
+        (out_).f32[2] = d_; \
+        (out_).f32[3] = d_; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_mat44_inverse( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_) \
+    do { \
+        /* the columns are treated as the rows of the transpose, whose */ \
+        /* inverse rows are the columns of the inverse. the 2x2 minors */ \
+        /* of the first two and last two rows are shared by every */ \
+        /* cofactor and by the determinant. */ \
+        float s0_ = (c0_).f32[0]*(c1_).f32[1] - (c1_).f32[0]*(c0_).f32[1]; \
+        float s1_ = (c0_).f32[0]*(c1_).f32[2] - (c1_).f32[0]*(c0_).f32[2]; \
+        float s2_ = (c0_).f32[0]*(c1_).f32[3] - (c1_).f32[0]*(c0_).f32[3]; \
+        float s3_ = (c0_).f32[1]*(c1_).f32[2] - (c1_).f32[1]*(c0_).f32[2]; \
+        float s4_ = (c0_).f32[1]*(c1_).f32[3] - (c1_).f32[1]*(c0_).f32[3]; \
+        float s5_ = (c0_).f32[2]*(c1_).f32[3] - (c1_).f32[2]*(c0_).f32[3]; \
+        float t0_ = (c2_).f32[0]*(c3_).f32[1] - (c3_).f32[0]*(c2_).f32[1]; \
+        float t1_ = (c2_).f32[0]*(c3_).f32[2] - (c3_).f32[0]*(c2_).f32[2]; \
+        float t2_ = (c2_).f32[0]*(c3_).f32[3] - (c3_).f32[0]*(c2_).f32[3]; \
+        float t3_ = (c2_).f32[1]*(c3_).f32[2] - (c3_).f32[1]*(c2_).f32[2]; \
+        float t4_ = (c2_).f32[1]*(c3_).f32[3] - (c3_).f32[1]*(c2_).f32[3]; \
+        float t5_ = (c2_).f32[2]*(c3_).f32[3] - (c3_).f32[2]*(c2_).f32[3]; \
+        float d_ = \
+            s0_*t5_ - s1_*t4_ + s2_*t3_ + s3_*t2_ - s4_*t1_ + s5_*t0_; \
+        float r_ = 1.0f/d_; \
+        taa_fpu_vec4 m0_; \
+        taa_fpu_vec4 m1_; \
+        taa_fpu_vec4 m2_; \
+        taa_fpu_vec4 m3_; \
+        m0_.f32[0] = \
+            ( (c1_).f32[1]*t5_ - (c1_).f32[2]*t4_ + (c1_).f32[3]*t3_)*r_; \
+        m0_.f32[1] = \
+            (-(c0_).f32[1]*t5_ + (c0_).f32[2]*t4_ - (c0_).f32[3]*t3_)*r_; \
+        m0_.f32[2] = \
+            ( (c3_).f32[1]*s5_ - (c3_).f32[2]*s4_ + (c3_).f32[3]*s3_)*r_; \
+        m0_.f32[3] = \
+            (-(c2_).f32[1]*s5_ + (c2_).f32[2]*s4_ - (c2_).f32[3]*s3_)*r_; \
+        m1_.f32[0] = \
+            (-(c1_).f32[0]*t5_ + (c1_).f32[2]*t2_ - (c1_).f32[3]*t1_)*r_; \
+        m1_.f32[1] = \
+            ( (c0_).f32[0]*t5_ - (c0_).f32[2]*t2_ + (c0_).f32[3]*t1_)*r_; \
+        m1_.f32[2] = \
+            (-(c3_).f32[0]*s5_ + (c3_).f32[2]*s2_ - (c3_).f32[3]*s1_)*r_; \
+        m1_.f32[3] = \
+            ( (c2_).f32[0]*s5_ - (c2_).f32[2]*s2_ + (c2_).f32[3]*s1_)*r_; \
+        m2_.f32[0] = \
+            ( (c1_).f32[0]*t4_ - (c1_).f32[1]*t2_ + (c1_).f32[3]*t0_)*r_; \
+        m2_.f32[1] = \
+            (-(c0_).f32[0]*t4_ + (c0_).f32[1]*t2_ - (c0_).f32[3]*t0_)*r_; \
+        m2_.f32[2] = \
+            ( (c3_).f32[0]*s4_ - (c3_).f32[1]*s2_ + (c3_).f32[3]*s0_)*r_; \
+        m2_.f32[3] = \
+            (-(c2_).f32[0]*s4_ + (c2_).f32[1]*s2_ - (c2_).f32[3]*s0_)*r_; \
+        m3_.f32[0] = \
+            (-(c1_).f32[0]*t3_ + (c1_).f32[1]*t1_ - (c1_).f32[2]*t0_)*r_; \
+        m3_.f32[1] = \
+            ( (c0_).f32[0]*t3_ - (c0_).f32[1]*t1_ + (c0_).f32[2]*t0_)*r_; \
+        m3_.f32[2] = \
+            (-(c3_).f32[0]*s3_ + (c3_).f32[1]*s1_ - (c3_).f32[2]*s0_)*r_; \
+        m3_.f32[3] = \
+            ( (c2_).f32[0]*s3_ - (c2_).f32[1]*s1_ + (c2_).f32[2]*s0_)*r_; \
+        (c0_out_) = m0_; \
+        (c1_out_) = m1_; \
+        (c2_out_) = m2_; \
+        (c3_out_) = m3_; \
+        (det_out_).f32[0] = d_; \
+        (det_out_).f32[1] = d_; \
+        (det_out_).f32[2] = d_; \
+        (det_out_).f32[3] = d_; \
+    } while(0)
+
 //****************************************************************************
 #define taa_fpu_mat44_mul_vec4(c0_, c1_, c2_, c3_, v_, out_) \
     do { \
@@ -147,10 +241,10 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
 //****************************************************************************
 #define taa_fpu_cmpagt(a_, b_, out_) \
     do { \
-        (out_).u32[0] = (fabs(a_.f32[0]) > fabs(b_.f32[0])) * 0xffffffff; \
-        (out_).u32[1] = (fabs(a_.f32[1]) > fabs(b_.f32[1])) * 0xffffffff; \
-        (out_).u32[2] = (fabs(a_.f32[2]) > fabs(b_.f32[2])) * 0xffffffff; \
-        (out_).u32[3] = (fabs(a_.f32[3]) > fabs(b_.f32[3])) * 0xffffffff; \
+        (out_).u32[0] = (fabs((a_).f32[0]) > fabs((b_).f32[0])) * 0xffffffff; \
+        (out_).u32[1] = (fabs((a_).f32[1]) > fabs((b_).f32[1])) * 0xffffffff; \
+        (out_).u32[2] = (fabs((a_).f32[2]) > fabs((b_).f32[2])) * 0xffffffff; \
+        (out_).u32[3] = (fabs((a_).f32[3]) > fabs((b_).f32[3])) * 0xffffffff; \
     } while(0)
 
 //****************************************************************************
@@ -203,6 +297,52 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
         (out_).f32[3] = (pa_)[3]; \
     } while(0)
 
+//****************************************************************************
+#define taa_fpu_load3(pa_, out_) \
+    do { \
+        (out_).f32[0] = (pa_)[0]; \
+        (out_).f32[1] = (pa_)[1]; \
+        (out_).f32[2] = (pa_)[2]; \
+        (out_).f32[3] = 0.0f; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_load3x4(pa_, x_out_, y_out_, z_out_) \
+    do { \
+        (x_out_).f32[0] = (pa_)[ 0]; \
+        (y_out_).f32[0] = (pa_)[ 1]; \
+        (z_out_).f32[0] = (pa_)[ 2]; \
+        (x_out_).f32[1] = (pa_)[ 3]; \
+        (y_out_).f32[1] = (pa_)[ 4]; \
+        (z_out_).f32[1] = (pa_)[ 5]; \
+        (x_out_).f32[2] = (pa_)[ 6]; \
+        (y_out_).f32[2] = (pa_)[ 7]; \
+        (z_out_).f32[2] = (pa_)[ 8]; \
+        (x_out_).f32[3] = (pa_)[ 9]; \
+        (y_out_).f32[3] = (pa_)[10]; \
+        (z_out_).f32[3] = (pa_)[11]; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_load4x4(pa_, x_out_, y_out_, z_out_, w_out_) \
+    do { \
+        taa_fpu_vec4 c0_; \
+        taa_fpu_vec4 c1_; \
+        taa_fpu_vec4 c2_; \
+        taa_fpu_vec4 c3_; \
+        taa_fpu_load((pa_)     , c0_); \
+        taa_fpu_load((pa_) +  4, c1_); \
+        taa_fpu_load((pa_) +  8, c2_); \
+        taa_fpu_load((pa_) + 12, c3_); \
+        taa_fpu_mat44_transpose( \
+            c0_,c1_,c2_,c3_, \
+            x_out_,y_out_,z_out_,w_out_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_loadu(pa_, out_) \
+    taa_fpu_load(pa_, out_)
+
 //****************************************************************************
 #define taa_fpu_max(a_, b_, out_) \
     do { \
@@ -224,6 +364,14 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
 #define taa_fpu_mov(a_, out_) \
     ((out_) = (a_))
 
+//****************************************************************************
+#define taa_fpu_movemask(a_, out_) \
+    ((out_) = (int) ( \
+        (((a_).u32[0] >> 31)     ) | \
+        (((a_).u32[1] >> 31) << 1) | \
+        (((a_).u32[2] >> 31) << 2) | \
+        (((a_).u32[3] >> 31) << 3)))
+
 //****************************************************************************
 #define taa_fpu_mul(a_, b_, out_) \
     do { \
@@ -265,6 +413,47 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
         (out_).u32[3] = (a_).u32[3] | (b_).u32[3]; \
     } while(0)
 
+//****************************************************************************
+#define taa_fpu_quat_mul(a_, b_, out_) \
+    do { \
+        float x_ = \
+            (a_).f32[3]*(b_).f32[0] + (a_).f32[0]*(b_).f32[3] + \
+            (a_).f32[1]*(b_).f32[2] - (a_).f32[2]*(b_).f32[1]; \
+        float y_ = \
+            (a_).f32[3]*(b_).f32[1] - (a_).f32[0]*(b_).f32[2] + \
+            (a_).f32[1]*(b_).f32[3] + (a_).f32[2]*(b_).f32[0]; \
+        float z_ = \
+            (a_).f32[3]*(b_).f32[2] + (a_).f32[0]*(b_).f32[1] - \
+            (a_).f32[1]*(b_).f32[0] + (a_).f32[2]*(b_).f32[3]; \
+        float w_ = \
+            (a_).f32[3]*(b_).f32[3] - (a_).f32[0]*(b_).f32[0] - \
+            (a_).f32[1]*(b_).f32[1] - (a_).f32[2]*(b_).f32[2]; \
+        (out_).f32[0] = x_; \
+        (out_).f32[1] = y_; \
+        (out_).f32[2] = z_; \
+        (out_).f32[3] = w_; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_quat_rotate(q_, v_, out_) \
+    do { \
+        /* t = cross(q, v) + q.w*v */ \
+        float tx_ = (q_).f32[1]*(v_).f32[2] - (q_).f32[2]*(v_).f32[1] + \
+                    (q_).f32[3]*(v_).f32[0]; \
+        float ty_ = (q_).f32[2]*(v_).f32[0] - (q_).f32[0]*(v_).f32[2] + \
+                    (q_).f32[3]*(v_).f32[1]; \
+        float tz_ = (q_).f32[0]*(v_).f32[1] - (q_).f32[1]*(v_).f32[0] + \
+                    (q_).f32[3]*(v_).f32[2]; \
+        /* out = v + 2*cross(q, t) */ \
+        float x_ = (v_).f32[0] + 2.0f*((q_).f32[1]*tz_ - (q_).f32[2]*ty_); \
+        float y_ = (v_).f32[1] + 2.0f*((q_).f32[2]*tx_ - (q_).f32[0]*tz_); \
+        float z_ = (v_).f32[2] + 2.0f*((q_).f32[0]*ty_ - (q_).f32[1]*tx_); \
+        (out_).f32[0] = x_; \
+        (out_).f32[1] = y_; \
+        (out_).f32[2] = z_; \
+        (out_).f32[3] = (v_).f32[3]; \
+    } while(0)
+
 //****************************************************************************
 #define taa_fpu_rsqrt(a_, out_) \
     do { \
@@ -274,6 +463,19 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
         (out_).f32[3] = 1.0f/((float) sqrt((a_).f32[3])); \
     } while(0)
 
+//****************************************************************************
+#define taa_fpu_select(a_, b_, mask_, out_) \
+    do { \
+        (out_).u32[0] = ((a_).u32[0] & ~(mask_).u32[0]) | \
+                        ((b_).u32[0] &  (mask_).u32[0]); \
+        (out_).u32[1] = ((a_).u32[1] & ~(mask_).u32[1]) | \
+                        ((b_).u32[1] &  (mask_).u32[1]); \
+        (out_).u32[2] = ((a_).u32[2] & ~(mask_).u32[2]) | \
+                        ((b_).u32[2] &  (mask_).u32[2]); \
+        (out_).u32[3] = ((a_).u32[3] & ~(mask_).u32[3]) | \
+                        ((b_).u32[3] &  (mask_).u32[3]); \
+    } while(0)
+
 //****************************************************************************
 #define taa_fpu_set(x_, y_, z_, w_, out_) \
     do { \
@@ -310,6 +512,15 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
         (out_).f32[3] = (b_).f32[0]; \
     } while(0)
 
+//****************************************************************************
+#define taa_fpu_sqrt(a_, out_) \
+    do { \
+        (out_).f32[0] = (float) sqrt((a_).f32[0]); \
+        (out_).f32[1] = (float) sqrt((a_).f32[1]); \
+        (out_).f32[2] = (float) sqrt((a_).f32[2]); \
+        (out_).f32[3] = (float) sqrt((a_).f32[3]); \
+    } while(0)
+
 //****************************************************************************
 #define taa_fpu_store(a_, out_) \
     do { \
@@ -323,6 +534,61 @@ union taa_DECLSPEC_ALIGN(16) taa_fpu_u
 #define taa_fpu_store1(a_, out_) \
     (*(out_) = (a_).f32[0])
 
+//****************************************************************************
+#define taa_fpu_store3(a_, out_) \
+    do { \
+        (out_)[0] = (a_).f32[0]; \
+        (out_)[1] = (a_).f32[1]; \
+        (out_)[2] = (a_).f32[2]; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_store3x4(x_, y_, z_, out_) \
+    do { \
+        (out_)[ 0] = (x_).f32[0]; \
+        (out_)[ 1] = (y_).f32[0]; \
+        (out_)[ 2] = (z_).f32[0]; \
+        (out_)[ 3] = (x_).f32[1]; \
+        (out_)[ 4] = (y_).f32[1]; \
+        (out_)[ 5] = (z_).f32[1]; \
+        (out_)[ 6] = (x_).f32[2]; \
+        (out_)[ 7] = (y_).f32[2]; \
+        (out_)[ 8] = (z_).f32[2]; \
+        (out_)[ 9] = (x_).f32[3]; \
+        (out_)[10] = (y_).f32[3]; \
+        (out_)[11] = (z_).f32[3]; \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_store4x4(x_, y_, z_, w_, out_) \
+    do { \
+        taa_fpu_vec4 c0_; \
+        taa_fpu_vec4 c1_; \
+        taa_fpu_vec4 c2_; \
+        taa_fpu_vec4 c3_; \
+        taa_fpu_mat44_transpose(x_,y_,z_,w_, c0_,c1_,c2_,c3_); \
+        taa_fpu_store(c0_, (out_)     ); \
+        taa_fpu_store(c1_, (out_) +  4); \
+        taa_fpu_store(c2_, (out_) +  8); \
+        taa_fpu_store(c3_, (out_) + 12); \
+    } while(0)
+
+//****************************************************************************
+#define taa_fpu_storeu(a_, out_) \
+    taa_fpu_store(a_, out_)
+
+//****************************************************************************
+#define taa_fpu_stream(a_, out_) \
+    taa_fpu_store(a_, out_)
+
+//****************************************************************************
+#define taa_fpu_stream3x4(x_, y_, z_, out_) \
+    taa_fpu_store3x4(x_, y_, z_, out_)
+
+//****************************************************************************
+#define taa_fpu_stream_fence() \
+    ((void) 0)
+
 //****************************************************************************
 #define taa_fpu_sub(a_, b_, out_) \
     do { \
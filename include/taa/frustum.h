@@ -0,0 +1,417 @@
+/**
+ * @brief     inlined view frustum culling functions header
+ * @details   the cull functions test four bounding volumes at a time, one
+ *            per lane, against each plane in turn. Results are written as a
+ *            bit mask with one bit per volume, set if the volume is at least
+ *            partially inside the frustum. The tests are conservative: a
+ *            volume near a frustum corner may be reported visible when it
+ *            is not.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_FRUSTUM_H_
+#define taa_FRUSTUM_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+
+enum
+{
+    taa_FRUSTUM_LEFT,
+    taa_FRUSTUM_RIGHT,
+    taa_FRUSTUM_BOTTOM,
+    taa_FRUSTUM_TOP,
+    taa_FRUSTUM_NEAR,
+    taa_FRUSTUM_FAR,
+    taa_FRUSTUM_NUM_PLANES
+};
+
+typedef struct taa_frustum_s taa_frustum;
+
+/**
+ * @brief six frustum planes in structure of arrays format
+ * @details plane i is (x[i], y[i], z[i], w[i]), with a unit length normal
+ *          pointing into the frustum. A point p is inside the plane when
+ *          dot(p.xyz, n) + w >= 0. The last two lanes repeat the far plane.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_frustum_s
+{
+    float x[8];
+    float y[8];
+    float z[8];
+    float w[8];
+} taa_ATTRIB_ALIGN(16);
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief tests an array of axis aligned boxes against a frustum
+ * @details each box is given by its center and its half size along each
+ *          axis. The w components are ignored. mask_out must have room for
+ *          (n + 31)/32 elements. center and extent must be 16 byte aligned.
+ */
+taa_INLINE static void taa_frustum_cull_aabbs(
+    const taa_frustum* f,
+    const taa_vec4* center,
+    const taa_vec4* extent,
+    uint32_t n,
+    uint32_t* mask_out);
+
+/**
+ * @brief tests an array of oriented boxes against a frustum
+ * @details each box is the transform of the cube from -1 to 1 by a matrix,
+ *          so the x, y and z columns are the half axes of the box and the w
+ *          column is its center. mask_out must have room for (n + 31)/32
+ *          elements.
+ */
+taa_INLINE static void taa_frustum_cull_obbs(
+    const taa_frustum* f,
+    const taa_mat44* obbs,
+    uint32_t n,
+    uint32_t* mask_out);
+
+/**
+ * @brief tests an array of bounding spheres against a frustum
+ * @details the xyz components of each sphere are the center and the w
+ *          component is the radius. mask_out must have room for
+ *          (n + 31)/32 elements. spheres must be 16 byte aligned.
+ */
+taa_INLINE static void taa_frustum_cull_spheres(
+    const taa_frustum* f,
+    const taa_vec4* spheres,
+    uint32_t n,
+    uint32_t* mask_out);
+
+/**
+ * @brief extracts the normalized planes of a view projection matrix
+ * @details depth_zero_to_one selects the clip space depth range; zero for
+ *          the OpenGL -w to w range, nonzero for the 0 to w range used by
+ *          the reversed projections. Infinite projections produce a far
+ *          plane that contains every point.
+ */
+taa_INLINE static void taa_frustum_from_mat44(
+    const taa_mat44* m,
+    int depth_zero_to_one,
+    taa_frustum* f_out);
+
+/**
+ * @brief converts a visibility mask into a list of the visible indices
+ * @details the loop is branchless: every element is written at the current
+ *          count, and the count only advances for visible elements. So
+ *          indices_out must hold n entries, not just the number of visible
+ *          elements. Entries past the returned count are overwritten with
+ *          scratch values.
+ * @return the number of visible indices at the start of indices_out
+ */
+taa_INLINE static uint32_t taa_frustum_mask_to_indices(
+    const uint32_t* mask,
+    uint32_t n,
+    uint32_t* indices_out);
+
+//****************************************************************************
+taa_INLINE static void taa_frustum_cull_aabbs(
+    const taa_frustum* f,
+    const taa_vec4* center,
+    const taa_vec4* extent,
+    uint32_t n,
+    uint32_t* mask_out)
+{
+    taa_vpu_vec4 px[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 py[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pz[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pw[taa_FRUSTUM_NUM_PLANES];
+    uint32_t i;
+    uint32_t p;
+    assert((((size_t) f) & 15) == 0);
+    assert((((size_t) center) & 15) == 0);
+    assert((((size_t) extent) & 15) == 0);
+    for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+    {
+        taa_vpu_set1(f->x[p], px[p]);
+        taa_vpu_set1(f->y[p], py[p]);
+        taa_vpu_set1(f->z[p], pz[p]);
+        taa_vpu_set1(f->w[p], pw[p]);
+    }
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        uint32_t i1 = i + ((nlanes > 1) ? 1 : 0);
+        uint32_t i2 = i + ((nlanes > 2) ? 2 : nlanes - 1);
+        uint32_t i3 = i + nlanes - 1;
+        taa_vpu_vec4 cx;
+        taa_vpu_vec4 cy;
+        taa_vpu_vec4 cz;
+        taa_vpu_vec4 ex;
+        taa_vpu_vec4 ey;
+        taa_vpu_vec4 ez;
+        taa_vpu_vec4 w;
+        taa_vpu_vec4 c0;
+        taa_vpu_vec4 c1;
+        taa_vpu_vec4 c2;
+        taa_vpu_vec4 c3;
+        taa_vpu_vec4 outside;
+        int bits;
+        // unused lanes repeat the last box
+        taa_vpu_load(&center[i ].x, c0);
+        taa_vpu_load(&center[i1].x, c1);
+        taa_vpu_load(&center[i2].x, c2);
+        taa_vpu_load(&center[i3].x, c3);
+        taa_vpu_mat44_transpose(c0, c1, c2, c3, cx, cy, cz, w);
+        taa_vpu_load(&extent[i ].x, c0);
+        taa_vpu_load(&extent[i1].x, c1);
+        taa_vpu_load(&extent[i2].x, c2);
+        taa_vpu_load(&extent[i3].x, c3);
+        taa_vpu_mat44_transpose(c0, c1, c2, c3, ex, ey, ez, w);
+        (void) w;
+        taa_vpu_set1(0.0f, outside);
+        for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+        {
+            // outside if dot(n, c) + w < -dot(abs(n), e)
+            taa_vpu_vec4 d;
+            taa_vpu_vec4 r;
+            taa_vpu_vec4 tmp;
+            taa_vpu_mul(px[p], cx, d);
+            taa_vpu_mul(py[p], cy, tmp);
+            taa_vpu_add(d, tmp, d);
+            taa_vpu_mul(pz[p], cz, tmp);
+            taa_vpu_add(d, tmp, d);
+            taa_vpu_add(d, pw[p], d);
+            taa_vpu_abs(px[p], r);
+            taa_vpu_mul(r, ex, r);
+            taa_vpu_abs(py[p], tmp);
+            taa_vpu_mul(tmp, ey, tmp);
+            taa_vpu_add(r, tmp, r);
+            taa_vpu_abs(pz[p], tmp);
+            taa_vpu_mul(tmp, ez, tmp);
+            taa_vpu_add(r, tmp, r);
+            taa_vpu_add(d, r, d);
+            taa_vpu_set1(0.0f, tmp);
+            taa_vpu_cmpgt(tmp, d, tmp);
+            taa_vpu_or(outside, tmp, outside);
+        }
+        taa_vpu_movemask(outside, bits);
+        bits = ~bits & ((1 << nlanes) - 1);
+        mask_out[i >> 5] = ((i & 31) != 0) ? mask_out[i >> 5] : 0;
+        mask_out[i >> 5] |= ((uint32_t) bits) << (i & 31);
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_frustum_cull_obbs(
+    const taa_frustum* f,
+    const taa_mat44* obbs,
+    uint32_t n,
+    uint32_t* mask_out)
+{
+    taa_vpu_vec4 px[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 py[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pz[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pw[taa_FRUSTUM_NUM_PLANES];
+    uint32_t i;
+    uint32_t j;
+    uint32_t p;
+    assert((((size_t) f) & 15) == 0);
+    assert((((size_t) obbs) & 15) == 0);
+    for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+    {
+        taa_vpu_set1(f->x[p], px[p]);
+        taa_vpu_set1(f->y[p], py[p]);
+        taa_vpu_set1(f->z[p], pz[p]);
+        taa_vpu_set1(f->w[p], pw[p]);
+    }
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        const float* m0 = &obbs[i].x.x;
+        const float* m1 = &obbs[i + ((nlanes > 1) ? 1 : 0)].x.x;
+        const float* m2 = &obbs[i + ((nlanes > 2) ? 2 : nlanes - 1)].x.x;
+        const float* m3 = &obbs[i + nlanes - 1].x.x;
+        // c[j*3 + k] is component k of column j for each lane
+        taa_vpu_vec4 c[12];
+        taa_vpu_vec4 outside;
+        int bits;
+        for(j = 0; j < 4; ++j)
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 unused;
+            taa_vpu_load(m0 + j*4, c0);
+            taa_vpu_load(m1 + j*4, c1);
+            taa_vpu_load(m2 + j*4, c2);
+            taa_vpu_load(m3 + j*4, c3);
+            taa_vpu_mat44_transpose(
+                c0, c1, c2, c3,
+                c[j*3 + 0], c[j*3 + 1], c[j*3 + 2], unused);
+            (void) unused;
+        }
+        taa_vpu_set1(0.0f, outside);
+        for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+        {
+            // outside if dot(n, c) + w < -sum(abs(dot(n, axis)))
+            taa_vpu_vec4 d;
+            taa_vpu_vec4 r;
+            taa_vpu_vec4 tmp;
+            taa_vpu_set1(0.0f, r);
+            for(j = 0; j < 4; ++j)
+            {
+                taa_vpu_mul(px[p], c[j*3 + 0], d);
+                taa_vpu_mul(py[p], c[j*3 + 1], tmp);
+                taa_vpu_add(d, tmp, d);
+                taa_vpu_mul(pz[p], c[j*3 + 2], tmp);
+                taa_vpu_add(d, tmp, d);
+                if(j < 3)
+                {
+                    taa_vpu_abs(d, d);
+                    taa_vpu_add(r, d, r);
+                }
+            }
+            taa_vpu_add(d, pw[p], d);
+            taa_vpu_add(d, r, d);
+            taa_vpu_set1(0.0f, tmp);
+            taa_vpu_cmpgt(tmp, d, tmp);
+            taa_vpu_or(outside, tmp, outside);
+        }
+        taa_vpu_movemask(outside, bits);
+        bits = ~bits & ((1 << nlanes) - 1);
+        mask_out[i >> 5] = ((i & 31) != 0) ? mask_out[i >> 5] : 0;
+        mask_out[i >> 5] |= ((uint32_t) bits) << (i & 31);
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_frustum_cull_spheres(
+    const taa_frustum* f,
+    const taa_vec4* spheres,
+    uint32_t n,
+    uint32_t* mask_out)
+{
+    taa_vpu_vec4 px[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 py[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pz[taa_FRUSTUM_NUM_PLANES];
+    taa_vpu_vec4 pw[taa_FRUSTUM_NUM_PLANES];
+    uint32_t i;
+    uint32_t p;
+    assert((((size_t) f) & 15) == 0);
+    assert((((size_t) spheres) & 15) == 0);
+    for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+    {
+        taa_vpu_set1(f->x[p], px[p]);
+        taa_vpu_set1(f->y[p], py[p]);
+        taa_vpu_set1(f->z[p], pz[p]);
+        taa_vpu_set1(f->w[p], pw[p]);
+    }
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        taa_vpu_vec4 cx;
+        taa_vpu_vec4 cy;
+        taa_vpu_vec4 cz;
+        taa_vpu_vec4 r;
+        taa_vpu_vec4 c0;
+        taa_vpu_vec4 c1;
+        taa_vpu_vec4 c2;
+        taa_vpu_vec4 c3;
+        taa_vpu_vec4 outside;
+        int bits;
+        // unused lanes repeat the last sphere
+        taa_vpu_load(&spheres[i].x, c0);
+        taa_vpu_load(&spheres[i + ((nlanes > 1) ? 1 : 0)].x, c1);
+        taa_vpu_load(&spheres[i + ((nlanes > 2) ? 2 : nlanes - 1)].x, c2);
+        taa_vpu_load(&spheres[i + nlanes - 1].x, c3);
+        taa_vpu_mat44_transpose(c0, c1, c2, c3, cx, cy, cz, r);
+        taa_vpu_neg(r, r);
+        taa_vpu_set1(0.0f, outside);
+        for(p = 0; p < taa_FRUSTUM_NUM_PLANES; ++p)
+        {
+            // outside if dot(n, c) + w < -r
+            taa_vpu_vec4 d;
+            taa_vpu_vec4 tmp;
+            taa_vpu_mul(px[p], cx, d);
+            taa_vpu_mul(py[p], cy, tmp);
+            taa_vpu_add(d, tmp, d);
+            taa_vpu_mul(pz[p], cz, tmp);
+            taa_vpu_add(d, tmp, d);
+            taa_vpu_add(d, pw[p], d);
+            taa_vpu_cmpgt(r, d, tmp);
+            taa_vpu_or(outside, tmp, outside);
+        }
+        taa_vpu_movemask(outside, bits);
+        bits = ~bits & ((1 << nlanes) - 1);
+        mask_out[i >> 5] = ((i & 31) != 0) ? mask_out[i >> 5] : 0;
+        mask_out[i >> 5] |= ((uint32_t) bits) << (i & 31);
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_frustum_from_mat44(
+    const taa_mat44* m,
+    int depth_zero_to_one,
+    taa_frustum* f_out)
+{
+    // rows of the matrix
+    const float* r0 = &m->x.x;
+    const float* r1 = &m->x.y;
+    const float* r2 = &m->x.z;
+    const float* r3 = &m->x.w;
+    float zn = (depth_zero_to_one) ? 0.0f : 1.0f;
+    uint32_t i;
+    uint32_t j;
+    for(j = 0; j < 4; ++j)
+    {
+        float* dst = f_out->x + j*8;
+        // the rows are strided by four floats
+        float a = r0[j*4];
+        float b = r1[j*4];
+        float c = r2[j*4];
+        float d = r3[j*4];
+        dst[taa_FRUSTUM_LEFT] = d + a;
+        dst[taa_FRUSTUM_RIGHT] = d - a;
+        dst[taa_FRUSTUM_BOTTOM] = d + b;
+        dst[taa_FRUSTUM_TOP] = d - b;
+        dst[taa_FRUSTUM_NEAR] = d*zn + c;
+        dst[taa_FRUSTUM_FAR] = d - c;
+    }
+    for(i = 0; i < taa_FRUSTUM_NUM_PLANES; ++i)
+    {
+        float x = f_out->x[i];
+        float y = f_out->y[i];
+        float z = f_out->z[i];
+        float len = sqrtf(x*x + y*y + z*z);
+        float s = (len > 0.0f) ? 1.0f/len : 1.0f;
+        f_out->x[i] = x * s;
+        f_out->y[i] = y * s;
+        f_out->z[i] = z * s;
+        f_out->w[i] = f_out->w[i] * s;
+    }
+    for(i = taa_FRUSTUM_NUM_PLANES; i < 8; ++i)
+    {
+        f_out->x[i] = f_out->x[taa_FRUSTUM_FAR];
+        f_out->y[i] = f_out->y[taa_FRUSTUM_FAR];
+        f_out->z[i] = f_out->z[taa_FRUSTUM_FAR];
+        f_out->w[i] = f_out->w[taa_FRUSTUM_FAR];
+    }
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_frustum_mask_to_indices(
+    const uint32_t* mask,
+    uint32_t n,
+    uint32_t* indices_out)
+{
+    uint32_t count = 0;
+    uint32_t i;
+    for(i = 0; i < n; ++i)
+    {
+        // write unconditionally and only advance for visible elements
+        indices_out[count] = i;
+        count += (mask[i >> 5] >> (i & 31)) & 1;
+    }
+    return count;
+}
+
+#endif // taa_FRUSTUM_H_
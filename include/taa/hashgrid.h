@@ -0,0 +1,417 @@
+/**
+ * @brief     spatial hash grid header
+ * @details   fixed radius neighbor queries over point sets. Points are
+ *            hashed by the integer coordinates of the cubic cell containing
+ *            them, then counting sorted by hash, so the points of each
+ *            bucket are contiguous in memory. The number of buckets is
+ *            fixed when the grid is created and does not depend on the
+ *            extent of the points.
+ *
+ *            taa_hashgrid_build builds the grid on one thread. To build it
+ *            on several, call taa_hashgrid_reset, then count disjoint
+ *            ranges of points concurrently, each into its own array of
+ *            counts. Call taa_hashgrid_offsets once, then scatter the same
+ *            ranges concurrently. The result is identical to the serial
+ *            build.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_HASHGRID_H_
+#define taa_HASHGRID_H_
+
+#include "mathdefs.h"
+#include "stream.h"
+#include "vpu.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * a query spans at most three cells along each axis, or four when rounding
+ * pushes a bound that lies exactly on a cell boundary
+ */
+#define taa_HASHGRID_MAX_QUERY_CELLS 64
+
+typedef struct taa_hashgrid_s taa_hashgrid;
+
+struct taa_hashgrid_s
+{
+    /** offset of the first point of each bucket, numcells + 1 */
+    uint32_t* cellstart;
+    /** scratch counts used by taa_hashgrid_build */
+    uint32_t* counts;
+    /** bucket of each point in its original order */
+    uint32_t* hashes;
+    /** original index of each point in bucket order */
+    uint32_t* indices;
+    /** points in bucket order */
+    taa_vec3* points;
+    /** unaligned allocation containing all the arrays */
+    void* buffer;
+    float cellsize;
+    float invcellsize;
+    /** number of buckets, a power of two */
+    uint32_t numcells;
+    uint32_t numpoints;
+    uint32_t capacity;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief builds the grid from an array of points
+ * @param cellsize edge length of the cells, at least the query radius
+ */
+taa_INLINE static void taa_hashgrid_build(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t n,
+    float cellsize);
+
+/**
+ * @brief hashes the points [begin, end) and counts them per bucket
+ * @details counts must hold grid->numcells elements and be zero before
+ *          the first call. Disjoint ranges may be counted concurrently
+ *          into different arrays.
+ */
+taa_INLINE static void taa_hashgrid_count_range(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t* counts);
+
+/**
+ * @param capacity maximum number of points
+ * @param numcells number of buckets, rounded up to a power of two
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_hashgrid_create(
+    uint32_t capacity,
+    uint32_t numcells,
+    taa_hashgrid* grid_out);
+
+taa_INLINE static void taa_hashgrid_destroy(
+    taa_hashgrid* grid);
+
+/**
+ * @brief computes the bucket of integer cell coordinates
+ */
+taa_INLINE static uint32_t taa_hashgrid_hash(
+    const taa_hashgrid* grid,
+    int32_t x,
+    int32_t y,
+    int32_t z);
+
+/**
+ * @brief converts range counts to scatter offsets
+ * @details counts holds numranges arrays of grid->numcells counts, in the
+ *          order of the point ranges they were counted from. Each array is
+ *          replaced with the offsets at which its range is scattered.
+ */
+taa_INLINE static void taa_hashgrid_offsets(
+    taa_hashgrid* grid,
+    uint32_t* counts,
+    uint32_t numranges);
+
+/**
+ * @brief finds the points within a radius of a position
+ * @details points are tested four at a time. radius must not be greater
+ *          than the cell size of the grid. At most maxresults indices are
+ *          written to indices_out, in no particular order.
+ * @return the number of points found, which may exceed maxresults
+ */
+taa_INLINE static uint32_t taa_hashgrid_query(
+    const taa_hashgrid* grid,
+    const taa_vec3* p,
+    float radius,
+    uint32_t* indices_out,
+    uint32_t maxresults);
+
+/**
+ * @brief prepares the grid to be built from n points
+ */
+taa_INLINE static void taa_hashgrid_reset(
+    taa_hashgrid* grid,
+    uint32_t n,
+    float cellsize);
+
+/**
+ * @brief moves the points [begin, end) into bucket order
+ * @details offsets is the array of counts used for the same range, after
+ *          taa_hashgrid_offsets. Disjoint ranges may be scattered
+ *          concurrently.
+ */
+taa_INLINE static void taa_hashgrid_scatter_range(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t* offsets);
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_build(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t n,
+    float cellsize)
+{
+    taa_hashgrid_reset(grid, n, cellsize);
+    memset(grid->counts, 0, grid->numcells * sizeof(*grid->counts));
+    taa_hashgrid_count_range(grid, points, 0, n, grid->counts);
+    taa_hashgrid_offsets(grid, grid->counts, 1);
+    taa_hashgrid_scatter_range(grid, points, 0, n, grid->counts);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_count_range(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t* counts)
+{
+    float s = grid->invcellsize;
+    uint32_t i;
+    assert(begin <= end && end <= grid->numpoints);
+    for(i = begin; i < end; ++i)
+    {
+        const taa_vec3* p = points + i;
+        uint32_t h = taa_hashgrid_hash(
+            grid,
+            (int32_t) floorf(p->x * s),
+            (int32_t) floorf(p->y * s),
+            (int32_t) floorf(p->z * s));
+        grid->hashes[i] = h;
+        ++counts[h];
+    }
+}
+
+//****************************************************************************
+taa_INLINE static int taa_hashgrid_create(
+    uint32_t capacity,
+    uint32_t numcells,
+    taa_hashgrid* grid_out)
+{
+    void* aligned = NULL;
+    uint32_t ncells = 1;
+    size_t cellsize;
+    size_t pointsize;
+    int err;
+    while(ncells < numcells)
+    {
+        ncells <<= 1;
+    }
+    pointsize = capacity * sizeof(taa_vec3);
+    cellsize = (ncells*2 + 1) * sizeof(uint32_t);
+    memset(grid_out, 0, sizeof(*grid_out));
+    err = taa_stream_realloc(
+        &grid_out->buffer,
+        &aligned,
+        0,
+        pointsize + cellsize + capacity*2*sizeof(uint32_t));
+    if(err == 0)
+    {
+        char* p = (char*) aligned;
+        grid_out->points = (taa_vec3*) p;
+        grid_out->cellstart = (uint32_t*) (p + pointsize);
+        grid_out->counts = grid_out->cellstart + ncells + 1;
+        grid_out->hashes = grid_out->counts + ncells;
+        grid_out->indices = grid_out->hashes + capacity;
+        grid_out->numcells = ncells;
+        grid_out->capacity = capacity;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_destroy(
+    taa_hashgrid* grid)
+{
+    free(grid->buffer);
+    memset(grid, 0, sizeof(*grid));
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_hashgrid_hash(
+    const taa_hashgrid* grid,
+    int32_t x,
+    int32_t y,
+    int32_t z)
+{
+    // large primes from Teschner et al., "Optimized Spatial Hashing"
+    uint32_t h = (((uint32_t) x) * 73856093U);
+    h ^= (((uint32_t) y) * 19349663U);
+    h ^= (((uint32_t) z) * 83492791U);
+    return h & (grid->numcells - 1);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_offsets(
+    taa_hashgrid* grid,
+    uint32_t* counts,
+    uint32_t numranges)
+{
+    uint32_t numcells = grid->numcells;
+    uint32_t total = 0;
+    uint32_t i;
+    for(i = 0; i < numcells; ++i)
+    {
+        uint32_t j;
+        grid->cellstart[i] = total;
+        for(j = 0; j < numranges; ++j)
+        {
+            uint32_t c = counts[j*numcells + i];
+            counts[j*numcells + i] = total;
+            total += c;
+        }
+    }
+    grid->cellstart[numcells] = total;
+    assert(total == grid->numpoints);
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_hashgrid_query(
+    const taa_hashgrid* grid,
+    const taa_vec3* p,
+    float radius,
+    uint32_t* indices_out,
+    uint32_t maxresults)
+{
+    uint32_t buckets[taa_HASHGRID_MAX_QUERY_CELLS];
+    uint32_t numbuckets = 0;
+    uint32_t count = 0;
+    float s = grid->invcellsize;
+    int32_t x0 = (int32_t) floorf((p->x - radius) * s);
+    int32_t y0 = (int32_t) floorf((p->y - radius) * s);
+    int32_t z0 = (int32_t) floorf((p->z - radius) * s);
+    int32_t x1 = (int32_t) floorf((p->x + radius) * s);
+    int32_t y1 = (int32_t) floorf((p->y + radius) * s);
+    int32_t z1 = (int32_t) floorf((p->z + radius) * s);
+    taa_vpu_vec4 px;
+    taa_vpu_vec4 py;
+    taa_vpu_vec4 pz;
+    taa_vpu_vec4 r2;
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    uint32_t i;
+    assert(radius <= grid->cellsize);
+    assert(x1 - x0 < 4 && y1 - y0 < 4 && z1 - z0 < 4);
+    // collect the buckets once, since different cells may share a bucket
+    for(z = z0; z <= z1; ++z)
+    {
+        for(y = y0; y <= y1; ++y)
+        {
+            for(x = x0; x <= x1; ++x)
+            {
+                uint32_t h = taa_hashgrid_hash(grid, x, y, z);
+                uint32_t j = 0;
+                while(j < numbuckets && buckets[j] != h)
+                {
+                    ++j;
+                }
+                if(j == numbuckets)
+                {
+                    buckets[numbuckets++] = h;
+                }
+            }
+        }
+    }
+    taa_vpu_set1(p->x, px);
+    taa_vpu_set1(p->y, py);
+    taa_vpu_set1(p->z, pz);
+    taa_vpu_set1(radius * radius, r2);
+    for(i = 0; i < numbuckets; ++i)
+    {
+        uint32_t begin = grid->cellstart[buckets[i]];
+        uint32_t end = grid->cellstart[buckets[i] + 1];
+        uint32_t j;
+        for(j = begin; j < end; j += 4)
+        {
+            uint32_t nlanes = ((end - j) < 4) ? (end - j) : 4;
+            const taa_vec3* v = grid->points + j;
+            taa_vpu_vec4 vx;
+            taa_vpu_vec4 vy;
+            taa_vpu_vec4 vz;
+            taa_vpu_vec4 d2;
+            int bits;
+            if(nlanes == 4)
+            {
+                taa_vpu_load3x4(&v->x, vx, vy, vz);
+            }
+            else
+            {
+                // unused lanes repeat the last point and are masked off
+                const taa_vec3* v1 = v + ((nlanes > 1) ? 1 : 0);
+                const taa_vec3* v2 = v + ((nlanes > 2) ? 2 : nlanes - 1);
+                const taa_vec3* v3 = v + nlanes - 1;
+                taa_vpu_set(v->x, v1->x, v2->x, v3->x, vx);
+                taa_vpu_set(v->y, v1->y, v2->y, v3->y, vy);
+                taa_vpu_set(v->z, v1->z, v2->z, v3->z, vz);
+            }
+            taa_vpu_sub(vx, px, vx);
+            taa_vpu_sub(vy, py, vy);
+            taa_vpu_sub(vz, pz, vz);
+            taa_vpu_mul(vx, vx, d2);
+            taa_vpu_mul(vy, vy, vy);
+            taa_vpu_mul(vz, vz, vz);
+            taa_vpu_add(d2, vy, d2);
+            taa_vpu_add(d2, vz, d2);
+            taa_vpu_cmpgt(d2, r2, d2);
+            taa_vpu_movemask(d2, bits);
+            bits = ~bits & ((1 << nlanes) - 1);
+            while(bits != 0)
+            {
+                uint32_t k = 0;
+                while((bits & (1 << k)) == 0)
+                {
+                    ++k;
+                }
+                bits &= ~(1 << k);
+                if(count < maxresults)
+                {
+                    indices_out[count] = grid->indices[j + k];
+                }
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_reset(
+    taa_hashgrid* grid,
+    uint32_t n,
+    float cellsize)
+{
+    assert(n <= grid->capacity);
+    assert(cellsize > 0.0f);
+    grid->numpoints = n;
+    grid->cellsize = cellsize;
+    grid->invcellsize = 1.0f / cellsize;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hashgrid_scatter_range(
+    taa_hashgrid* grid,
+    const taa_vec3* points,
+    uint32_t begin,
+    uint32_t end,
+    uint32_t* offsets)
+{
+    uint32_t i;
+    assert(begin <= end && end <= grid->numpoints);
+    for(i = begin; i < end; ++i)
+    {
+        uint32_t j = offsets[grid->hashes[i]]++;
+        grid->points[j] = points[i];
+        grid->indices[j] = i;
+    }
+}
+
+#endif // taa_HASHGRID_H_
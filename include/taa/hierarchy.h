@@ -0,0 +1,357 @@
+/**
+ * @brief     transform hierarchy header
+ * @details   world transforms are propagated one depth level at a time. All
+ *            nodes of a level depend only on the previous level, so a level
+ *            may be split into ranges and updated by several threads. Nodes
+ *            whose local transform and ancestors are unchanged since the
+ *            last update are skipped, and an update of a hierarchy with no
+ *            changes returns without visiting any node.
+ *
+ *            The dirty nodes of a level are multiplied four at a time. Their
+ *            parent and local matrices are gathered into taa_mat44x4 blocks,
+ *            multiplied in structure of arrays format, and scattered back.
+ *            local and world stay arrays of taa_mat44, since that is what
+ *            callers write and what skinning palettes read. Transposing in
+ *            registers costs less than converting a whole SoA world array
+ *            back every frame.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_HIERARCHY_H_
+#define taa_HIERARCHY_H_
+
+#include "mat44.h"
+#include "mat44x4.h"
+#include "stream.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** parent index of nodes with no parent */
+#define taa_HIERARCHY_ROOT ((uint32_t) 0xffffffff)
+
+typedef struct taa_hierarchy_s taa_hierarchy;
+
+struct taa_hierarchy_s
+{
+    /** local transforms, 64 byte aligned */
+    taa_mat44* local;
+    /** world transforms, 64 byte aligned */
+    taa_mat44* world;
+    /** parent of each node, or taa_HIERARCHY_ROOT */
+    uint32_t* parents;
+    /** node indices sorted by depth */
+    uint32_t* order;
+    /** offset into order of the first node of each level, numlevels + 1 */
+    uint32_t* levels;
+    /** nonzero if the world transform of the node is out of date */
+    uint8_t* dirty;
+    /** unaligned allocation containing all the arrays */
+    void* buffer;
+    uint32_t size;
+    uint32_t numlevels;
+    /** nonzero if any local transform changed since the last update */
+    int changed;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief clears the dirty flags of all nodes
+ * @details only needed after updating with taa_hierarchy_update_range.
+ *          Until the next local transform change, updates return
+ *          immediately.
+ */
+taa_INLINE static void taa_hierarchy_clear_dirty(
+    taa_hierarchy* h);
+
+/**
+ * @brief creates a hierarchy from an array of parent indices
+ * @details parents may be in any order, but must not contain cycles. All
+ *          local transforms are initialized to identity and all nodes are
+ *          marked dirty.
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_hierarchy_create(
+    const uint32_t* parents,
+    uint32_t n,
+    taa_hierarchy* h_out);
+
+taa_INLINE static void taa_hierarchy_destroy(
+    taa_hierarchy* h);
+
+taa_INLINE static void taa_hierarchy_set_local(
+    taa_hierarchy* h,
+    uint32_t node,
+    const taa_mat44* m);
+
+/**
+ * @brief sets the local transforms of all nodes from separate components
+ * @details the matrices are built with taa_mat44_from_trs_array, four nodes
+ *          at a time in structure of arrays format.
+ */
+taa_INLINE static void taa_hierarchy_set_local_trs_array(
+    taa_hierarchy* h,
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s);
+
+/**
+ * @brief recomputes the world transforms of all dirty nodes
+ * @return the number of world transforms that were recomputed
+ */
+taa_INLINE static uint32_t taa_hierarchy_update(
+    taa_hierarchy* h);
+
+/**
+ * @brief recomputes the dirty world transforms of order[begin, end)
+ * @details begin and end must lie within one level, and every earlier
+ *          level must already be updated. Disjoint ranges of the same level
+ *          may be updated concurrently. Dirty flags are propagated to
+ *          children, but not cleared; call taa_hierarchy_clear_dirty once
+ *          every level has been updated.
+ * @return the number of world transforms that were recomputed
+ */
+taa_INLINE static uint32_t taa_hierarchy_update_range(
+    taa_hierarchy* h,
+    uint32_t begin,
+    uint32_t end);
+
+/**
+ * @brief recomputes the world transforms of up to four nodes of one level
+ * @details n must be 1 to 4.
+ */
+taa_INLINE static void taa_hierarchy_update_x4(
+    taa_hierarchy* h,
+    const uint32_t* nodes,
+    uint32_t n);
+
+//****************************************************************************
+taa_INLINE static void taa_hierarchy_clear_dirty(
+    taa_hierarchy* h)
+{
+    memset(h->dirty, 0, h->size);
+    h->changed = 0;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_hierarchy_create(
+    const uint32_t* parents,
+    uint32_t n,
+    taa_hierarchy* h_out)
+{
+    int err = -1;
+    uint32_t* depth = NULL;
+    memset(h_out, 0, sizeof(*h_out));
+    if(n > 0)
+    {
+        depth = (uint32_t*) malloc(n * sizeof(*depth));
+    }
+    if(depth != NULL || n == 0)
+    {
+        void* aligned = NULL;
+        size_t matsize = n * sizeof(taa_mat44);
+        size_t idxsize = n * sizeof(uint32_t);
+        err = taa_stream_realloc(
+            &h_out->buffer,
+            &aligned,
+            0,
+            matsize*2 + idxsize*3 + sizeof(uint32_t) + n);
+        if(err == 0)
+        {
+            const uint32_t root = taa_HIERARCHY_ROOT;
+            char* p = (char*) aligned;
+            uint32_t i;
+            h_out->local = (taa_mat44*) p;
+            h_out->world = (taa_mat44*) (p + matsize);
+            h_out->parents = (uint32_t*) (p + matsize*2);
+            h_out->order = (uint32_t*) (p + matsize*2 + idxsize);
+            h_out->levels = (uint32_t*) (p + matsize*2 + idxsize*2);
+            h_out->dirty = (uint8_t*) (h_out->levels + n + 1);
+            h_out->size = n;
+            h_out->changed = 1;
+            memcpy(h_out->parents, parents, idxsize);
+            memset(h_out->dirty, 1, n);
+            // compute the depth of each node, walking up to the nearest
+            // ancestor of known depth and then back down. unknown depths
+            // are marked with the same value as missing parents.
+            for(i = 0; i < n; ++i)
+            {
+                depth[i] = root;
+            }
+            for(i = 0; i < n; ++i)
+            {
+                uint32_t j = i;
+                uint32_t d = 0;
+                while(j != root && depth[j] == root)
+                {
+                    assert(parents[j] == root || parents[j] < n);
+                    assert(d < n);
+                    j = parents[j];
+                    ++d;
+                }
+                d += (j != root) ? depth[j] + 1 : 0;
+                j = i;
+                while(j != root && depth[j] == root)
+                {
+                    depth[j] = --d;
+                    j = parents[j];
+                }
+                if(depth[i] + 1 > h_out->numlevels)
+                {
+                    h_out->numlevels = depth[i] + 1;
+                }
+            }
+            // counting sort by depth
+            for(i = 0; i < n; ++i)
+            {
+                ++h_out->levels[depth[i] + 1];
+            }
+            for(i = 0; i < h_out->numlevels; ++i)
+            {
+                h_out->levels[i + 1] += h_out->levels[i];
+            }
+            for(i = 0; i < n; ++i)
+            {
+                h_out->order[h_out->levels[depth[i]]++] = i;
+            }
+            for(i = h_out->numlevels; i > 0; --i)
+            {
+                h_out->levels[i] = h_out->levels[i - 1];
+            }
+            h_out->levels[0] = 0;
+            for(i = 0; i < n; ++i)
+            {
+                taa_mat44_identity(h_out->local + i);
+            }
+        }
+        free(depth);
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hierarchy_destroy(
+    taa_hierarchy* h)
+{
+    free(h->buffer);
+    memset(h, 0, sizeof(*h));
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hierarchy_set_local(
+    taa_hierarchy* h,
+    uint32_t node,
+    const taa_mat44* m)
+{
+    assert(node < h->size);
+    h->local[node] = *m;
+    h->dirty[node] = 1;
+    h->changed = 1;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hierarchy_set_local_trs_array(
+    taa_hierarchy* h,
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s)
+{
+    taa_mat44_from_trs_array(t, r, s, h->size, h->local);
+    memset(h->dirty, 1, h->size);
+    h->changed = 1;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_hierarchy_update(
+    taa_hierarchy* h)
+{
+    uint32_t count = 0;
+    uint32_t i;
+    if(!h->changed)
+    {
+        return 0;
+    }
+    for(i = 0; i < h->numlevels; ++i)
+    {
+        count += taa_hierarchy_update_range(
+            h,
+            h->levels[i],
+            h->levels[i + 1]);
+    }
+    taa_hierarchy_clear_dirty(h);
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_hierarchy_update_range(
+    taa_hierarchy* h,
+    uint32_t begin,
+    uint32_t end)
+{
+    const uint32_t* order = h->order;
+    const uint32_t* parents = h->parents;
+    uint8_t* dirty = h->dirty;
+    uint32_t batch[4];
+    uint32_t nbatch = 0;
+    uint32_t count = 0;
+    uint32_t i;
+    assert(begin <= end && end <= h->size);
+    if(!h->changed)
+    {
+        return 0;
+    }
+    for(i = begin; i < end; ++i)
+    {
+        uint32_t node = order[i];
+        uint32_t parent = parents[node];
+        if(parent == taa_HIERARCHY_ROOT)
+        {
+            if(dirty[node])
+            {
+                h->world[node] = h->local[node];
+                ++count;
+            }
+        }
+        else if(dirty[node] | dirty[parent])
+        {
+            dirty[node] = 1;
+            batch[nbatch++] = node;
+            if(nbatch == 4)
+            {
+                taa_hierarchy_update_x4(h, batch, nbatch);
+                nbatch = 0;
+            }
+            ++count;
+        }
+    }
+    if(nbatch > 0)
+    {
+        taa_hierarchy_update_x4(h, batch, nbatch);
+    }
+    return count;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_hierarchy_update_x4(
+    taa_hierarchy* h,
+    const uint32_t* nodes,
+    uint32_t n)
+{
+    taa_mat44x4 p4;
+    taa_mat44x4 l4;
+    uint32_t parents[4];
+    uint32_t i;
+    for(i = 0; i < n; ++i)
+    {
+        parents[i] = h->parents[nodes[i]];
+    }
+    taa_mat44x4_gather(h->world, parents, n, &p4);
+    taa_mat44x4_gather(h->local, nodes, n, &l4);
+    taa_mat44x4_multiply(&p4, &l4, &l4);
+    taa_mat44x4_scatter(&l4, nodes, n, h->world);
+}
+
+#endif // taa_HIERARCHY_H_
@@ -7,7 +7,10 @@
 #ifndef taa_MAT33_H_
 #define taa_MAT33_H_
 
+#include "mat33x4.h"
+#include "quatx4.h"
 #include "vec3.h"
+#include "vpu.h"
 
 //****************************************************************************
 // forward declarations
@@ -33,10 +36,32 @@ taa_INLINE static void taa_mat33_pitch(
     float pitch,
     taa_mat33* m_out);
 
+/**
+ * @brief replaces each matrix with its closest orthogonal matrix
+ * @details uses taa_mat33x4_polar, which treats all three axes equally.
+ *          Matrices with a negative determinant become reflections. a and
+ *          m_out may point to the same array.
+ */
+taa_INLINE static void taa_mat33_polar_array(
+    const taa_mat33* a,
+    uint32_t n,
+    uint32_t iterations,
+    taa_mat33* m_out);
+
 taa_INLINE static void taa_mat33_from_quat(
     const taa_quat* q,
     taa_mat33* m_out);
 
+/**
+ * @brief converts an array of unit quaternions into rotation matrices
+ * @details the quaternions are converted four at a time in structure of
+ *          arrays format, using taa_mat33x4_from_quatx4.
+ */
+taa_INLINE static void taa_mat33_from_quat_array(
+    const taa_quat* q,
+    uint32_t n,
+    taa_mat33* m_out);
+
 taa_INLINE static void taa_mat33_roll(
     float roll,
     taa_mat33* m_out);
@@ -65,6 +90,17 @@ taa_INLINE static void taa_mat33_orthonormalize(
     const taa_mat33* a,
     taa_mat33* m_out);
 
+/**
+ * @brief orthonormalizes an array of matrices
+ * @details produces the same result as taa_mat33_orthonormalize, but four
+ *          matrices at a time in structure of arrays format. a and m_out may
+ *          point to the same array.
+ */
+taa_INLINE static void taa_mat33_orthonormalize_array(
+    const taa_mat33* a,
+    uint32_t n,
+    taa_mat33* m_out);
+
 taa_INLINE static void taa_mat33_scale(
     const taa_mat33* a,
     float x,
@@ -158,6 +194,36 @@ taa_INLINE static void taa_mat33_pitch(
     taa_vec3_set(0.0f,   -s,    c, &m_out->z);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat33_polar_array(
+    const taa_mat33* a,
+    uint32_t n,
+    uint32_t iterations,
+    taa_mat33* m_out)
+{
+    const taa_mat33* aend = a + n;
+    taa_mat33x4 m4;
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        uint32_t i;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat33(a, nlanes, &m4);
+        for(i = nlanes; i < 4; ++i)
+        {
+            // unused lanes are zero, make them identity to keep the newton
+            // iteration from dividing by zero
+            m4.x.x[i] = 1.0f;
+            m4.y.y[i] = 1.0f;
+            m4.z.z[i] = 1.0f;
+        }
+        taa_mat33x4_polar(&m4, iterations, &m4);
+        taa_mat33x4_to_mat33(&m4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat33_from_quat(
     const taa_quat* q,
@@ -178,6 +244,27 @@ taa_INLINE static void taa_mat33_from_quat(
     taa_vec3_set(         xz+wy,          yz-wx, 1.0f - (xx+yy), &m_out->z);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat33_from_quat_array(
+    const taa_quat* q,
+    uint32_t n,
+    taa_mat33* m_out)
+{
+    const taa_quat* qend = q + n;
+    taa_quatx4 q4;
+    taa_mat33x4 m4;
+    while(q != qend)
+    {
+        uint32_t nlanes = (uint32_t) (qend - q);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_quatx4_from_quat(q, nlanes, &q4);
+        taa_mat33x4_from_quatx4(&q4, &m4);
+        taa_mat33x4_to_mat33(&m4, nlanes, m_out);
+        q += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat33_roll(
     float roll,
@@ -238,17 +325,33 @@ taa_INLINE static void taa_mat33_inverse(
     const taa_mat33* a,
     taa_mat33* m_out)
 {
-    float d = 1.0f/taa_mat33_determinant(a);
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 r0;
+    taa_vpu_vec4 r1;
+    taa_vpu_vec4 r2;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 one;
     assert(a != m_out);
-    m_out->x.x = (a->y.y*a->z.z - a->y.z*a->z.y)*d;
-    m_out->x.y = (a->x.z*a->z.y - a->x.y*a->z.z)*d;
-    m_out->x.z = (a->x.y*a->y.z - a->x.z*a->y.y)*d;
-    m_out->y.x = (a->y.z*a->z.x - a->y.x*a->z.z)*d;
-    m_out->y.y = (a->x.x*a->z.z - a->x.z*a->z.x)*d;
-    m_out->y.z = (a->x.z*a->y.x - a->x.x*a->y.z)*d;
-    m_out->z.x = (a->y.x*a->z.y - a->y.y*a->z.x)*d;
-    m_out->z.y = (a->x.y*a->z.x - a->x.x*a->z.y)*d;
-    m_out->z.z = (a->x.x*a->y.y - a->x.y*a->y.x)*d;
+    taa_vpu_load3(&a->x.x, c0);
+    taa_vpu_load3(&a->y.x, c1);
+    taa_vpu_load3(&a->z.x, c2);
+    // the rows of the inverse are the cross products of the columns
+    // divided by the determinant
+    taa_vpu_cross3(c1, c2, r0);
+    taa_vpu_cross3(c2, c0, r1);
+    taa_vpu_cross3(c0, c1, r2);
+    taa_vpu_dot(c0, r0, d);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_div(one, d, d);
+    taa_vpu_mul(r0, d, r0);
+    taa_vpu_mul(r1, d, r1);
+    taa_vpu_mul(r2, d, r2);
+    taa_vpu_mat33_transpose(r0, r1, r2, c0, c1, c2);
+    taa_vpu_store3(c0, &m_out->x.x);
+    taa_vpu_store3(c1, &m_out->y.x);
+    taa_vpu_store3(c2, &m_out->z.x);
 }
 
 //****************************************************************************
@@ -257,17 +360,25 @@ taa_INLINE static void taa_mat33_multiply(
     const taa_mat33* b,
     taa_mat33* m_out)
 {
+    taa_vpu_vec4 a0;
+    taa_vpu_vec4 a1;
+    taa_vpu_vec4 a2;
+    taa_vpu_vec4 v;
+    taa_vpu_vec4 r;
     assert(a != m_out);
     assert(b != m_out);
-    m_out->x.x = a->x.x*b->x.x + a->y.x*b->x.y + a->z.x*b->x.z;
-    m_out->x.y = a->x.y*b->x.x + a->y.y*b->x.y + a->z.y*b->x.z;
-    m_out->x.z = a->x.z*b->x.x + a->y.z*b->x.y + a->z.z*b->x.z;
-    m_out->y.x = a->x.x*b->y.x + a->y.x*b->y.y + a->z.x*b->y.z;
-    m_out->y.y = a->x.y*b->y.x + a->y.y*b->y.y + a->z.y*b->y.z;
-    m_out->y.z = a->x.z*b->y.x + a->y.z*b->y.y + a->z.z*b->y.z;
-    m_out->z.x = a->x.x*b->z.x + a->y.x*b->z.y + a->z.x*b->z.z;
-    m_out->z.y = a->x.y*b->z.x + a->y.y*b->z.y + a->z.y*b->z.z;
-    m_out->z.z = a->x.z*b->z.x + a->y.z*b->z.y + a->z.z*b->z.z;
+    taa_vpu_load3(&a->x.x, a0);
+    taa_vpu_load3(&a->y.x, a1);
+    taa_vpu_load3(&a->z.x, a2);
+    taa_vpu_load3(&b->x.x, v);
+    taa_vpu_mat34_mul_vec4(a0, a1, a2, v, r);
+    taa_vpu_store3(r, &m_out->x.x);
+    taa_vpu_load3(&b->y.x, v);
+    taa_vpu_mat34_mul_vec4(a0, a1, a2, v, r);
+    taa_vpu_store3(r, &m_out->y.x);
+    taa_vpu_load3(&b->z.x, v);
+    taa_vpu_mat34_mul_vec4(a0, a1, a2, v, r);
+    taa_vpu_store3(r, &m_out->z.x);
 }
 
 //****************************************************************************
@@ -278,20 +389,53 @@ taa_INLINE static void taa_mat33_orthonormalize(
     // col0' = |col0|
     // col1' = |col1 - dot(col0', col1) col0'|
     // col2' = |col2 - dot(col0', col2) col0' - dot(col1', col2) col1'|
-    taa_vec3 u;
-    taa_vec3 v;
-
-    taa_vec3_normalize(&a->x, &m_out->x);
-
-    taa_vec3_scale(&m_out->x, taa_vec3_dot(&m_out->x, &a->y), &v);
-    taa_vec3_subtract(&a->y, &v, &m_out->y);
-    taa_vec3_normalize(&m_out->y, &m_out->y);
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 d;
+    taa_vpu_load3(&a->x.x, c0);
+    taa_vpu_load3(&a->y.x, c1);
+    taa_vpu_load3(&a->z.x, c2);
+    // the w components are zero, so four component dots are safe
+
+    taa_vpu_normalize(c0, c0);
+
+    taa_vpu_dot(c0, c1, d);
+    taa_vpu_mul(c0, d, d);
+    taa_vpu_sub(c1, d, c1);
+    taa_vpu_normalize(c1, c1);
+
+    taa_vpu_dot(c0, c2, d);
+    taa_vpu_mul(c0, d, d);
+    taa_vpu_sub(c2, d, c2);
+    taa_vpu_dot(c1, c2, d);
+    taa_vpu_mul(c1, d, d);
+    taa_vpu_sub(c2, d, c2);
+    taa_vpu_normalize(c2, c2);
+
+    taa_vpu_store3(c0, &m_out->x.x);
+    taa_vpu_store3(c1, &m_out->y.x);
+    taa_vpu_store3(c2, &m_out->z.x);
+}
 
-    taa_vec3_scale(&m_out->x, taa_vec3_dot(&m_out->x, &a->z), &u);
-    taa_vec3_scale(&m_out->y, taa_vec3_dot(&m_out->y, &a->z), &v);
-    taa_vec3_subtract(&a->z, &u, &m_out->z);
-    taa_vec3_subtract(&m_out->z, &v, &m_out->z);
-    taa_vec3_normalize(&m_out->z, &m_out->z);
+//****************************************************************************
+taa_INLINE static void taa_mat33_orthonormalize_array(
+    const taa_mat33* a,
+    uint32_t n,
+    taa_mat33* m_out)
+{
+    const taa_mat33* aend = a + n;
+    taa_mat33x4 m4;
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat33(a, nlanes, &m4);
+        taa_mat33x4_orthonormalize(&m4, &m4);
+        taa_mat33x4_to_mat33(&m4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
 }
 
 //****************************************************************************
@@ -322,11 +466,19 @@ taa_INLINE static void taa_mat33_transform_vec3(
     const taa_vec3* b,
     taa_vec3* v_out)
 {
+    taa_vpu_vec4 a0;
+    taa_vpu_vec4 a1;
+    taa_vpu_vec4 a2;
+    taa_vpu_vec4 v;
+    taa_vpu_vec4 r;
     assert(&a->x > v_out || &a->z < v_out);
     assert(b != v_out);
-    v_out->x = a->x.x*b->x + a->y.x*b->y + a->z.x*b->z;
-    v_out->y = a->x.y*b->x + a->y.y*b->y + a->z.y*b->z;
-    v_out->z = a->x.z*b->x + a->y.z*b->y + a->z.z*b->z;
+    taa_vpu_load3(&a->x.x, a0);
+    taa_vpu_load3(&a->y.x, a1);
+    taa_vpu_load3(&a->z.x, a2);
+    taa_vpu_load3(&b->x, v);
+    taa_vpu_mat34_mul_vec4(a0, a1, a2, v, r);
+    taa_vpu_store3(r, &v_out->x);
 }
 
 //****************************************************************************
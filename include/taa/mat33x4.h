@@ -0,0 +1,924 @@
+/**
+ * @brief     header for inlined structure of arrays 3x3 matrix functions
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_MAT33X4_H_
+#define taa_MAT33X4_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+#include <float.h>
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief calculates the determinant of each of the four matrices
+ * @param m input matrices
+ * @param d_out four lane array of determinants, must be 16 byte aligned
+ */
+taa_INLINE static void taa_mat33x4_determinant(
+    const taa_mat33x4* m,
+    float* d_out);
+
+/**
+ * @brief converts an array of matrices into structure of arrays format
+ * @details m_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element are set to zero.
+ */
+taa_INLINE static void taa_mat33x4_from_mat33(
+    const taa_mat33* m,
+    uint32_t n,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief converts the upper 3x3 of an array of matrices into structure of
+ *        arrays format
+ * @details m must be 16 byte aligned. m_out must have room for (n + 3)/4
+ *          elements. Unused lanes of the last element are set to zero.
+ */
+taa_INLINE static void taa_mat33x4_from_mat44(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief converts four unit quaternions into rotation matrices
+ */
+taa_INLINE static void taa_mat33x4_from_quatx4(
+    const taa_quatx4* q,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief inverts each of the four matrices
+ * @details the matrices must not be singular. Unused zero lanes produce
+ *          non-finite results, which are harmless as long as they are not
+ *          converted back to taa_mat33.
+ */
+taa_INLINE static void taa_mat33x4_inverse(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief multiplies the matrices in a by the matrices in b, lane by lane
+ */
+taa_INLINE static void taa_mat33x4_multiply(
+    const taa_mat33x4* a,
+    const taa_mat33x4* b,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief re-orthonormalizes each of the four matrices with gram-schmidt
+ * @details the first column keeps its direction, and the others are made
+ *          perpendicular to the columns before them.
+ */
+taa_INLINE static void taa_mat33x4_orthonormalize(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief finds the closest orthogonal matrix to each of the four matrices
+ * @details computes the orthogonal factor of the polar decomposition with
+ *          the newton iteration x' = (x + transpose(inverse(x)))/2, which
+ *          does not favor any axis. Convergence is quadratic, so two
+ *          iterations remove the drift of an integrated rotation and three
+ *          handle distortions of a few percent. The result keeps the sign
+ *          of the determinant, so a matrix with a negative determinant
+ *          becomes a reflection rather than a rotation. The matrices must
+ *          not be singular, and a and m_out may point to the same matrix.
+ */
+taa_INLINE static void taa_mat33x4_polar(
+    const taa_mat33x4* a,
+    uint32_t iterations,
+    taa_mat33x4* m_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of matrices
+ * @details a must contain (n + 3)/4 elements.
+ */
+taa_INLINE static void taa_mat33x4_to_mat33(
+    const taa_mat33x4* a,
+    uint32_t n,
+    taa_mat33* m_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of 4x4
+ *        matrices
+ * @details the upper 3x3 of each matrix is written with zero w components,
+ *          and the last column is set to (0, 0, 0, 1), the same as
+ *          taa_mat44_from_mat33. m_out must be 16 byte aligned.
+ */
+taa_INLINE static void taa_mat33x4_to_mat44(
+    const taa_mat33x4* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
+/**
+ * @brief multiplies the matrices in a by the column vectors in b
+ */
+taa_INLINE static void taa_mat33x4_transform_vec3x4(
+    const taa_mat33x4* a,
+    const taa_vec3x4* b,
+    taa_vec3x4* v_out);
+
+/**
+ * @brief transposes each of the four matrices
+ * @details a and m_out may point to the same matrix
+ */
+taa_INLINE static void taa_mat33x4_transpose(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out);
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_determinant(
+    const taa_mat33x4* m,
+    float* d_out)
+{
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 xy;
+    taa_vpu_vec4 xz;
+    taa_vpu_vec4 yx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 yz;
+    taa_vpu_vec4 zx;
+    taa_vpu_vec4 zy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 t0;
+    taa_vpu_vec4 t1;
+    taa_vpu_vec4 d;
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) d_out) & 15) == 0);
+    taa_vpu_load(m->x.x, xx);
+    taa_vpu_load(m->x.y, xy);
+    taa_vpu_load(m->x.z, xz);
+    taa_vpu_load(m->y.x, yx);
+    taa_vpu_load(m->y.y, yy);
+    taa_vpu_load(m->y.z, yz);
+    taa_vpu_load(m->z.x, zx);
+    taa_vpu_load(m->z.y, zy);
+    taa_vpu_load(m->z.z, zz);
+    // expand along the first column using the 2x2 minors
+    // d = xx*(yy*zz - yz*zy) + xy*(yz*zx - yx*zz) + xz*(yx*zy - yy*zx)
+    taa_vpu_mul(yy, zz, t0);
+    taa_vpu_mul(yz, zy, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(xx, t0, d);
+    taa_vpu_mul(yz, zx, t0);
+    taa_vpu_mul(yx, zz, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(xy, t0, t0);
+    taa_vpu_add(d, t0, d);
+    taa_vpu_mul(yx, zy, t0);
+    taa_vpu_mul(yy, zx, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(xz, t0, t0);
+    taa_vpu_add(d, t0, d);
+    taa_vpu_store(d, d_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_from_mat33(
+    const taa_mat33* m,
+    uint32_t n,
+    taa_mat33x4* m_out)
+{
+    const taa_mat33* mend = m + (n & ~3);
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) m_out) & 15) == 0);
+    while(m != mend)
+    {
+        // four packed matrices are 36 contiguous floats. elements 0-3 and
+        // 4-7 of each matrix are transposed into lane arrays four at a
+        // time, and the last element is gathered individually.
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(j = 0; j < 8; j += 4)
+        {
+            taa_vpu_vec4 r0;
+            taa_vpu_vec4 r1;
+            taa_vpu_vec4 r2;
+            taa_vpu_vec4 r3;
+            taa_vpu_vec4 e0;
+            taa_vpu_vec4 e1;
+            taa_vpu_vec4 e2;
+            taa_vpu_vec4 e3;
+            taa_vpu_loadu(src + j     , r0);
+            taa_vpu_loadu(src + j +  9, r1);
+            taa_vpu_loadu(src + j + 18, r2);
+            taa_vpu_loadu(src + j + 27, r3);
+            taa_vpu_mat44_transpose(r0, r1, r2, r3, e0, e1, e2, e3);
+            taa_vpu_store(e0, dst + j*4     );
+            taa_vpu_store(e1, dst + j*4 +  4);
+            taa_vpu_store(e2, dst + j*4 +  8);
+            taa_vpu_store(e3, dst + j*4 + 12);
+        }
+        dst[32] = src[ 8];
+        dst[33] = src[17];
+        dst[34] = src[26];
+        dst[35] = src[35];
+        m += 4;
+        ++m_out;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(i = 0; i < 4; ++i)
+        {
+            for(j = 0; j < 9; ++j)
+            {
+                dst[j*4 + i] = (i < n) ? src[i*9 + j] : 0.0f;
+            }
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_from_mat44(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat33x4* m_out)
+{
+    const taa_mat44* mend = m + (n & ~3);
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    while(m != mend)
+    {
+        // column j of the four matrices is transposed into the x, y and z
+        // lane arrays of column j. the w lanes are discarded.
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 w;
+            taa_vpu_load(src + j*4     , c0);
+            taa_vpu_load(src + j*4 + 16, c1);
+            taa_vpu_load(src + j*4 + 32, c2);
+            taa_vpu_load(src + j*4 + 48, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, x, y, z, w);
+            taa_vpu_store(x, dst + j*12    );
+            taa_vpu_store(y, dst + j*12 + 4);
+            taa_vpu_store(z, dst + j*12 + 8);
+            (void) w;
+        }
+        m += 4;
+        ++m_out;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(i = 0; i < 4; ++i)
+        {
+            for(j = 0; j < 9; ++j)
+            {
+                dst[j*4 + i] = (i < n) ? src[i*16 + (j/3)*4 + j%3] : 0.0f;
+            }
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_from_quatx4(
+    const taa_quatx4* q,
+    taa_mat33x4* m_out)
+{
+    taa_vpu_vec4 x;
+    taa_vpu_vec4 y;
+    taa_vpu_vec4 z;
+    taa_vpu_vec4 w;
+    taa_vpu_vec4 x2;
+    taa_vpu_vec4 y2;
+    taa_vpu_vec4 z2;
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 a;
+    taa_vpu_vec4 b;
+    taa_vpu_vec4 c;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 one;
+    taa_vpu_load(q->x, x);
+    taa_vpu_load(q->y, y);
+    taa_vpu_load(q->z, z);
+    taa_vpu_load(q->w, w);
+    taa_vpu_add(x, x, x2);
+    taa_vpu_add(y, y, y2);
+    taa_vpu_add(z, z, z2);
+    taa_vpu_mul(x, x2, xx);
+    taa_vpu_mul(y, y2, yy);
+    taa_vpu_mul(z, z2, zz);
+    // diagonal
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_add(yy, zz, a);
+    taa_vpu_sub(one, a, a);
+    taa_vpu_store(a, m_out->x.x);
+    taa_vpu_add(xx, zz, a);
+    taa_vpu_sub(one, a, a);
+    taa_vpu_store(a, m_out->y.y);
+    taa_vpu_add(xx, yy, a);
+    taa_vpu_sub(one, a, a);
+    taa_vpu_store(a, m_out->z.z);
+    // xy +- wz
+    taa_vpu_mul(x, y2, a);
+    taa_vpu_mul(w, z2, b);
+    taa_vpu_add(a, b, c);
+    taa_vpu_sub(a, b, d);
+    taa_vpu_store(c, m_out->x.y);
+    taa_vpu_store(d, m_out->y.x);
+    // xz -+ wy
+    taa_vpu_mul(x, z2, a);
+    taa_vpu_mul(w, y2, b);
+    taa_vpu_sub(a, b, c);
+    taa_vpu_add(a, b, d);
+    taa_vpu_store(c, m_out->x.z);
+    taa_vpu_store(d, m_out->z.x);
+    // yz +- wx
+    taa_vpu_mul(y, z2, a);
+    taa_vpu_mul(w, x2, b);
+    taa_vpu_add(a, b, c);
+    taa_vpu_sub(a, b, d);
+    taa_vpu_store(c, m_out->y.z);
+    taa_vpu_store(d, m_out->z.y);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_inverse(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out)
+{
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 xy;
+    taa_vpu_vec4 xz;
+    taa_vpu_vec4 yx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 yz;
+    taa_vpu_vec4 zx;
+    taa_vpu_vec4 zy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 t0;
+    taa_vpu_vec4 t1;
+    taa_vpu_vec4 d;
+    assert(a != m_out);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    taa_vpu_load(a->x.x, xx);
+    taa_vpu_load(a->x.y, xy);
+    taa_vpu_load(a->x.z, xz);
+    taa_vpu_load(a->y.x, yx);
+    taa_vpu_load(a->y.y, yy);
+    taa_vpu_load(a->y.z, yz);
+    taa_vpu_load(a->z.x, zx);
+    taa_vpu_load(a->z.y, zy);
+    taa_vpu_load(a->z.z, zz);
+    // the cofactors of the first column are shared with the determinant
+    taa_vpu_mul(yy, zz, t0);
+    taa_vpu_mul(yz, zy, t1);
+    taa_vpu_sub(t0, t1, c0);
+    taa_vpu_mul(yz, zx, t0);
+    taa_vpu_mul(yx, zz, t1);
+    taa_vpu_sub(t0, t1, c1);
+    taa_vpu_mul(yx, zy, t0);
+    taa_vpu_mul(yy, zx, t1);
+    taa_vpu_sub(t0, t1, c2);
+    taa_vpu_mul(xx, c0, d);
+    taa_vpu_mul(xy, c1, t0);
+    taa_vpu_add(d, t0, d);
+    taa_vpu_mul(xz, c2, t0);
+    taa_vpu_add(d, t0, d);
+    taa_vpu_set1(1.0f, t0);
+    taa_vpu_div(t0, d, d);
+    taa_vpu_mul(c0, d, c0);
+    taa_vpu_mul(c1, d, c1);
+    taa_vpu_mul(c2, d, c2);
+    taa_vpu_store(c0, m_out->x.x);
+    taa_vpu_store(c1, m_out->y.x);
+    taa_vpu_store(c2, m_out->z.x);
+    // x.y = (xz*zy - xy*zz)*d
+    taa_vpu_mul(xz, zy, t0);
+    taa_vpu_mul(xy, zz, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->x.y);
+    // x.z = (xy*yz - xz*yy)*d
+    taa_vpu_mul(xy, yz, t0);
+    taa_vpu_mul(xz, yy, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->x.z);
+    // y.y = (xx*zz - xz*zx)*d
+    taa_vpu_mul(xx, zz, t0);
+    taa_vpu_mul(xz, zx, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->y.y);
+    // y.z = (xz*yx - xx*yz)*d
+    taa_vpu_mul(xz, yx, t0);
+    taa_vpu_mul(xx, yz, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->y.z);
+    // z.y = (xy*zx - xx*zy)*d
+    taa_vpu_mul(xy, zx, t0);
+    taa_vpu_mul(xx, zy, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->z.y);
+    // z.z = (xx*yy - xy*yx)*d
+    taa_vpu_mul(xx, yy, t0);
+    taa_vpu_mul(xy, yx, t1);
+    taa_vpu_sub(t0, t1, t0);
+    taa_vpu_mul(t0, d, t0);
+    taa_vpu_store(t0, m_out->z.z);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_multiply(
+    const taa_mat33x4* a,
+    const taa_mat33x4* b,
+    taa_mat33x4* m_out)
+{
+    const float* pa = a->x.x;
+    const float* pb = b->x.x;
+    float* pout = m_out->x.x;
+    uint32_t i;
+    uint32_t j;
+    assert(a != m_out);
+    assert(b != m_out);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    // each column is 12 floats; element j of column i starts at i*12 + j*4
+    for(i = 0; i < 36; i += 12)
+    {
+        taa_vpu_vec4 bx;
+        taa_vpu_vec4 by;
+        taa_vpu_vec4 bz;
+        taa_vpu_load(pb + i    , bx);
+        taa_vpu_load(pb + i + 4, by);
+        taa_vpu_load(pb + i + 8, bz);
+        for(j = 0; j < 12; j += 4)
+        {
+            taa_vpu_vec4 ax;
+            taa_vpu_vec4 ay;
+            taa_vpu_vec4 az;
+            taa_vpu_load(pa + j     , ax);
+            taa_vpu_load(pa + j + 12, ay);
+            taa_vpu_load(pa + j + 24, az);
+            taa_vpu_mul(ax, bx, ax);
+            taa_vpu_mul(ay, by, ay);
+            taa_vpu_mul(az, bz, az);
+            taa_vpu_add(ax, ay, ax);
+            taa_vpu_add(ax, az, ax);
+            taa_vpu_store(ax, pout + i + j);
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_orthonormalize(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out)
+{
+    // col0' = |col0|
+    // col1' = |col1 - dot(col0', col1) col0'|
+    // col2' = |col2 - dot(col0', col2) col0' - dot(col1', col2) col1'|
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 xy;
+    taa_vpu_vec4 xz;
+    taa_vpu_vec4 yx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 yz;
+    taa_vpu_vec4 zx;
+    taa_vpu_vec4 zy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 tmp;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 tiny;
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_set1(FLT_MIN, tiny);
+    taa_vpu_load(a->x.x, xx);
+    taa_vpu_load(a->x.y, xy);
+    taa_vpu_load(a->x.z, xz);
+    taa_vpu_load(a->y.x, yx);
+    taa_vpu_load(a->y.y, yy);
+    taa_vpu_load(a->y.z, yz);
+    taa_vpu_load(a->z.x, zx);
+    taa_vpu_load(a->z.y, zy);
+    taa_vpu_load(a->z.z, zz);
+    // x = |x|
+    taa_vpu_mul(xx, xx, d);
+    taa_vpu_mul(xy, xy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(xz, xz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_sqrt(d, d);
+    taa_vpu_add(d, tiny, d);
+    taa_vpu_div(one, d, d);
+    taa_vpu_mul(xx, d, xx);
+    taa_vpu_mul(xy, d, xy);
+    taa_vpu_mul(xz, d, xz);
+    // y = |y - dot(x, y) x|
+    taa_vpu_mul(xx, yx, d);
+    taa_vpu_mul(xy, yy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(xz, yz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(xx, d, tmp);
+    taa_vpu_sub(yx, tmp, yx);
+    taa_vpu_mul(xy, d, tmp);
+    taa_vpu_sub(yy, tmp, yy);
+    taa_vpu_mul(xz, d, tmp);
+    taa_vpu_sub(yz, tmp, yz);
+    taa_vpu_mul(yx, yx, d);
+    taa_vpu_mul(yy, yy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(yz, yz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_sqrt(d, d);
+    taa_vpu_add(d, tiny, d);
+    taa_vpu_div(one, d, d);
+    taa_vpu_mul(yx, d, yx);
+    taa_vpu_mul(yy, d, yy);
+    taa_vpu_mul(yz, d, yz);
+    // z = |z - dot(x, z) x - dot(y, z) y|
+    taa_vpu_mul(xx, zx, d);
+    taa_vpu_mul(xy, zy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(xz, zz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(xx, d, tmp);
+    taa_vpu_sub(zx, tmp, zx);
+    taa_vpu_mul(xy, d, tmp);
+    taa_vpu_sub(zy, tmp, zy);
+    taa_vpu_mul(xz, d, tmp);
+    taa_vpu_sub(zz, tmp, zz);
+    taa_vpu_mul(yx, zx, d);
+    taa_vpu_mul(yy, zy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(yz, zz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(yx, d, tmp);
+    taa_vpu_sub(zx, tmp, zx);
+    taa_vpu_mul(yy, d, tmp);
+    taa_vpu_sub(zy, tmp, zy);
+    taa_vpu_mul(yz, d, tmp);
+    taa_vpu_sub(zz, tmp, zz);
+    taa_vpu_mul(zx, zx, d);
+    taa_vpu_mul(zy, zy, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(zz, zz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_sqrt(d, d);
+    taa_vpu_add(d, tiny, d);
+    taa_vpu_div(one, d, d);
+    taa_vpu_mul(zx, d, zx);
+    taa_vpu_mul(zy, d, zy);
+    taa_vpu_mul(zz, d, zz);
+    taa_vpu_store(xx, m_out->x.x);
+    taa_vpu_store(xy, m_out->x.y);
+    taa_vpu_store(xz, m_out->x.z);
+    taa_vpu_store(yx, m_out->y.x);
+    taa_vpu_store(yy, m_out->y.y);
+    taa_vpu_store(yz, m_out->y.z);
+    taa_vpu_store(zx, m_out->z.x);
+    taa_vpu_store(zy, m_out->z.y);
+    taa_vpu_store(zz, m_out->z.z);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_polar(
+    const taa_mat33x4* a,
+    uint32_t iterations,
+    taa_mat33x4* m_out)
+{
+    // transpose(inverse(x)) is the cofactor matrix divided by the
+    // determinant, and the cofactor columns are the cross products of the
+    // column pairs: (y X z, z X x, x X y)
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 xy;
+    taa_vpu_vec4 xz;
+    taa_vpu_vec4 yx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 yz;
+    taa_vpu_vec4 zx;
+    taa_vpu_vec4 zy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 half;
+    uint32_t i;
+    taa_vpu_set1(0.5f, half);
+    taa_vpu_load(a->x.x, xx);
+    taa_vpu_load(a->x.y, xy);
+    taa_vpu_load(a->x.z, xz);
+    taa_vpu_load(a->y.x, yx);
+    taa_vpu_load(a->y.y, yy);
+    taa_vpu_load(a->y.z, yz);
+    taa_vpu_load(a->z.x, zx);
+    taa_vpu_load(a->z.y, zy);
+    taa_vpu_load(a->z.z, zz);
+    for(i = 0; i < iterations; ++i)
+    {
+        taa_vpu_vec4 cxx;
+        taa_vpu_vec4 cxy;
+        taa_vpu_vec4 cxz;
+        taa_vpu_vec4 cyx;
+        taa_vpu_vec4 cyy;
+        taa_vpu_vec4 cyz;
+        taa_vpu_vec4 czx;
+        taa_vpu_vec4 czy;
+        taa_vpu_vec4 czz;
+        taa_vpu_vec4 s;
+        taa_vpu_vec4 tmp;
+        // cx = y X z
+        taa_vpu_mul(yy, zz, cxx);
+        taa_vpu_mul(yz, zy, tmp);
+        taa_vpu_sub(cxx, tmp, cxx);
+        taa_vpu_mul(yz, zx, cxy);
+        taa_vpu_mul(yx, zz, tmp);
+        taa_vpu_sub(cxy, tmp, cxy);
+        taa_vpu_mul(yx, zy, cxz);
+        taa_vpu_mul(yy, zx, tmp);
+        taa_vpu_sub(cxz, tmp, cxz);
+        // cy = z X x
+        taa_vpu_mul(zy, xz, cyx);
+        taa_vpu_mul(zz, xy, tmp);
+        taa_vpu_sub(cyx, tmp, cyx);
+        taa_vpu_mul(zz, xx, cyy);
+        taa_vpu_mul(zx, xz, tmp);
+        taa_vpu_sub(cyy, tmp, cyy);
+        taa_vpu_mul(zx, xy, cyz);
+        taa_vpu_mul(zy, xx, tmp);
+        taa_vpu_sub(cyz, tmp, cyz);
+        // cz = x X y
+        taa_vpu_mul(xy, yz, czx);
+        taa_vpu_mul(xz, yy, tmp);
+        taa_vpu_sub(czx, tmp, czx);
+        taa_vpu_mul(xz, yx, czy);
+        taa_vpu_mul(xx, yz, tmp);
+        taa_vpu_sub(czy, tmp, czy);
+        taa_vpu_mul(xx, yy, czz);
+        taa_vpu_mul(xy, yx, tmp);
+        taa_vpu_sub(czz, tmp, czz);
+        // s = 0.5/dot(x, cx)
+        taa_vpu_mul(xx, cxx, s);
+        taa_vpu_mul(xy, cxy, tmp);
+        taa_vpu_add(s, tmp, s);
+        taa_vpu_mul(xz, cxz, tmp);
+        taa_vpu_add(s, tmp, s);
+        taa_vpu_div(half, s, s);
+        // m = 0.5*m + s*c
+        taa_vpu_mul(xx, half, xx);
+        taa_vpu_mul(cxx, s, tmp);
+        taa_vpu_add(xx, tmp, xx);
+        taa_vpu_mul(xy, half, xy);
+        taa_vpu_mul(cxy, s, tmp);
+        taa_vpu_add(xy, tmp, xy);
+        taa_vpu_mul(xz, half, xz);
+        taa_vpu_mul(cxz, s, tmp);
+        taa_vpu_add(xz, tmp, xz);
+        taa_vpu_mul(yx, half, yx);
+        taa_vpu_mul(cyx, s, tmp);
+        taa_vpu_add(yx, tmp, yx);
+        taa_vpu_mul(yy, half, yy);
+        taa_vpu_mul(cyy, s, tmp);
+        taa_vpu_add(yy, tmp, yy);
+        taa_vpu_mul(yz, half, yz);
+        taa_vpu_mul(cyz, s, tmp);
+        taa_vpu_add(yz, tmp, yz);
+        taa_vpu_mul(zx, half, zx);
+        taa_vpu_mul(czx, s, tmp);
+        taa_vpu_add(zx, tmp, zx);
+        taa_vpu_mul(zy, half, zy);
+        taa_vpu_mul(czy, s, tmp);
+        taa_vpu_add(zy, tmp, zy);
+        taa_vpu_mul(zz, half, zz);
+        taa_vpu_mul(czz, s, tmp);
+        taa_vpu_add(zz, tmp, zz);
+    }
+    taa_vpu_store(xx, m_out->x.x);
+    taa_vpu_store(xy, m_out->x.y);
+    taa_vpu_store(xz, m_out->x.z);
+    taa_vpu_store(yx, m_out->y.x);
+    taa_vpu_store(yy, m_out->y.y);
+    taa_vpu_store(yz, m_out->y.z);
+    taa_vpu_store(zx, m_out->z.x);
+    taa_vpu_store(zy, m_out->z.y);
+    taa_vpu_store(zz, m_out->z.z);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_to_mat33(
+    const taa_mat33x4* a,
+    uint32_t n,
+    taa_mat33* m_out)
+{
+    const taa_mat33* mend = m_out + (n & ~3);
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) a) & 15) == 0);
+    while(m_out != mend)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(j = 0; j < 8; j += 4)
+        {
+            taa_vpu_vec4 e0;
+            taa_vpu_vec4 e1;
+            taa_vpu_vec4 e2;
+            taa_vpu_vec4 e3;
+            taa_vpu_vec4 r0;
+            taa_vpu_vec4 r1;
+            taa_vpu_vec4 r2;
+            taa_vpu_vec4 r3;
+            taa_vpu_load(src + j*4     , e0);
+            taa_vpu_load(src + j*4 +  4, e1);
+            taa_vpu_load(src + j*4 +  8, e2);
+            taa_vpu_load(src + j*4 + 12, e3);
+            taa_vpu_mat44_transpose(e0, e1, e2, e3, r0, r1, r2, r3);
+            taa_vpu_storeu(r0, dst + j     );
+            taa_vpu_storeu(r1, dst + j +  9);
+            taa_vpu_storeu(r2, dst + j + 18);
+            taa_vpu_storeu(r3, dst + j + 27);
+        }
+        dst[ 8] = src[32];
+        dst[17] = src[33];
+        dst[26] = src[34];
+        dst[35] = src[35];
+        ++a;
+        m_out += 4;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(i = 0; i < n; ++i)
+        {
+            for(j = 0; j < 9; ++j)
+            {
+                dst[i*9 + j] = src[j*4 + i];
+            }
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_to_mat44(
+    const taa_mat33x4* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* mend = m_out + (n & ~3);
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 w;
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set(0.0f, 0.0f, 0.0f, 1.0f, w);
+    while(m_out != mend)
+    {
+        // the x, y and z lane arrays of column j are transposed into
+        // column j of the four matrices, with w set to zero
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_load(src + j*12    , x);
+            taa_vpu_load(src + j*12 + 4, y);
+            taa_vpu_load(src + j*12 + 8, z);
+            taa_vpu_mat44_transpose(x, y, z, zero, c0, c1, c2, c3);
+            taa_vpu_store(c0, dst + j*4     );
+            taa_vpu_store(c1, dst + j*4 + 16);
+            taa_vpu_store(c2, dst + j*4 + 32);
+            taa_vpu_store(c3, dst + j*4 + 48);
+        }
+        taa_vpu_store(w, dst + 12);
+        taa_vpu_store(w, dst + 28);
+        taa_vpu_store(w, dst + 44);
+        taa_vpu_store(w, dst + 60);
+        ++a;
+        m_out += 4;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(i = 0; i < n; ++i)
+        {
+            for(j = 0; j < 16; ++j)
+            {
+                uint32_t col = j/4;
+                uint32_t row = j%4;
+                dst[i*16 + j] =
+                    (col < 3 && row < 3) ? src[col*12 + row*4 + i] : 0.0f;
+            }
+            dst[i*16 + 15] = 1.0f;
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_transform_vec3x4(
+    const taa_mat33x4* a,
+    const taa_vec3x4* b,
+    taa_vec3x4* v_out)
+{
+    const float* pa = a->x.x;
+    float* pout = v_out->x;
+    taa_vpu_vec4 bx;
+    taa_vpu_vec4 by;
+    taa_vpu_vec4 bz;
+    uint32_t j;
+    assert(b != v_out);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) v_out) & 15) == 0);
+    taa_vpu_load(b->x, bx);
+    taa_vpu_load(b->y, by);
+    taa_vpu_load(b->z, bz);
+    for(j = 0; j < 12; j += 4)
+    {
+        taa_vpu_vec4 ax;
+        taa_vpu_vec4 ay;
+        taa_vpu_vec4 az;
+        taa_vpu_load(pa + j     , ax);
+        taa_vpu_load(pa + j + 12, ay);
+        taa_vpu_load(pa + j + 24, az);
+        taa_vpu_mul(ax, bx, ax);
+        taa_vpu_mul(ay, by, ay);
+        taa_vpu_mul(az, bz, az);
+        taa_vpu_add(ax, ay, ax);
+        taa_vpu_add(ax, az, ax);
+        taa_vpu_store(ax, pout + j);
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat33x4_transpose(
+    const taa_mat33x4* a,
+    taa_mat33x4* m_out)
+{
+    taa_vpu_vec4 xy;
+    taa_vpu_vec4 xz;
+    taa_vpu_vec4 yx;
+    taa_vpu_vec4 yz;
+    taa_vpu_vec4 zx;
+    taa_vpu_vec4 zy;
+    taa_vpu_vec4 t;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    // each lane holds a different matrix, so transposing only swaps the
+    // off diagonal lane arrays
+    taa_vpu_load(a->x.y, xy);
+    taa_vpu_load(a->x.z, xz);
+    taa_vpu_load(a->y.x, yx);
+    taa_vpu_load(a->y.z, yz);
+    taa_vpu_load(a->z.x, zx);
+    taa_vpu_load(a->z.y, zy);
+    if(a != m_out)
+    {
+        taa_vpu_load(a->x.x, t);
+        taa_vpu_store(t, m_out->x.x);
+        taa_vpu_load(a->y.y, t);
+        taa_vpu_store(t, m_out->y.y);
+        taa_vpu_load(a->z.z, t);
+        taa_vpu_store(t, m_out->z.z);
+    }
+    taa_vpu_store(yx, m_out->x.y);
+    taa_vpu_store(zx, m_out->x.z);
+    taa_vpu_store(xy, m_out->y.x);
+    taa_vpu_store(zy, m_out->y.z);
+    taa_vpu_store(xz, m_out->z.x);
+    taa_vpu_store(yz, m_out->z.y);
+}
+
+#endif // taa_MAT33X4_H_
@@ -7,8 +7,13 @@
 #ifndef taa_MAT44_H_
 #define taa_MAT44_H_
 
+#include "mat33x4.h"
+#include "mat44x4.h"
+#include "quat.h"
+#include "quatx4.h"
 #include "vec4.h"
 #include "vpu.h"
+#include <float.h>
 
 //****************************************************************************
 // forward declarations
@@ -26,6 +31,33 @@ taa_INLINE static void taa_mat44_axisangle(
     const taa_vec4* axis,
     taa_mat44* m_out);
 
+/**
+ * @brief splits a transform into translation, rotation and scale
+ * @details the inverse of taa_mat44_from_trs. The matrix must be affine
+ *          without shear. A mirroring transform is returned as a negative x
+ *          scale. The w component of t_out is 0 and the w component of s_out
+ *          is 1, the same as taa_vec4_from_mat44_translate and
+ *          taa_vec4_from_mat44_scale.
+ */
+taa_INLINE static void taa_mat44_decompose_trs(
+    const taa_mat44* m,
+    taa_vec4* t_out,
+    taa_quat* r_out,
+    taa_vec4* s_out);
+
+/**
+ * @brief splits each transform in an array into translation, rotation and
+ *        scale
+ * @details produces the same results as taa_mat44_decompose_trs, four
+ *          matrices at a time in structure of arrays format.
+ */
+taa_INLINE static void taa_mat44_decompose_trs_array(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_vec4* t_out,
+    taa_quat* r_out,
+    taa_vec4* s_out);
+
 taa_INLINE static void taa_mat44_from_mat33(
     const taa_mat33* a,
     taa_mat44* m_out);
@@ -34,6 +66,16 @@ taa_INLINE static void taa_mat44_from_quat(
     const taa_quat* q,
     taa_mat44* m_out);
 
+/**
+ * @brief converts an array of unit quaternions into rotation matrices
+ * @details the quaternions are converted four at a time in structure of
+ *          arrays format, using taa_mat33x4_from_quatx4.
+ */
+taa_INLINE static void taa_mat44_from_quat_array(
+    const taa_quat* q,
+    uint32_t n,
+    taa_mat44* m_out);
+
 taa_INLINE static void taa_mat44_from_scale(
     const taa_vec4 *scale,
     taa_mat44* m_out);
@@ -42,6 +84,30 @@ taa_INLINE static void taa_mat44_from_translate(
     const taa_vec4* v,
     taa_mat44* m_out);
 
+/**
+ * @brief builds a transform from translation, rotation and scale
+ * @details computes translate(t) * rotate(r) * scale(s) directly, without
+ *          the intermediate matrices. r must be a unit quaternion, and the w
+ *          components of t and s are ignored.
+ */
+taa_INLINE static void taa_mat44_from_trs(
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s,
+    taa_mat44* m_out);
+
+/**
+ * @brief builds an array of transforms from translation, rotation and scale
+ * @details produces the same results as taa_mat44_from_trs, four matrices
+ *          at a time in structure of arrays format.
+ */
+taa_INLINE static void taa_mat44_from_trs_array(
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s,
+    uint32_t n,
+    taa_mat44* m_out);
+
 taa_INLINE static void taa_mat44_identity(
     taa_mat44* m_out);
 
@@ -49,6 +115,49 @@ taa_INLINE static void taa_mat44_inverse(
     const taa_mat44* a,
     taa_mat44* m_out);
 
+/**
+ * @brief inverts an affine matrix
+ * @details the matrix must have a last row of 0,0,0,1. Only the upper 3x3
+ *          block is inverted, and the translation is transformed by the
+ *          result. a and m_out may point to the same matrix.
+ */
+taa_INLINE static void taa_mat44_inverse_affine(
+    const taa_mat44* a,
+    taa_mat44* m_out);
+
+/**
+ * @brief inverts each matrix in an array of affine matrices
+ * @details matrices are transposed into taa_mat44x4 blocks and inverted
+ *          four at a time. a and m_out must each contain n matrices and may
+ *          be the same array.
+ */
+taa_INLINE static void taa_mat44_inverse_affine_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
+/**
+ * @brief inverts a rigid body transform
+ * @details the upper 3x3 block must be orthonormal and the last row must be
+ *          0,0,0,1. The inverse is the transposed rotation with the
+ *          translation rotated and negated. a and m_out may point to the
+ *          same matrix.
+ */
+taa_INLINE static void taa_mat44_inverse_rigid(
+    const taa_mat44* a,
+    taa_mat44* m_out);
+
+/**
+ * @brief inverts each matrix in an array of rigid body transforms
+ * @details matrices are transposed into taa_mat44x4 blocks and inverted
+ *          four at a time. a and m_out must each contain n matrices and may
+ *          be the same array.
+ */
+taa_INLINE static void taa_mat44_inverse_rigid_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
 taa_INLINE static void taa_mat44_lookat(
     const taa_vec4* eye,
     const taa_vec4* target,
@@ -64,6 +173,17 @@ taa_INLINE static void taa_mat44_orthonormalize(
     const taa_mat44* a,
     taa_mat44* m_out);
 
+/**
+ * @brief orthonormalizes an array of matrices
+ * @details produces the same result as taa_mat44_orthonormalize, but four
+ *          matrices at a time in structure of arrays format. a and m_out may
+ *          point to the same array.
+ */
+taa_INLINE static void taa_mat44_orthonormalize_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
 taa_INLINE static void taa_mat44_perspective(
     float fovy,
     float aspect,
@@ -75,6 +195,21 @@ taa_INLINE static void taa_mat44_pitch(
     float pitch,
     taa_mat44* m_out);
 
+/**
+ * @brief replaces the upper 3x3 of each matrix with its closest orthogonal
+ *        matrix
+ * @details uses taa_mat33x4_polar, which treats all three axes equally.
+ *          Matrices with a negative determinant become reflections. As
+ *          with taa_mat44_orthonormalize, the w components are cleared and
+ *          the last column is set to (0, 0, 0, 1). a and m_out may point to
+ *          the same array.
+ */
+taa_INLINE static void taa_mat44_polar_array(
+    const taa_mat44* a,
+    uint32_t n,
+    uint32_t iterations,
+    taa_mat44* m_out);
+
 taa_INLINE static void taa_mat44_roll(
     float roll,
     taa_mat44* m_out);
@@ -145,31 +280,17 @@ taa_INLINE static void taa_mat44_add(
 taa_INLINE static float taa_mat44_determinant(
     const taa_mat44* a)
 {
-    return
-        + a->w.x * a->z.y * a->y.z * a->x.w
-        - a->z.x * a->w.y * a->y.z * a->x.w
-        - a->w.x * a->y.y * a->z.z * a->x.w
-        + a->y.x * a->w.y * a->z.z * a->x.w
-        + a->z.x * a->y.y * a->w.z * a->x.w
-        - a->y.x * a->z.y * a->w.z * a->x.w
-        - a->w.x * a->z.y * a->x.z * a->y.w
-        + a->z.x * a->w.y * a->x.z * a->y.w
-        + a->w.x * a->x.y * a->z.z * a->y.w
-        - a->x.x * a->w.y * a->z.z * a->y.w
-        - a->z.x * a->x.y * a->w.z * a->y.w
-        + a->x.x * a->z.y * a->w.z * a->y.w
-        + a->w.x * a->y.y * a->x.z * a->z.w
-        - a->y.x * a->w.y * a->x.z * a->z.w
-        - a->w.x * a->x.y * a->y.z * a->z.w
-        + a->x.x * a->w.y * a->y.z * a->z.w
-        + a->y.x * a->x.y * a->w.z * a->z.w
-        - a->x.x * a->y.y * a->w.z * a->z.w
-        - a->z.x * a->y.y * a->x.z * a->w.w
-        + a->y.x * a->z.y * a->x.z * a->w.w
-        + a->z.x * a->x.y * a->y.z * a->w.w
-        - a->x.x * a->z.y * a->y.z * a->w.w
-        - a->y.x * a->x.y * a->z.z * a->w.w
-        + a->x.x * a->y.y * a->z.z * a->w.w;
+    taa_vpu_vec4 d;
+    float det;
+    assert((((size_t) a) & 15) == 0);
+    taa_vpu_mat44_determinant(
+        *((taa_vpu_vec4*) &a->x),
+        *((taa_vpu_vec4*) &a->y),
+        *((taa_vpu_vec4*) &a->z),
+        *((taa_vpu_vec4*) &a->w),
+        d);
+    taa_vpu_store1(d, &det);
+    return det;
 }
 
 //****************************************************************************
@@ -198,6 +319,159 @@ taa_INLINE static void taa_mat44_axisangle(
     m_out->w.w = 1.0f;
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat44_decompose_trs(
+    const taa_mat44* m,
+    taa_vec4* t_out,
+    taa_quat* r_out,
+    taa_vec4* s_out)
+{
+    taa_mat33 rot;
+    float sx;
+    float sy;
+    float sz;
+    float det;
+    sx = sqrtf(m->x.x*m->x.x + m->x.y*m->x.y + m->x.z*m->x.z) + FLT_MIN;
+    sy = sqrtf(m->y.x*m->y.x + m->y.y*m->y.y + m->y.z*m->y.z) + FLT_MIN;
+    sz = sqrtf(m->z.x*m->z.x + m->z.y*m->z.y + m->z.z*m->z.z) + FLT_MIN;
+    // det = dot(x, cross(y, z))
+    det = m->x.x*(m->y.y*m->z.z - m->y.z*m->z.y) +
+          m->x.y*(m->y.z*m->z.x - m->y.x*m->z.z) +
+          m->x.z*(m->y.x*m->z.y - m->y.y*m->z.x);
+    sx = (det < 0.0f) ? -sx : sx;
+    taa_vec3_set(m->x.x/sx, m->x.y/sx, m->x.z/sx, &rot.x);
+    taa_vec3_set(m->y.x/sy, m->y.y/sy, m->y.z/sy, &rot.y);
+    taa_vec3_set(m->z.x/sz, m->z.y/sz, m->z.z/sz, &rot.z);
+    taa_quat_from_mat33(&rot, r_out);
+    taa_vec4_set(m->w.x, m->w.y, m->w.z, 0.0f, t_out);
+    taa_vec4_set(sx, sy, sz, 1.0f, s_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_decompose_trs_array(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_vec4* t_out,
+    taa_quat* r_out,
+    taa_vec4* s_out)
+{
+    const taa_mat44* mend = m + n;
+    taa_mat33x4 m4;
+    taa_quatx4 q4;
+    taa_vec4x4 s4;
+    taa_vpu_vec4 tiny;
+    taa_vpu_vec4 sign;
+    taa_vpu_set1(FLT_MIN, tiny);
+    taa_vpu_set1(-0.0f, sign);
+    while(m != mend)
+    {
+        uint32_t nlanes = (uint32_t) (mend - m);
+        taa_vpu_vec4 xx;
+        taa_vpu_vec4 xy;
+        taa_vpu_vec4 xz;
+        taa_vpu_vec4 yx;
+        taa_vpu_vec4 yy;
+        taa_vpu_vec4 yz;
+        taa_vpu_vec4 zx;
+        taa_vpu_vec4 zy;
+        taa_vpu_vec4 zz;
+        taa_vpu_vec4 sx;
+        taa_vpu_vec4 sy;
+        taa_vpu_vec4 sz;
+        taa_vpu_vec4 d;
+        taa_vpu_vec4 tmp;
+        uint32_t i;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat44(m, nlanes, &m4);
+        taa_vpu_load(m4.x.x, xx);
+        taa_vpu_load(m4.x.y, xy);
+        taa_vpu_load(m4.x.z, xz);
+        taa_vpu_load(m4.y.x, yx);
+        taa_vpu_load(m4.y.y, yy);
+        taa_vpu_load(m4.y.z, yz);
+        taa_vpu_load(m4.z.x, zx);
+        taa_vpu_load(m4.z.y, zy);
+        taa_vpu_load(m4.z.z, zz);
+        // column lengths
+        taa_vpu_mul(xx, xx, sx);
+        taa_vpu_mul(xy, xy, tmp);
+        taa_vpu_add(sx, tmp, sx);
+        taa_vpu_mul(xz, xz, tmp);
+        taa_vpu_add(sx, tmp, sx);
+        taa_vpu_sqrt(sx, sx);
+        taa_vpu_add(sx, tiny, sx);
+        taa_vpu_mul(yx, yx, sy);
+        taa_vpu_mul(yy, yy, tmp);
+        taa_vpu_add(sy, tmp, sy);
+        taa_vpu_mul(yz, yz, tmp);
+        taa_vpu_add(sy, tmp, sy);
+        taa_vpu_sqrt(sy, sy);
+        taa_vpu_add(sy, tiny, sy);
+        taa_vpu_mul(zx, zx, sz);
+        taa_vpu_mul(zy, zy, tmp);
+        taa_vpu_add(sz, tmp, sz);
+        taa_vpu_mul(zz, zz, tmp);
+        taa_vpu_add(sz, tmp, sz);
+        taa_vpu_sqrt(sz, sz);
+        taa_vpu_add(sz, tiny, sz);
+        // d = dot(x, cross(y, z)), and its sign is moved onto sx
+        taa_vpu_mul(yy, zz, d);
+        taa_vpu_mul(yz, zy, tmp);
+        taa_vpu_sub(d, tmp, d);
+        taa_vpu_mul(xx, d, d);
+        taa_vpu_mul(yz, zx, tmp);
+        taa_vpu_mul(xy, tmp, tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_mul(yx, zz, tmp);
+        taa_vpu_mul(xy, tmp, tmp);
+        taa_vpu_sub(d, tmp, d);
+        taa_vpu_mul(yx, zy, tmp);
+        taa_vpu_mul(xz, tmp, tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_mul(yy, zx, tmp);
+        taa_vpu_mul(xz, tmp, tmp);
+        taa_vpu_sub(d, tmp, d);
+        taa_vpu_and(d, sign, d);
+        taa_vpu_xor(sx, d, sx);
+        // rotation = columns / scale
+        taa_vpu_div(xx, sx, xx);
+        taa_vpu_div(xy, sx, xy);
+        taa_vpu_div(xz, sx, xz);
+        taa_vpu_div(yx, sy, yx);
+        taa_vpu_div(yy, sy, yy);
+        taa_vpu_div(yz, sy, yz);
+        taa_vpu_div(zx, sz, zx);
+        taa_vpu_div(zy, sz, zy);
+        taa_vpu_div(zz, sz, zz);
+        taa_vpu_store(xx, m4.x.x);
+        taa_vpu_store(xy, m4.x.y);
+        taa_vpu_store(xz, m4.x.z);
+        taa_vpu_store(yx, m4.y.x);
+        taa_vpu_store(yy, m4.y.y);
+        taa_vpu_store(yz, m4.y.z);
+        taa_vpu_store(zx, m4.z.x);
+        taa_vpu_store(zy, m4.z.y);
+        taa_vpu_store(zz, m4.z.z);
+        taa_quatx4_from_mat33x4(&m4, &q4);
+        taa_quatx4_to_quat(&q4, nlanes, r_out);
+        taa_vpu_set1(1.0f, tmp);
+        taa_vpu_store(sx, s4.x);
+        taa_vpu_store(sy, s4.y);
+        taa_vpu_store(sz, s4.z);
+        taa_vpu_store(tmp, s4.w);
+        taa_vec4x4_to_vec4(&s4, nlanes, s_out);
+        for(i = 0; i < nlanes; ++i)
+        {
+            t_out[i] = m[i].w;
+            t_out[i].w = 0.0f;
+        }
+        m += nlanes;
+        t_out += nlanes;
+        r_out += nlanes;
+        s_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat44_from_mat33(
     const taa_mat33* a,
@@ -230,6 +504,27 @@ taa_INLINE static void taa_mat44_from_quat(
     taa_vec4_set(        0.0f,         0.0f,         0.0f, 1.0f, &m_out->w);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat44_from_quat_array(
+    const taa_quat* q,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_quat* qend = q + n;
+    taa_quatx4 q4;
+    taa_mat33x4 m4;
+    while(q != qend)
+    {
+        uint32_t nlanes = (uint32_t) (qend - q);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_quatx4_from_quat(q, nlanes, &q4);
+        taa_mat33x4_from_quatx4(&q4, &m4);
+        taa_mat33x4_to_mat44(&m4, nlanes, m_out);
+        q += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat44_from_scale(
     const taa_vec4 *scale,
@@ -254,6 +549,89 @@ taa_INLINE static void taa_mat44_from_translate(
     taa_vec4_set( v->x, v->y, v->z, 1.0f, &m_out->w);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat44_from_trs(
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s,
+    taa_mat44* m_out)
+{
+    float xx = 2.0f * r->x * r->x;
+    float xy = 2.0f * r->y * r->x;
+    float xz = 2.0f * r->z * r->x;
+    float yy = 2.0f * r->y * r->y;
+    float yz = 2.0f * r->z * r->y;
+    float zz = 2.0f * r->z * r->z;
+    float wx = 2.0f * r->x * r->w;
+    float wy = 2.0f * r->y * r->w;
+    float wz = 2.0f * r->z * r->w;
+    // columns are the rotation columns multiplied by the scale
+    m_out->x.x = (1.0f-(yy+zz)) * s->x;
+    m_out->x.y = (       xy+wz) * s->x;
+    m_out->x.z = (       xz-wy) * s->x;
+    m_out->x.w = 0.0f;
+    m_out->y.x = (       xy-wz) * s->y;
+    m_out->y.y = (1.0f-(xx+zz)) * s->y;
+    m_out->y.z = (       yz+wx) * s->y;
+    m_out->y.w = 0.0f;
+    m_out->z.x = (       xz+wy) * s->z;
+    m_out->z.y = (       yz-wx) * s->z;
+    m_out->z.z = (1.0f-(xx+yy)) * s->z;
+    m_out->z.w = 0.0f;
+    taa_vec4_set(t->x, t->y, t->z, 1.0f, &m_out->w);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_from_trs_array(
+    const taa_vec4* t,
+    const taa_quat* r,
+    const taa_vec4* s,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_vec4* tend = t + n;
+    taa_quatx4 q4;
+    taa_mat33x4 m4;
+    taa_vec4x4 s4;
+    while(t != tend)
+    {
+        uint32_t nlanes = (uint32_t) (tend - t);
+        uint32_t i;
+        uint32_t j;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_quatx4_from_quat(r, nlanes, &q4);
+        taa_vec4x4_from_vec4(s, nlanes, &s4);
+        taa_mat33x4_from_quatx4(&q4, &m4);
+        // scale each rotation column j by the lanes of scale component j
+        for(j = 0; j < 3; ++j)
+        {
+            float* col = m4.x.x + j*12;
+            taa_vpu_vec4 sj;
+            taa_vpu_vec4 c;
+            taa_vpu_load(s4.x + j*4, sj);
+            taa_vpu_load(col    , c);
+            taa_vpu_mul(c, sj, c);
+            taa_vpu_store(c, col    );
+            taa_vpu_load(col + 4, c);
+            taa_vpu_mul(c, sj, c);
+            taa_vpu_store(c, col + 4);
+            taa_vpu_load(col + 8, c);
+            taa_vpu_mul(c, sj, c);
+            taa_vpu_store(c, col + 8);
+        }
+        taa_mat33x4_to_mat44(&m4, nlanes, m_out);
+        for(i = 0; i < nlanes; ++i)
+        {
+            m_out[i].w = t[i];
+            m_out[i].w.w = 1.0f;
+        }
+        t += nlanes;
+        r += nlanes;
+        s += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat44_identity(
     taa_mat44* m_out)
@@ -270,75 +648,241 @@ taa_INLINE static void taa_mat44_inverse(
     const taa_mat44* a,
     taa_mat44* m_out)
 {
-    float d = 1.0f/taa_mat44_determinant(a);
+    taa_vpu_vec4 d;
     assert(a != m_out);
-    m_out->x.x = d *
-        (a->z.y*a->w.z*a->y.w - a->w.y*a->z.z*a->y.w +
-         a->w.y*a->y.z*a->z.w - a->y.y*a->w.z*a->z.w -
-         a->z.y*a->y.z*a->w.w + a->y.y*a->z.z*a->w.w);
-    m_out->x.y = d *
-        (a->w.y*a->z.z*a->x.w - a->z.y*a->w.z*a->x.w -
-         a->w.y*a->x.z*a->z.w + a->x.y*a->w.z*a->z.w +
-         a->z.y*a->x.z*a->w.w - a->x.y*a->z.z*a->w.w);
-    m_out->x.z = d *
-        (a->y.y*a->w.z*a->x.w - a->w.y*a->y.z*a->x.w +
-         a->w.y*a->x.z*a->y.w - a->x.y*a->w.z*a->y.w -
-         a->y.y*a->x.z*a->w.w + a->x.y*a->y.z*a->w.w);
-    m_out->x.w = d *
-        (a->z.y*a->y.z*a->x.w - a->y.y*a->z.z*a->x.w -
-         a->z.y*a->x.z*a->y.w + a->x.y*a->z.z*a->y.w +
-         a->y.y*a->x.z*a->z.w - a->x.y*a->y.z*a->z.w);
-
-    m_out->y.x = d *
-        (a->w.x*a->z.z*a->y.w - a->z.x*a->w.z*a->y.w -
-         a->w.x*a->y.z*a->z.w + a->y.x*a->w.z*a->z.w +
-         a->z.x*a->y.z*a->w.w - a->y.x*a->z.z*a->w.w);
-    m_out->y.y = d *
-        (a->z.x*a->w.z*a->x.w - a->w.x*a->z.z*a->x.w +
-         a->w.x*a->x.z*a->z.w - a->x.x*a->w.z*a->z.w -
-         a->z.x*a->x.z*a->w.w + a->x.x*a->z.z*a->w.w);
-    m_out->y.z =  d *
-        (a->w.x*a->y.z*a->x.w - a->y.x*a->w.z*a->x.w -
-         a->w.x*a->x.z*a->y.w + a->x.x*a->w.z*a->y.w +
-         a->y.x*a->x.z*a->w.w - a->x.x*a->y.z*a->w.w);
-    m_out->y.w = d *
-        (a->y.x*a->z.z*a->x.w - a->z.x*a->y.z*a->x.w +
-         a->z.x*a->x.z*a->y.w - a->x.x*a->z.z*a->y.w -
-         a->y.x*a->x.z*a->z.w + a->x.x*a->y.z*a->z.w);
-
-    m_out->z.x = d *
-        (a->z.x*a->w.y*a->y.w - a->w.x*a->z.y*a->y.w +
-         a->w.x*a->y.y*a->z.w - a->y.x*a->w.y*a->z.w -
-         a->z.x*a->y.y*a->w.w + a->y.x*a->z.y*a->w.w);
-    m_out->z.y = d *
-        (a->w.x*a->z.y*a->x.w - a->z.x*a->w.y*a->x.w -
-         a->w.x*a->x.y*a->z.w + a->x.x*a->w.y*a->z.w +
-         a->z.x*a->x.y*a->w.w - a->x.x*a->z.y*a->w.w);
-    m_out->z.z = d *
-        (a->y.x*a->w.y*a->x.w - a->w.x*a->y.y*a->x.w +
-         a->w.x*a->x.y*a->y.w - a->x.x*a->w.y*a->y.w -
-         a->y.x*a->x.y*a->w.w + a->x.x*a->y.y*a->w.w);
-    m_out->z.w = d *
-        (a->z.x*a->y.y*a->x.w - a->y.x*a->z.y*a->x.w -
-         a->z.x*a->x.y*a->y.w + a->x.x*a->z.y*a->y.w +
-         a->y.x*a->x.y*a->z.w - a->x.x*a->y.y*a->z.w);
-
-    m_out->w.x = d *
-        (a->w.x*a->z.y*a->y.z - a->z.x*a->w.y*a->y.z -
-         a->w.x*a->y.y*a->z.z + a->y.x*a->w.y*a->z.z +
-         a->z.x*a->y.y*a->w.z - a->y.x*a->z.y*a->w.z);
-    m_out->w.y = d *
-        (a->z.x*a->w.y*a->x.z - a->w.x*a->z.y*a->x.z +
-         a->w.x*a->x.y*a->z.z - a->x.x*a->w.y*a->z.z -
-         a->z.x*a->x.y*a->w.z + a->x.x*a->z.y*a->w.z);
-    m_out->w.z = d *
-        (a->w.x*a->y.y*a->x.z - a->y.x*a->w.y*a->x.z -
-         a->w.x*a->x.y*a->y.z + a->x.x*a->w.y*a->y.z +
-         a->y.x*a->x.y*a->w.z - a->x.x*a->y.y*a->w.z);
-    m_out->w.w = d *
-        (a->y.x*a->z.y*a->x.z - a->z.x*a->y.y*a->x.z +
-         a->z.x*a->x.y*a->y.z - a->x.x*a->z.y*a->y.z -
-         a->y.x*a->x.y*a->z.z + a->x.x*a->y.y*a->z.z);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    taa_vpu_mat44_inverse(
+        *((taa_vpu_vec4*) &a->x),
+        *((taa_vpu_vec4*) &a->y),
+        *((taa_vpu_vec4*) &a->z),
+        *((taa_vpu_vec4*) &a->w),
+        *((taa_vpu_vec4*) &m_out->x),
+        *((taa_vpu_vec4*) &m_out->y),
+        *((taa_vpu_vec4*) &m_out->z),
+        *((taa_vpu_vec4*) &m_out->w),
+        d);
+    // the determinant is a by-product; callers that need it can use the
+    // taa_vpu_mat44_inverse macro directly
+    (void) d;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_inverse_affine(
+    const taa_mat44* a,
+    taa_mat44* m_out)
+{
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 c3;
+    taa_vpu_vec4 r0;
+    taa_vpu_vec4 r1;
+    taa_vpu_vec4 r2;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 one;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    taa_vpu_load(&a->x.x, c0);
+    taa_vpu_load(&a->y.x, c1);
+    taa_vpu_load(&a->z.x, c2);
+    taa_vpu_load(&a->w.x, c3);
+    // the rows of the 3x3 inverse are the cross products of the columns
+    // divided by the determinant. the w components of the crosses are 0.
+    taa_vpu_cross3(c1, c2, r0);
+    taa_vpu_cross3(c2, c0, r1);
+    taa_vpu_cross3(c0, c1, r2);
+    taa_vpu_dot(c0, r0, d);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_div(one, d, d);
+    taa_vpu_mul(r0, d, r0);
+    taa_vpu_mul(r1, d, r1);
+    taa_vpu_mul(r2, d, r2);
+    taa_vpu_mat33_transpose(r0, r1, r2, c0, c1, c2);
+    // translation = (0,0,0,1) - inverse(upper 3x3) * translation
+    taa_vpu_mat34_mul_vec4(c0, c1, c2, c3, r0);
+    taa_vpu_set(0.0f, 0.0f, 0.0f, 1.0f, c3);
+    taa_vpu_sub(c3, r0, c3);
+    taa_vpu_store(c0, &m_out->x.x);
+    taa_vpu_store(c1, &m_out->y.x);
+    taa_vpu_store(c2, &m_out->z.x);
+    taa_vpu_store(c3, &m_out->w.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_inverse_affine_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* aend = a + n;
+    taa_mat44x4 m4;
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        float* src = m4.x.x;
+        taa_vpu_vec4 c[3][3];
+        taa_vpu_vec4 r[3][3];
+        taa_vpu_vec4 t[3];
+        taa_vpu_vec4 d;
+        taa_vpu_vec4 tmp;
+        int i;
+        int j;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat44x4_from_mat44(a, nlanes, &m4);
+        for(i = (int) nlanes; i < 4; ++i)
+        {
+            // unused lanes are zero, make them identity to avoid dividing
+            // by zero
+            m4.x.x[i] = 1.0f;
+            m4.y.y[i] = 1.0f;
+            m4.z.z[i] = 1.0f;
+        }
+        // c[i][j] holds component j of column i for each lane
+        for(i = 0; i < 3; ++i)
+        {
+            for(j = 0; j < 3; ++j)
+            {
+                taa_vpu_load(src + i*16 + j*4, c[i][j]);
+            }
+            taa_vpu_load(src + 48 + i*4, t[i]);
+        }
+        // the rows of the 3x3 inverse are the cross products of the columns
+        // divided by the determinant
+        for(i = 0; i < 3; ++i)
+        {
+            int i1 = (i + 1) % 3;
+            int i2 = (i + 2) % 3;
+            for(j = 0; j < 3; ++j)
+            {
+                int j1 = (j + 1) % 3;
+                int j2 = (j + 2) % 3;
+                taa_vpu_mul(c[i1][j1], c[i2][j2], r[i][j]);
+                taa_vpu_mul(c[i1][j2], c[i2][j1], tmp);
+                taa_vpu_sub(r[i][j], tmp, r[i][j]);
+            }
+        }
+        taa_vpu_mul(c[0][0], r[0][0], d);
+        taa_vpu_mul(c[0][1], r[0][1], tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_mul(c[0][2], r[0][2], tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_div(one, d, d);
+        // column j of the inverse is (r[0][j], r[1][j], r[2][j], 0), and
+        // the translation is -(inverse * t)
+        for(i = 0; i < 3; ++i)
+        {
+            taa_vpu_vec4 dt;
+            for(j = 0; j < 3; ++j)
+            {
+                taa_vpu_mul(r[i][j], d, r[i][j]);
+                taa_vpu_store(r[i][j], src + j*16 + i*4);
+            }
+            taa_vpu_mul(r[i][0], t[0], dt);
+            taa_vpu_mul(r[i][1], t[1], tmp);
+            taa_vpu_add(dt, tmp, dt);
+            taa_vpu_mul(r[i][2], t[2], tmp);
+            taa_vpu_add(dt, tmp, dt);
+            taa_vpu_sub(zero, dt, dt);
+            taa_vpu_store(zero, src + i*16 + 12);
+            taa_vpu_store(dt, src + 48 + i*4);
+        }
+        taa_vpu_store(one, src + 60);
+        taa_mat44x4_to_mat44(&m4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_inverse_rigid(
+    const taa_mat44* a,
+    taa_mat44* m_out)
+{
+    taa_vpu_vec4 c0;
+    taa_vpu_vec4 c1;
+    taa_vpu_vec4 c2;
+    taa_vpu_vec4 c3;
+    taa_vpu_vec4 r0;
+    taa_vpu_vec4 r1;
+    taa_vpu_vec4 r2;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    taa_vpu_load(&a->x.x, c0);
+    taa_vpu_load(&a->y.x, c1);
+    taa_vpu_load(&a->z.x, c2);
+    taa_vpu_load(&a->w.x, c3);
+    // the w components of the transposed columns come from c2.w, which is 0
+    taa_vpu_mat33_transpose(c0, c1, c2, r0, r1, r2);
+    // translation = (0,0,0,1) - transpose(upper 3x3) * translation
+    taa_vpu_mat34_mul_vec4(r0, r1, r2, c3, c0);
+    taa_vpu_set(0.0f, 0.0f, 0.0f, 1.0f, c3);
+    taa_vpu_sub(c3, c0, c3);
+    taa_vpu_store(r0, &m_out->x.x);
+    taa_vpu_store(r1, &m_out->y.x);
+    taa_vpu_store(r2, &m_out->z.x);
+    taa_vpu_store(c3, &m_out->w.x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44_inverse_rigid_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* aend = a + n;
+    taa_mat44x4 m4;
+    taa_mat44x4 r4;
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        const float* src = m4.x.x;
+        float* dst = r4.x.x;
+        taa_vpu_vec4 t[3];
+        int i;
+        int j;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat44x4_from_mat44(a, nlanes, &m4);
+        for(i = 0; i < 3; ++i)
+        {
+            taa_vpu_load(src + 48 + i*4, t[i]);
+        }
+        // the inverse rotation is the transpose, and the translation is
+        // -(transpose * t), so component i of it is -dot(column i, t)
+        for(i = 0; i < 3; ++i)
+        {
+            taa_vpu_vec4 dt;
+            taa_vpu_vec4 tmp;
+            for(j = 0; j < 3; ++j)
+            {
+                taa_vpu_load(src + i*16 + j*4, tmp);
+                taa_vpu_store(tmp, dst + j*16 + i*4);
+            }
+            taa_vpu_load(src + i*16, dt);
+            taa_vpu_mul(dt, t[0], dt);
+            taa_vpu_load(src + i*16 + 4, tmp);
+            taa_vpu_mul(tmp, t[1], tmp);
+            taa_vpu_add(dt, tmp, dt);
+            taa_vpu_load(src + i*16 + 8, tmp);
+            taa_vpu_mul(tmp, t[2], tmp);
+            taa_vpu_add(dt, tmp, dt);
+            taa_vpu_sub(zero, dt, dt);
+            taa_vpu_store(zero, dst + i*16 + 12);
+            taa_vpu_store(dt, dst + 48 + i*4);
+        }
+        taa_vpu_store(one, dst + 60);
+        taa_mat44x4_to_mat44(&r4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
 }
 
 //****************************************************************************
@@ -444,6 +988,26 @@ taa_INLINE static void taa_mat44_orthonormalize(
     taa_vec4_set(0.0f, 0.0f, 0.0f, 1.0f, &m_out->w);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat44_orthonormalize_array(
+    const taa_mat44* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* aend = a + n;
+    taa_mat33x4 m4;
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat44(a, nlanes, &m4);
+        taa_mat33x4_orthonormalize(&m4, &m4);
+        taa_mat33x4_to_mat44(&m4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat44_perspective(
     float fovy,
@@ -481,6 +1045,36 @@ taa_INLINE static void taa_mat44_pitch(
     taa_vec4_set(0.0f, 0.0f, 0.0f, 1.0f, &m_out->w);
 }
 
+//****************************************************************************
+taa_INLINE static void taa_mat44_polar_array(
+    const taa_mat44* a,
+    uint32_t n,
+    uint32_t iterations,
+    taa_mat44* m_out)
+{
+    const taa_mat44* aend = a + n;
+    taa_mat33x4 m4;
+    while(a != aend)
+    {
+        uint32_t nlanes = (uint32_t) (aend - a);
+        uint32_t i;
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat44(a, nlanes, &m4);
+        for(i = nlanes; i < 4; ++i)
+        {
+            // unused lanes are zero, make them identity to keep the newton
+            // iteration from dividing by zero
+            m4.x.x[i] = 1.0f;
+            m4.y.y[i] = 1.0f;
+            m4.z.z[i] = 1.0f;
+        }
+        taa_mat33x4_polar(&m4, iterations, &m4);
+        taa_mat33x4_to_mat44(&m4, nlanes, m_out);
+        a += nlanes;
+        m_out += nlanes;
+    }
+}
+
 //****************************************************************************
 taa_INLINE static void taa_mat44_roll(
     float roll,
@@ -0,0 +1,389 @@
+/**
+ * @brief     header for inlined structure of arrays 4x4 matrix functions
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_MAT44X4_H_
+#define taa_MAT44X4_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief converts an array of matrices into structure of arrays format
+ * @details m_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element are set to zero.
+ */
+taa_INLINE static void taa_mat44x4_from_mat44(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat44x4* m_out);
+
+/**
+ * @brief non-temporal store version of taa_mat44x4_from_mat44
+ */
+taa_INLINE static void taa_mat44x4_from_mat44_stream(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat44x4* m_out);
+
+/**
+ * @brief converts up to four indexed matrices into structure of arrays format
+ * @details lane i is loaded from m[indices[i]]. Unused lanes repeat the last
+ *          matrix. n must be 1 to 4.
+ */
+taa_INLINE static void taa_mat44x4_gather(
+    const taa_mat44* m,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_mat44x4* m_out);
+
+/**
+ * @brief multiplies four pairs of matrices, m_out = a * b for each lane
+ * @details m_out may be the same as a or b.
+ */
+taa_INLINE static void taa_mat44x4_multiply(
+    const taa_mat44x4* a,
+    const taa_mat44x4* b,
+    taa_mat44x4* m_out);
+
+/**
+ * @brief writes the first n lanes to indexed matrices
+ * @details lane i is stored to m_out[indices[i]]. n must be 1 to 4.
+ */
+taa_INLINE static void taa_mat44x4_scatter(
+    const taa_mat44x4* a,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_mat44* m_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of matrices
+ * @details a must contain (n + 3)/4 elements.
+ */
+taa_INLINE static void taa_mat44x4_to_mat44(
+    const taa_mat44x4* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
+/**
+ * @brief non-temporal store version of taa_mat44x4_to_mat44
+ */
+taa_INLINE static void taa_mat44x4_to_mat44_stream(
+    const taa_mat44x4* a,
+    uint32_t n,
+    taa_mat44* m_out);
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_from_mat44(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat44x4* m_out)
+{
+    const taa_mat44* mend = m + (n & ~3);
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    while(m != mend)
+    {
+        // each matrix column j of the four inputs is transposed into the
+        // x, y, z and w lane arrays of output column j
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 w;
+            taa_vpu_load(src + j     , c0);
+            taa_vpu_load(src + j + 16, c1);
+            taa_vpu_load(src + j + 32, c2);
+            taa_vpu_load(src + j + 48, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, x, y, z, w);
+            taa_vpu_store(x, dst + j*4     );
+            taa_vpu_store(y, dst + j*4 +  4);
+            taa_vpu_store(z, dst + j*4 +  8);
+            taa_vpu_store(w, dst + j*4 + 12);
+        }
+        m += 4;
+        ++m_out;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(i = 0; i < 4; ++i)
+        {
+            for(j = 0; j < 16; ++j)
+            {
+                dst[j*4 + i] = (i < n) ? src[i*16 + j] : 0.0f;
+            }
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_from_mat44_stream(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_mat44x4* m_out)
+{
+    const taa_mat44* mend = m + (n & ~3);
+    uint32_t j;
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    while(m != mend)
+    {
+        const float* src = &m->x.x;
+        float* dst = m_out->x.x;
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 w;
+            taa_vpu_load(src + j     , c0);
+            taa_vpu_load(src + j + 16, c1);
+            taa_vpu_load(src + j + 32, c2);
+            taa_vpu_load(src + j + 48, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, x, y, z, w);
+            taa_vpu_stream(x, dst + j*4     );
+            taa_vpu_stream(y, dst + j*4 +  4);
+            taa_vpu_stream(z, dst + j*4 +  8);
+            taa_vpu_stream(w, dst + j*4 + 12);
+        }
+        m += 4;
+        ++m_out;
+    }
+    taa_vpu_stream_fence();
+    taa_mat44x4_from_mat44(m, n & 3, m_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_gather(
+    const taa_mat44* m,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_mat44x4* m_out)
+{
+    const float* src0 = &m[indices[0]].x.x;
+    const float* src1 = &m[indices[(n > 1) ? 1 : 0]].x.x;
+    const float* src2 = &m[indices[(n > 2) ? 2 : n - 1]].x.x;
+    const float* src3 = &m[indices[n - 1]].x.x;
+    float* dst = m_out->x.x;
+    uint32_t j;
+    assert(n > 0 && n <= 4);
+    assert((((size_t) m) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    for(j = 0; j < 16; j += 4)
+    {
+        taa_vpu_vec4 c0;
+        taa_vpu_vec4 c1;
+        taa_vpu_vec4 c2;
+        taa_vpu_vec4 c3;
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_vec4 w;
+        taa_vpu_load(src0 + j, c0);
+        taa_vpu_load(src1 + j, c1);
+        taa_vpu_load(src2 + j, c2);
+        taa_vpu_load(src3 + j, c3);
+        taa_vpu_mat44_transpose(c0, c1, c2, c3, x, y, z, w);
+        taa_vpu_store(x, dst + j*4     );
+        taa_vpu_store(y, dst + j*4 +  4);
+        taa_vpu_store(z, dst + j*4 +  8);
+        taa_vpu_store(w, dst + j*4 + 12);
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_multiply(
+    const taa_mat44x4* a,
+    const taa_mat44x4* b,
+    taa_mat44x4* m_out)
+{
+    // ak[k*4 + r] holds row r of column k of a for each lane
+    taa_vpu_vec4 ak[16];
+    const float* pa = a->x.x;
+    const float* pb = b->x.x;
+    float* dst = m_out->x.x;
+    uint32_t c;
+    uint32_t r;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    for(r = 0; r < 16; ++r)
+    {
+        taa_vpu_load(pa + r*4, ak[r]);
+    }
+    for(c = 0; c < 4; ++c)
+    {
+        // column c of the result is a * column c of b
+        taa_vpu_vec4 bx;
+        taa_vpu_vec4 by;
+        taa_vpu_vec4 bz;
+        taa_vpu_vec4 bw;
+        taa_vpu_load(pb + c*16     , bx);
+        taa_vpu_load(pb + c*16 +  4, by);
+        taa_vpu_load(pb + c*16 +  8, bz);
+        taa_vpu_load(pb + c*16 + 12, bw);
+        for(r = 0; r < 4; ++r)
+        {
+            taa_vpu_vec4 v;
+            taa_vpu_vec4 tmp;
+            taa_vpu_mul(ak[r], bx, v);
+            taa_vpu_mul(ak[4 + r], by, tmp);
+            taa_vpu_add(v, tmp, v);
+            taa_vpu_mul(ak[8 + r], bz, tmp);
+            taa_vpu_add(v, tmp, v);
+            taa_vpu_mul(ak[12 + r], bw, tmp);
+            taa_vpu_add(v, tmp, v);
+            taa_vpu_store(v, dst + c*16 + r*4);
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_scatter(
+    const taa_mat44x4* a,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const float* src = a->x.x;
+    uint32_t i;
+    uint32_t j;
+    assert(n > 0 && n <= 4);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    for(j = 0; j < 16; j += 4)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_vec4 w;
+        taa_vpu_vec4 c[4];
+        taa_vpu_load(src + j*4     , x);
+        taa_vpu_load(src + j*4 +  4, y);
+        taa_vpu_load(src + j*4 +  8, z);
+        taa_vpu_load(src + j*4 + 12, w);
+        taa_vpu_mat44_transpose(x, y, z, w, c[0], c[1], c[2], c[3]);
+        for(i = 0; i < n; ++i)
+        {
+            taa_vpu_store(c[i], &m_out[indices[i]].x.x + j);
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_to_mat44(
+    const taa_mat44x4* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* mend = m_out + (n & ~3);
+    uint32_t i;
+    uint32_t j;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    while(m_out != mend)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 w;
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_load(src + j*4     , x);
+            taa_vpu_load(src + j*4 +  4, y);
+            taa_vpu_load(src + j*4 +  8, z);
+            taa_vpu_load(src + j*4 + 12, w);
+            taa_vpu_mat44_transpose(x, y, z, w, c0, c1, c2, c3);
+            taa_vpu_store(c0, dst + j     );
+            taa_vpu_store(c1, dst + j + 16);
+            taa_vpu_store(c2, dst + j + 32);
+            taa_vpu_store(c3, dst + j + 48);
+        }
+        ++a;
+        m_out += 4;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(i = 0; i < n; ++i)
+        {
+            for(j = 0; j < 16; ++j)
+            {
+                dst[i*16 + j] = src[j*4 + i];
+            }
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mat44x4_to_mat44_stream(
+    const taa_mat44x4* a,
+    uint32_t n,
+    taa_mat44* m_out)
+{
+    const taa_mat44* mend = m_out + (n & ~3);
+    uint32_t j;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) m_out) & 15) == 0);
+    while(m_out != mend)
+    {
+        const float* src = a->x.x;
+        float* dst = &m_out->x.x;
+        for(j = 0; j < 16; j += 4)
+        {
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 w;
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_load(src + j*4     , x);
+            taa_vpu_load(src + j*4 +  4, y);
+            taa_vpu_load(src + j*4 +  8, z);
+            taa_vpu_load(src + j*4 + 12, w);
+            taa_vpu_mat44_transpose(x, y, z, w, c0, c1, c2, c3);
+            taa_vpu_stream(c0, dst + j     );
+            taa_vpu_stream(c1, dst + j + 16);
+            taa_vpu_stream(c2, dst + j + 32);
+            taa_vpu_stream(c3, dst + j + 48);
+        }
+        ++a;
+        m_out += 4;
+    }
+    taa_vpu_stream_fence();
+    taa_mat44x4_to_mat44(a, n & 3, m_out);
+}
+
+#endif // taa_MAT44X4_H_
@@ -37,6 +37,14 @@ typedef struct taa_mat33_s taa_mat33;
  */
 typedef struct taa_mat44_s taa_mat44;
 
+/**
+ * @brief a unit dual quaternion representing a rigid transform
+ * @details This structure MUST BE aligned on 16 byte boundaries. real is the
+ *          rotation and dual is 0.5 * t * real, where t is the translation
+ *          as a quaternion with a w of zero.
+ */
+typedef struct taa_dualquat_s taa_dualquat;
+
 /**
  * @brief a 4 dimensional quaternion
  * @details This structure MUST BE aligned on 16 byte boundaries.
@@ -61,6 +69,42 @@ typedef struct taa_vec3_s taa_vec3;
  */
 typedef struct taa_vec4_s taa_vec4;
 
+/**
+ * @brief four 3 dimensional vectors in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Each
+ *          component array holds the value for one vector per lane.
+ */
+typedef struct taa_vec3x4_s taa_vec3x4;
+
+/**
+ * @brief four 4 dimensional vectors in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Each
+ *          component array holds the value for one vector per lane.
+ */
+typedef struct taa_vec4x4_s taa_vec4x4;
+
+/**
+ * @brief four quaternions in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries.
+ */
+typedef struct taa_vec4x4_s taa_quatx4;
+
+/**
+ * @brief four 3x3 matrices in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Columns
+ *          are stored the same as taa_mat33, but each element is a four
+ *          lane array holding the value for one matrix per lane.
+ */
+typedef struct taa_mat33x4_s taa_mat33x4;
+
+/**
+ * @brief four 4x4 matrices in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Columns
+ *          are stored the same as taa_mat44, but each element is a four
+ *          lane array holding the value for one matrix per lane.
+ */
+typedef struct taa_mat44x4_s taa_mat44x4;
+
 struct taa_vec2_s
 {
     float x, y;
@@ -91,4 +135,40 @@ struct taa_DECLSPEC_ALIGN(16) taa_mat44_s
     taa_vec4 w;
 } taa_ATTRIB_ALIGN(16);
 
+struct taa_DECLSPEC_ALIGN(16) taa_dualquat_s
+{
+    taa_quat real;
+    taa_quat dual;
+} taa_ATTRIB_ALIGN(16);
+
+struct taa_DECLSPEC_ALIGN(16) taa_vec3x4_s
+{
+    float x[4];
+    float y[4];
+    float z[4];
+} taa_ATTRIB_ALIGN(16);
+
+struct taa_DECLSPEC_ALIGN(16) taa_vec4x4_s
+{
+    float x[4];
+    float y[4];
+    float z[4];
+    float w[4];
+} taa_ATTRIB_ALIGN(16);
+
+struct taa_DECLSPEC_ALIGN(16) taa_mat33x4_s
+{
+    taa_vec3x4 x;
+    taa_vec3x4 y;
+    taa_vec3x4 z;
+} taa_ATTRIB_ALIGN(16);
+
+struct taa_DECLSPEC_ALIGN(16) taa_mat44x4_s
+{
+    taa_vec4x4 x;
+    taa_vec4x4 y;
+    taa_vec4x4 z;
+    taa_vec4x4 w;
+} taa_ATTRIB_ALIGN(16);
+
 #endif // taa_MATHDEFS_H_
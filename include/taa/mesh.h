@@ -0,0 +1,692 @@
+/**
+ * @brief     mesh normal and tangent generation header
+ * @details   vertex normals are the normalized sum of the area weighted
+ *            normals of the faces using the vertex. Tangents are built the
+ *            same way from the texture coordinate derivatives of each face,
+ *            then orthogonalized against the vertex normal. The w component
+ *            of each tangent holds the handedness of the bitangent,
+ *            bitangent = cross(normal, tangent.xyz) * tangent.w.
+ *
+ *            taa_mesh_normals and taa_mesh_tangents scatter face values
+ *            into the vertices they use. To split the work across threads,
+ *            compute face values for disjoint face ranges, then gather them
+ *            for disjoint vertex ranges using a taa_mesh_adjacency. Every
+ *            output is then written by exactly one range.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_MESH_H_
+#define taa_MESH_H_
+
+#include "mathdefs.h"
+#include "stream.h"
+#include "vpu.h"
+#include <assert.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct taa_mesh_adjacency_s taa_mesh_adjacency;
+
+/**
+ * @brief faces using each vertex of a triangle list
+ */
+struct taa_mesh_adjacency_s
+{
+    /** offset into faces of the first face of each vertex, numverts + 1 */
+    uint32_t* offsets;
+    /** face indices grouped by vertex */
+    uint32_t* faces;
+    /** unaligned allocation containing all the arrays */
+    void* buffer;
+    uint32_t numverts;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief builds the vertex to face adjacency of a triangle list
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_mesh_adjacency_create(
+    const uint32_t* indices,
+    uint32_t numtris,
+    uint32_t numverts,
+    taa_mesh_adjacency* adj_out);
+
+taa_INLINE static void taa_mesh_adjacency_destroy(
+    taa_mesh_adjacency* adj);
+
+/**
+ * @brief computes area weighted face normals
+ * @details each normal is the cross product of two edges of the face, so
+ *          its length is twice the area of the face. Faces are processed
+ *          four at a time.
+ */
+taa_INLINE static void taa_mesh_face_normals(
+    const taa_vec3* pos,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec3* fn_out);
+
+/**
+ * @brief computes area weighted face tangents
+ * @details xyz is the direction of increasing u scaled by twice the area of
+ *          the face. w is the same weight, negated if the texture mapping is
+ *          mirrored. Faces with degenerate texture coordinates are zero.
+ */
+taa_INLINE static void taa_mesh_face_tangents(
+    const taa_vec3* pos,
+    const taa_vec2* uv,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec4* ft_out);
+
+/**
+ * @brief computes vertex normals for a triangle list
+ */
+taa_INLINE static void taa_mesh_normals(
+    const taa_vec3* pos,
+    uint32_t numverts,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief normalizes an array of vectors in place, four at a time
+ * @details zero length vectors stay zero. Unlike taa_vec3_normalize_array,
+ *          the array does not need to be padded.
+ */
+taa_INLINE static void taa_mesh_normalize_array(
+    taa_vec3* v,
+    uint32_t n);
+
+/**
+ * @brief finishes accumulated tangents
+ * @details orthogonalizes each tangent against its normal, normalizes it
+ *          and replaces w with its sign.
+ */
+taa_INLINE static void taa_mesh_orthonormalize_tangents(
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec4* tan);
+
+/**
+ * @brief computes vertex tangents for a triangle list
+ * @details nrm holds the vertex normals, see taa_mesh_normals.
+ */
+taa_INLINE static void taa_mesh_tangents(
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    const taa_vec2* uv,
+    uint32_t numverts,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec4* tan_out);
+
+/**
+ * @brief gathers face normals into the vertex normals of [begin, end)
+ * @details fn holds the normals of every face, see taa_mesh_face_normals.
+ *          Disjoint ranges may be computed concurrently.
+ */
+taa_INLINE static void taa_mesh_vertex_normals_range(
+    const taa_vec3* fn,
+    const taa_mesh_adjacency* adj,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief gathers face tangents into the vertex tangents of [begin, end)
+ * @details ft holds the tangents of every face, see taa_mesh_face_tangents.
+ *          Disjoint ranges may be computed concurrently.
+ */
+taa_INLINE static void taa_mesh_vertex_tangents_range(
+    const taa_vec3* nrm,
+    const taa_vec4* ft,
+    const taa_mesh_adjacency* adj,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec4* tan_out);
+
+//****************************************************************************
+taa_INLINE static int taa_mesh_adjacency_create(
+    const uint32_t* indices,
+    uint32_t numtris,
+    uint32_t numverts,
+    taa_mesh_adjacency* adj_out)
+{
+    void* aligned = NULL;
+    int err;
+    memset(adj_out, 0, sizeof(*adj_out));
+    err = taa_stream_realloc(
+        &adj_out->buffer,
+        &aligned,
+        0,
+        (numverts + 1 + numtris*3) * sizeof(uint32_t));
+    if(err == 0)
+    {
+        uint32_t* offsets = (uint32_t*) aligned;
+        uint32_t* faces = offsets + numverts + 1;
+        uint32_t i;
+        // counting sort of the faces by vertex
+        for(i = 0; i < numtris*3; ++i)
+        {
+            assert(indices[i] < numverts);
+            ++offsets[indices[i] + 1];
+        }
+        for(i = 0; i < numverts; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        for(i = 0; i < numtris*3; ++i)
+        {
+            faces[offsets[indices[i]]++] = i/3;
+        }
+        for(i = numverts; i > 0; --i)
+        {
+            offsets[i] = offsets[i - 1];
+        }
+        offsets[0] = 0;
+        adj_out->offsets = offsets;
+        adj_out->faces = faces;
+        adj_out->numverts = numverts;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_adjacency_destroy(
+    taa_mesh_adjacency* adj)
+{
+    free(adj->buffer);
+    memset(adj, 0, sizeof(*adj));
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_face_normals(
+    const taa_vec3* pos,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec3* fn_out)
+{
+    uint32_t i;
+    for(i = 0; i < numtris; i += 4)
+    {
+        uint32_t nlanes = ((numtris - i) < 4) ? (numtris - i) : 4;
+        const taa_vec3* v[3][4];
+        taa_vpu_vec4 e1[3];
+        taa_vpu_vec4 e2[3];
+        taa_vpu_vec4 n;
+        taa_vpu_vec4 tmp;
+        taa_vec3x4 fn;
+        uint32_t k;
+        int j;
+        // gather the vertices, repeating the last face in unused lanes
+        for(k = 0; k < 4; ++k)
+        {
+            const uint32_t* tri;
+            tri = indices + (i + ((k < nlanes) ? k : nlanes - 1))*3;
+            v[0][k] = pos + tri[0];
+            v[1][k] = pos + tri[1];
+            v[2][k] = pos + tri[2];
+        }
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_vec4 p0;
+            taa_vpu_set(
+                (&v[0][0]->x)[j],
+                (&v[0][1]->x)[j],
+                (&v[0][2]->x)[j],
+                (&v[0][3]->x)[j],
+                p0);
+            taa_vpu_set(
+                (&v[1][0]->x)[j],
+                (&v[1][1]->x)[j],
+                (&v[1][2]->x)[j],
+                (&v[1][3]->x)[j],
+                e1[j]);
+            taa_vpu_set(
+                (&v[2][0]->x)[j],
+                (&v[2][1]->x)[j],
+                (&v[2][2]->x)[j],
+                (&v[2][3]->x)[j],
+                e2[j]);
+            taa_vpu_sub(e1[j], p0, e1[j]);
+            taa_vpu_sub(e2[j], p0, e2[j]);
+        }
+        for(j = 0; j < 3; ++j)
+        {
+            int j1 = (j + 1) % 3;
+            int j2 = (j + 2) % 3;
+            taa_vpu_mul(e1[j1], e2[j2], n);
+            taa_vpu_mul(e1[j2], e2[j1], tmp);
+            taa_vpu_sub(n, tmp, n);
+            taa_vpu_store(n, (j == 0) ? fn.x : (j == 1) ? fn.y : fn.z);
+        }
+        for(k = 0; k < nlanes; ++k)
+        {
+            fn_out[i + k].x = fn.x[k];
+            fn_out[i + k].y = fn.y[k];
+            fn_out[i + k].z = fn.z[k];
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_face_tangents(
+    const taa_vec3* pos,
+    const taa_vec2* uv,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec4* ft_out)
+{
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 tiny;
+    uint32_t i;
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(FLT_MIN, tiny);
+    for(i = 0; i < numtris; i += 4)
+    {
+        uint32_t nlanes = ((numtris - i) < 4) ? (numtris - i) : 4;
+        const uint32_t* tri[4];
+        taa_vpu_vec4 e1[3];
+        taa_vpu_vec4 e2[3];
+        taa_vpu_vec4 t[3];
+        taa_vpu_vec4 b[3];
+        taa_vpu_vec4 n[3];
+        taa_vpu_vec4 du1;
+        taa_vpu_vec4 dv1;
+        taa_vpu_vec4 du2;
+        taa_vpu_vec4 dv2;
+        taa_vpu_vec4 r;
+        taa_vpu_vec4 area;
+        taa_vpu_vec4 tlen;
+        taa_vpu_vec4 h;
+        taa_vpu_vec4 tmp;
+        taa_vpu_vec4 mask;
+        taa_vec4x4 ft;
+        uint32_t k;
+        int j;
+        for(k = 0; k < 4; ++k)
+        {
+            tri[k] = indices + (i + ((k < nlanes) ? k : nlanes - 1))*3;
+        }
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_vec4 p0;
+            taa_vpu_set(
+                (&pos[tri[0][0]].x)[j],
+                (&pos[tri[1][0]].x)[j],
+                (&pos[tri[2][0]].x)[j],
+                (&pos[tri[3][0]].x)[j],
+                p0);
+            taa_vpu_set(
+                (&pos[tri[0][1]].x)[j],
+                (&pos[tri[1][1]].x)[j],
+                (&pos[tri[2][1]].x)[j],
+                (&pos[tri[3][1]].x)[j],
+                e1[j]);
+            taa_vpu_set(
+                (&pos[tri[0][2]].x)[j],
+                (&pos[tri[1][2]].x)[j],
+                (&pos[tri[2][2]].x)[j],
+                (&pos[tri[3][2]].x)[j],
+                e2[j]);
+            taa_vpu_sub(e1[j], p0, e1[j]);
+            taa_vpu_sub(e2[j], p0, e2[j]);
+        }
+        taa_vpu_set(
+            uv[tri[0][1]].x - uv[tri[0][0]].x,
+            uv[tri[1][1]].x - uv[tri[1][0]].x,
+            uv[tri[2][1]].x - uv[tri[2][0]].x,
+            uv[tri[3][1]].x - uv[tri[3][0]].x,
+            du1);
+        taa_vpu_set(
+            uv[tri[0][1]].y - uv[tri[0][0]].y,
+            uv[tri[1][1]].y - uv[tri[1][0]].y,
+            uv[tri[2][1]].y - uv[tri[2][0]].y,
+            uv[tri[3][1]].y - uv[tri[3][0]].y,
+            dv1);
+        taa_vpu_set(
+            uv[tri[0][2]].x - uv[tri[0][0]].x,
+            uv[tri[1][2]].x - uv[tri[1][0]].x,
+            uv[tri[2][2]].x - uv[tri[2][0]].x,
+            uv[tri[3][2]].x - uv[tri[3][0]].x,
+            du2);
+        taa_vpu_set(
+            uv[tri[0][2]].y - uv[tri[0][0]].y,
+            uv[tri[1][2]].y - uv[tri[1][0]].y,
+            uv[tri[2][2]].y - uv[tri[2][0]].y,
+            uv[tri[3][2]].y - uv[tri[3][0]].y,
+            dv2);
+        // r = du1*dv2 - du2*dv1 is twice the signed area in texture space
+        taa_vpu_mul(du1, dv2, r);
+        taa_vpu_mul(du2, dv1, tmp);
+        taa_vpu_sub(r, tmp, r);
+        // t = e1*dv2 - e2*dv1 and b = e2*du1 - e1*du2, both scaled by r
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_mul(e1[j], dv2, t[j]);
+            taa_vpu_mul(e2[j], dv1, tmp);
+            taa_vpu_sub(t[j], tmp, t[j]);
+            taa_vpu_mul(e2[j], du1, b[j]);
+            taa_vpu_mul(e1[j], du2, tmp);
+            taa_vpu_sub(b[j], tmp, b[j]);
+        }
+        for(j = 0; j < 3; ++j)
+        {
+            int j1 = (j + 1) % 3;
+            int j2 = (j + 2) % 3;
+            taa_vpu_mul(e1[j1], e2[j2], n[j]);
+            taa_vpu_mul(e1[j2], e2[j1], tmp);
+            taa_vpu_sub(n[j], tmp, n[j]);
+        }
+        taa_vpu_mul(n[0], n[0], area);
+        taa_vpu_mul(n[1], n[1], tmp);
+        taa_vpu_add(area, tmp, area);
+        taa_vpu_mul(n[2], n[2], tmp);
+        taa_vpu_add(area, tmp, area);
+        taa_vpu_sqrt(area, area);
+        taa_vpu_mul(t[0], t[0], tlen);
+        taa_vpu_mul(t[1], t[1], tmp);
+        taa_vpu_add(tlen, tmp, tlen);
+        taa_vpu_mul(t[2], t[2], tmp);
+        taa_vpu_add(tlen, tmp, tlen);
+        taa_vpu_sqrt(tlen, tlen);
+        taa_vpu_add(tlen, tiny, tlen);
+        // handedness is the sign of cross(n, t).b, which r does not change
+        taa_vpu_mov(zero, h);
+        for(j = 0; j < 3; ++j)
+        {
+            int j1 = (j + 1) % 3;
+            int j2 = (j + 2) % 3;
+            taa_vpu_vec4 c;
+            taa_vpu_mul(n[j1], t[j2], c);
+            taa_vpu_mul(n[j2], t[j1], tmp);
+            taa_vpu_sub(c, tmp, c);
+            taa_vpu_mul(c, b[j], c);
+            taa_vpu_add(h, c, h);
+        }
+        // scale t to the face area, flipping it where r is negative
+        taa_vpu_div(area, tlen, tlen);
+        taa_vpu_sub(zero, tlen, tmp);
+        taa_vpu_cmpgt(zero, r, mask);
+        taa_vpu_select(tlen, tmp, mask, tlen);
+        taa_vpu_sub(zero, area, tmp);
+        taa_vpu_cmpgt(zero, h, mask);
+        taa_vpu_select(area, tmp, mask, area);
+        taa_vpu_cmpagt(r, tiny, mask);
+        taa_vpu_select(zero, tlen, mask, tlen);
+        taa_vpu_select(zero, area, mask, area);
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_mul(t[j], tlen, t[j]);
+            taa_vpu_store(t[j], (j == 0) ? ft.x : (j == 1) ? ft.y : ft.z);
+        }
+        taa_vpu_store(area, ft.w);
+        for(k = 0; k < nlanes; ++k)
+        {
+            ft_out[i + k].x = ft.x[k];
+            ft_out[i + k].y = ft.y[k];
+            ft_out[i + k].z = ft.z[k];
+            ft_out[i + k].w = ft.w[k];
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_normals(
+    const taa_vec3* pos,
+    uint32_t numverts,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec3* nrm_out)
+{
+    uint32_t i;
+    memset(nrm_out, 0, numverts * sizeof(*nrm_out));
+    for(i = 0; i < numtris; i += 4)
+    {
+        uint32_t nlanes = ((numtris - i) < 4) ? (numtris - i) : 4;
+        const uint32_t* tri = indices + i*3;
+        taa_vec3 fn[4];
+        uint32_t k;
+        taa_mesh_face_normals(pos, tri, nlanes, fn);
+        for(k = 0; k < nlanes*3; ++k)
+        {
+            taa_vec3* n = nrm_out + tri[k];
+            n->x += fn[k/3].x;
+            n->y += fn[k/3].y;
+            n->z += fn[k/3].z;
+        }
+    }
+    taa_mesh_normalize_array(nrm_out, numverts);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_normalize_array(
+    taa_vec3* v,
+    uint32_t n)
+{
+    taa_vpu_vec4 tiny;
+    uint32_t i;
+    taa_vpu_set1(FLT_MIN, tiny);
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        const taa_vec3* v0 = v + i;
+        const taa_vec3* v1 = v + i + ((nlanes > 1) ? 1 : 0);
+        const taa_vec3* v2 = v + i + ((nlanes > 2) ? 2 : nlanes - 1);
+        const taa_vec3* v3 = v + i + nlanes - 1;
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_vec4 len;
+        taa_vpu_vec4 tmp;
+        taa_vec3x4 r;
+        uint32_t k;
+        taa_vpu_set(v0->x, v1->x, v2->x, v3->x, x);
+        taa_vpu_set(v0->y, v1->y, v2->y, v3->y, y);
+        taa_vpu_set(v0->z, v1->z, v2->z, v3->z, z);
+        taa_vpu_mul(x, x, len);
+        taa_vpu_mul(y, y, tmp);
+        taa_vpu_add(len, tmp, len);
+        taa_vpu_mul(z, z, tmp);
+        taa_vpu_add(len, tmp, len);
+        taa_vpu_sqrt(len, len);
+        taa_vpu_add(len, tiny, len);
+        taa_vpu_div(x, len, x);
+        taa_vpu_div(y, len, y);
+        taa_vpu_div(z, len, z);
+        taa_vpu_store(x, r.x);
+        taa_vpu_store(y, r.y);
+        taa_vpu_store(z, r.z);
+        for(k = 0; k < nlanes; ++k)
+        {
+            v[i + k].x = r.x[k];
+            v[i + k].y = r.y[k];
+            v[i + k].z = r.z[k];
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_orthonormalize_tangents(
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec4* tan)
+{
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 tiny;
+    uint32_t i;
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_set1(FLT_MIN, tiny);
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        uint32_t i1 = i + ((nlanes > 1) ? 1 : 0);
+        uint32_t i2 = i + ((nlanes > 2) ? 2 : nlanes - 1);
+        uint32_t i3 = i + nlanes - 1;
+        taa_vpu_vec4 nv[3];
+        taa_vpu_vec4 tv[3];
+        taa_vpu_vec4 w;
+        taa_vpu_vec4 d;
+        taa_vpu_vec4 tmp;
+        taa_vec4x4 r;
+        uint32_t k;
+        int j;
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_set(
+                (&nrm[i].x)[j],
+                (&nrm[i1].x)[j],
+                (&nrm[i2].x)[j],
+                (&nrm[i3].x)[j],
+                nv[j]);
+            taa_vpu_set(
+                (&tan[i].x)[j],
+                (&tan[i1].x)[j],
+                (&tan[i2].x)[j],
+                (&tan[i3].x)[j],
+                tv[j]);
+        }
+        taa_vpu_set(tan[i].w, tan[i1].w, tan[i2].w, tan[i3].w, w);
+        // t -= n * dot(n, t)
+        taa_vpu_mul(nv[0], tv[0], d);
+        taa_vpu_mul(nv[1], tv[1], tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_mul(nv[2], tv[2], tmp);
+        taa_vpu_add(d, tmp, d);
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_mul(nv[j], d, tmp);
+            taa_vpu_sub(tv[j], tmp, tv[j]);
+        }
+        taa_vpu_mul(tv[0], tv[0], d);
+        taa_vpu_mul(tv[1], tv[1], tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_mul(tv[2], tv[2], tmp);
+        taa_vpu_add(d, tmp, d);
+        taa_vpu_sqrt(d, d);
+        taa_vpu_add(d, tiny, d);
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vpu_div(tv[j], d, tv[j]);
+            taa_vpu_store(tv[j], (j == 0) ? r.x : (j == 1) ? r.y : r.z);
+        }
+        taa_vpu_sub(zero, one, tmp);
+        taa_vpu_cmpgt(zero, w, w);
+        taa_vpu_select(one, tmp, w, w);
+        taa_vpu_store(w, r.w);
+        for(k = 0; k < nlanes; ++k)
+        {
+            tan[i + k].x = r.x[k];
+            tan[i + k].y = r.y[k];
+            tan[i + k].z = r.z[k];
+            tan[i + k].w = r.w[k];
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_tangents(
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    const taa_vec2* uv,
+    uint32_t numverts,
+    const uint32_t* indices,
+    uint32_t numtris,
+    taa_vec4* tan_out)
+{
+    uint32_t i;
+    memset(tan_out, 0, numverts * sizeof(*tan_out));
+    for(i = 0; i < numtris; i += 4)
+    {
+        uint32_t nlanes = ((numtris - i) < 4) ? (numtris - i) : 4;
+        const uint32_t* tri = indices + i*3;
+        taa_vec4 ft[4];
+        uint32_t k;
+        taa_mesh_face_tangents(pos, uv, tri, nlanes, ft);
+        for(k = 0; k < nlanes*3; ++k)
+        {
+            taa_vec4* t = tan_out + tri[k];
+            t->x += ft[k/3].x;
+            t->y += ft[k/3].y;
+            t->z += ft[k/3].z;
+            t->w += ft[k/3].w;
+        }
+    }
+    taa_mesh_orthonormalize_tangents(nrm, numverts, tan_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_vertex_normals_range(
+    const taa_vec3* fn,
+    const taa_mesh_adjacency* adj,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* nrm_out)
+{
+    const uint32_t* offsets = adj->offsets;
+    const uint32_t* faces = adj->faces;
+    uint32_t i;
+    assert(begin <= end && end <= adj->numverts);
+    for(i = begin; i < end; ++i)
+    {
+        taa_vec3* n = nrm_out + i;
+        uint32_t j;
+        n->x = 0.0f;
+        n->y = 0.0f;
+        n->z = 0.0f;
+        for(j = offsets[i]; j < offsets[i + 1]; ++j)
+        {
+            const taa_vec3* f = fn + faces[j];
+            n->x += f->x;
+            n->y += f->y;
+            n->z += f->z;
+        }
+    }
+    taa_mesh_normalize_array(nrm_out + begin, end - begin);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_mesh_vertex_tangents_range(
+    const taa_vec3* nrm,
+    const taa_vec4* ft,
+    const taa_mesh_adjacency* adj,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec4* tan_out)
+{
+    const uint32_t* offsets = adj->offsets;
+    const uint32_t* faces = adj->faces;
+    uint32_t i;
+    assert(begin <= end && end <= adj->numverts);
+    for(i = begin; i < end; ++i)
+    {
+        taa_vec4* t = tan_out + i;
+        uint32_t j;
+        t->x = 0.0f;
+        t->y = 0.0f;
+        t->z = 0.0f;
+        t->w = 0.0f;
+        for(j = offsets[i]; j < offsets[i + 1]; ++j)
+        {
+            const taa_vec4* f = ft + faces[j];
+            t->x += f->x;
+            t->y += f->y;
+            t->z += f->z;
+            t->w += f->w;
+        }
+    }
+    taa_mesh_orthonormalize_tangents(
+        nrm + begin,
+        end - begin,
+        tan_out + begin);
+}
+
+#endif // taa_MESH_H_
@@ -7,6 +7,8 @@
 #ifndef taa_QUAT_H_
 #define taa_QUAT_H_
 
+#include "mat33x4.h"
+#include "quatx4.h"
 #include "vec3.h"
 #include "vec4.h"
 #include <assert.h>
@@ -32,10 +34,30 @@ taa_INLINE static void taa_quat_from_mat33(
     const taa_mat33* m,
     taa_quat* q_out);
 
+/**
+ * @brief converts an array of rotation matrices into quaternions
+ * @details the matrices are converted four at a time in structure of arrays
+ *          format, using taa_quatx4_from_mat33x4.
+ */
+taa_INLINE static void taa_quat_from_mat33_array(
+    const taa_mat33* m,
+    uint32_t n,
+    taa_quat* q_out);
+
 taa_INLINE static void taa_quat_from_mat44(
     const taa_mat44* m,
     taa_quat* q_out);
 
+/**
+ * @brief converts an array of rotation matrices into quaternions
+ * @details the upper 3x3 of each matrix is converted four at a time in
+ *          structure of arrays format, using taa_quatx4_from_mat33x4.
+ */
+taa_INLINE static void taa_quat_from_mat44_array(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_quat* q_out);
+
 taa_INLINE static void taa_quat_identity(
     taa_quat* q_out);
 
@@ -49,6 +71,18 @@ taa_INLINE static void taa_quat_multiply_vec3(
     const taa_vec3* b,
     taa_quat* q_out);
 
+/**
+ * @brief normalized linear interpolation between two rotations
+ * @details interpolates along the shortest path, negating b if the two
+ *          quaternions are in opposite hemispheres. The result does not move
+ *          at a constant angular velocity, but is much cheaper than slerp.
+ */
+taa_INLINE static void taa_quat_nlerp(
+    const taa_quat* a,
+    const taa_quat* b,
+    float t,
+    taa_quat* q_out);
+
 taa_INLINE static void taa_quat_normalize(
     const taa_quat* a,
     taa_quat* q_out);
@@ -72,6 +106,17 @@ taa_INLINE static void taa_quat_scale(
     float x,
     taa_quat* q_out);
 
+/**
+ * @brief spherical linear interpolation between two rotations
+ * @details interpolates along the shortest path, negating b if the two
+ *          quaternions are in opposite hemispheres.
+ */
+taa_INLINE static void taa_quat_slerp(
+    const taa_quat* a,
+    const taa_quat* b,
+    float t,
+    taa_quat* q_out);
+
 //****************************************************************************
 taa_INLINE static void taa_quat_add(
     const taa_quat* a,
@@ -114,45 +159,53 @@ taa_INLINE static void taa_quat_from_mat33(
     const taa_mat33* m,
     taa_quat* q_out)
 {
+    // row i of k is 4*q*q[i]. every row is computed and the case is chosen
+    // by index rather than by branching, since the choice is unpredictable
+    // for arbitrary rotations.
     float trace = m->x.x + m->y.y + m->z.z;
-    if (trace >= 0.0f)
-    {
-        float s = sqrtf(trace + 1.0f) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->y.z - m->z.y) * t;
-        q_out->y = (m->z.x - m->x.z) * t;
-        q_out->z = (m->x.y - m->y.x) * t;
-        q_out->w = s;
-    }
-    else if((m->x.x > m->y.y) && (m->x.x > m->z.z))
-    {
-        // s=4*x
-        float s = sqrtf(1.0f+m->x.x-m->y.y-m->z.z) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = s;
-        q_out->y = (m->y.x + m->x.y) * t;
-        q_out->z = (m->x.z + m->z.x) * t;
-        q_out->w = (m->y.z - m->z.y) * t;
-    }
-    else if(m->y.y > m->z.z)
-    {
-        // s=4*y
-        float s = sqrtf(1.0f+m->y.y-m->x.x-m->z.z) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->y.x + m->x.y) * t;
-        q_out->y = s;
-        q_out->z = (m->z.y + m->y.z) * t;
-        q_out->w = (m->z.x - m->x.z) * t;
-    }
-    else
+    float k[4][4];
+    float t;
+    int i;
+    k[0][0] = 1.0f + m->x.x - m->y.y - m->z.z;
+    k[1][1] = 1.0f - m->x.x + m->y.y - m->z.z;
+    k[2][2] = 1.0f - m->x.x - m->y.y + m->z.z;
+    k[3][3] = 1.0f + trace;
+    k[0][1] = k[1][0] = m->x.y + m->y.x;
+    k[0][2] = k[2][0] = m->x.z + m->z.x;
+    k[1][2] = k[2][1] = m->y.z + m->z.y;
+    k[0][3] = k[3][0] = m->y.z - m->z.y;
+    k[1][3] = k[3][1] = m->z.x - m->x.z;
+    k[2][3] = k[3][2] = m->x.y - m->y.x;
+    // w if trace >= 0, else x if xx is the largest diagonal element, else
+    // y if yy > zz, else z
+    i = (m->y.y > m->z.z) ? 1 : 2;
+    i = ((m->x.x > m->y.y) & (m->x.x > m->z.z)) ? 0 : i;
+    i = (trace >= 0.0f) ? 3 : i;
+    t = 0.5f/sqrtf(k[i][i]);
+    q_out->x = k[i][0] * t;
+    q_out->y = k[i][1] * t;
+    q_out->z = k[i][2] * t;
+    q_out->w = k[i][3] * t;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_from_mat33_array(
+    const taa_mat33* m,
+    uint32_t n,
+    taa_quat* q_out)
+{
+    const taa_mat33* mend = m + n;
+    taa_mat33x4 m4;
+    taa_quatx4 q4;
+    while(m != mend)
     {
-        // s=4*z
-        float s = sqrtf(1.0f+m->z.z-m->x.x-m->y.y) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->z.x + m->x.z) * t;
-        q_out->y = (m->z.y + m->y.z) * t;
-        q_out->z = s;
-        q_out->w = (m->x.y - m->y.x) * t;
+        uint32_t nlanes = (uint32_t) (mend - m);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat33(m, nlanes, &m4);
+        taa_quatx4_from_mat33x4(&m4, &q4);
+        taa_quatx4_to_quat(&q4, nlanes, q_out);
+        m += nlanes;
+        q_out += nlanes;
     }
 }
 
@@ -161,45 +214,53 @@ taa_INLINE static void taa_quat_from_mat44(
     const taa_mat44* m,
     taa_quat* q_out)
 {
+    // row i of k is 4*q*q[i]. every row is computed and the case is chosen
+    // by index rather than by branching, since the choice is unpredictable
+    // for arbitrary rotations.
     float trace = m->x.x + m->y.y + m->z.z;
-    if (trace >= 0.0f)
-    {
-        float s = sqrtf(trace + 1.0f) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->y.z - m->z.y) * t;
-        q_out->y = (m->z.x - m->x.z) * t;
-        q_out->z = (m->x.y - m->y.x) * t;
-        q_out->w = s;
-    }
-    else if((m->x.x > m->y.y) && (m->x.x > m->z.z))
-    {
-        // s=4*x
-        float s = sqrtf(1.0f+m->x.x-m->y.y-m->z.z) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = s;
-        q_out->y = (m->y.x + m->x.y) * t;
-        q_out->z = (m->x.z + m->z.x) * t;
-        q_out->w = (m->y.z - m->z.y) * t;
-    }
-    else if(m->y.y > m->z.z)
-    {
-        // s=4*y
-        float s = sqrtf(1.0f+m->y.y-m->x.x-m->z.z) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->y.x + m->x.y) * t;
-        q_out->y = s;
-        q_out->z = (m->z.y + m->y.z) * t;
-        q_out->w = (m->z.x - m->x.z) * t;
-    }
-    else
+    float k[4][4];
+    float t;
+    int i;
+    k[0][0] = 1.0f + m->x.x - m->y.y - m->z.z;
+    k[1][1] = 1.0f - m->x.x + m->y.y - m->z.z;
+    k[2][2] = 1.0f - m->x.x - m->y.y + m->z.z;
+    k[3][3] = 1.0f + trace;
+    k[0][1] = k[1][0] = m->x.y + m->y.x;
+    k[0][2] = k[2][0] = m->x.z + m->z.x;
+    k[1][2] = k[2][1] = m->y.z + m->z.y;
+    k[0][3] = k[3][0] = m->y.z - m->z.y;
+    k[1][3] = k[3][1] = m->z.x - m->x.z;
+    k[2][3] = k[3][2] = m->x.y - m->y.x;
+    // w if trace >= 0, else x if xx is the largest diagonal element, else
+    // y if yy > zz, else z
+    i = (m->y.y > m->z.z) ? 1 : 2;
+    i = ((m->x.x > m->y.y) & (m->x.x > m->z.z)) ? 0 : i;
+    i = (trace >= 0.0f) ? 3 : i;
+    t = 0.5f/sqrtf(k[i][i]);
+    q_out->x = k[i][0] * t;
+    q_out->y = k[i][1] * t;
+    q_out->z = k[i][2] * t;
+    q_out->w = k[i][3] * t;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_from_mat44_array(
+    const taa_mat44* m,
+    uint32_t n,
+    taa_quat* q_out)
+{
+    const taa_mat44* mend = m + n;
+    taa_mat33x4 m4;
+    taa_quatx4 q4;
+    while(m != mend)
     {
-        // s=4*z
-        float s = sqrtf(1.0f+m->z.z-m->x.x-m->y.y) * 0.5f;
-        float t = 0.25f/s;
-        q_out->x = (m->z.x + m->x.z) * t;
-        q_out->y = (m->z.y + m->y.z) * t;
-        q_out->z = s;
-        q_out->w = (m->x.y - m->y.x) * t;
+        uint32_t nlanes = (uint32_t) (mend - m);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        taa_mat33x4_from_mat44(m, nlanes, &m4);
+        taa_quatx4_from_mat33x4(&m4, &q4);
+        taa_quatx4_to_quat(&q4, nlanes, q_out);
+        m += nlanes;
+        q_out += nlanes;
     }
 }
 
@@ -221,10 +282,13 @@ taa_INLINE static void taa_quat_multiply(
 {
     assert(a != q_out);
     assert(b != q_out);
-    q_out->x = a->y*b->z - a->z*b->y + a->w*b->x + a->x*b->w;
-    q_out->y = a->z*b->x - a->x*b->z + a->w*b->y + a->y*b->w;
-    q_out->z = a->x*b->y - a->y*b->x + a->w*b->z + a->z*b->w;
-    q_out->w = a->w*b->w - a->x*b->x - a->y*b->y - a->z*b->z;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) q_out) & 15) == 0);
+    taa_vpu_quat_mul(
+        *((taa_vpu_vec4*) a),
+        *((taa_vpu_vec4*) b),
+        *((taa_vpu_vec4*) q_out));
 }
 
 //****************************************************************************
@@ -233,11 +297,28 @@ taa_INLINE static void taa_quat_multiply_vec3(
     const taa_vec3* b,
     taa_quat* q_out)
 {
+    taa_vpu_vec4 vb;
     assert(a != q_out);
-    q_out->x = a->w * b->x + a->y * b->z - a->z * b->y;
-    q_out->y = a->w * b->y + a->z * b->x - a->x * b->z;
-    q_out->z = a->w * b->z + a->x * b->y - a->y * b->x;
-    q_out->w =-a->x * b->x - a->y * b->y - a->z * b->z;
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) q_out) & 15) == 0);
+    taa_vpu_set(b->x, b->y, b->z, 0.0f, vb);
+    taa_vpu_quat_mul(*((taa_vpu_vec4*) a), vb, *((taa_vpu_vec4*) q_out));
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_nlerp(
+    const taa_quat* a,
+    const taa_quat* b,
+    float t,
+    taa_quat* q_out)
+{
+    float wa = 1.0f - t;
+    float wb = (taa_vec4_dot(a, b) >= 0.0f) ? t : -t;
+    q_out->x = a->x*wa + b->x*wb;
+    q_out->y = a->y*wa + b->y*wb;
+    q_out->z = a->z*wa + b->z*wb;
+    q_out->w = a->w*wa + b->w*wb;
+    taa_vec4_normalize(q_out, q_out);
 }
 
 //****************************************************************************
@@ -277,15 +358,15 @@ taa_INLINE static void taa_quat_transform_vec3(
     taa_vec3* v_out)
 {
     // v' = 2 * cross(q.xyz, (cross(q.xyz, v) + v*q.w)) + v
-    const taa_vec3* q = (const taa_vec3*) a;
-    taa_vec3 qxv;
+    taa_vec4 r;
+    taa_vpu_vec4 vb;
     assert(b != v_out);
-    taa_vec3_cross(q, b, &qxv);
-    taa_vec3_scale(b, a->w, v_out);
-    taa_vec3_add(&qxv, v_out, v_out);
-    taa_vec3_cross(q, v_out, &qxv);
-    taa_vec3_scale(&qxv, 2.0f, v_out);
-    taa_vec3_add(v_out, b, v_out);
+    assert((((size_t) a) & 15) == 0);
+    taa_vpu_set(b->x, b->y, b->z, 0.0f, vb);
+    taa_vpu_quat_rotate(*((taa_vpu_vec4*) a), vb, *((taa_vpu_vec4*) &r));
+    v_out->x = r.x;
+    v_out->y = r.y;
+    v_out->z = r.z;
 }
 
 //****************************************************************************
@@ -295,15 +376,14 @@ taa_INLINE static void taa_quat_transform_vec4(
     taa_vec4* v_out)
 {
     // v' = 2 * cross(q.xyz, (cross(q.xyz, v) + v*q.w)) + v
-    const taa_vec4* q = (const taa_vec4*) a;
-    taa_vec4 qxv;
     assert(b != v_out);
-    taa_vec4_cross3(q, b, &qxv);
-    taa_vec4_scale(b, a->w, v_out);
-    taa_vec4_add(&qxv, v_out, v_out);
-    taa_vec4_cross3(q, v_out, &qxv);
-    taa_vec4_scale(&qxv, 2.0f, v_out);
-    taa_vec4_add(v_out, b, v_out);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) v_out) & 15) == 0);
+    taa_vpu_quat_rotate(
+        *((taa_vpu_vec4*) a),
+        *((taa_vpu_vec4*) b),
+        *((taa_vpu_vec4*) v_out));
 }
 
 //****************************************************************************
@@ -318,5 +398,42 @@ taa_INLINE static void taa_quat_scale(
     q_out->w = a->w * x;
 }
 
+//****************************************************************************
+taa_INLINE static void taa_quat_slerp(
+    const taa_quat* a,
+    const taa_quat* b,
+    float t,
+    taa_quat* q_out)
+{
+    float d = taa_vec4_dot(a, b);
+    float sign = 1.0f;
+    float wa;
+    float wb;
+    if(d < 0.0f)
+    {
+        // take the shortest path
+        d = -d;
+        sign = -1.0f;
+    }
+    if(d < 1.0f - FLT_EPSILON)
+    {
+        float theta = acosf(d);
+        float rsin = 1.0f/sinf(theta);
+        wa = sinf((1.0f - t)*theta) * rsin;
+        wb = sinf(t*theta) * rsin;
+    }
+    else
+    {
+        // the rotations are nearly identical; sin(theta) approaches zero
+        wa = 1.0f - t;
+        wb = t;
+    }
+    wb *= sign;
+    q_out->x = a->x*wa + b->x*wb;
+    q_out->y = a->y*wa + b->y*wb;
+    q_out->z = a->z*wa + b->z*wb;
+    q_out->w = a->w*wa + b->w*wb;
+}
+
 #endif // taa_QUAT_H_
 
@@ -0,0 +1,420 @@
+/**
+ * @brief     inlined structure of arrays quaternion functions header
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_QUATX4_H_
+#define taa_QUATX4_H_
+
+#include "vec4x4.h"
+#include <float.h>
+
+/**
+ * @brief polynomial coefficients for taa_quatx4_slerp
+ * @details sin(t*theta)/sin(theta) is expanded as a series in
+ *          (cos(theta) - 1) whose terms are generated by the recurrence
+ *          a[i] = (u[i]*t*t - v[i]) * (cos(theta) - 1) * a[i-1], where
+ *          u[i] = 1/(i*(2i+1)) and v[i] = i/(2i+1). The series is truncated
+ *          to eight terms, and the last term is scaled by 1.85298109 to
+ *          minimize the maximum error over 0 <= theta <= pi/2. The error of
+ *          each interpolation weight does not exceed 2e-5.
+ *          See D. Eberly, "A Fast and Accurate Algorithm for Computing
+ *          SLERP", Journal of Graphics, GPU, and Game Tools, 2011.
+ */
+static const float s_taa_quatx4_slerp_u[8] =
+{
+    1.0f/( 1*3), 1.0f/( 2*5), 1.0f/( 3*7), 1.0f/( 4*9),
+    1.0f/(5*11), 1.0f/(6*13), 1.0f/(7*15), 1.85298109f/(8*17)
+};
+
+static const float s_taa_quatx4_slerp_v[8] =
+{
+    1.0f/3.0f, 2.0f/5.0f, 3.0f/7.0f, 4.0f/9.0f,
+    5.0f/11.0f, 6.0f/13.0f, 7.0f/15.0f, 1.85298109f*8.0f/17.0f
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief converts four rotation matrices into quaternions
+ * @details uses the same case selection as taa_quat_from_mat33, but every
+ *          case is evaluated and the results are blended with lane masks,
+ *          so there are no data dependent branches.
+ */
+taa_INLINE static void taa_quatx4_from_mat33x4(
+    const taa_mat33x4* m,
+    taa_quatx4* q_out);
+
+/**
+ * @brief converts an array of quaternions into structure of arrays format
+ * @details q_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element are set to zero.
+ */
+taa_INLINE static void taa_quatx4_from_quat(
+    const taa_quat* q,
+    uint32_t n,
+    taa_quatx4* q_out);
+
+/**
+ * @brief non-temporal store version of taa_quatx4_from_quat
+ */
+taa_INLINE static void taa_quatx4_from_quat_stream(
+    const taa_quat* q,
+    uint32_t n,
+    taa_quatx4* q_out);
+
+/**
+ * @brief normalized linear interpolation of four pairs of rotations
+ * @details interpolates along the shortest path for each lane.
+ * @params t four 16 byte aligned interpolation factors, one per lane
+ */
+taa_INLINE static void taa_quatx4_nlerp(
+    const taa_quatx4* a,
+    const taa_quatx4* b,
+    const float* t,
+    taa_quatx4* q_out);
+
+/**
+ * @brief approximate spherical linear interpolation of four pairs of
+ *        rotations
+ * @details interpolates along the shortest path for each lane using the
+ *          polynomial approximation described by s_taa_quatx4_slerp_u. No
+ *          trigonometric functions or divisions are evaluated.
+ * @params t four 16 byte aligned interpolation factors, one per lane
+ */
+taa_INLINE static void taa_quatx4_slerp(
+    const taa_quatx4* a,
+    const taa_quatx4* b,
+    const float* t,
+    taa_quatx4* q_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of quaternions
+ * @details a must contain (n + 3)/4 elements.
+ */
+taa_INLINE static void taa_quatx4_to_quat(
+    const taa_quatx4* a,
+    uint32_t n,
+    taa_quat* q_out);
+
+/**
+ * @brief non-temporal store version of taa_quatx4_to_quat
+ */
+taa_INLINE static void taa_quatx4_to_quat_stream(
+    const taa_quatx4* a,
+    uint32_t n,
+    taa_quat* q_out);
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_from_mat33x4(
+    const taa_mat33x4* m,
+    taa_quatx4* q_out)
+{
+    // each case i computes 4*q*q[i], and is scaled by 0.5/sqrt(4*q[i]*q[i])
+    // x case: (1+xx-yy-zz,      xy+yx,      xz+zx,      yz-zy)
+    // y case: (     xy+yx, 1-xx+yy-zz,      yz+zy,      zx-xz)
+    // z case: (     xz+zx,      yz+zy, 1-xx-yy+zz,      xy-yx)
+    // w case: (     yz-zy,      zx-xz,      xy-yx, 1+xx+yy+zz)
+    taa_vpu_vec4 xx;
+    taa_vpu_vec4 yy;
+    taa_vpu_vec4 zz;
+    taa_vpu_vec4 sxy;
+    taa_vpu_vec4 sxz;
+    taa_vpu_vec4 syz;
+    taa_vpu_vec4 dx;
+    taa_vpu_vec4 dy;
+    taa_vpu_vec4 dz;
+    taa_vpu_vec4 tx;
+    taa_vpu_vec4 ty;
+    taa_vpu_vec4 tz;
+    taa_vpu_vec4 tw;
+    taa_vpu_vec4 mx;
+    taa_vpu_vec4 my;
+    taa_vpu_vec4 mw;
+    taa_vpu_vec4 qx;
+    taa_vpu_vec4 qy;
+    taa_vpu_vec4 qz;
+    taa_vpu_vec4 qw;
+    taa_vpu_vec4 t;
+    taa_vpu_vec4 tmp;
+    taa_vpu_load(m->x.x, xx);
+    taa_vpu_load(m->y.y, yy);
+    taa_vpu_load(m->z.z, zz);
+    taa_vpu_load(m->x.y, sxy);
+    taa_vpu_load(m->y.x, tmp);
+    taa_vpu_sub(sxy, tmp, dz);
+    taa_vpu_add(sxy, tmp, sxy);
+    taa_vpu_load(m->z.x, sxz);
+    taa_vpu_load(m->x.z, tmp);
+    taa_vpu_sub(sxz, tmp, dy);
+    taa_vpu_add(sxz, tmp, sxz);
+    taa_vpu_load(m->y.z, syz);
+    taa_vpu_load(m->z.y, tmp);
+    taa_vpu_sub(syz, tmp, dx);
+    taa_vpu_add(syz, tmp, syz);
+    // diagonal terms
+    taa_vpu_set1(1.0f, t);
+    taa_vpu_add(t, xx, tw);
+    taa_vpu_sub(t, xx, tz);
+    taa_vpu_sub(tw, yy, tx);
+    taa_vpu_add(tw, yy, tw);
+    taa_vpu_add(tz, yy, ty);
+    taa_vpu_sub(tz, yy, tz);
+    taa_vpu_sub(tx, zz, tx);
+    taa_vpu_add(tw, zz, tw);
+    taa_vpu_sub(ty, zz, ty);
+    taa_vpu_add(tz, zz, tz);
+    // case masks: w if trace >= 0, else x if xx is the largest diagonal
+    // element, else y if yy > zz, else z
+    taa_vpu_cmpgt(xx, yy, mx);
+    taa_vpu_cmpgt(xx, zz, tmp);
+    taa_vpu_and(mx, tmp, mx);
+    taa_vpu_cmpgt(yy, zz, my);
+    taa_vpu_cmpgt(t, tw, mw);
+    // blend the cases: z, then y, then x, then w
+    taa_vpu_select(sxz, sxy, my, qx);
+    taa_vpu_select(qx, tx, mx, qx);
+    taa_vpu_select(dx, qx, mw, qx);
+    taa_vpu_select(syz, ty, my, qy);
+    taa_vpu_select(qy, sxy, mx, qy);
+    taa_vpu_select(dy, qy, mw, qy);
+    taa_vpu_select(tz, syz, my, qz);
+    taa_vpu_select(qz, sxz, mx, qz);
+    taa_vpu_select(dz, qz, mw, qz);
+    taa_vpu_select(dz, dy, my, qw);
+    taa_vpu_select(qw, dx, mx, qw);
+    taa_vpu_select(tw, qw, mw, qw);
+    taa_vpu_select(tz, ty, my, t);
+    taa_vpu_select(t, tx, mx, t);
+    taa_vpu_select(tw, t, mw, t);
+    // scale = 0.5/sqrt(t)
+    taa_vpu_sqrt(t, t);
+    taa_vpu_set1(0.5f, tmp);
+    taa_vpu_div(tmp, t, t);
+    taa_vpu_mul(qx, t, qx);
+    taa_vpu_mul(qy, t, qy);
+    taa_vpu_mul(qz, t, qz);
+    taa_vpu_mul(qw, t, qw);
+    taa_vpu_store(qx, q_out->x);
+    taa_vpu_store(qy, q_out->y);
+    taa_vpu_store(qz, q_out->z);
+    taa_vpu_store(qw, q_out->w);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_from_quat(
+    const taa_quat* q,
+    uint32_t n,
+    taa_quatx4* q_out)
+{
+    taa_vec4x4_from_vec4(q, n, q_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_from_quat_stream(
+    const taa_quat* q,
+    uint32_t n,
+    taa_quatx4* q_out)
+{
+    taa_vec4x4_from_vec4_stream(q, n, q_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_nlerp(
+    const taa_quatx4* a,
+    const taa_quatx4* b,
+    const float* t,
+    taa_quatx4* q_out)
+{
+    taa_vpu_vec4 ax;
+    taa_vpu_vec4 ay;
+    taa_vpu_vec4 az;
+    taa_vpu_vec4 aw;
+    taa_vpu_vec4 bx;
+    taa_vpu_vec4 by;
+    taa_vpu_vec4 bz;
+    taa_vpu_vec4 bw;
+    taa_vpu_vec4 wa;
+    taa_vpu_vec4 wb;
+    taa_vpu_vec4 d;
+    taa_vpu_vec4 sign;
+    taa_vpu_vec4 tmp;
+    assert((((size_t) t) & 15) == 0);
+    taa_vpu_load(a->x, ax);
+    taa_vpu_load(a->y, ay);
+    taa_vpu_load(a->z, az);
+    taa_vpu_load(a->w, aw);
+    taa_vpu_load(b->x, bx);
+    taa_vpu_load(b->y, by);
+    taa_vpu_load(b->z, bz);
+    taa_vpu_load(b->w, bw);
+    // d = dot(a, b)
+    taa_vpu_mul(ax, bx, d);
+    taa_vpu_mul(ay, by, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(az, bz, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(aw, bw, tmp);
+    taa_vpu_add(d, tmp, d);
+    // wa = 1 - t, wb = (d < 0) ? -t : t
+    taa_vpu_set1(-0.0f, sign);
+    taa_vpu_and(d, sign, sign);
+    taa_vpu_load(t, wb);
+    taa_vpu_set1(1.0f, wa);
+    taa_vpu_sub(wa, wb, wa);
+    taa_vpu_xor(wb, sign, wb);
+    // q = a*wa + b*wb
+    taa_vpu_mul(ax, wa, ax);
+    taa_vpu_mul(bx, wb, bx);
+    taa_vpu_add(ax, bx, ax);
+    taa_vpu_mul(ay, wa, ay);
+    taa_vpu_mul(by, wb, by);
+    taa_vpu_add(ay, by, ay);
+    taa_vpu_mul(az, wa, az);
+    taa_vpu_mul(bz, wb, bz);
+    taa_vpu_add(az, bz, az);
+    taa_vpu_mul(aw, wa, aw);
+    taa_vpu_mul(bw, wb, bw);
+    taa_vpu_add(aw, bw, aw);
+    // q /= length(q)
+    taa_vpu_mul(ax, ax, d);
+    taa_vpu_mul(ay, ay, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(az, az, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_mul(aw, aw, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_sqrt(d, d);
+    taa_vpu_set1(FLT_MIN, tmp);
+    taa_vpu_add(d, tmp, d);
+    taa_vpu_set1(1.0f, tmp);
+    taa_vpu_div(tmp, d, d);
+    taa_vpu_mul(ax, d, ax);
+    taa_vpu_mul(ay, d, ay);
+    taa_vpu_mul(az, d, az);
+    taa_vpu_mul(aw, d, aw);
+    taa_vpu_store(ax, q_out->x);
+    taa_vpu_store(ay, q_out->y);
+    taa_vpu_store(az, q_out->z);
+    taa_vpu_store(aw, q_out->w);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_slerp(
+    const taa_quatx4* a,
+    const taa_quatx4* b,
+    const float* t,
+    taa_quatx4* q_out)
+{
+    taa_vpu_vec4 ax;
+    taa_vpu_vec4 ay;
+    taa_vpu_vec4 az;
+    taa_vpu_vec4 aw;
+    taa_vpu_vec4 bx;
+    taa_vpu_vec4 by;
+    taa_vpu_vec4 bz;
+    taa_vpu_vec4 bw;
+    taa_vpu_vec4 vt;
+    taa_vpu_vec4 vd;
+    taa_vpu_vec4 ct;
+    taa_vpu_vec4 cd;
+    taa_vpu_vec4 tt;
+    taa_vpu_vec4 dd;
+    taa_vpu_vec4 xm1;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 sign;
+    taa_vpu_vec4 tmp;
+    int i;
+    assert((((size_t) t) & 15) == 0);
+    taa_vpu_load(a->x, ax);
+    taa_vpu_load(a->y, ay);
+    taa_vpu_load(a->z, az);
+    taa_vpu_load(a->w, aw);
+    taa_vpu_load(b->x, bx);
+    taa_vpu_load(b->y, by);
+    taa_vpu_load(b->z, bz);
+    taa_vpu_load(b->w, bw);
+    // x = dot(a, b) = cos(theta)
+    taa_vpu_mul(ax, bx, xm1);
+    taa_vpu_mul(ay, by, tmp);
+    taa_vpu_add(xm1, tmp, xm1);
+    taa_vpu_mul(az, bz, tmp);
+    taa_vpu_add(xm1, tmp, xm1);
+    taa_vpu_mul(aw, bw, tmp);
+    taa_vpu_add(xm1, tmp, xm1);
+    // take the shortest path: x = abs(x), and negate the weight of b
+    taa_vpu_set1(-0.0f, sign);
+    taa_vpu_and(xm1, sign, sign);
+    taa_vpu_xor(xm1, sign, xm1);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_sub(xm1, one, xm1);
+    // evaluate the polynomial for both t and d = 1 - t
+    taa_vpu_load(t, vt);
+    taa_vpu_sub(one, vt, vd);
+    taa_vpu_mul(vt, vt, tt);
+    taa_vpu_mul(vd, vd, dd);
+    taa_vpu_mov(one, ct);
+    taa_vpu_mov(one, cd);
+    for(i = 7; i >= 0; --i)
+    {
+        taa_vpu_vec4 u;
+        taa_vpu_vec4 v;
+        taa_vpu_set1(s_taa_quatx4_slerp_u[i], u);
+        taa_vpu_set1(s_taa_quatx4_slerp_v[i], v);
+        // ct = 1 + (u*t*t - v)*(x - 1)*ct
+        taa_vpu_mul(u, tt, tmp);
+        taa_vpu_sub(tmp, v, tmp);
+        taa_vpu_mul(tmp, xm1, tmp);
+        taa_vpu_mul(tmp, ct, ct);
+        taa_vpu_add(ct, one, ct);
+        // cd = 1 + (u*d*d - v)*(x - 1)*cd
+        taa_vpu_mul(u, dd, tmp);
+        taa_vpu_sub(tmp, v, tmp);
+        taa_vpu_mul(tmp, xm1, tmp);
+        taa_vpu_mul(tmp, cd, cd);
+        taa_vpu_add(cd, one, cd);
+    }
+    // wa = d*cd, wb = sign*t*ct
+    taa_vpu_mul(vd, cd, cd);
+    taa_vpu_mul(vt, ct, ct);
+    taa_vpu_xor(ct, sign, ct);
+    // q = a*wa + b*wb
+    taa_vpu_mul(ax, cd, ax);
+    taa_vpu_mul(bx, ct, bx);
+    taa_vpu_add(ax, bx, ax);
+    taa_vpu_mul(ay, cd, ay);
+    taa_vpu_mul(by, ct, by);
+    taa_vpu_add(ay, by, ay);
+    taa_vpu_mul(az, cd, az);
+    taa_vpu_mul(bz, ct, bz);
+    taa_vpu_add(az, bz, az);
+    taa_vpu_mul(aw, cd, aw);
+    taa_vpu_mul(bw, ct, bw);
+    taa_vpu_add(aw, bw, aw);
+    taa_vpu_store(ax, q_out->x);
+    taa_vpu_store(ay, q_out->y);
+    taa_vpu_store(az, q_out->z);
+    taa_vpu_store(aw, q_out->w);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_to_quat(
+    const taa_quatx4* a,
+    uint32_t n,
+    taa_quat* q_out)
+{
+    taa_vec4x4_to_vec4(a, n, q_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quatx4_to_quat_stream(
+    const taa_quatx4* a,
+    uint32_t n,
+    taa_quat* q_out)
+{
+    taa_vec4x4_to_vec4_stream(a, n, q_out);
+}
+
+#endif // taa_QUATX4_H_
@@ -0,0 +1,486 @@
+/**
+ * @brief     inlined ray intersection functions header
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_RAY_H_
+#define taa_RAY_H_
+
+#include "aabb.h"
+#include <float.h>
+
+typedef struct taa_ray_s taa_ray;
+typedef struct taa_ray_hit_s taa_ray_hit;
+typedef struct taa_rayx4_s taa_rayx4;
+typedef struct taa_trianglex4_s taa_trianglex4;
+
+/**
+ * @brief ray with precomputed reciprocal direction
+ * @details This structure MUST BE aligned on 16 byte boundaries. Zero
+ *          direction components have a reciprocal of FLT_MAX rather than
+ *          infinity, so slab tests never produce NaN. The w components are
+ *          ignored.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_ray_s
+{
+    taa_vec4 origin;
+    taa_vec4 dir;
+    taa_vec4 invdir;
+} taa_ATTRIB_ALIGN(16);
+
+/**
+ * @brief nearest intersection of a ray with an array of triangles
+ * @details the hit point is origin + dir*t, or v0*(1-u-v) + v1*u + v2*v
+ *          in terms of the vertices of the triangle.
+ */
+struct taa_ray_hit_s
+{
+    float t;
+    float u;
+    float v;
+    uint32_t index;
+};
+
+/**
+ * @brief four rays in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_rayx4_s
+{
+    taa_vec3x4 origin;
+    taa_vec3x4 dir;
+    taa_vec3x4 invdir;
+} taa_ATTRIB_ALIGN(16);
+
+/**
+ * @brief four triangles in structure of arrays format
+ * @details This structure MUST BE aligned on 16 byte boundaries. Each
+ *          triangle is stored as its first vertex and the two edges leaving
+ *          it, e1 = v1 - v0 and e2 = v2 - v0.
+ */
+struct taa_DECLSPEC_ALIGN(16) taa_trianglex4_s
+{
+    taa_vec3x4 v0;
+    taa_vec3x4 e1;
+    taa_vec3x4 e2;
+} taa_ATTRIB_ALIGN(16);
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief tests one ray against four boxes using the slab method
+ * @details only distances in the range [0, tmax] are considered. Entry
+ *          distances are written to t_out, clamped to 0 for rays starting
+ *          inside a box. Lanes that miss are set to FLT_MAX.
+ * @return bit mask of the lanes that were hit
+ */
+taa_INLINE static int taa_ray_intersect_aabbx4(
+    const taa_ray* r,
+    const taa_aabbx4* b,
+    float tmax,
+    taa_vec4* t_out);
+
+/**
+ * @brief finds the nearest intersection of a ray with an array of triangles
+ * @details uses the Moller-Trumbore test on four triangles at a time.
+ *          Triangles are two sided. tris must contain (n + 3)/4 elements.
+ *          Only distances in the range [0, tmax) are considered. hit_out is
+ *          only written if a triangle is hit.
+ * @return 1 if a triangle was hit, 0 otherwise
+ */
+taa_INLINE static int taa_ray_intersect_trianglex4(
+    const taa_ray* r,
+    const taa_trianglex4* tris,
+    uint32_t n,
+    float tmax,
+    taa_ray_hit* hit_out);
+
+/**
+ * @brief initializes a ray and computes its reciprocal direction
+ */
+taa_INLINE static void taa_ray_set(
+    const taa_vec4* origin,
+    const taa_vec4* dir,
+    taa_ray* r_out);
+
+/**
+ * @brief converts an array of rays into structure of arrays format
+ * @details r_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element repeat the last ray.
+ */
+taa_INLINE static void taa_rayx4_from_rays(
+    const taa_ray* r,
+    uint32_t n,
+    taa_rayx4* r_out);
+
+/**
+ * @brief tests a packet of four rays against one box
+ * @details tmax holds the maximum distance of each ray. Otherwise the same
+ *          as taa_ray_intersect_aabbx4.
+ * @return bit mask of the rays that hit the box
+ */
+taa_INLINE static int taa_rayx4_intersect_aabb(
+    const taa_rayx4* r,
+    const taa_aabb_minmax* b,
+    const taa_vec4* tmax,
+    taa_vec4* t_out);
+
+/**
+ * @brief converts an indexed triangle list into structure of arrays format
+ * @details indices contains three vertex indices per triangle. t_out must
+ *          have room for (n + 3)/4 elements. Unused lanes of the last
+ *          element repeat the last triangle.
+ */
+taa_INLINE static void taa_trianglex4_from_indexed(
+    const taa_vec4* pos,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_trianglex4* t_out);
+
+//****************************************************************************
+taa_INLINE static int taa_ray_intersect_aabbx4(
+    const taa_ray* r,
+    const taa_aabbx4* b,
+    float tmax,
+    taa_vec4* t_out)
+{
+    const float* o = &r->origin.x;
+    const float* inv = &r->invdir.x;
+    const float* bmin = b->min.x;
+    const float* bmax = b->max.x;
+    taa_vpu_vec4 tn;
+    taa_vpu_vec4 tf;
+    taa_vpu_vec4 miss;
+    taa_vpu_vec4 tfar;
+    int bits;
+    int i;
+    assert((((size_t) r) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) t_out) & 15) == 0);
+    taa_vpu_set1(0.0f, tn);
+    taa_vpu_set1(tmax, tf);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 vo;
+        taa_vpu_vec4 vinv;
+        taa_vpu_vec4 t1;
+        taa_vpu_vec4 t2;
+        taa_vpu_vec4 tlo;
+        taa_vpu_vec4 thi;
+        taa_vpu_set1(o[i], vo);
+        taa_vpu_set1(inv[i], vinv);
+        taa_vpu_load(bmin + i*4, t1);
+        taa_vpu_load(bmax + i*4, t2);
+        taa_vpu_sub(t1, vo, t1);
+        taa_vpu_sub(t2, vo, t2);
+        taa_vpu_mul(t1, vinv, t1);
+        taa_vpu_mul(t2, vinv, t2);
+        taa_vpu_min(t1, t2, tlo);
+        taa_vpu_max(t1, t2, thi);
+        taa_vpu_max(tn, tlo, tn);
+        taa_vpu_min(tf, thi, tf);
+    }
+    taa_vpu_cmpgt(tn, tf, miss);
+    taa_vpu_set1(FLT_MAX, tfar);
+    taa_vpu_select(tn, tfar, miss, tn);
+    taa_vpu_store(tn, &t_out->x);
+    taa_vpu_movemask(miss, bits);
+    return ~bits & 15;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_ray_intersect_trianglex4(
+    const taa_ray* r,
+    const taa_trianglex4* tris,
+    uint32_t n,
+    float tmax,
+    taa_ray_hit* hit_out)
+{
+    int result = 0;
+    taa_vpu_vec4 ox;
+    taa_vpu_vec4 oy;
+    taa_vpu_vec4 oz;
+    taa_vpu_vec4 dx;
+    taa_vpu_vec4 dy;
+    taa_vpu_vec4 dz;
+    taa_vpu_vec4 zero;
+    taa_vpu_vec4 one;
+    taa_vpu_vec4 eps;
+    taa_vpu_vec4 tbest;
+    uint32_t i;
+    assert((((size_t) r) & 15) == 0);
+    assert((((size_t) tris) & 15) == 0);
+    taa_vpu_set1(r->origin.x, ox);
+    taa_vpu_set1(r->origin.y, oy);
+    taa_vpu_set1(r->origin.z, oz);
+    taa_vpu_set1(r->dir.x, dx);
+    taa_vpu_set1(r->dir.y, dy);
+    taa_vpu_set1(r->dir.z, dz);
+    taa_vpu_set1(0.0f, zero);
+    taa_vpu_set1(1.0f, one);
+    taa_vpu_set1(FLT_MIN, eps);
+    taa_vpu_set1(tmax, tbest);
+    for(i = 0; i < n; i += 4)
+    {
+        const taa_trianglex4* tri = tris + (i >> 2);
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        taa_vpu_vec4 e1x;
+        taa_vpu_vec4 e1y;
+        taa_vpu_vec4 e1z;
+        taa_vpu_vec4 e2x;
+        taa_vpu_vec4 e2y;
+        taa_vpu_vec4 e2z;
+        taa_vpu_vec4 tx;
+        taa_vpu_vec4 ty;
+        taa_vpu_vec4 tz;
+        taa_vpu_vec4 px;
+        taa_vpu_vec4 py;
+        taa_vpu_vec4 pz;
+        taa_vpu_vec4 qx;
+        taa_vpu_vec4 qy;
+        taa_vpu_vec4 qz;
+        taa_vpu_vec4 det;
+        taa_vpu_vec4 inv;
+        taa_vpu_vec4 u;
+        taa_vpu_vec4 v;
+        taa_vpu_vec4 t;
+        taa_vpu_vec4 tmp;
+        taa_vpu_vec4 fail;
+        taa_vpu_vec4 hit;
+        int bits;
+        taa_vpu_load(tri->e1.x, e1x);
+        taa_vpu_load(tri->e1.y, e1y);
+        taa_vpu_load(tri->e1.z, e1z);
+        taa_vpu_load(tri->e2.x, e2x);
+        taa_vpu_load(tri->e2.y, e2y);
+        taa_vpu_load(tri->e2.z, e2z);
+        // p = d x e2
+        taa_vpu_mul(dy, e2z, px);
+        taa_vpu_mul(dz, e2y, tmp);
+        taa_vpu_sub(px, tmp, px);
+        taa_vpu_mul(dz, e2x, py);
+        taa_vpu_mul(dx, e2z, tmp);
+        taa_vpu_sub(py, tmp, py);
+        taa_vpu_mul(dx, e2y, pz);
+        taa_vpu_mul(dy, e2x, tmp);
+        taa_vpu_sub(pz, tmp, pz);
+        // det = e1 . p
+        taa_vpu_mul(e1x, px, det);
+        taa_vpu_mul(e1y, py, tmp);
+        taa_vpu_add(det, tmp, det);
+        taa_vpu_mul(e1z, pz, tmp);
+        taa_vpu_add(det, tmp, det);
+        taa_vpu_div(one, det, inv);
+        // t = o - v0
+        taa_vpu_load(tri->v0.x, tx);
+        taa_vpu_load(tri->v0.y, ty);
+        taa_vpu_load(tri->v0.z, tz);
+        taa_vpu_sub(ox, tx, tx);
+        taa_vpu_sub(oy, ty, ty);
+        taa_vpu_sub(oz, tz, tz);
+        // u = (t . p) / det
+        taa_vpu_mul(tx, px, u);
+        taa_vpu_mul(ty, py, tmp);
+        taa_vpu_add(u, tmp, u);
+        taa_vpu_mul(tz, pz, tmp);
+        taa_vpu_add(u, tmp, u);
+        taa_vpu_mul(u, inv, u);
+        // q = t x e1
+        taa_vpu_mul(ty, e1z, qx);
+        taa_vpu_mul(tz, e1y, tmp);
+        taa_vpu_sub(qx, tmp, qx);
+        taa_vpu_mul(tz, e1x, qy);
+        taa_vpu_mul(tx, e1z, tmp);
+        taa_vpu_sub(qy, tmp, qy);
+        taa_vpu_mul(tx, e1y, qz);
+        taa_vpu_mul(ty, e1x, tmp);
+        taa_vpu_sub(qz, tmp, qz);
+        // v = (d . q) / det
+        taa_vpu_mul(dx, qx, v);
+        taa_vpu_mul(dy, qy, tmp);
+        taa_vpu_add(v, tmp, v);
+        taa_vpu_mul(dz, qz, tmp);
+        taa_vpu_add(v, tmp, v);
+        taa_vpu_mul(v, inv, v);
+        // t = (e2 . q) / det
+        taa_vpu_mul(e2x, qx, t);
+        taa_vpu_mul(e2y, qy, tmp);
+        taa_vpu_add(t, tmp, t);
+        taa_vpu_mul(e2z, qz, tmp);
+        taa_vpu_add(t, tmp, t);
+        taa_vpu_mul(t, inv, t);
+        // reject parallel triangles and hits outside the triangle or range.
+        // the final compare also rejects any NaN distance.
+        taa_vpu_cmpagt(eps, det, fail);
+        taa_vpu_cmpgt(zero, u, tmp);
+        taa_vpu_or(fail, tmp, fail);
+        taa_vpu_cmpgt(zero, v, tmp);
+        taa_vpu_or(fail, tmp, fail);
+        taa_vpu_add(u, v, tmp);
+        taa_vpu_cmpgt(tmp, one, tmp);
+        taa_vpu_or(fail, tmp, fail);
+        taa_vpu_cmpgt(zero, t, tmp);
+        taa_vpu_or(fail, tmp, fail);
+        taa_vpu_cmpgt(tbest, t, hit);
+        taa_vpu_select(hit, zero, fail, hit);
+        taa_vpu_movemask(hit, bits);
+        bits &= (1 << nlanes) - 1;
+        if(bits != 0)
+        {
+            taa_vec3x4 tuv;
+            uint32_t k;
+            taa_vpu_store(t, tuv.x);
+            taa_vpu_store(u, tuv.y);
+            taa_vpu_store(v, tuv.z);
+            for(k = 0; k < nlanes; ++k)
+            {
+                if((bits & (1 << k)) != 0 && tuv.x[k] < tmax)
+                {
+                    tmax = tuv.x[k];
+                    hit_out->t = tuv.x[k];
+                    hit_out->u = tuv.y[k];
+                    hit_out->v = tuv.z[k];
+                    hit_out->index = i + k;
+                    result = 1;
+                }
+            }
+            taa_vpu_set1(tmax, tbest);
+        }
+    }
+    return result;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_ray_set(
+    const taa_vec4* origin,
+    const taa_vec4* dir,
+    taa_ray* r_out)
+{
+    const float* d = &dir->x;
+    float* inv = &r_out->invdir.x;
+    int i;
+    r_out->origin = *origin;
+    r_out->dir = *dir;
+    for(i = 0; i < 3; ++i)
+    {
+        if(d[i] != 0.0f)
+        {
+            inv[i] = 1.0f/d[i];
+        }
+        else
+        {
+            inv[i] = FLT_MAX;
+        }
+    }
+    inv[3] = 0.0f;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_rayx4_from_rays(
+    const taa_ray* r,
+    uint32_t n,
+    taa_rayx4* r_out)
+{
+    uint32_t i;
+    assert(n > 0);
+    for(i = 0; i < ((n + 3) & ~3); ++i)
+    {
+        const taa_ray* ri = r + ((i < n) ? i : n - 1);
+        taa_rayx4* ro = r_out + (i >> 2);
+        uint32_t lane = i & 3;
+        ro->origin.x[lane] = ri->origin.x;
+        ro->origin.y[lane] = ri->origin.y;
+        ro->origin.z[lane] = ri->origin.z;
+        ro->dir.x[lane] = ri->dir.x;
+        ro->dir.y[lane] = ri->dir.y;
+        ro->dir.z[lane] = ri->dir.z;
+        ro->invdir.x[lane] = ri->invdir.x;
+        ro->invdir.y[lane] = ri->invdir.y;
+        ro->invdir.z[lane] = ri->invdir.z;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static int taa_rayx4_intersect_aabb(
+    const taa_rayx4* r,
+    const taa_aabb_minmax* b,
+    const taa_vec4* tmax,
+    taa_vec4* t_out)
+{
+    const float* o = r->origin.x;
+    const float* inv = r->invdir.x;
+    const float* bmin = &b->min.x;
+    const float* bmax = &b->max.x;
+    taa_vpu_vec4 tn;
+    taa_vpu_vec4 tf;
+    taa_vpu_vec4 miss;
+    taa_vpu_vec4 tfar;
+    int bits;
+    int i;
+    assert((((size_t) r) & 15) == 0);
+    assert((((size_t) b) & 15) == 0);
+    assert((((size_t) tmax) & 15) == 0);
+    assert((((size_t) t_out) & 15) == 0);
+    taa_vpu_set1(0.0f, tn);
+    taa_vpu_load(&tmax->x, tf);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_vpu_vec4 vo;
+        taa_vpu_vec4 vinv;
+        taa_vpu_vec4 t1;
+        taa_vpu_vec4 t2;
+        taa_vpu_vec4 tlo;
+        taa_vpu_vec4 thi;
+        taa_vpu_load(o + i*4, vo);
+        taa_vpu_load(inv + i*4, vinv);
+        taa_vpu_set1(bmin[i], t1);
+        taa_vpu_set1(bmax[i], t2);
+        taa_vpu_sub(t1, vo, t1);
+        taa_vpu_sub(t2, vo, t2);
+        taa_vpu_mul(t1, vinv, t1);
+        taa_vpu_mul(t2, vinv, t2);
+        taa_vpu_min(t1, t2, tlo);
+        taa_vpu_max(t1, t2, thi);
+        taa_vpu_max(tn, tlo, tn);
+        taa_vpu_min(tf, thi, tf);
+    }
+    taa_vpu_cmpgt(tn, tf, miss);
+    taa_vpu_set1(FLT_MAX, tfar);
+    taa_vpu_select(tn, tfar, miss, tn);
+    taa_vpu_store(tn, &t_out->x);
+    taa_vpu_movemask(miss, bits);
+    return ~bits & 15;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_trianglex4_from_indexed(
+    const taa_vec4* pos,
+    const uint32_t* indices,
+    uint32_t n,
+    taa_trianglex4* t_out)
+{
+    uint32_t i;
+    assert(n > 0);
+    for(i = 0; i < ((n + 3) & ~3); ++i)
+    {
+        const uint32_t* idx = indices + ((i < n) ? i : n - 1)*3;
+        const taa_vec4* v0 = pos + idx[0];
+        const taa_vec4* v1 = pos + idx[1];
+        const taa_vec4* v2 = pos + idx[2];
+        taa_trianglex4* to = t_out + (i >> 2);
+        uint32_t lane = i & 3;
+        to->v0.x[lane] = v0->x;
+        to->v0.y[lane] = v0->y;
+        to->v0.z[lane] = v0->z;
+        to->e1.x[lane] = v1->x - v0->x;
+        to->e1.y[lane] = v1->y - v0->y;
+        to->e1.z[lane] = v1->z - v0->z;
+        to->e2.x[lane] = v2->x - v0->x;
+        to->e2.y[lane] = v2->y - v0->y;
+        to->e2.z[lane] = v2->z - v0->z;
+    }
+}
+
+#endif // taa_RAY_H_
@@ -0,0 +1,401 @@
+/**
+ * @brief     inlined linear blend skinning functions header
+ * @details   vertices are skinned four at a time in structure of arrays
+ *            format. The four bone matrices of each vertex are blended in
+ *            registers, so no blended matrix is ever written to memory.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_SKIN_H_
+#define taa_SKIN_H_
+
+#include "vec3x4.h"
+#include "vec4x4.h"
+#include "vpu.h"
+#include <assert.h>
+#include <float.h>
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief linear blend skinning of an array of vertices
+ * @details each vertex is influenced by four bones. indices holds four bone
+ *          indices per vertex, and weights holds the matching four weights
+ *          in its x, y, z and w components. Only the upper 3x4 of the
+ *          palette matrices is used. Normals are transformed by the blended
+ *          upper 3x3 and renormalized, which assumes the bones do not
+ *          contain non-uniform scale. nrm and nrm_out may both be NULL to
+ *          skip normals. palette and weights must be 16 byte aligned.
+ */
+taa_INLINE static void taa_skin_lbs(
+    const taa_mat44* palette,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief taa_skin_lbs with the width of the bone indices as an argument
+ * @details indexsize is the size in bytes of each bone index, 1 for uint8_t
+ *          or 2 for uint16_t. The other arguments are the same as
+ *          taa_skin_lbs, which along with taa_skin_lbs_u8 calls this.
+ */
+taa_INLINE static void taa_skin_lbs_indexed(
+    const taa_mat44* palette,
+    const void* indices,
+    uint32_t indexsize,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief skins the vertices in the range [begin, end)
+ * @details the arguments are the same as taa_skin_lbs, with all arrays
+ *          indexed from the start of the mesh. Ranges do not share any
+ *          output, so disjoint ranges of the same mesh may be skinned
+ *          concurrently by separate threads.
+ */
+taa_INLINE static void taa_skin_lbs_range(
+    const taa_mat44* palette,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief 8 bit bone index version of taa_skin_lbs
+ */
+taa_INLINE static void taa_skin_lbs_u8(
+    const taa_mat44* palette,
+    const uint8_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief 8 bit bone index version of taa_skin_lbs_range
+ */
+taa_INLINE static void taa_skin_lbs_u8_range(
+    const taa_mat44* palette,
+    const uint8_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out);
+
+/**
+ * @brief skins four vertices in structure of arrays format
+ * @details bones[k][i] is the matrix of influence k for lane i, and w[k]
+ *          holds the weights of influence k for each lane. n4 may be NULL.
+ *          p4 and n4 are transformed in place.
+ */
+taa_INLINE static void taa_skin_lbs_x4(
+    const taa_mat44* bones[4][4],
+    const taa_vec4x4* w,
+    taa_vec3x4* p4,
+    taa_vec3x4* n4);
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs(
+    const taa_mat44* palette,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    taa_skin_lbs_indexed(
+        palette,
+        indices,
+        sizeof(*indices),
+        weights,
+        pos,
+        nrm,
+        n,
+        pos_out,
+        nrm_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs_indexed(
+    const taa_mat44* palette,
+    const void* indices,
+    uint32_t indexsize,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    const uint8_t* idx8 = (const uint8_t*) indices;
+    const uint16_t* idx16 = (const uint16_t*) indices;
+    const taa_vec3* pend = pos + n;
+    const taa_mat44* bones[4][4];
+    taa_vec4x4 w4;
+    taa_vec3x4 p4;
+    taa_vec3x4 n4;
+    uint32_t i;
+    uint32_t k;
+    assert((((size_t) palette) & 15) == 0);
+    assert((((size_t) weights) & 15) == 0);
+    assert(indexsize == 1 || indexsize == 2);
+    assert((nrm == NULL) == (nrm_out == NULL));
+    while(pos != pend)
+    {
+        uint32_t nlanes = (uint32_t) (pend - pos);
+        nlanes = (nlanes < 4) ? nlanes : 4;
+        // unused lanes reuse the first bone with zero weight
+        for(i = 0; i < 4; ++i)
+        {
+            for(k = 0; k < 4; ++k)
+            {
+                uint32_t b = 0;
+                if(i < nlanes)
+                {
+                    b = (indexsize == 1) ? idx8[i*4 + k] : idx16[i*4 + k];
+                }
+                bones[k][i] = palette + b;
+            }
+        }
+        taa_vec4x4_from_vec4(weights, nlanes, &w4);
+        taa_vec3x4_from_vec3(pos, nlanes, &p4);
+        if(nrm != NULL)
+        {
+            taa_vec3x4_from_vec3(nrm, nlanes, &n4);
+            taa_skin_lbs_x4(bones, &w4, &p4, &n4);
+            taa_vec3x4_to_vec3(&n4, nlanes, nrm_out);
+            nrm += nlanes;
+            nrm_out += nlanes;
+        }
+        else
+        {
+            taa_skin_lbs_x4(bones, &w4, &p4, NULL);
+        }
+        taa_vec3x4_to_vec3(&p4, nlanes, pos_out);
+        pos += nlanes;
+        pos_out += nlanes;
+        idx8 += nlanes*4;
+        idx16 += nlanes*4;
+        weights += nlanes;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs_range(
+    const taa_mat44* palette,
+    const uint16_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    assert(begin <= end);
+    taa_skin_lbs(
+        palette,
+        indices + begin*4,
+        weights + begin,
+        pos + begin,
+        (nrm != NULL) ? nrm + begin : NULL,
+        end - begin,
+        pos_out + begin,
+        (nrm_out != NULL) ? nrm_out + begin : NULL);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs_u8(
+    const taa_mat44* palette,
+    const uint8_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t n,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    taa_skin_lbs_indexed(
+        palette,
+        indices,
+        sizeof(*indices),
+        weights,
+        pos,
+        nrm,
+        n,
+        pos_out,
+        nrm_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs_u8_range(
+    const taa_mat44* palette,
+    const uint8_t* indices,
+    const taa_vec4* weights,
+    const taa_vec3* pos,
+    const taa_vec3* nrm,
+    uint32_t begin,
+    uint32_t end,
+    taa_vec3* pos_out,
+    taa_vec3* nrm_out)
+{
+    assert(begin <= end);
+    taa_skin_lbs_u8(
+        palette,
+        indices + begin*4,
+        weights + begin,
+        pos + begin,
+        (nrm != NULL) ? nrm + begin : NULL,
+        end - begin,
+        pos_out + begin,
+        (nrm_out != NULL) ? nrm_out + begin : NULL);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_skin_lbs_x4(
+    const taa_mat44* bones[4][4],
+    const taa_vec4x4* w,
+    taa_vec3x4* p4,
+    taa_vec3x4* n4)
+{
+    // m[c*3 + r] holds row r of column c of the blended matrix for each lane
+    taa_vpu_vec4 m[12];
+    taa_vpu_vec4 vx;
+    taa_vpu_vec4 vy;
+    taa_vpu_vec4 vz;
+    taa_vpu_vec4 rx;
+    taa_vpu_vec4 ry;
+    taa_vpu_vec4 rz;
+    taa_vpu_vec4 tmp;
+    uint32_t c;
+    uint32_t k;
+    assert((((size_t) w) & 15) == 0);
+    assert((((size_t) p4) & 15) == 0);
+    for(k = 0; k < 4; ++k)
+    {
+        const float* b0 = &bones[k][0]->x.x;
+        const float* b1 = &bones[k][1]->x.x;
+        const float* b2 = &bones[k][2]->x.x;
+        const float* b3 = &bones[k][3]->x.x;
+        taa_vpu_vec4 wk;
+        taa_vpu_load(w->x + k*4, wk);
+        for(c = 0; c < 4; ++c)
+        {
+            taa_vpu_vec4 c0;
+            taa_vpu_vec4 c1;
+            taa_vpu_vec4 c2;
+            taa_vpu_vec4 c3;
+            taa_vpu_vec4 x;
+            taa_vpu_vec4 y;
+            taa_vpu_vec4 z;
+            taa_vpu_vec4 unused;
+            taa_vpu_load(b0 + c*4, c0);
+            taa_vpu_load(b1 + c*4, c1);
+            taa_vpu_load(b2 + c*4, c2);
+            taa_vpu_load(b3 + c*4, c3);
+            taa_vpu_mat44_transpose(c0, c1, c2, c3, x, y, z, unused);
+            (void) unused;
+            taa_vpu_mul(x, wk, x);
+            taa_vpu_mul(y, wk, y);
+            taa_vpu_mul(z, wk, z);
+            if(k == 0)
+            {
+                taa_vpu_mov(x, m[c*3 + 0]);
+                taa_vpu_mov(y, m[c*3 + 1]);
+                taa_vpu_mov(z, m[c*3 + 2]);
+            }
+            else
+            {
+                taa_vpu_add(m[c*3 + 0], x, m[c*3 + 0]);
+                taa_vpu_add(m[c*3 + 1], y, m[c*3 + 1]);
+                taa_vpu_add(m[c*3 + 2], z, m[c*3 + 2]);
+            }
+        }
+    }
+    // p' = M * (p, 1)
+    taa_vpu_load(p4->x, vx);
+    taa_vpu_load(p4->y, vy);
+    taa_vpu_load(p4->z, vz);
+    taa_vpu_mul(m[0], vx, rx);
+    taa_vpu_mul(m[1], vx, ry);
+    taa_vpu_mul(m[2], vx, rz);
+    taa_vpu_mul(m[3], vy, tmp);
+    taa_vpu_add(rx, tmp, rx);
+    taa_vpu_mul(m[4], vy, tmp);
+    taa_vpu_add(ry, tmp, ry);
+    taa_vpu_mul(m[5], vy, tmp);
+    taa_vpu_add(rz, tmp, rz);
+    taa_vpu_mul(m[6], vz, tmp);
+    taa_vpu_add(rx, tmp, rx);
+    taa_vpu_mul(m[7], vz, tmp);
+    taa_vpu_add(ry, tmp, ry);
+    taa_vpu_mul(m[8], vz, tmp);
+    taa_vpu_add(rz, tmp, rz);
+    taa_vpu_add(rx, m[9], rx);
+    taa_vpu_add(ry, m[10], ry);
+    taa_vpu_add(rz, m[11], rz);
+    taa_vpu_store(rx, p4->x);
+    taa_vpu_store(ry, p4->y);
+    taa_vpu_store(rz, p4->z);
+    if(n4 != NULL)
+    {
+        // n' = |M3 * n|
+        assert((((size_t) n4) & 15) == 0);
+        taa_vpu_load(n4->x, vx);
+        taa_vpu_load(n4->y, vy);
+        taa_vpu_load(n4->z, vz);
+        taa_vpu_mul(m[0], vx, rx);
+        taa_vpu_mul(m[1], vx, ry);
+        taa_vpu_mul(m[2], vx, rz);
+        taa_vpu_mul(m[3], vy, tmp);
+        taa_vpu_add(rx, tmp, rx);
+        taa_vpu_mul(m[4], vy, tmp);
+        taa_vpu_add(ry, tmp, ry);
+        taa_vpu_mul(m[5], vy, tmp);
+        taa_vpu_add(rz, tmp, rz);
+        taa_vpu_mul(m[6], vz, tmp);
+        taa_vpu_add(rx, tmp, rx);
+        taa_vpu_mul(m[7], vz, tmp);
+        taa_vpu_add(ry, tmp, ry);
+        taa_vpu_mul(m[8], vz, tmp);
+        taa_vpu_add(rz, tmp, rz);
+        taa_vpu_mul(rx, rx, tmp);
+        taa_vpu_mul(ry, ry, vx);
+        taa_vpu_add(tmp, vx, tmp);
+        taa_vpu_mul(rz, rz, vx);
+        taa_vpu_add(tmp, vx, tmp);
+        // zero length normals, including unused lanes, stay zero
+        taa_vpu_set1(FLT_MIN, vx);
+        taa_vpu_sqrt(tmp, tmp);
+        taa_vpu_add(tmp, vx, tmp);
+        taa_vpu_div(rx, tmp, rx);
+        taa_vpu_div(ry, tmp, ry);
+        taa_vpu_div(rz, tmp, rz);
+        taa_vpu_store(rx, n4->x);
+        taa_vpu_store(ry, n4->y);
+        taa_vpu_store(rz, n4->z);
+    }
+}
+
+#endif // taa_SKIN_H_
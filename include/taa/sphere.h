@@ -0,0 +1,337 @@
+/**
+ * @brief     inlined bounding sphere functions header
+ * @details   spheres are stored in a taa_vec4, with the center in xyz and
+ *            the radius in w. To bound a very large point set on several
+ *            threads, bound disjoint ranges of it separately and combine
+ *            the results with taa_sphere_merge_array.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_SPHERE_H_
+#define taa_SPHERE_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+/** number of directions searched for extreme points */
+#define taa_SPHERE_NUM_DIRS 7
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief computes a bounding sphere for an array of points
+ * @details the initial sphere spans the most distant pair of extreme points
+ *          along seven directions, found four points at a time. A second
+ *          pass grows the sphere to include any point outside it. The
+ *          result is typically within a few percent of the minimal sphere.
+ *          n must be less than 2^24.
+ */
+taa_INLINE static void taa_sphere_from_points(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec4* sphere_out);
+
+/**
+ * @brief grows a sphere to include an array of points
+ * @details uses Ritter's method, testing four points at a time and only
+ *          updating the sphere for the points found outside it.
+ */
+taa_INLINE static void taa_sphere_grow_points(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec4* sphere);
+
+/**
+ * @brief computes the smallest sphere enclosing two spheres
+ * @details a, b, and sphere_out may be the same.
+ */
+taa_INLINE static void taa_sphere_merge(
+    const taa_vec4* a,
+    const taa_vec4* b,
+    taa_vec4* sphere_out);
+
+/**
+ * @brief computes a sphere enclosing an array of spheres
+ */
+taa_INLINE static void taa_sphere_merge_array(
+    const taa_vec4* s,
+    uint32_t n,
+    taa_vec4* sphere_out);
+
+//****************************************************************************
+taa_INLINE static void taa_sphere_from_points(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec4* sphere_out)
+{
+    taa_vpu_vec4 minv[taa_SPHERE_NUM_DIRS];
+    taa_vpu_vec4 maxv[taa_SPHERE_NUM_DIRS];
+    taa_vpu_vec4 mini[taa_SPHERE_NUM_DIRS];
+    taa_vpu_vec4 maxi[taa_SPHERE_NUM_DIRS];
+    taa_vpu_vec4 idx;
+    taa_vpu_vec4 four;
+    const taa_vec3* best0 = v;
+    const taa_vec3* best1 = v;
+    float bestd2 = -1.0f;
+    uint32_t i;
+    int k;
+    assert(n < (1 << 24));
+    if(n == 0)
+    {
+        sphere_out->x = 0.0f;
+        sphere_out->y = 0.0f;
+        sphere_out->z = 0.0f;
+        sphere_out->w = 0.0f;
+        return;
+    }
+    taa_vpu_set1(FLT_MAX, minv[0]);
+    taa_vpu_set1(-FLT_MAX, maxv[0]);
+    taa_vpu_set1(0.0f, mini[0]);
+    for(k = 1; k < taa_SPHERE_NUM_DIRS; ++k)
+    {
+        taa_vpu_mov(minv[0], minv[k]);
+        taa_vpu_mov(maxv[0], maxv[k]);
+        taa_vpu_mov(mini[0], mini[k]);
+    }
+    for(k = 0; k < taa_SPHERE_NUM_DIRS; ++k)
+    {
+        taa_vpu_mov(mini[0], maxi[k]);
+    }
+    taa_vpu_set(0.0f, 1.0f, 2.0f, 3.0f, idx);
+    taa_vpu_set1(4.0f, four);
+    // find the extreme points along each direction, one per lane
+    for(i = 0; i < n; i += 4)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_vec4 xy;
+        taa_vpu_vec4 x_y;
+        taa_vpu_vec4 proj[taa_SPHERE_NUM_DIRS];
+        if(n - i >= 4)
+        {
+            taa_vpu_load3x4(&v[i].x, x, y, z);
+        }
+        else
+        {
+            // unused lanes repeat the last point
+            const taa_vec3* v0 = v + i;
+            const taa_vec3* v1 = v + ((i + 1 < n) ? i + 1 : n - 1);
+            const taa_vec3* v2 = v + ((i + 2 < n) ? i + 2 : n - 1);
+            const taa_vec3* v3 = v + n - 1;
+            taa_vpu_set(v0->x, v1->x, v2->x, v3->x, x);
+            taa_vpu_set(v0->y, v1->y, v2->y, v3->y, y);
+            taa_vpu_set(v0->z, v1->z, v2->z, v3->z, z);
+        }
+        taa_vpu_add(x, y, xy);
+        taa_vpu_sub(x, y, x_y);
+        taa_vpu_mov(x, proj[0]);
+        taa_vpu_mov(y, proj[1]);
+        taa_vpu_mov(z, proj[2]);
+        taa_vpu_add(xy, z, proj[3]);
+        taa_vpu_sub(xy, z, proj[4]);
+        taa_vpu_add(x_y, z, proj[5]);
+        taa_vpu_sub(x_y, z, proj[6]);
+        for(k = 0; k < taa_SPHERE_NUM_DIRS; ++k)
+        {
+            taa_vpu_vec4 mask;
+            taa_vpu_cmpgt(minv[k], proj[k], mask);
+            taa_vpu_select(minv[k], proj[k], mask, minv[k]);
+            taa_vpu_select(mini[k], idx, mask, mini[k]);
+            taa_vpu_cmpgt(proj[k], maxv[k], mask);
+            taa_vpu_select(maxv[k], proj[k], mask, maxv[k]);
+            taa_vpu_select(maxi[k], idx, mask, maxi[k]);
+        }
+        taa_vpu_add(idx, four, idx);
+    }
+    // reduce the lanes and keep the most distant pair of extreme points
+    for(k = 0; k < taa_SPHERE_NUM_DIRS; ++k)
+    {
+        taa_vec4 mnv;
+        taa_vec4 mxv;
+        taa_vec4 mni;
+        taa_vec4 mxi;
+        const taa_vec3* p0;
+        const taa_vec3* p1;
+        float dx;
+        float dy;
+        float dz;
+        float d2;
+        int lmin = 0;
+        int lmax = 0;
+        int l;
+        taa_vpu_store(minv[k], &mnv.x);
+        taa_vpu_store(maxv[k], &mxv.x);
+        taa_vpu_store(mini[k], &mni.x);
+        taa_vpu_store(maxi[k], &mxi.x);
+        for(l = 1; l < 4; ++l)
+        {
+            lmin = ((&mnv.x)[l] < (&mnv.x)[lmin]) ? l : lmin;
+            lmax = ((&mxv.x)[l] > (&mxv.x)[lmax]) ? l : lmax;
+        }
+        p0 = v + (uint32_t) (&mni.x)[lmin];
+        p1 = v + (uint32_t) (&mxi.x)[lmax];
+        dx = p1->x - p0->x;
+        dy = p1->y - p0->y;
+        dz = p1->z - p0->z;
+        d2 = dx*dx + dy*dy + dz*dz;
+        if(d2 > bestd2)
+        {
+            bestd2 = d2;
+            best0 = p0;
+            best1 = p1;
+        }
+    }
+    sphere_out->x = (best0->x + best1->x) * 0.5f;
+    sphere_out->y = (best0->y + best1->y) * 0.5f;
+    sphere_out->z = (best0->z + best1->z) * 0.5f;
+    sphere_out->w = sqrtf(bestd2) * 0.5f;
+    taa_sphere_grow_points(v, n, sphere_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_sphere_grow_points(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec4* sphere)
+{
+    taa_vpu_vec4 cx;
+    taa_vpu_vec4 cy;
+    taa_vpu_vec4 cz;
+    taa_vpu_vec4 r2;
+    uint32_t i;
+    taa_vpu_set1(sphere->x, cx);
+    taa_vpu_set1(sphere->y, cy);
+    taa_vpu_set1(sphere->z, cz);
+    taa_vpu_set1(sphere->w * sphere->w, r2);
+    for(i = 0; i < n; i += 4)
+    {
+        uint32_t nlanes = ((n - i) < 4) ? (n - i) : 4;
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_vec4 d2;
+        int bits;
+        if(nlanes == 4)
+        {
+            taa_vpu_load3x4(&v[i].x, x, y, z);
+        }
+        else
+        {
+            const taa_vec3* v0 = v + i;
+            const taa_vec3* v1 = v + ((nlanes > 1) ? i + 1 : n - 1);
+            const taa_vec3* v2 = v + ((nlanes > 2) ? i + 2 : n - 1);
+            const taa_vec3* v3 = v + n - 1;
+            taa_vpu_set(v0->x, v1->x, v2->x, v3->x, x);
+            taa_vpu_set(v0->y, v1->y, v2->y, v3->y, y);
+            taa_vpu_set(v0->z, v1->z, v2->z, v3->z, z);
+        }
+        taa_vpu_sub(x, cx, x);
+        taa_vpu_sub(y, cy, y);
+        taa_vpu_sub(z, cz, z);
+        taa_vpu_mul(x, x, d2);
+        taa_vpu_mul(y, y, y);
+        taa_vpu_mul(z, z, z);
+        taa_vpu_add(d2, y, d2);
+        taa_vpu_add(d2, z, d2);
+        taa_vpu_cmpgt(d2, r2, d2);
+        taa_vpu_movemask(d2, bits);
+        bits &= (1 << nlanes) - 1;
+        if(bits != 0)
+        {
+            // grow the sphere to just include each outside point in order
+            uint32_t k;
+            for(k = 0; k < nlanes; ++k)
+            {
+                if((bits & (1 << k)) != 0)
+                {
+                    const taa_vec3* p = v + i + k;
+                    float dx = p->x - sphere->x;
+                    float dy = p->y - sphere->y;
+                    float dz = p->z - sphere->z;
+                    float d = sqrtf(dx*dx + dy*dy + dz*dz);
+                    if(d > sphere->w)
+                    {
+                        float r = (sphere->w + d) * 0.5f;
+                        float s = (r - sphere->w) / d;
+                        sphere->x += dx * s;
+                        sphere->y += dy * s;
+                        sphere->z += dz * s;
+                        sphere->w = r;
+                    }
+                }
+            }
+            taa_vpu_set1(sphere->x, cx);
+            taa_vpu_set1(sphere->y, cy);
+            taa_vpu_set1(sphere->z, cz);
+            taa_vpu_set1(sphere->w * sphere->w, r2);
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_sphere_merge(
+    const taa_vec4* a,
+    const taa_vec4* b,
+    taa_vec4* sphere_out)
+{
+    float dx = b->x - a->x;
+    float dy = b->y - a->y;
+    float dz = b->z - a->z;
+    float d = sqrtf(dx*dx + dy*dy + dz*dz);
+    if(d + b->w <= a->w)
+    {
+        *sphere_out = *a;
+    }
+    else if(d + a->w <= b->w)
+    {
+        *sphere_out = *b;
+    }
+    else
+    {
+        float r = (d + a->w + b->w) * 0.5f;
+        float s = (r - a->w) / d;
+        taa_vec4 c;
+        c.x = a->x + dx*s;
+        c.y = a->y + dy*s;
+        c.z = a->z + dz*s;
+        c.w = r;
+        *sphere_out = c;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_sphere_merge_array(
+    const taa_vec4* s,
+    uint32_t n,
+    taa_vec4* sphere_out)
+{
+    taa_vec4 acc;
+    uint32_t i;
+    acc.x = 0.0f;
+    acc.y = 0.0f;
+    acc.z = 0.0f;
+    acc.w = 0.0f;
+    if(n > 0)
+    {
+        // start from the largest sphere, which is most often the result
+        uint32_t largest = 0;
+        for(i = 1; i < n; ++i)
+        {
+            largest = (s[i].w > s[largest].w) ? i : largest;
+        }
+        acc = s[largest];
+        for(i = 0; i < n; ++i)
+        {
+            taa_sphere_merge(&acc, s + i, &acc);
+        }
+    }
+    *sphere_out = acc;
+}
+
+#endif // taa_SPHERE_H_
@@ -0,0 +1,560 @@
+/**
+ * @brief     structure of arrays vec3 and quaternion containers header
+ * @details   elements are stored in four lane taa_vec3x4 and taa_quatx4
+ *            blocks so that the contents can be handed directly to the
+ *            structure of arrays kernels a whole block at a time. Storage
+ *            is aligned on 64 byte boundaries and grows in multiples of 16
+ *            elements, so every group of four blocks starts a cache line.
+ *            Lanes beyond the size of the container are always zero.
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_STREAM_H_
+#define taa_STREAM_H_
+
+#include "quatx4.h"
+#include "vec3x4.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    /** alignment in bytes of stream storage */
+    taa_STREAM_ALIGN = 64,
+    /** number of elements capacity is rounded up to */
+    taa_STREAM_GRANULARITY = 16
+};
+
+typedef struct taa_vec3_stream_s taa_vec3_stream;
+typedef struct taa_quat_stream_s taa_quat_stream;
+
+struct taa_vec3_stream_s
+{
+    /** 64 byte aligned blocks, (capacity / 4) in length */
+    taa_vec3x4* blocks;
+    /** unaligned allocation containing the blocks */
+    void* buffer;
+    uint32_t size;
+    uint32_t capacity;
+};
+
+struct taa_quat_stream_s
+{
+    /** 64 byte aligned blocks, (capacity / 4) in length */
+    taa_quatx4* blocks;
+    /** unaligned allocation containing the blocks */
+    void* buffer;
+    uint32_t size;
+    uint32_t capacity;
+};
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief appends one vector to the end of the stream
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_vec3_stream_append(
+    taa_vec3_stream* s,
+    const taa_vec3* v);
+
+/**
+ * @brief removes all elements without releasing memory
+ */
+taa_INLINE static void taa_vec3_stream_clear(
+    taa_vec3_stream* s);
+
+/**
+ * @brief initializes an empty stream
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_vec3_stream_create(
+    uint32_t capacity,
+    taa_vec3_stream* s_out);
+
+/**
+ * @brief releases all memory owned by the stream
+ */
+taa_INLINE static void taa_vec3_stream_destroy(
+    taa_vec3_stream* s);
+
+/**
+ * @brief copies the contents of the stream into an array of packed vec3
+ * @details v_out must have room for s->size elements.
+ */
+taa_INLINE static void taa_vec3_stream_export(
+    const taa_vec3_stream* s,
+    taa_vec3* v_out);
+
+taa_INLINE static void taa_vec3_stream_get(
+    const taa_vec3_stream* s,
+    uint32_t i,
+    taa_vec3* v_out);
+
+/**
+ * @brief appends an array of packed vec3 to the end of the stream
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_vec3_stream_import(
+    taa_vec3_stream* s,
+    const taa_vec3* v,
+    uint32_t n);
+
+/**
+ * @brief returns the number of blocks that contain elements
+ */
+taa_INLINE static uint32_t taa_vec3_stream_num_blocks(
+    const taa_vec3_stream* s);
+
+/**
+ * @brief removes an element by moving the last element into its place
+ * @details this changes the index of the last element to i.
+ */
+taa_INLINE static void taa_vec3_stream_remove_swap(
+    taa_vec3_stream* s,
+    uint32_t i);
+
+/**
+ * @brief ensures the stream can hold at least capacity elements
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_vec3_stream_reserve(
+    taa_vec3_stream* s,
+    uint32_t capacity);
+
+taa_INLINE static void taa_vec3_stream_set(
+    taa_vec3_stream* s,
+    uint32_t i,
+    const taa_vec3* v);
+
+taa_INLINE static int taa_quat_stream_append(
+    taa_quat_stream* s,
+    const taa_quat* q);
+
+taa_INLINE static void taa_quat_stream_clear(
+    taa_quat_stream* s);
+
+taa_INLINE static int taa_quat_stream_create(
+    uint32_t capacity,
+    taa_quat_stream* s_out);
+
+taa_INLINE static void taa_quat_stream_destroy(
+    taa_quat_stream* s);
+
+/**
+ * @brief copies the contents of the stream into an array of quaternions
+ * @details q_out must have room for s->size elements.
+ */
+taa_INLINE static void taa_quat_stream_export(
+    const taa_quat_stream* s,
+    taa_quat* q_out);
+
+taa_INLINE static void taa_quat_stream_get(
+    const taa_quat_stream* s,
+    uint32_t i,
+    taa_quat* q_out);
+
+taa_INLINE static int taa_quat_stream_import(
+    taa_quat_stream* s,
+    const taa_quat* q,
+    uint32_t n);
+
+taa_INLINE static uint32_t taa_quat_stream_num_blocks(
+    const taa_quat_stream* s);
+
+taa_INLINE static void taa_quat_stream_remove_swap(
+    taa_quat_stream* s,
+    uint32_t i);
+
+taa_INLINE static int taa_quat_stream_reserve(
+    taa_quat_stream* s,
+    uint32_t capacity);
+
+taa_INLINE static void taa_quat_stream_set(
+    taa_quat_stream* s,
+    uint32_t i,
+    const taa_quat* q);
+
+/**
+ * @brief grows an aligned, zero filled allocation
+ * @details copies the first size bytes of the old allocation and zero fills
+ *          the remainder. On failure, the old allocation is left unmodified.
+ * @return 0 on success, -1 if memory could not be allocated
+ */
+taa_INLINE static int taa_stream_realloc(
+    void** buffer,
+    void** aligned,
+    size_t size,
+    size_t newsize);
+
+//****************************************************************************
+taa_INLINE static int taa_vec3_stream_append(
+    taa_vec3_stream* s,
+    const taa_vec3* v)
+{
+    int err = 0;
+    if(s->size == s->capacity)
+    {
+        err = taa_vec3_stream_reserve(
+            s,
+            (s->capacity != 0) ? s->capacity * 2 : taa_STREAM_GRANULARITY);
+    }
+    if(err == 0)
+    {
+        taa_vec3_stream_set(s, s->size, v);
+        ++s->size;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_clear(
+    taa_vec3_stream* s)
+{
+    if(s->size != 0)
+    {
+        memset(s->blocks, 0, ((s->size + 3)/4) * sizeof(*s->blocks));
+        s->size = 0;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static int taa_vec3_stream_create(
+    uint32_t capacity,
+    taa_vec3_stream* s_out)
+{
+    memset(s_out, 0, sizeof(*s_out));
+    return taa_vec3_stream_reserve(s_out, capacity);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_destroy(
+    taa_vec3_stream* s)
+{
+    free(s->buffer);
+    memset(s, 0, sizeof(*s));
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_export(
+    const taa_vec3_stream* s,
+    taa_vec3* v_out)
+{
+    taa_vec3x4_to_vec3(s->blocks, s->size, v_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_get(
+    const taa_vec3_stream* s,
+    uint32_t i,
+    taa_vec3* v_out)
+{
+    const taa_vec3x4* b = s->blocks + (i >> 2);
+    assert(i < s->size);
+    i &= 3;
+    v_out->x = b->x[i];
+    v_out->y = b->y[i];
+    v_out->z = b->z[i];
+}
+
+//****************************************************************************
+taa_INLINE static int taa_vec3_stream_import(
+    taa_vec3_stream* s,
+    const taa_vec3* v,
+    uint32_t n)
+{
+    int err = 0;
+    if(s->size + n > s->capacity)
+    {
+        uint32_t capacity = s->capacity * 2;
+        err = taa_vec3_stream_reserve(
+            s,
+            (capacity > s->size + n) ? capacity : s->size + n);
+    }
+    if(err == 0)
+    {
+        // fill the partial last block one lane at a time
+        while((s->size & 3) != 0 && n > 0)
+        {
+            taa_vec3_stream_set(s, s->size, v);
+            ++s->size;
+            ++v;
+            --n;
+        }
+        // convert the remainder directly into whole blocks
+        taa_vec3x4_from_vec3(v, n, s->blocks + (s->size >> 2));
+        s->size += n;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_vec3_stream_num_blocks(
+    const taa_vec3_stream* s)
+{
+    return (s->size + 3) >> 2;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_remove_swap(
+    taa_vec3_stream* s,
+    uint32_t i)
+{
+    uint32_t last = s->size - 1;
+    taa_vec3x4* b = s->blocks + (last >> 2);
+    assert(i < s->size);
+    if(i != last)
+    {
+        taa_vec3 v;
+        taa_vec3_stream_get(s, last, &v);
+        taa_vec3_stream_set(s, i, &v);
+    }
+    last &= 3;
+    b->x[last] = 0.0f;
+    b->y[last] = 0.0f;
+    b->z[last] = 0.0f;
+    --s->size;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_vec3_stream_reserve(
+    taa_vec3_stream* s,
+    uint32_t capacity)
+{
+    int err = 0;
+    capacity += taa_STREAM_GRANULARITY - 1;
+    capacity &= ~(taa_STREAM_GRANULARITY - 1);
+    if(capacity > s->capacity)
+    {
+        void* aligned = s->blocks;
+        err = taa_stream_realloc(
+            &s->buffer,
+            &aligned,
+            (s->capacity/4) * sizeof(*s->blocks),
+            (capacity/4) * sizeof(*s->blocks));
+        if(err == 0)
+        {
+            s->blocks = (taa_vec3x4*) aligned;
+            s->capacity = capacity;
+        }
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_stream_set(
+    taa_vec3_stream* s,
+    uint32_t i,
+    const taa_vec3* v)
+{
+    taa_vec3x4* b = s->blocks + (i >> 2);
+    assert(i < s->capacity);
+    i &= 3;
+    b->x[i] = v->x;
+    b->y[i] = v->y;
+    b->z[i] = v->z;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_quat_stream_append(
+    taa_quat_stream* s,
+    const taa_quat* q)
+{
+    int err = 0;
+    if(s->size == s->capacity)
+    {
+        err = taa_quat_stream_reserve(
+            s,
+            (s->capacity != 0) ? s->capacity * 2 : taa_STREAM_GRANULARITY);
+    }
+    if(err == 0)
+    {
+        taa_quat_stream_set(s, s->size, q);
+        ++s->size;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_clear(
+    taa_quat_stream* s)
+{
+    if(s->size != 0)
+    {
+        memset(s->blocks, 0, ((s->size + 3)/4) * sizeof(*s->blocks));
+        s->size = 0;
+    }
+}
+
+//****************************************************************************
+taa_INLINE static int taa_quat_stream_create(
+    uint32_t capacity,
+    taa_quat_stream* s_out)
+{
+    memset(s_out, 0, sizeof(*s_out));
+    return taa_quat_stream_reserve(s_out, capacity);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_destroy(
+    taa_quat_stream* s)
+{
+    free(s->buffer);
+    memset(s, 0, sizeof(*s));
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_export(
+    const taa_quat_stream* s,
+    taa_quat* q_out)
+{
+    taa_quatx4_to_quat(s->blocks, s->size, q_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_get(
+    const taa_quat_stream* s,
+    uint32_t i,
+    taa_quat* q_out)
+{
+    const taa_quatx4* b = s->blocks + (i >> 2);
+    assert(i < s->size);
+    i &= 3;
+    q_out->x = b->x[i];
+    q_out->y = b->y[i];
+    q_out->z = b->z[i];
+    q_out->w = b->w[i];
+}
+
+//****************************************************************************
+taa_INLINE static int taa_quat_stream_import(
+    taa_quat_stream* s,
+    const taa_quat* q,
+    uint32_t n)
+{
+    int err = 0;
+    if(s->size + n > s->capacity)
+    {
+        uint32_t capacity = s->capacity * 2;
+        err = taa_quat_stream_reserve(
+            s,
+            (capacity > s->size + n) ? capacity : s->size + n);
+    }
+    if(err == 0)
+    {
+        // fill the partial last block one lane at a time
+        while((s->size & 3) != 0 && n > 0)
+        {
+            taa_quat_stream_set(s, s->size, q);
+            ++s->size;
+            ++q;
+            --n;
+        }
+        // convert the remainder directly into whole blocks
+        taa_quatx4_from_quat(q, n, s->blocks + (s->size >> 2));
+        s->size += n;
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static uint32_t taa_quat_stream_num_blocks(
+    const taa_quat_stream* s)
+{
+    return (s->size + 3) >> 2;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_remove_swap(
+    taa_quat_stream* s,
+    uint32_t i)
+{
+    uint32_t last = s->size - 1;
+    taa_quatx4* b = s->blocks + (last >> 2);
+    assert(i < s->size);
+    if(i != last)
+    {
+        taa_quat q;
+        taa_quat_stream_get(s, last, &q);
+        taa_quat_stream_set(s, i, &q);
+    }
+    last &= 3;
+    b->x[last] = 0.0f;
+    b->y[last] = 0.0f;
+    b->z[last] = 0.0f;
+    b->w[last] = 0.0f;
+    --s->size;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_quat_stream_reserve(
+    taa_quat_stream* s,
+    uint32_t capacity)
+{
+    int err = 0;
+    capacity += taa_STREAM_GRANULARITY - 1;
+    capacity &= ~(taa_STREAM_GRANULARITY - 1);
+    if(capacity > s->capacity)
+    {
+        void* aligned = s->blocks;
+        err = taa_stream_realloc(
+            &s->buffer,
+            &aligned,
+            (s->capacity/4) * sizeof(*s->blocks),
+            (capacity/4) * sizeof(*s->blocks));
+        if(err == 0)
+        {
+            s->blocks = (taa_quatx4*) aligned;
+            s->capacity = capacity;
+        }
+    }
+    return err;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_quat_stream_set(
+    taa_quat_stream* s,
+    uint32_t i,
+    const taa_quat* q)
+{
+    taa_quatx4* b = s->blocks + (i >> 2);
+    assert(i < s->capacity);
+    i &= 3;
+    b->x[i] = q->x;
+    b->y[i] = q->y;
+    b->z[i] = q->z;
+    b->w[i] = q->w;
+}
+
+//****************************************************************************
+taa_INLINE static int taa_stream_realloc(
+    void** buffer,
+    void** aligned,
+    size_t size,
+    size_t newsize)
+{
+    int err = -1;
+    void* newbuffer = malloc(newsize + taa_STREAM_ALIGN - 1);
+    if(newbuffer != NULL)
+    {
+        size_t addr = (size_t) newbuffer;
+        void* newaligned;
+        addr += taa_STREAM_ALIGN - 1;
+        addr &= ~((size_t) (taa_STREAM_ALIGN - 1));
+        newaligned = (void*) addr;
+        if(size > 0)
+        {
+            memcpy(newaligned, *aligned, size);
+        }
+        memset(((char*) newaligned) + size, 0, newsize - size);
+        free(*buffer);
+        *buffer = newbuffer;
+        *aligned = newaligned;
+        err = 0;
+    }
+    return err;
+}
+
+#endif // taa_STREAM_H_
@@ -8,9 +8,35 @@
 #define taa_VEC3_H_
 
 #include "mathdefs.h"
+#include "vpu.h"
 #include <assert.h>
 #include <float.h>
 
+/**
+ * @brief number of floats that must be readable past the end of a packed
+ *        vec3 array passed to the bulk _array functions
+ * @details the bulk functions fetch each vector with a single unaligned 16
+ *          byte load and discard the w lane, so the last vector reads one
+ *          float beyond the end of the array. Only the inputs need padding;
+ *          outputs are written with 12 byte stores.
+ */
+enum
+{
+    taa_VEC3_ARRAY_PADDING = 1
+};
+
+//****************************************************************************
+// constants
+
+static const taa_DECLSPEC_ALIGN(16) union
+{
+    uint32_t u32[4];
+    float    f32[4];
+} taa_ATTRIB_ALIGN(16) s_taa_vec3_xyzmask =
+{
+    { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000 }
+};
+
 //****************************************************************************
 // forward declarations
 
@@ -24,6 +50,17 @@ taa_INLINE static void taa_vec3_cross(
     const taa_vec3* b,
     taa_vec3* v_out);
 
+/**
+ * @brief computes the cross products of n pairs of vectors
+ * @details a and b must be padded by taa_VEC3_ARRAY_PADDING. v_out may be the
+ *          same array as a or b.
+ */
+taa_INLINE static void taa_vec3_cross_array(
+    const taa_vec3* a,
+    const taa_vec3* b,
+    uint32_t n,
+    taa_vec3* v_out);
+
 taa_INLINE static void taa_vec3_divide(
     const taa_vec3* a,
     const taa_vec3* b,
@@ -33,6 +70,16 @@ taa_INLINE static float taa_vec3_dot(
     const taa_vec3* a,
     const taa_vec3* b);
 
+/**
+ * @brief computes the dot products of n pairs of vectors
+ * @details a and b must be padded by taa_VEC3_ARRAY_PADDING.
+ */
+taa_INLINE static void taa_vec3_dot_array(
+    const taa_vec3* a,
+    const taa_vec3* b,
+    uint32_t n,
+    float* d_out);
+
 taa_INLINE static void taa_vec3_from_mat33_scale(
     const taa_mat33* a,
     taa_vec3* v_out);
@@ -59,6 +106,16 @@ taa_INLINE static void taa_vec3_normalize(
     const taa_vec3* a,
     taa_vec3* v_out);
 
+/**
+ * @brief normalizes n vectors
+ * @details a must be padded by taa_VEC3_ARRAY_PADDING. v_out may be the same
+ *          array as a.
+ */
+taa_INLINE static void taa_vec3_normalize_array(
+    const taa_vec3* a,
+    uint32_t n,
+    taa_vec3* v_out);
+
 taa_INLINE static void taa_vec3_scale(
     const taa_vec3* a,
     float x,
@@ -92,11 +149,40 @@ taa_INLINE static void taa_vec3_cross(
     const taa_vec3* b,
     taa_vec3* v_out)
 {
+    taa_vpu_vec4 va;
+    taa_vpu_vec4 vb;
+    taa_vpu_vec4 r;
     assert(a != v_out);
     assert(b != v_out);
-    v_out->x = a->y*b->z-a->z*b->y;
-    v_out->y = a->z*b->x-a->x*b->z;
-    v_out->z = a->x*b->y-a->y*b->x;
+    taa_vpu_load3(&a->x, va);
+    taa_vpu_load3(&b->x, vb);
+    taa_vpu_cross3(va, vb, r);
+    taa_vpu_store3(r, &v_out->x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_cross_array(
+    const taa_vec3* a,
+    const taa_vec3* b,
+    uint32_t n,
+    taa_vec3* v_out)
+{
+    const taa_vec3* aend = a + n;
+    while(a != aend)
+    {
+        // the w lanes hold the x of the next vector, but the cross product
+        // never mixes them into x, y or z
+        taa_vpu_vec4 va;
+        taa_vpu_vec4 vb;
+        taa_vpu_vec4 r;
+        taa_vpu_loadu(&a->x, va);
+        taa_vpu_loadu(&b->x, vb);
+        taa_vpu_cross3(va, vb, r);
+        taa_vpu_store3(r, &v_out->x);
+        ++a;
+        ++b;
+        ++v_out;
+    }
 }
 
 //****************************************************************************
@@ -115,7 +201,44 @@ taa_INLINE static float taa_vec3_dot(
     const taa_vec3* a,
     const taa_vec3* b)
 {
-    return a->x*b->x + a->y*b->y + a->z*b->z;
+    float dp;
+    taa_vpu_vec4 va;
+    taa_vpu_vec4 vb;
+    taa_vpu_vec4 r;
+    taa_vpu_load3(&a->x, va);
+    taa_vpu_load3(&b->x, vb);
+    taa_vpu_dot(va, vb, r);
+    taa_vpu_store1(r, &dp);
+    return dp;
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_dot_array(
+    const taa_vec3* a,
+    const taa_vec3* b,
+    uint32_t n,
+    float* d_out)
+{
+    const taa_vec3* aend = a + n;
+    taa_vpu_vec4 mask;
+    taa_vpu_load(s_taa_vec3_xyzmask.f32, mask);
+    while(a != aend)
+    {
+        // both w lanes are cleared, since a non finite value in either would
+        // poison the sum
+        taa_vpu_vec4 va;
+        taa_vpu_vec4 vb;
+        taa_vpu_vec4 r;
+        taa_vpu_loadu(&a->x, va);
+        taa_vpu_loadu(&b->x, vb);
+        taa_vpu_and(va, mask, va);
+        taa_vpu_and(vb, mask, vb);
+        taa_vpu_dot(va, vb, r);
+        taa_vpu_store1(r, d_out);
+        ++a;
+        ++b;
+        ++d_out;
+    }
 }
 
 //****************************************************************************
@@ -173,7 +296,33 @@ taa_INLINE static void taa_vec3_normalize(
     const taa_vec3* a,
     taa_vec3* v_out)
 {
-    taa_vec3_scale(a, 1.0f/(taa_vec3_length(a) + FLT_MIN), v_out);
+    taa_vpu_vec4 va;
+    taa_vpu_vec4 r;
+    taa_vpu_load3(&a->x, va);
+    taa_vpu_normalize(va, r);
+    taa_vpu_store3(r, &v_out->x);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3_normalize_array(
+    const taa_vec3* a,
+    uint32_t n,
+    taa_vec3* v_out)
+{
+    const taa_vec3* aend = a + n;
+    taa_vpu_vec4 mask;
+    taa_vpu_load(s_taa_vec3_xyzmask.f32, mask);
+    while(a != aend)
+    {
+        taa_vpu_vec4 va;
+        taa_vpu_vec4 r;
+        taa_vpu_loadu(&a->x, va);
+        taa_vpu_and(va, mask, va);
+        taa_vpu_normalize(va, r);
+        taa_vpu_store3(r, &v_out->x);
+        ++a;
+        ++v_out;
+    }
 }
 
 //****************************************************************************
@@ -0,0 +1,170 @@
+/**
+ * @brief     inlined structure of arrays 3 dimensional vector functions header
+ * @author    Thomas Atwood (tatwood.net)
+ * @date      2012
+ * @copyright unlicense / public domain
+ ****************************************************************************/
+#ifndef taa_VEC3X4_H_
+#define taa_VEC3X4_H_
+
+#include "mathdefs.h"
+#include "vpu.h"
+#include <assert.h>
+
+//****************************************************************************
+// forward declarations
+
+/**
+ * @brief converts an array of packed vec3 into structure of arrays format
+ * @details v_out must have room for (n + 3)/4 elements. Unused lanes of the
+ *          last element are set to zero.
+ */
+taa_INLINE static void taa_vec3x4_from_vec3(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec3x4* v_out);
+
+/**
+ * @brief converts an array of packed vec3 into structure of arrays format
+ * @details identical to taa_vec3x4_from_vec3, but the results are written
+ *          with non-temporal stores that bypass the cache. Use this for
+ *          arrays that are much larger than the cache.
+ */
+taa_INLINE static void taa_vec3x4_from_vec3_stream(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec3x4* v_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of packed vec3
+ * @details a must contain (n + 3)/4 elements.
+ */
+taa_INLINE static void taa_vec3x4_to_vec3(
+    const taa_vec3x4* a,
+    uint32_t n,
+    taa_vec3* v_out);
+
+/**
+ * @brief converts structure of arrays data back into an array of packed vec3
+ * @details identical to taa_vec3x4_to_vec3, but the results are written
+ *          with non-temporal stores that bypass the cache. v_out must be
+ *          aligned on a 16 byte boundary.
+ */
+taa_INLINE static void taa_vec3x4_to_vec3_stream(
+    const taa_vec3x4* a,
+    uint32_t n,
+    taa_vec3* v_out);
+
+//****************************************************************************
+taa_INLINE static void taa_vec3x4_from_vec3(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec3x4* v_out)
+{
+    const taa_vec3* vend = v + (n & ~3);
+    uint32_t i;
+    assert((((size_t) v_out) & 15) == 0);
+    while(v != vend)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_load3x4(&v->x, x, y, z);
+        taa_vpu_store(x, v_out->x);
+        taa_vpu_store(y, v_out->y);
+        taa_vpu_store(z, v_out->z);
+        v += 4;
+        ++v_out;
+    }
+    n &= 3;
+    if(n != 0)
+    {
+        for(i = 0; i < 4; ++i)
+        {
+            v_out->x[i] = (i < n) ? v[i].x : 0.0f;
+            v_out->y[i] = (i < n) ? v[i].y : 0.0f;
+            v_out->z[i] = (i < n) ? v[i].z : 0.0f;
+        }
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3x4_from_vec3_stream(
+    const taa_vec3* v,
+    uint32_t n,
+    taa_vec3x4* v_out)
+{
+    const taa_vec3* vend = v + (n & ~3);
+    assert((((size_t) v_out) & 15) == 0);
+    while(v != vend)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_load3x4(&v->x, x, y, z);
+        taa_vpu_stream(x, v_out->x);
+        taa_vpu_stream(y, v_out->y);
+        taa_vpu_stream(z, v_out->z);
+        v += 4;
+        ++v_out;
+    }
+    taa_vpu_stream_fence();
+    taa_vec3x4_from_vec3(v, n & 3, v_out);
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3x4_to_vec3(
+    const taa_vec3x4* a,
+    uint32_t n,
+    taa_vec3* v_out)
+{
+    const taa_vec3* vend = v_out + (n & ~3);
+    uint32_t i;
+    assert((((size_t) a) & 15) == 0);
+    while(v_out != vend)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_load(a->x, x);
+        taa_vpu_load(a->y, y);
+        taa_vpu_load(a->z, z);
+        taa_vpu_store3x4(x, y, z, &v_out->x);
+        ++a;
+        v_out += 4;
+    }
+    n &= 3;
+    for(i = 0; i < n; ++i)
+    {
+        v_out[i].x = a->x[i];
+        v_out[i].y = a->y[i];
+        v_out[i].z = a->z[i];
+    }
+}
+
+//****************************************************************************
+taa_INLINE static void taa_vec3x4_to_vec3_stream(
+    const taa_vec3x4* a,
+    uint32_t n,
+    taa_vec3* v_out)
+{
+    const taa_vec3* vend = v_out + (n & ~3);
+    assert((((size_t) a) & 15) == 0);
+    assert((((size_t) v_out) & 15) == 0);
+    while(v_out != vend)
+    {
+        taa_vpu_vec4 x;
+        taa_vpu_vec4 y;
+        taa_vpu_vec4 z;
+        taa_vpu_load(a->x, x);
+        taa_vpu_load(a->y, y);
+        taa_vpu_load(a->z, z);
+        taa_vpu_stream3x4(x, y, z, &v_out->x);
+        ++a;
+        v_out += 4;
+    }
+    taa_vpu_stream_fence();
+    taa_vec3x4_to_vec3(a, n & 3, v_out);
+}
+
+#endif // taa_VEC3X4_H_
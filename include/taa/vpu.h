@@ -38,6 +38,9 @@
 #define taa_vpu_mat34_mul_vec4(c0_, c1_, c2_, v_, out_) \
     taa_vpu_mat34_mul_vec4_target(c0_, c1_, c2_, v_, out_)
 
+/**
+ * @brief computes the absolute value of each element of a 4x4 matrix
+ */
 #define taa_vpu_mat44_abs( \
         c0_, c1_, c2_, c3_,  \
         c0_out_, c1_out_, c2_out_, c3_out_) \
@@ -45,6 +48,38 @@
         c0_,c1_,c2_,c3_, \
         c0_out_,c1_out_,c2_out_,c3_out_)
 
+/**
+ * @brief calculates the determinant of a 4x4 matrix
+ * @details the determinant is written to all four components of out
+ * @params c0 taa_vpu_vec4 in, first column
+ * @params c1 taa_vpu_vec4 in, second column
+ * @params c2 taa_vpu_vec4 in, third column
+ * @params c3 taa_vpu_vec4 in, fourth column
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_mat44_determinant(c0_, c1_, c2_, c3_, out_) \
+    taa_vpu_mat44_determinant_target(c0_, c1_, c2_, c3_, out_)
+
+/**
+ * @brief calculates the inverse of a 4x4 matrix
+ * @details the inverse is built from the 2x2 sub-determinants of the
+ *          matrix, which also produce the determinant. The determinant is
+ *          written to all four components of det_out so the caller may
+ *          test for a singular matrix; if it is zero the inverse is not
+ *          finite.
+ * @params c0 - c3 taa_vpu_vec4 in, columns of the matrix
+ * @params c0_out - c3_out taa_vpu_vec4 out, columns of the inverse
+ * @params det_out taa_vpu_vec4 out, determinant
+ */
+#define taa_vpu_mat44_inverse( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_) \
+    taa_vpu_mat44_inverse_target( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_)
+
 #define taa_vpu_mat44_mul_vec4(c0_, c1_, c2_, c3_, v_, out_) \
     taa_vpu_mat44_mul_vec4_target(c0_, c1_, c2_, c3_, v_, out_)
 
@@ -151,6 +186,58 @@
 #define taa_vpu_load(pa_, out_) \
     taa_vpu_load_target(pa_, out_)
 
+/**
+ * @brief loads a 3 component vector into a vpu register
+ * @details reads exactly 12 bytes, so it is safe at the end of a buffer or
+ *          page. pa does not need to be aligned.
+ *          out.x = pa[0];
+ *          out.y = pa[1];
+ *          out.z = pa[2];
+ *          out.w = 0;
+ * @params pa const float* in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_load3(pa_, out_) \
+    taa_vpu_load3_target(pa_, out_)
+
+/**
+ * @brief loads four packed 3 component vectors and deinterleaves them
+ * @details pa does not need to be aligned.
+ *          out_x = { pa[0], pa[3], pa[6], pa[ 9] };
+ *          out_y = { pa[1], pa[4], pa[7], pa[10] };
+ *          out_z = { pa[2], pa[5], pa[8], pa[11] };
+ * @params pa const float* in
+ * @params x_out taa_vpu_vec4 out
+ * @params y_out taa_vpu_vec4 out
+ * @params z_out taa_vpu_vec4 out
+ */
+#define taa_vpu_load3x4(pa_, x_out_, y_out_, z_out_) \
+    taa_vpu_load3x4_target(pa_, x_out_, y_out_, z_out_)
+
+/**
+ * @brief loads four 4 component vectors and deinterleaves them
+ * @details pa must be aligned on a 16 byte boundary.
+ *          out_x = { pa[0], pa[4], pa[ 8], pa[12] };
+ *          out_y = { pa[1], pa[5], pa[ 9], pa[13] };
+ *          out_z = { pa[2], pa[6], pa[10], pa[14] };
+ *          out_w = { pa[3], pa[7], pa[11], pa[15] };
+ * @params pa const float* in
+ * @params x_out taa_vpu_vec4 out
+ * @params y_out taa_vpu_vec4 out
+ * @params z_out taa_vpu_vec4 out
+ * @params w_out taa_vpu_vec4 out
+ */
+#define taa_vpu_load4x4(pa_, x_out_, y_out_, z_out_, w_out_) \
+    taa_vpu_load4x4_target(pa_, x_out_, y_out_, z_out_, w_out_)
+
+/**
+ * @brief loads unaligned memory address into vpu register
+ * @params pa const float* in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_loadu(pa_, out_) \
+    taa_vpu_loadu_target(pa_, out_)
+
 #define taa_vpu_max(a_, b_, out_) \
     taa_vpu_max_target(a_, b_, out_)
 
@@ -160,6 +247,18 @@
 #define taa_vpu_mov(a_, out_) \
     taa_vpu_mov_target(a_, out_)
 
+/**
+ * @brief gathers the sign bit of each component into an integer
+ * @details applied to the result of a comparison, bit i of out is set if the
+ *          comparison was true for component i.
+ *          out = (sign(a.x) << 0) | (sign(a.y) << 1) |
+ *                (sign(a.z) << 2) | (sign(a.w) << 3)
+ * @params a taa_vpu_vec4 in
+ * @params out int out
+ */
+#define taa_vpu_movemask(a_, out_) \
+    taa_vpu_movemask_target(a_, out_)
+
 #define taa_vpu_mul(a_, b_, out_) \
     taa_vpu_mul_target(a_, b_, out_)
 
@@ -203,12 +302,56 @@
 #define taa_vpu_or(a_, b_, out_) \
     taa_vpu_or_target(a_, b_, out_)
 
+/**
+ * @brief quaternion product
+ * @details out = a * b, rotating by b and then by a. The components are
+ *          stored x, y, z, w with w as the scalar part. out may be the same
+ *          register as a or b.
+ *          out.x = a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y;
+ *          out.y = a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x;
+ *          out.z = a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w;
+ *          out.w = a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z;
+ * @params a taa_vpu_vec4 in
+ * @params b taa_vpu_vec4 in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_quat_mul(a_, b_, out_) \
+    taa_vpu_quat_mul_target(a_, b_, out_)
+
+/**
+ * @brief rotates a vector by a unit quaternion
+ * @details out.xyz = v + 2*cross(q.xyz, cross(q.xyz, v) + q.w*v)
+ *          out.w = v.w
+ *          out may be the same register as q or v.
+ * @params q taa_vpu_vec4 in
+ * @params v taa_vpu_vec4 in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_quat_rotate(q_, v_, out_) \
+    taa_vpu_quat_rotate_target(q_, v_, out_)
+
 /**
  * @details reciprocal square root
  */
 #define taa_vpu_rsqrt(a_, out_) \
     taa_vpu_rsqrt_target(a_, out_)
 
+/**
+ * @brief selects between two vectors using a comparison mask
+ * @details each mask lane must be all zeroes or all ones, as produced by the
+ *          comparison macros. out may be the same register as any input.
+ *          out.x = mask.x ? b.x : a.x;
+ *          out.y = mask.y ? b.y : a.y;
+ *          out.z = mask.z ? b.z : a.z;
+ *          out.w = mask.w ? b.w : a.w;
+ * @params a taa_vpu_vec4 in
+ * @params b taa_vpu_vec4 in
+ * @params mask taa_vpu_vec4 in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_select(a_, b_, mask_, out_) \
+    taa_vpu_select_target(a_, b_, mask_, out_)
+
 #define taa_vpu_set(x_, y_, z_, w_, out_) \
     taa_vpu_set_target(x_, y_, z_, w_, out_)
 
@@ -255,6 +398,19 @@
 #define taa_vpu_shuf_ax_ay_az_bx(a_, b_, out_) \
     taa_vpu_shuf_ax_ay_az_bx_target(a_, b_, out_)
 
+/**
+ * @brief compute square root
+ * @details
+ *          out.x = sqrt(a.x);
+ *          out.y = sqrt(a.y);
+ *          out.z = sqrt(a.z);
+ *          out.w = sqrt(a.w);
+ * @params a taa_vpu_vec4 in
+ * @params out taa_vpu_vec4 out
+ */
+#define taa_vpu_sqrt(a_, out_) \
+    taa_vpu_sqrt_target(a_, out_)
+
 /**
  * @brief stores vpu register into memory address
  * @details
@@ -278,6 +434,83 @@
 #define taa_vpu_store1(a_, out_) \
     taa_vpu_store1_target(a_, out_)
 
+/**
+ * @brief stores the x, y and z components of a vpu register
+ * @details writes exactly 12 bytes; out[3] is not modified. out does not
+ *          need to be aligned.
+ *          out[0] = a.x;
+ *          out[1] = a.y;
+ *          out[2] = a.z;
+ * @params a taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_store3(a_, out_) \
+    taa_vpu_store3_target(a_, out_)
+
+/**
+ * @brief interleaves four 3 component vectors and stores them packed
+ * @details out does not need to be aligned.
+ *          out = { x.x,y.x,z.x, x.y,y.y,z.y, x.z,y.z,z.z, x.w,y.w,z.w };
+ * @params x taa_vpu_vec4 in
+ * @params y taa_vpu_vec4 in
+ * @params z taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_store3x4(x_, y_, z_, out_) \
+    taa_vpu_store3x4_target(x_, y_, z_, out_)
+
+/**
+ * @brief interleaves four 4 component vectors and stores them
+ * @details out must be aligned on a 16 byte boundary. This is the inverse
+ *          of taa_vpu_load4x4.
+ * @params x taa_vpu_vec4 in
+ * @params y taa_vpu_vec4 in
+ * @params z taa_vpu_vec4 in
+ * @params w taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_store4x4(x_, y_, z_, w_, out_) \
+    taa_vpu_store4x4_target(x_, y_, z_, w_, out_)
+
+/**
+ * @brief stores vpu register into unaligned memory address
+ * @params a taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_storeu(a_, out_) \
+    taa_vpu_storeu_target(a_, out_)
+
+/**
+ * @brief stores vpu register into memory address, bypassing the cache
+ * @details out must be aligned on a 16 byte boundary. Use for large outputs
+ *          that will not be read again soon. A series of stream stores must
+ *          be followed by taa_vpu_stream_fence before the data is consumed
+ *          by another thread.
+ * @params a taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_stream(a_, out_) \
+    taa_vpu_stream_target(a_, out_)
+
+/**
+ * @brief interleaves four 3 component vectors and stores them packed,
+ *        bypassing the cache
+ * @details out must be aligned on a 16 byte boundary. The layout is the
+ *          same as taa_vpu_store3x4.
+ * @params x taa_vpu_vec4 in
+ * @params y taa_vpu_vec4 in
+ * @params z taa_vpu_vec4 in
+ * @params out float* out
+ */
+#define taa_vpu_stream3x4(x_, y_, z_, out_) \
+    taa_vpu_stream3x4_target(x_, y_, z_, out_)
+
+/**
+ * @brief orders all previous stream stores before any subsequent stores
+ */
+#define taa_vpu_stream_fence() \
+    taa_vpu_stream_fence_target()
+
 #define taa_vpu_sub(a_, b_, out_) \
     taa_vpu_sub_target(a_, b_, out_)
 
@@ -27,6 +27,18 @@
         c0_, c1_, c2_, c3_,  \
         c0_out_, c1_out_, c2_out_, c3_out_)
 
+#define taa_vpu_mat44_determinant_target(c0_, c1_, c2_, c3_, out_) \
+    taa_fpu_mat44_determinant(c0_, c1_, c2_, c3_, out_)
+
+#define taa_vpu_mat44_inverse_target( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_) \
+    taa_fpu_mat44_inverse( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_)
+
 #define taa_vpu_mat44_mul_vec4_target(c0_, c1_, c2_, c3_, v_, out_) \
     taa_fpu_mat44_mul_vec4(c0_, c1_, c2_, c3_, v_, out_)
 
@@ -64,6 +76,18 @@
 #define taa_vpu_load_target(pa_, out_) \
     taa_fpu_load(pa_, out_)
 
+#define taa_vpu_load3_target(pa_, out_) \
+    taa_fpu_load3(pa_, out_)
+
+#define taa_vpu_load3x4_target(pa_, x_out_, y_out_, z_out_) \
+    taa_fpu_load3x4(pa_, x_out_, y_out_, z_out_)
+
+#define taa_vpu_load4x4_target(pa_, x_out_, y_out_, z_out_, w_out_) \
+    taa_fpu_load4x4(pa_, x_out_, y_out_, z_out_, w_out_)
+
+#define taa_vpu_loadu_target(pa_, out_) \
+    taa_fpu_loadu(pa_, out_)
+
 #define taa_vpu_max_target(a_, b_, out_) \
     taa_fpu_max(a_, b_, out_)
 
@@ -73,6 +97,9 @@
 #define taa_vpu_mov_target(a_, out_) \
     taa_fpu_mov(a_, out_)
 
+#define taa_vpu_movemask_target(a_, out_) \
+    taa_fpu_movemask(a_, out_)
+
 #define taa_vpu_mul_target(a_, b_, out_) \
     taa_fpu_mul(a_, b_, out_)
 
@@ -85,9 +112,18 @@
 #define taa_vpu_or_target(a_, b_, out_) \
     taa_fpu_or(a_, b_, out_)
 
+#define taa_vpu_quat_mul_target(a_, b_, out_) \
+    taa_fpu_quat_mul(a_, b_, out_)
+
+#define taa_vpu_quat_rotate_target(q_, v_, out_) \
+    taa_fpu_quat_rotate(q_, v_, out_)
+
 #define taa_vpu_rsqrt_target(a_, out_) \
     taa_fpu_rsqrt(a_, out_)
 
+#define taa_vpu_select_target(a_, b_, mask_, out_) \
+    taa_fpu_select(a_, b_, mask_, out_)
+
 #define taa_vpu_set_target(x_, y_, z_, w_, out_) \
     taa_fpu_set(x_, y_, z_, w_, out_)
 
@@ -100,12 +136,36 @@
 #define taa_vpu_shuf_aw_bx_cw_dx_target(a_, b_, c_, d_, out_) \
     taa_fpu_shuf_aw_bx_cw_dx(a_, b_, c_, d_, out_)
 
+#define taa_vpu_sqrt_target(a_, out_) \
+    taa_fpu_sqrt(a_, out_)
+
 #define taa_vpu_store_target(a_, out_) \
     taa_fpu_store(a_, out_)
 
 #define taa_vpu_store1_target(a_, out_) \
     taa_fpu_store1(a_, out_)
 
+#define taa_vpu_store3_target(a_, out_) \
+    taa_fpu_store3(a_, out_)
+
+#define taa_vpu_store3x4_target(x_, y_, z_, out_) \
+    taa_fpu_store3x4(x_, y_, z_, out_)
+
+#define taa_vpu_store4x4_target(x_, y_, z_, w_, out_) \
+    taa_fpu_store4x4(x_, y_, z_, w_, out_)
+
+#define taa_vpu_storeu_target(a_, out_) \
+    taa_fpu_storeu(a_, out_)
+
+#define taa_vpu_stream_target(a_, out_) \
+    taa_fpu_stream(a_, out_)
+
+#define taa_vpu_stream3x4_target(x_, y_, z_, out_) \
+    taa_fpu_stream3x4(x_, y_, z_, out_)
+
+#define taa_vpu_stream_fence_target() \
+    taa_fpu_stream_fence()
+
 #define taa_vpu_sub_target(a_, b_, out_) \
     taa_fpu_sub(a_, b_, out_)
 
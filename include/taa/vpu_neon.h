@@ -13,6 +13,176 @@
 
 #define taa_vpu_target float32x4_t
 
+static const float s_taa_neon_adjsign[4] = { 1.0f, -1.0f, -1.0f, 1.0f };
+
+//****************************************************************************
+/* helpers for the 4x4 inverse. each register holds a 2x2 block of the */
+/* transposed matrix as (m00, m01, m10, m11). */
+
+/* out = a * b */
+#define taa_neon_mat22_mul(a_, b_, out_) \
+    do { \
+        /* b03_.val[0] = b0,b3  b03_.val[1] = b1,b2 */ \
+        float32x2x2_t b03_ = vtrn_f32( \
+            vget_low_f32(b_), \
+            vget_high_f32(vrev64q_f32(b_))); \
+        float32x2_t b21_ = vrev64_f32(b03_.val[1]); \
+        (out_) = vmlaq_f32( \
+            vmulq_f32(a_, vcombine_f32(b03_.val[0], b03_.val[0])), \
+            vrev64q_f32(a_), \
+            vcombine_f32(b21_, b21_)); \
+    } while(0)
+
+/* out = adj(a) * b */
+#define taa_neon_mat22_adjmul(a_, b_, out_) \
+    do { \
+        float32x2_t lo_ = vget_low_f32(a_); \
+        float32x2_t hi_ = vget_high_f32(a_); \
+        (out_) = vmlsq_f32( \
+            vmulq_f32( \
+                vcombine_f32(vdup_lane_f32(hi_, 1), vdup_lane_f32(lo_, 0)), \
+                b_), \
+            vcombine_f32(vdup_lane_f32(lo_, 1), vdup_lane_f32(hi_, 0)), \
+            vextq_f32(b_, b_, 2)); \
+    } while(0)
+
+/* out = a * adj(b) */
+#define taa_neon_mat22_muladj(a_, b_, out_) \
+    do { \
+        /* b03_.val[0] = b0,b3  b03_.val[1] = b1,b2 */ \
+        float32x2x2_t b03_ = vtrn_f32( \
+            vget_low_f32(b_), \
+            vget_high_f32(vrev64q_f32(b_))); \
+        float32x2_t b30_ = vrev64_f32(b03_.val[0]); \
+        float32x2_t b21_ = vrev64_f32(b03_.val[1]); \
+        (out_) = vmlsq_f32( \
+            vmulq_f32(a_, vcombine_f32(b30_, b30_)), \
+            vrev64q_f32(a_), \
+            vcombine_f32(b21_, b21_)); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_mat44_determinant_target(c0_, c1_, c2_, c3_, out_) \
+    do { \
+        float32x4_t a_ = vcombine_f32(vget_low_f32(c0_), vget_low_f32(c1_));\
+        float32x4_t b_ = vcombine_f32(vget_high_f32(c0_),vget_high_f32(c1_));\
+        float32x4_t c_ = vcombine_f32(vget_low_f32(c2_), vget_low_f32(c3_));\
+        float32x4_t d_ = vcombine_f32(vget_high_f32(c2_),vget_high_f32(c3_));\
+        float32x4x2_t u_ = vuzpq_f32(c0_, c2_); \
+        float32x4x2_t v_ = vuzpq_f32(c1_, c3_); \
+        /* |A|, |B|, |C|, |D| */ \
+        float32x4_t det22_ = vmlsq_f32( \
+            vmulq_f32(u_.val[0], v_.val[1]), \
+            u_.val[1], \
+            v_.val[0]); \
+        float32x2_t lo_ = vget_low_f32(det22_); \
+        float32x2_t hi_ = vget_high_f32(det22_); \
+        float32x4_t ab_; \
+        float32x4_t dc_; \
+        float32x2x2_t dcz_; \
+        float32x4_t tr_; \
+        float32x2_t sum_; \
+        taa_neon_mat22_adjmul(a_, b_, ab_); \
+        taa_neon_mat22_adjmul(d_, c_, dc_); \
+        /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */ \
+        dcz_ = vzip_f32(vget_low_f32(dc_), vget_high_f32(dc_)); \
+        tr_ = vmulq_f32(ab_, vcombine_f32(dcz_.val[0], dcz_.val[1])); \
+        sum_ = vpadd_f32(vget_low_f32(tr_), vget_high_f32(tr_)); \
+        sum_ = vpadd_f32(sum_, sum_); \
+        sum_ = vsub_f32( \
+            vmla_f32( \
+                vmul_f32(vdup_lane_f32(lo_, 0), vdup_lane_f32(hi_, 1)), \
+                vdup_lane_f32(lo_, 1), \
+                vdup_lane_f32(hi_, 0)), \
+            sum_); \
+        (out_) = vcombine_f32(sum_, sum_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_mat44_inverse_target( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_) \
+    do { \
+        /* block inverse of the transposed matrix. see vpu_sse3.h */ \
+        float32x4_t a_ = vcombine_f32(vget_low_f32(c0_), vget_low_f32(c1_));\
+        float32x4_t b_ = vcombine_f32(vget_high_f32(c0_),vget_high_f32(c1_));\
+        float32x4_t c_ = vcombine_f32(vget_low_f32(c2_), vget_low_f32(c3_));\
+        float32x4_t d_ = vcombine_f32(vget_high_f32(c2_),vget_high_f32(c3_));\
+        float32x4x2_t u_ = vuzpq_f32(c0_, c2_); \
+        float32x4x2_t v_ = vuzpq_f32(c1_, c3_); \
+        /* |A|, |B|, |C|, |D| */ \
+        float32x4_t det22_ = vmlsq_f32( \
+            vmulq_f32(u_.val[0], v_.val[1]), \
+            u_.val[1], \
+            v_.val[0]); \
+        float32x4_t deta_ = vdupq_lane_f32(vget_low_f32(det22_), 0); \
+        float32x4_t detb_ = vdupq_lane_f32(vget_low_f32(det22_), 1); \
+        float32x4_t detc_ = vdupq_lane_f32(vget_high_f32(det22_), 0); \
+        float32x4_t detd_ = vdupq_lane_f32(vget_high_f32(det22_), 1); \
+        float32x4_t ab_; \
+        float32x4_t dc_; \
+        float32x4_t x_; \
+        float32x4_t y_; \
+        float32x4_t z_; \
+        float32x4_t w_; \
+        float32x2x2_t dcz_; \
+        float32x4_t tr_; \
+        float32x2_t sum_; \
+        float32x4_t det_; \
+        float32x4_t rdet_; \
+        float32x4x2_t xy_; \
+        float32x4x2_t zw_; \
+        taa_neon_mat22_adjmul(a_, b_, ab_); \
+        taa_neon_mat22_adjmul(d_, c_, dc_); \
+        /* adj(X) = |D|A - B adj(D)C */ \
+        taa_neon_mat22_mul(b_, dc_, x_); \
+        x_ = vsubq_f32(vmulq_f32(detd_, a_), x_); \
+        /* adj(W) = |A|D - C adj(A)B */ \
+        taa_neon_mat22_mul(c_, ab_, w_); \
+        w_ = vsubq_f32(vmulq_f32(deta_, d_), w_); \
+        /* adj(Y) = |B|C - D adj(adj(A)B) */ \
+        taa_neon_mat22_muladj(d_, ab_, y_); \
+        y_ = vsubq_f32(vmulq_f32(detb_, c_), y_); \
+        /* adj(Z) = |C|B - A adj(adj(D)C) */ \
+        taa_neon_mat22_muladj(a_, dc_, z_); \
+        z_ = vsubq_f32(vmulq_f32(detc_, b_), z_); \
+        /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */ \
+        dcz_ = vzip_f32(vget_low_f32(dc_), vget_high_f32(dc_)); \
+        tr_ = vmulq_f32(ab_, vcombine_f32(dcz_.val[0], dcz_.val[1])); \
+        sum_ = vpadd_f32(vget_low_f32(tr_), vget_high_f32(tr_)); \
+        sum_ = vpadd_f32(sum_, sum_); \
+        det_ = vmlaq_f32(vmulq_f32(deta_, detd_), detb_, detc_); \
+        det_ = vsubq_f32(det_, vcombine_f32(sum_, sum_)); \
+        rdet_ = vdivq_f32(vld1q_f32(s_taa_neon_adjsign), det_); \
+        x_ = vmulq_f32(x_, rdet_); \
+        y_ = vmulq_f32(y_, rdet_); \
+        z_ = vmulq_f32(z_, rdet_); \
+        w_ = vmulq_f32(w_, rdet_); \
+        /* undo the adjugates while interleaving the blocks into columns */ \
+        xy_ = vuzpq_f32(x_, y_); \
+        zw_ = vuzpq_f32(z_, w_); \
+        (c0_out_) = vrev64q_f32(xy_.val[1]); \
+        (c1_out_) = vrev64q_f32(xy_.val[0]); \
+        (c2_out_) = vrev64q_f32(zw_.val[1]); \
+        (c3_out_) = vrev64q_f32(zw_.val[0]); \
+        (det_out_) = det_; \
+    } while(0)
+
+/* signs for the shuffled b terms of the quaternion product */
+static const float s_taa_neon_quatsign[12] =
+{
+    1.0f, -1.0f,  1.0f, -1.0f, /* w,-z, y,-x */
+    1.0f,  1.0f, -1.0f, -1.0f, /* z, w,-x,-y */
+   -1.0f,  1.0f,  1.0f, -1.0f  /*-y, x, w,-z */
+};
+
+/* y, z, x, w */
+#define taa_neon_yzxw(a_) \
+    vcombine_f32( \
+        vget_low_f32(vextq_f32(a_, a_, 1)), \
+        vrev64_f32(vget_high_f32(vextq_f32(a_, a_, 1))))
+
 //****************************************************************************
 #define taa_vpu_mat44_mul_vec4_target(c0_, c1_, c2_, c3_, v_, out_) \
     ((out_) = vmulq_n_f32(      c0_, vgetq_lane_f32(v_, 0)); \
@@ -34,7 +204,7 @@
 
 //****************************************************************************
 #define taa_vpu_cmpagt_target(a_, b_, out_) \
-    ((out_) = (float32x4_t) vcagtq_f32 (a_, b_)
+    ((out_) = (float32x4_t) vcagtq_f32(a_, b_))
 
 //****************************************************************************
 #define taa_vpu_cmpgt_target(a_, b_, out_) \
@@ -48,6 +218,35 @@
 #define taa_vpu_load_target(pa_, out_) \
     ((out_) = vld1q_f32(pa_))
 
+//****************************************************************************
+#define taa_vpu_load3_target(pa_, out_) \
+    ((out_) = vcombine_f32( \
+        vld1_f32(pa_), \
+        vld1_lane_f32((pa_) + 2, vdup_n_f32(0.0f), 0)))
+
+//****************************************************************************
+#define taa_vpu_load3x4_target(pa_, x_out_, y_out_, z_out_) \
+    do { \
+        float32x4x3_t xyz_ = vld3q_f32(pa_); \
+        (x_out_) = xyz_.val[0]; \
+        (y_out_) = xyz_.val[1]; \
+        (z_out_) = xyz_.val[2]; \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_load4x4_target(pa_, x_out_, y_out_, z_out_, w_out_) \
+    do { \
+        float32x4x4_t xyzw_ = vld4q_f32(pa_); \
+        (x_out_) = xyzw_.val[0]; \
+        (y_out_) = xyzw_.val[1]; \
+        (z_out_) = xyzw_.val[2]; \
+        (w_out_) = xyzw_.val[3]; \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_loadu_target(pa_, out_) \
+    ((out_) = vld1q_f32(pa_))
+
 //****************************************************************************
 #define taa_vpu_max_target(a_, b_, out_) \
     ((out_) = vmaxq_u32 (a_, b_))
@@ -56,6 +255,17 @@
 #define taa_vpu_min_target(a_, b_, out_) \
     ((out_) = vminq_u32 (a_, b_))
 
+//****************************************************************************
+#define taa_vpu_movemask_target(a_, out_) \
+    do { \
+        uint32x4_t s_ = vshrq_n_u32((uint32x4_t) (a_), 31); \
+        (out_) = (int) ( \
+            (vgetq_lane_u32(s_, 0)     ) | \
+            (vgetq_lane_u32(s_, 1) << 1) | \
+            (vgetq_lane_u32(s_, 2) << 2) | \
+            (vgetq_lane_u32(s_, 3) << 3)); \
+    } while(0)
+
 //****************************************************************************
 #define taa_vpu_mul_target(a_, b_, out_) \
     ((out_) = vmulq_f32(a_, b_))
@@ -72,6 +282,48 @@
 #define taa_vpu_neg_target(a_, out_) \
     ((out_) = vrsqrteq_f32(a_))
 
+//****************************************************************************
+#define taa_vpu_quat_mul_target(a_, b_, out_) \
+    do { \
+        /* out = a.w*b + a.x*b.wzyx*(+-+-) + a.y*b.zwxy*(++--) + */ \
+        /*       a.z*b.yxwz*(-++-) */ \
+        float32x4_t byxwz_ = vrev64q_f32(b_); \
+        float32x4_t bwzyx_ = vextq_f32(byxwz_, byxwz_, 2); \
+        float32x4_t bzwxy_ = vextq_f32(b_, b_, 2); \
+        float32x2_t alo_ = vget_low_f32(a_); \
+        float32x2_t ahi_ = vget_high_f32(a_); \
+        float32x4_t r_ = vmulq_lane_f32(b_, ahi_, 1); \
+        bwzyx_ = vmulq_f32(bwzyx_, vld1q_f32(s_taa_neon_quatsign)); \
+        bzwxy_ = vmulq_f32(bzwxy_, vld1q_f32(s_taa_neon_quatsign + 4)); \
+        byxwz_ = vmulq_f32(byxwz_, vld1q_f32(s_taa_neon_quatsign + 8)); \
+        r_ = vmlaq_lane_f32(r_, bwzyx_, alo_, 0); \
+        r_ = vmlaq_lane_f32(r_, bzwxy_, alo_, 1); \
+        r_ = vmlaq_lane_f32(r_, byxwz_, ahi_, 0); \
+        (out_) = r_; \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_quat_rotate_target(q_, v_, out_) \
+    do { \
+        /* cross(a, b) = yzxw(a*yzxw(b) - yzxw(a)*b), whose w is 0 */ \
+        float32x4_t qyzx_ = taa_neon_yzxw(q_); \
+        float32x4_t t_ = vmlsq_f32( \
+            vmulq_f32(q_, taa_neon_yzxw(v_)), \
+            qyzx_, \
+            v_); \
+        float32x4_t c_; \
+        /* t = cross(q, v) + q.w*v */ \
+        t_ = vmlaq_lane_f32(taa_neon_yzxw(t_), v_, vget_high_f32(q_), 1); \
+        /* out = v + 2*cross(q, t) */ \
+        c_ = vmlsq_f32(vmulq_f32(q_, taa_neon_yzxw(t_)), qyzx_, t_); \
+        c_ = taa_neon_yzxw(c_); \
+        (out_) = vaddq_f32(v_, vaddq_f32(c_, c_)); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_select_target(a_, b_, mask_, out_) \
+    ((out_) = vbslq_f32((uint32x4_t) (mask_), b_, a_))
+
 //****************************************************************************
 #define taa_vpu_set_target(x_, y_, z_, w_, out_) \
     ((out_) = __extension__ (taa_vpu_vec4){ x_, y_, z_, w_ })
@@ -101,6 +353,66 @@
         out_ = vextq_f32(out_,   b_, 1);\
     } while(0)
 
+//****************************************************************************
+#define taa_vpu_sqrt_target(a_, out_) \
+    do { \
+        /* sqrt(a) = a * rsqrt(a), refined with two newton raphson steps */ \
+        float32x4_t r_ = vrsqrteq_f32(a_); \
+        r_ = vmulq_f32(r_, vrsqrtsq_f32(vmulq_f32(a_, r_), r_)); \
+        r_ = vmulq_f32(r_, vrsqrtsq_f32(vmulq_f32(a_, r_), r_)); \
+        (out_) = (float32x4_t) vandq_u32( \
+            vcgtq_f32(a_, vdupq_n_f32(0.0f)), \
+            (uint32x4_t) vmulq_f32(a_, r_)); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_store1_target(a_, out_) \
+    (vst1q_lane_f32(out_, a_, 0))
+
+//****************************************************************************
+#define taa_vpu_store3_target(a_, out_) \
+    do { \
+        vst1_f32(out_, vget_low_f32(a_)); \
+        vst1q_lane_f32((out_) + 2, a_, 2); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_store3x4_target(x_, y_, z_, out_) \
+    do { \
+        float32x4x3_t xyz_; \
+        xyz_.val[0] = (x_); \
+        xyz_.val[1] = (y_); \
+        xyz_.val[2] = (z_); \
+        vst3q_f32(out_, xyz_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_store4x4_target(x_, y_, z_, w_, out_) \
+    do { \
+        float32x4x4_t xyzw_; \
+        xyzw_.val[0] = (x_); \
+        xyzw_.val[1] = (y_); \
+        xyzw_.val[2] = (z_); \
+        xyzw_.val[3] = (w_); \
+        vst4q_f32(out_, xyzw_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_storeu_target(a_, out_) \
+    (vst1q_f32(out_, a_))
+
+//****************************************************************************
+#define taa_vpu_stream_target(a_, out_) \
+    (vst1q_f32(out_, a_))
+
+//****************************************************************************
+#define taa_vpu_stream3x4_target(x_, y_, z_, out_) \
+    taa_vpu_store3x4_target(x_, y_, z_, out_)
+
+//****************************************************************************
+#define taa_vpu_stream_fence_target() \
+    ((void) 0)
+
 //****************************************************************************
 #define taa_vpu_sub_target(a_, b_, out_) \
     ((out_) = vsubq_f32(a_, b_))
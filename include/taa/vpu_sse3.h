@@ -39,6 +39,25 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
     FLT_MIN, FLT_MIN, FLT_MIN, FLT_MIN
 };
 
+static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_adjsign[4] =
+{
+    1.0f, -1.0f, -1.0f, 1.0f
+};
+
+/* sign masks for the shuffled b terms of the quaternion product */
+static const taa_DECLSPEC_ALIGN(16) union
+{
+    uint32_t u32[12];
+    float    f32[12];
+} taa_ATTRIB_ALIGN(16) s_taa_sse_quatsign =
+{
+    {
+        0x00000000, 0x80000000, 0x00000000, 0x80000000, /* w,-z, y,-x */
+        0x00000000, 0x00000000, 0x80000000, 0x80000000, /* z, w,-x,-y */
+        0x80000000, 0x00000000, 0x00000000, 0x80000000  /*-y, x, w,-z */
+    }
+};
+
 //****************************************************************************
 #define taa_vpu_mat33_transpose_target(c0_,c1_,c2_, c0_out_,c1_out_,c2_out_) \
     do { \
@@ -74,6 +93,136 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
         (c3_out_) = _mm_andnot_ps(mask_, c3_); \
     } while(0)
 
+//****************************************************************************
+/* helpers for the 4x4 inverse. each register holds a 2x2 block of the */
+/* transposed matrix as (m00, m01, m10, m11). */
+
+/* out = a * b */
+#define taa_sse_mat22_mul(a_, b_, out_) \
+    ((out_) = _mm_add_ps( \
+        _mm_mul_ps(a_, _mm_shuffle_ps(b_, b_, 0xcc/*11001100*/)), \
+        _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0xb1/*10110001*/), \
+            _mm_shuffle_ps(b_, b_, 0x66/*01100110*/))))
+
+/* out = adj(a) * b */
+#define taa_sse_mat22_adjmul(a_, b_, out_) \
+    ((out_) = _mm_sub_ps( \
+        _mm_mul_ps(_mm_shuffle_ps(a_, a_, 0x0f/*00001111*/), b_), \
+        _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0xa5/*10100101*/), \
+            _mm_shuffle_ps(b_, b_, 0x4e/*01001110*/))))
+
+/* out = a * adj(b) */
+#define taa_sse_mat22_muladj(a_, b_, out_) \
+    ((out_) = _mm_sub_ps( \
+        _mm_mul_ps(a_, _mm_shuffle_ps(b_, b_, 0x33/*00110011*/)), \
+        _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0xb1/*10110001*/), \
+            _mm_shuffle_ps(b_, b_, 0x66/*01100110*/))))
+
+//****************************************************************************
+#define taa_vpu_mat44_determinant_target(c0_, c1_, c2_, c3_, out_) \
+    do { \
+        taa_vpu_vec4 a_ = _mm_movelh_ps(c0_, c1_); \
+        taa_vpu_vec4 b_ = _mm_movehl_ps(c1_, c0_); \
+        taa_vpu_vec4 c_ = _mm_movelh_ps(c2_, c3_); \
+        taa_vpu_vec4 d_ = _mm_movehl_ps(c3_, c2_); \
+        /* |A|, |B|, |C|, |D| */ \
+        taa_vpu_vec4 det22_ = _mm_sub_ps( \
+            _mm_mul_ps( \
+                _mm_shuffle_ps(c0_, c2_, 0x88/*10001000*/), \
+                _mm_shuffle_ps(c1_, c3_, 0xdd/*11011101*/)), \
+            _mm_mul_ps( \
+                _mm_shuffle_ps(c0_, c2_, 0xdd/*11011101*/), \
+                _mm_shuffle_ps(c1_, c3_, 0x88/*10001000*/))); \
+        taa_vpu_vec4 ab_; \
+        taa_vpu_vec4 dc_; \
+        taa_vpu_vec4 tr_; \
+        taa_sse_mat22_adjmul(a_, b_, ab_); \
+        taa_sse_mat22_adjmul(d_, c_, dc_); \
+        /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */ \
+        tr_ = _mm_mul_ps(ab_, _mm_shuffle_ps(dc_, dc_, 0xd8/*11011000*/)); \
+        tr_ = _mm_hadd_ps(tr_, tr_); \
+        tr_ = _mm_hadd_ps(tr_, tr_); \
+        (out_) = _mm_sub_ps( \
+            _mm_add_ps( \
+                _mm_mul_ps( \
+                    _mm_shuffle_ps(det22_, det22_, 0x00/*00000000*/), \
+                    _mm_shuffle_ps(det22_, det22_, 0xff/*11111111*/)), \
+                _mm_mul_ps( \
+                    _mm_shuffle_ps(det22_, det22_, 0x55/*01010101*/), \
+                    _mm_shuffle_ps(det22_, det22_, 0xaa/*10101010*/))), \
+            tr_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_mat44_inverse_target( \
+        c0_, c1_, c2_, c3_, \
+        c0_out_, c1_out_, c2_out_, c3_out_, \
+        det_out_) \
+    do { \
+        /* block inverse of the transposed matrix. the inverse of the */ \
+        /* transpose has the columns of the inverse in its rows, so no */ \
+        /* extra transpose is needed on input or output. */ \
+        taa_vpu_vec4 a_ = _mm_movelh_ps(c0_, c1_); \
+        taa_vpu_vec4 b_ = _mm_movehl_ps(c1_, c0_); \
+        taa_vpu_vec4 c_ = _mm_movelh_ps(c2_, c3_); \
+        taa_vpu_vec4 d_ = _mm_movehl_ps(c3_, c2_); \
+        /* |A|, |B|, |C|, |D| */ \
+        taa_vpu_vec4 det22_ = _mm_sub_ps( \
+            _mm_mul_ps( \
+                _mm_shuffle_ps(c0_, c2_, 0x88/*10001000*/), \
+                _mm_shuffle_ps(c1_, c3_, 0xdd/*11011101*/)), \
+            _mm_mul_ps( \
+                _mm_shuffle_ps(c0_, c2_, 0xdd/*11011101*/), \
+                _mm_shuffle_ps(c1_, c3_, 0x88/*10001000*/))); \
+        taa_vpu_vec4 deta_ = _mm_shuffle_ps(det22_, det22_, 0x00/*00000000*/);\
+        taa_vpu_vec4 detb_ = _mm_shuffle_ps(det22_, det22_, 0x55/*01010101*/);\
+        taa_vpu_vec4 detc_ = _mm_shuffle_ps(det22_, det22_, 0xaa/*10101010*/);\
+        taa_vpu_vec4 detd_ = _mm_shuffle_ps(det22_, det22_, 0xff/*11111111*/);\
+        taa_vpu_vec4 ab_; \
+        taa_vpu_vec4 dc_; \
+        taa_vpu_vec4 x_; \
+        taa_vpu_vec4 y_; \
+        taa_vpu_vec4 z_; \
+        taa_vpu_vec4 w_; \
+        taa_vpu_vec4 tr_; \
+        taa_vpu_vec4 det_; \
+        taa_vpu_vec4 rdet_; \
+        taa_sse_mat22_adjmul(a_, b_, ab_); \
+        taa_sse_mat22_adjmul(d_, c_, dc_); \
+        /* adj(X) = |D|A - B adj(D)C */ \
+        taa_sse_mat22_mul(b_, dc_, x_); \
+        x_ = _mm_sub_ps(_mm_mul_ps(detd_, a_), x_); \
+        /* adj(W) = |A|D - C adj(A)B */ \
+        taa_sse_mat22_mul(c_, ab_, w_); \
+        w_ = _mm_sub_ps(_mm_mul_ps(deta_, d_), w_); \
+        /* adj(Y) = |B|C - D adj(adj(A)B) */ \
+        taa_sse_mat22_muladj(d_, ab_, y_); \
+        y_ = _mm_sub_ps(_mm_mul_ps(detb_, c_), y_); \
+        /* adj(Z) = |C|B - A adj(adj(D)C) */ \
+        taa_sse_mat22_muladj(a_, dc_, z_); \
+        z_ = _mm_sub_ps(_mm_mul_ps(detc_, b_), z_); \
+        /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */ \
+        tr_ = _mm_mul_ps(ab_, _mm_shuffle_ps(dc_, dc_, 0xd8/*11011000*/)); \
+        tr_ = _mm_hadd_ps(tr_, tr_); \
+        tr_ = _mm_hadd_ps(tr_, tr_); \
+        det_ = _mm_add_ps(_mm_mul_ps(deta_, detd_), _mm_mul_ps(detb_, detc_));\
+        det_ = _mm_sub_ps(det_, tr_); \
+        rdet_ = _mm_div_ps(_mm_load_ps(s_taa_sse_adjsign), det_); \
+        x_ = _mm_mul_ps(x_, rdet_); \
+        y_ = _mm_mul_ps(y_, rdet_); \
+        z_ = _mm_mul_ps(z_, rdet_); \
+        w_ = _mm_mul_ps(w_, rdet_); \
+        /* undo the adjugates while interleaving the blocks into columns */ \
+        (c0_out_) = _mm_shuffle_ps(x_, y_, 0x77/*01110111*/); \
+        (c1_out_) = _mm_shuffle_ps(x_, y_, 0x22/*00100010*/); \
+        (c2_out_) = _mm_shuffle_ps(z_, w_, 0x77/*01110111*/); \
+        (c3_out_) = _mm_shuffle_ps(z_, w_, 0x22/*00100010*/); \
+        (det_out_) = det_; \
+    } while(0)
+
 //****************************************************************************
 #define taa_vpu_mat44_mul_vec4_target(c0_, c1_, c2_, c3_, v_, out_) \
     do { \
@@ -125,7 +274,7 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
     do { \
         __m128 mask_= _mm_load_ps(s_taa_sse_absmask.f32); \
         (out_) = _mm_cmpgt_ps(_mm_andnot_ps(mask_, a_), \
-                              _mm_andnot_ps(mask_, a_)); \
+                              _mm_andnot_ps(mask_, b_)); \
     } while(0)
 
 //****************************************************************************
@@ -160,6 +309,48 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
 #define taa_vpu_load_target(pa_, out_) \
     ((out_) = _mm_load_ps(pa_))
 
+//****************************************************************************
+#define taa_vpu_load3_target(pa_, out_) \
+    do { \
+        /* movlps loads x,y into a cleared register, movss loads z into */ \
+        /* the low lane of another, and movlhps combines them */ \
+        taa_vpu_vec4 xy_ = _mm_loadl_pi( \
+            _mm_setzero_ps(), \
+            (const __m64*) (pa_)); \
+        (out_) = _mm_movelh_ps(xy_, _mm_load_ss((pa_) + 2)); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_load3x4_target(pa_, x_out_, y_out_, z_out_) \
+    do { \
+        /* a = x0,y0,z0,x1  b = y1,z1,x2,y2  c = z2,x3,y3,z3 */ \
+        taa_vpu_vec4 a_ = _mm_loadu_ps((pa_)    ); \
+        taa_vpu_vec4 b_ = _mm_loadu_ps((pa_) + 4); \
+        taa_vpu_vec4 c_ = _mm_loadu_ps((pa_) + 8); \
+        /* t = y0,z0,y1,z1  u = x2,y2,x3,y3 */ \
+        taa_vpu_vec4 t_ = _mm_shuffle_ps(a_, b_, 0x49/*01001001*/); \
+        taa_vpu_vec4 u_ = _mm_shuffle_ps(b_, c_, 0x9e/*10011110*/); \
+        x_out_ = _mm_shuffle_ps(a_, u_, 0x8c/*10001100*/); \
+        y_out_ = _mm_shuffle_ps(t_, u_, 0xd8/*11011000*/); \
+        z_out_ = _mm_shuffle_ps(t_, c_, 0xcd/*11001101*/); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_load4x4_target(pa_, x_out_, y_out_, z_out_, w_out_) \
+    do { \
+        taa_vpu_vec4 c0_ = _mm_load_ps((pa_)     ); \
+        taa_vpu_vec4 c1_ = _mm_load_ps((pa_) +  4); \
+        taa_vpu_vec4 c2_ = _mm_load_ps((pa_) +  8); \
+        taa_vpu_vec4 c3_ = _mm_load_ps((pa_) + 12); \
+        taa_vpu_mat44_transpose_target( \
+            c0_,c1_,c2_,c3_, \
+            x_out_,y_out_,z_out_,w_out_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_loadu_target(pa_, out_) \
+    ((out_) = _mm_loadu_ps(pa_))
+
 //****************************************************************************
 #define taa_vpu_max_target(a_, b_, out_) \
     ((out_) = _mm_max_ps(a_, b_))
@@ -172,6 +363,10 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
 #define taa_vpu_mov_target(a_, out_) \
     ((out_) = (a_))
 
+//****************************************************************************
+#define taa_vpu_movemask_target(a_, out_) \
+    ((out_) = _mm_movemask_ps(a_))
+
 //****************************************************************************
 #define taa_vpu_mul_target(a_, b_, out_) \
     ((out_) = _mm_mul_ps(a_, b_))
@@ -198,10 +393,53 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
 #define taa_vpu_or_target(a_, b_, out_) \
     ((out_) = _mm_or_ps(a_, b_))
 
+//****************************************************************************
+#define taa_vpu_quat_mul_target(a_, b_, out_) \
+    do { \
+        /* out = a.w*b + a.x*b.wzyx*(+-+-) + a.y*b.zwxy*(++--) + */ \
+        /*       a.z*b.yxwz*(-++-) */ \
+        taa_vpu_vec4 bwzyx_ = _mm_xor_ps( \
+            _mm_shuffle_ps(b_, b_, 0x1b/*00011011*/), \
+            _mm_load_ps(s_taa_sse_quatsign.f32)); \
+        taa_vpu_vec4 bzwxy_ = _mm_xor_ps( \
+            _mm_shuffle_ps(b_, b_, 0x4e/*01001110*/), \
+            _mm_load_ps(s_taa_sse_quatsign.f32 + 4)); \
+        taa_vpu_vec4 byxwz_ = _mm_xor_ps( \
+            _mm_shuffle_ps(b_, b_, 0xb1/*10110001*/), \
+            _mm_load_ps(s_taa_sse_quatsign.f32 + 8)); \
+        taa_vpu_vec4 r_ = _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0xff/*11111111*/), b_); \
+        r_ = _mm_add_ps(r_, _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0x00/*00000000*/), bwzyx_)); \
+        r_ = _mm_add_ps(r_, _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0x55/*01010101*/), bzwxy_)); \
+        r_ = _mm_add_ps(r_, _mm_mul_ps( \
+            _mm_shuffle_ps(a_, a_, 0xaa/*10101010*/), byxwz_)); \
+        (out_) = r_; \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_quat_rotate_target(q_, v_, out_) \
+    do { \
+        /* t = cross(q, v) + q.w*v, whose w is q.w*v.w */ \
+        /* out = v + 2*cross(q, t), the w of the cross is exactly 0 */ \
+        taa_vpu_vec4 t_; \
+        taa_vpu_vec4 c_; \
+        taa_vpu_cross3_target(q_, v_, t_); \
+        t_ = _mm_add_ps(t_, _mm_mul_ps( \
+            _mm_shuffle_ps(q_, q_, 0xff/*11111111*/), v_)); \
+        taa_vpu_cross3_target(q_, t_, c_); \
+        (out_) = _mm_add_ps(v_, _mm_add_ps(c_, c_)); \
+    } while(0)
+
 //****************************************************************************
 #define taa_vpu_rsqrt_target(a_, out_) \
     ((out_) = _mm_rsqrt_ps(a_))
 
+//****************************************************************************
+#define taa_vpu_select_target(a_, b_, mask_, out_) \
+    ((out_) = _mm_or_ps(_mm_andnot_ps(mask_, a_), _mm_and_ps(mask_, b_)))
+
 //****************************************************************************
 #define taa_vpu_set_target(x_, y_, z_, w_, out_) \
     ((out_) = _mm_set_ps(w_, z_, y_, x_))
@@ -230,6 +468,10 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
         out_              = _mm_shuffle_ps(tmp_, out_, 0x88 /*10001000*/); \
     } while(0)
 
+//****************************************************************************
+#define taa_vpu_sqrt_target(a_, out_) \
+    ((out_) = _mm_sqrt_ps(a_))
+
 //****************************************************************************
 #define taa_vpu_store_target(a_, out_) \
     (_mm_store_ps(out_, a_))
@@ -238,6 +480,68 @@ static const taa_DECLSPEC_ALIGN(16) float taa_ATTRIB_ALIGN(16) s_taa_sse_tiny[4]
 #define taa_vpu_store1_target(a_, out_) \
     (_mm_store_ss(out_, a_))
 
+//****************************************************************************
+#define taa_vpu_store3_target(a_, out_) \
+    do { \
+        _mm_storel_pi((__m64*) (out_), a_); \
+        _mm_store_ss((out_) + 2, _mm_movehl_ps(a_, a_)); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_store3x4_target(x_, y_, z_, out_) \
+    do { \
+        /* p = x0,x1,y0,y1  q = z0,z2,x1,x3 */ \
+        taa_vpu_vec4 p_ = _mm_shuffle_ps(x_, y_, 0x44/*01000100*/); \
+        taa_vpu_vec4 q_ = _mm_shuffle_ps(z_, x_, 0xd8/*11011000*/); \
+        /* r = y1,y2,z1,z2  w = x2,x3,y2,y3  s = y3,y3,z3,z3 */ \
+        taa_vpu_vec4 r_ = _mm_shuffle_ps(y_, z_, 0x99/*10011001*/); \
+        taa_vpu_vec4 w_ = _mm_shuffle_ps(x_, y_, 0xee/*11101110*/); \
+        taa_vpu_vec4 s_ = _mm_shuffle_ps(y_, z_, 0xff/*11111111*/); \
+        _mm_storeu_ps((out_)    , _mm_shuffle_ps(p_, q_, 0x88/*10001000*/));\
+        _mm_storeu_ps((out_) + 4, _mm_shuffle_ps(r_, w_, 0x88/*10001000*/));\
+        _mm_storeu_ps((out_) + 8, _mm_shuffle_ps(q_, s_, 0x8d/*10001101*/));\
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_store4x4_target(x_, y_, z_, w_, out_) \
+    do { \
+        taa_vpu_vec4 c0_; \
+        taa_vpu_vec4 c1_; \
+        taa_vpu_vec4 c2_; \
+        taa_vpu_vec4 c3_; \
+        taa_vpu_mat44_transpose_target(x_,y_,z_,w_, c0_,c1_,c2_,c3_); \
+        _mm_store_ps((out_)     , c0_); \
+        _mm_store_ps((out_) +  4, c1_); \
+        _mm_store_ps((out_) +  8, c2_); \
+        _mm_store_ps((out_) + 12, c3_); \
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_storeu_target(a_, out_) \
+    (_mm_storeu_ps(out_, a_))
+
+//****************************************************************************
+#define taa_vpu_stream_target(a_, out_) \
+    (_mm_stream_ps(out_, a_))
+
+//****************************************************************************
+#define taa_vpu_stream3x4_target(x_, y_, z_, out_) \
+    do { \
+        /* same shuffles as taa_vpu_store3x4_target */ \
+        taa_vpu_vec4 p_ = _mm_shuffle_ps(x_, y_, 0x44/*01000100*/); \
+        taa_vpu_vec4 q_ = _mm_shuffle_ps(z_, x_, 0xd8/*11011000*/); \
+        taa_vpu_vec4 r_ = _mm_shuffle_ps(y_, z_, 0x99/*10011001*/); \
+        taa_vpu_vec4 w_ = _mm_shuffle_ps(x_, y_, 0xee/*11101110*/); \
+        taa_vpu_vec4 s_ = _mm_shuffle_ps(y_, z_, 0xff/*11111111*/); \
+        _mm_stream_ps((out_)    , _mm_shuffle_ps(p_, q_, 0x88/*10001000*/));\
+        _mm_stream_ps((out_) + 4, _mm_shuffle_ps(r_, w_, 0x88/*10001000*/));\
+        _mm_stream_ps((out_) + 8, _mm_shuffle_ps(q_, s_, 0x8d/*10001101*/));\
+    } while(0)
+
+//****************************************************************************
+#define taa_vpu_stream_fence_target() \
+    (_mm_sfence())
+
 //****************************************************************************
 #define taa_vpu_sub_target(a_, b_, out_) \
     ((out_) = _mm_sub_ps(a_, b_))
@@ -6,8 +6,10 @@
 #include "testutil.h"
 #include <taa/scalar.h>
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef NDEBUG
 #error asserts are not enabled
@@ -45,6 +47,49 @@ static void test_vec3_normalize()
     }    
 }
 
+static void test_vec3_array()
+{
+    enum { N = 37 };
+    // the padding float is filled with a non finite value so that any
+    // leak of the w lane into the results is caught
+    float a[N*3 + taa_VEC3_ARRAY_PADDING];
+    float b[N*3 + taa_VEC3_ARRAY_PADDING];
+    taa_vec3* u = (taa_vec3*) a;
+    taa_vec3* v = (taa_vec3*) b;
+    taa_vec3 c[N];
+    float d[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec3(u + i);
+        rand_vec3(v + i);
+    }
+    a[N*3] = (float) HUGE_VAL;
+    b[N*3] = (float) -HUGE_VAL;
+    taa_vec3_cross_array(u, v, N, c);
+    taa_vec3_dot_array(u, v, N, d);
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec3 r;
+        r.x = u[i].y*v[i].z - u[i].z*v[i].y;
+        r.y = u[i].z*v[i].x - u[i].x*v[i].z;
+        r.z = u[i].x*v[i].y - u[i].y*v[i].x;
+        assert(cmp_vec3(c + i, &r, TEST_EPSILON) == 0);
+        assert(cmp_scalar(
+            d[i],
+            u[i].x*v[i].x + u[i].y*v[i].y + u[i].z*v[i].z,
+            TEST_EPSILON) == 0);
+        taa_vec3_normalize(u + i, &r);
+        assert(cmp_scalar(taa_vec3_length(&r), 1.0f, TEST_EPSILON) == 0);
+        c[i] = r;
+    }
+    taa_vec3_normalize_array(u, N, u);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec3(u + i, c + i, 0.0f) == 0);
+    }
+}
+
 static void test_vec4_normalize()
 {
     int i;
@@ -103,6 +148,139 @@ static void test_mat33_inverse()
     assert(numtests > 0);
 }
 
+static void test_mat33_orthonormalize()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS; ++i)
+    {
+        taa_mat33 M;
+        taa_mat33 N;
+        taa_mat33 T;
+        taa_mat33 I;
+        taa_vec3 u;
+        rand_mat33(&M);
+        M.x.x += 1.0f;
+        M.y.y += 1.0f;
+        M.z.z += 1.0f;
+        if(fabs(taa_mat33_determinant(&M)) < 0.1f)
+        {
+            // gram-schmidt loses orthogonality on nearly dependent columns
+            continue;
+        }
+        taa_mat33_orthonormalize(&M, &N);
+        // the result is a rotation, within gram-schmidt rounding error
+        taa_mat33_transpose(&N, &T);
+        taa_mat33_multiply(&T, &N, &I);
+        assert(cmp_scalar(I.x.x, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.y.y, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.z.z, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.x.y, 0.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.x.z, 0.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.y.z, 0.0f, 1e-5f) == 0);
+        // the first column keeps its direction
+        taa_vec3_normalize(&M.x, &u);
+        assert(cmp_vec3(&u, &N.x, TEST_EPSILON) == 0);
+        // the transform matches the column combination
+        taa_mat33_transform_vec3(&N, &M.y, &u);
+        assert(cmp_scalar(
+            u.x,
+            N.x.x*M.y.x + N.y.x*M.y.y + N.z.x*M.y.z,
+            TEST_EPSILON) == 0);
+    }
+}
+
+static void test_mat33_orthonormalize_array()
+{
+    enum { N = 37 };
+    taa_mat33 A[N];
+    taa_mat33 B[N];
+    taa_mat44 C[N];
+    taa_mat44 D[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_mat33(A + i);
+        A[i].x.x += 1.0f;
+        A[i].y.y += 1.0f;
+        A[i].z.z += 1.0f;
+        taa_mat44_from_mat33(A + i, C + i);
+        C[i].w.x = randf();
+    }
+    taa_mat33_orthonormalize_array(A, N, B);
+    taa_mat44_orthonormalize_array(C, N, D);
+    for(i = 0; i < N; ++i)
+    {
+        taa_mat33 M;
+        taa_mat44 R;
+        taa_mat33_orthonormalize(A + i, &M);
+        taa_mat44_orthonormalize(C + i, &R);
+        assert(cmp_mat33(B + i, &M, TEST_EPSILON) == 0);
+        assert(cmp_mat44(D + i, &R, TEST_EPSILON) == 0);
+    }
+    // in place
+    taa_mat33_orthonormalize_array(A, N, A);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_mat33(A + i, B + i, 0.0f) == 0);
+    }
+}
+
+static void test_mat33_polar_array()
+{
+    enum { N = 37 };
+    taa_mat33 R[N];
+    taa_mat33 A[N];
+    taa_mat33 B[N];
+    taa_mat44 C[N];
+    taa_mat44 D[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        taa_quat q;
+        rand_quat(&q);
+        taa_mat33_from_quat(&q, R + i);
+        // drift of up to 1e-2 per element
+        A[i] = R[i];
+        A[i].x.x += (randf() - 0.5f) * 2e-2f;
+        A[i].x.y += (randf() - 0.5f) * 2e-2f;
+        A[i].y.z += (randf() - 0.5f) * 2e-2f;
+        A[i].z.x += (randf() - 0.5f) * 2e-2f;
+        A[i].z.z += (randf() - 0.5f) * 2e-2f;
+        taa_mat44_from_mat33(A + i, C + i);
+    }
+    // a rotation is its own polar factor
+    taa_mat33_polar_array(R, N, 3, B);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_mat33(B + i, R + i, 1e-5f) == 0);
+    }
+    taa_mat33_polar_array(A, N, 3, B);
+    taa_mat44_polar_array(C, N, 3, D);
+    for(i = 0; i < N; ++i)
+    {
+        taa_mat33 T;
+        taa_mat33 I;
+        taa_mat44 M;
+        taa_mat33_transpose(B + i, &T);
+        taa_mat33_multiply(&T, B + i, &I);
+        assert(cmp_scalar(I.x.x, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.y.y, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.z.z, 1.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.x.y, 0.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.x.z, 0.0f, 1e-5f) == 0);
+        assert(cmp_scalar(I.y.z, 0.0f, 1e-5f) == 0);
+        assert(cmp_scalar(taa_mat33_determinant(B + i), 1.0f, 1e-5f) == 0);
+        // the drift is removed without rotating away from the original
+        assert(cmp_mat33(B + i, R + i, 1e-2f) == 0);
+        taa_mat44_from_mat33(B + i, &M);
+        assert(cmp_mat44(D + i, &M, TEST_EPSILON) == 0);
+    }
+    // a mirrored matrix converges to a reflection
+    taa_vec3_scale(&A[0].x, -1.0f, &A[0].x);
+    taa_mat33_polar_array(A, 1, 3, B);
+    assert(cmp_scalar(taa_mat33_determinant(B), -1.0f, 1e-5f) == 0);
+}
+
 static void test_mat44_inverse()
 {
     int i;
@@ -124,7 +302,9 @@ static void test_mat44_inverse()
         taa_vec4_normalize(&M.z, &M.z);
         taa_vec4_normalize(&M.w, &M.w);        
         taa_mat44_scale(&M, 2.0f, &M);
-        if(fabs(taa_mat44_determinant(&M)) > 1e-3f)
+        // nearly singular matrices amplify rounding error past the fixed
+        // tolerance below regardless of the inversion method
+        if(fabs(taa_mat44_determinant(&M)) > 1e-2f)
         {
             taa_mat44 Minv;
             taa_mat44_inverse(&M, &Minv);
@@ -136,80 +316,2323 @@ static void test_mat44_inverse()
     assert(numtests > 0);
 }
 
-static void test_mat44_from_quat()
+static void test_mat44_inverse_affine()
 {
+    enum { N = 5 };
+    taa_mat44 M[N];
+    taa_mat44 R[N];
     int i;
     for(i = 0; i < NUM_TEST_LOOPS; ++i)
     {
-        float rad = randf() * taa_PI * 0.5f;
-        taa_quat q;
-        taa_mat44 M;
-        taa_vec4 axis;
-        taa_vec4 t;
-        taa_vec4 u;
-        taa_vec4 v;
-        rand_vec4(&t);
-        rand_vec4(&axis);
-        axis.w = 0.0f;
-        taa_vec4_normalize(&axis, &axis);
-        taa_quat_axisangle(rad, &axis, &q);
-        taa_mat44_from_quat(&q, &M);
-        taa_quat_transform_vec4(&q, &t, &u);
-        taa_mat44_transform_vec4(&M, &t, &v);
-        assert(cmp_vec4(&u, &v, TEST_EPSILON) == 0);
+        taa_mat44 Minv;
+        int j;
+        for(j = 0; j < N; ++j)
+        {
+            // keep the matrices well conditioned by biasing the diagonal
+            rand_mat44(M + j);
+            M[j].x.x += 2.0f;
+            M[j].y.y += 2.0f;
+            M[j].z.z += 2.0f;
+            M[j].x.w = 0.0f;
+            M[j].y.w = 0.0f;
+            M[j].z.w = 0.0f;
+            M[j].w.w = 1.0f;
+        }
+        // the translations reach ~3 in magnitude, so allow a few ulps
+        taa_mat44_inverse_affine_array(M, N, R);
+        for(j = 0; j < N; ++j)
+        {
+            taa_mat44_inverse(M + j, &Minv);
+            assert(cmp_mat44(&Minv, R + j, 1e-5f) == 0);
+        }
+        // in place
+        taa_mat44_inverse_affine(R, R);
+        assert(cmp_mat44(M, R, 1e-5f) == 0);
+        taa_mat44_inverse_affine_array(R + 1, N - 1, R + 1);
+        for(j = 1; j < N; ++j)
+        {
+            assert(cmp_mat44(M + j, R + j, 1e-5f) == 0);
+        }
     }
 }
 
-static void test_quat_from_mat44()
+static void test_mat44_inverse_rigid()
 {
+    enum { N = 5 };
+    taa_mat44 M[N];
+    taa_mat44 R[N];
     int i;
     for(i = 0; i < NUM_TEST_LOOPS; ++i)
     {
-        float rad = randf() * taa_PI * 0.5f;
+        taa_mat44 Minv;
+        int j;
+        for(j = 0; j < N; ++j)
+        {
+            taa_quat q;
+            rand_quat(&q);
+            taa_mat44_from_quat(&q, M + j);
+            rand_vec4(&M[j].w);
+            M[j].w.w = 1.0f;
+        }
+        // the translations reach ~1.7 in magnitude, so allow a few ulps
+        taa_mat44_inverse_rigid_array(M, N, R);
+        for(j = 0; j < N; ++j)
+        {
+            taa_mat44_inverse(M + j, &Minv);
+            assert(cmp_mat44(&Minv, R + j, 1e-5f) == 0);
+        }
+        // in place
+        taa_mat44_inverse_rigid(R, R);
+        assert(cmp_mat44(M, R, 1e-5f) == 0);
+        taa_mat44_inverse_rigid_array(R + 1, N - 1, R + 1);
+        for(j = 1; j < N; ++j)
+        {
+            assert(cmp_mat44(M + j, R + j, 1e-5f) == 0);
+        }
+    }
+}
+
+static void test_mat44_trs()
+{
+    enum { N = 37 };
+    taa_vec4 t[N];
+    taa_quat r[N];
+    taa_vec4 sc[N];
+    taa_mat44 M[N];
+    taa_vec4 t2[N];
+    taa_quat r2[N];
+    taa_vec4 s2[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        taa_mat44 T;
+        taa_mat44 R;
+        taa_mat44 S;
+        taa_mat44 A;
+        taa_mat44 B;
+        rand_vec4(t + i);
+        rand_quat(r + i);
+        rand_vec4(sc + i);
+        sc[i].x += 0.5f;
+        sc[i].y += 0.5f;
+        sc[i].z += 0.5f;
+        // every third transform is mirrored
+        sc[i].y = ((i % 3) == 0) ? -sc[i].y : sc[i].y;
+        taa_mat44_from_trs(t + i, r + i, sc + i, M + i);
+        // matches the composition of the separate matrices
+        taa_mat44_from_translate(t + i, &T);
+        taa_mat44_from_quat(r + i, &R);
+        taa_mat44_from_scale(sc + i, &S);
+        taa_mat44_multiply(&R, &S, &A);
+        taa_mat44_multiply(&T, &A, &B);
+        assert(cmp_mat44(M + i, &B, TEST_EPSILON) == 0);
+    }
+    taa_mat44_decompose_trs_array(M, N, t2, r2, s2);
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 u;
         taa_quat q;
-        taa_mat44 M;
-        taa_vec4 axis;
+        taa_vec4 v;
+        taa_mat44 A;
+        taa_mat44_decompose_trs(M + i, &u, &q, &v);
+        assert(cmp_vec4(t2 + i, &u, TEST_EPSILON) == 0);
+        assert(cmp_vec4(r2 + i, &q, TEST_EPSILON) == 0);
+        assert(cmp_vec4(s2 + i, &v, TEST_EPSILON) == 0);
+        assert(cmp_scalar(u.x, t[i].x, 0.0f) == 0);
+        assert(cmp_scalar(u.w, 0.0f, 0.0f) == 0);
+        assert(cmp_scalar(v.w, 1.0f, 0.0f) == 0);
+        if((i % 3) != 0)
+        {
+            assert(cmp_scalar(v.x, sc[i].x, 1e-5f) == 0);
+            assert(cmp_scalar(v.y, sc[i].y, 1e-5f) == 0);
+            assert(cmp_scalar(v.z, sc[i].z, 1e-5f) == 0);
+            assert(cmp_scalar(fabs(taa_vec4_dot(&q, r+i)), 1.0f, 1e-5f) == 0);
+        }
+        else
+        {
+            // mirroring is reported on the x axis
+            assert(v.x < 0.0f);
+        }
+        // the parts always rebuild the original transform
+        taa_mat44_from_trs(&u, &q, &v, &A);
+        assert(cmp_mat44(M + i, &A, 1e-5f) == 0);
+    }
+    taa_mat44_from_trs_array(t2, r2, s2, N, M);
+    for(i = 0; i < N; ++i)
+    {
+        taa_mat44 A;
+        taa_mat44_from_trs(t2 + i, r2 + i, s2 + i, &A);
+        assert(cmp_mat44(M + i, &A, TEST_EPSILON) == 0);
+    }
+}
+
+static void test_camera_build_array()
+{
+    enum { N = 37 };
+    taa_camera_desc desc[N];
+    taa_camera cam[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec4(&desc[i].eye);
+        rand_vec4(&desc[i].target);
+        desc[i].target.x += 2.0f;
+        taa_vec4_set(randf() - 0.5f, 1.0f, randf() - 0.5f, 0.0f, &desc[i].up);
+        desc[i].fovy = 0.5f + randf();
+        desc[i].aspect = 0.5f + randf();
+        desc[i].znear = 0.1f + randf();
+        desc[i].zfar = desc[i].znear + 10.0f + 100.0f*randf();
+        desc[i].projection = (taa_projection) (i % 4);
+    }
+    taa_camera_build_array(desc, N, cam);
+    for(i = 0; i < N; ++i)
+    {
+        const taa_camera_desc* d = desc + i;
+        const taa_camera* c = cam + i;
+        taa_mat44 A;
+        taa_mat44 I;
+        taa_vec4 p;
+        taa_vec4 v;
+        float zn = (d->projection >= taa_PROJECTION_REVERSED) ? 1.0f : -1.0f;
+        float zf = (d->projection >= taa_PROJECTION_REVERSED) ? 0.0f : 1.0f;
+        taa_mat44_lookat(&d->eye, &d->target, &d->up, &A);
+        assert(cmp_mat44(&c->view, &A, 1e-5f) == 0);
+        if(d->projection == taa_PROJECTION_PERSPECTIVE)
+        {
+            taa_mat44_perspective(d->fovy,d->aspect,d->znear,d->zfar,&A);
+            assert(cmp_mat44(&c->proj, &A, 1e-4f) == 0);
+        }
+        taa_mat44_multiply(&c->proj, &c->view, &A);
+        assert(cmp_mat44(&c->viewproj, &A, 1e-4f) == 0);
+        taa_mat44_identity(&I);
+        taa_mat44_multiply(&c->view_inverse, &c->view, &A);
+        assert(cmp_mat44(&I, &A, 1e-4f) == 0);
+        taa_mat44_multiply(&c->proj_inverse, &c->proj, &A);
+        assert(cmp_mat44(&I, &A, 1e-4f) == 0);
+        taa_mat44_multiply(&c->viewproj_inverse, &c->viewproj, &A);
+        assert(cmp_mat44(&I, &A, 1e-3f) == 0);
+        // the near plane maps to the near depth
+        taa_vec4_set(0.0f, 0.0f, -d->znear, 1.0f, &v);
+        taa_mat44_transform_vec4(&c->proj, &v, &p);
+        assert(cmp_scalar(p.z/p.w, zn, 1e-4f) == 0);
+        // the far plane maps to the far depth, or approaches it at infinity
+        if((d->projection & 1) == 0)
+        {
+            taa_vec4_set(0.0f, 0.0f, -d->zfar, 1.0f, &v);
+        }
+        else
+        {
+            taa_vec4_set(0.0f, 0.0f, -1.0f, 0.0f, &v);
+        }
+        taa_mat44_transform_vec4(&c->proj, &v, &p);
+        assert(cmp_scalar(p.z/p.w, zf, 1e-4f) == 0);
+    }
+}
+
+static void test_dualquat()
+{
+    enum { N = 37, NUM_BONES = 8 };
+    taa_dualquat bones[NUM_BONES];
+    taa_mat44 mats[NUM_BONES];
+    uint16_t indices[N*4];
+    taa_vec4 weights[N];
+    taa_vec3 pos[N];
+    taa_vec3 nrm[N];
+    taa_vec3 pos2[N];
+    taa_vec3 nrm2[N];
+    taa_vec4 one;
+    int i;
+    int j;
+    taa_vec4_set(1.0f, 1.0f, 1.0f, 1.0f, &one);
+    for(i = 0; i < NUM_BONES; ++i)
+    {
+        taa_quat r;
         taa_vec4 t;
+        taa_dualquat dq;
+        taa_mat44 A;
+        rand_quat(&r);
+        rand_vec4(&t);
+        taa_dualquat_from_rt(&r, &t, bones + i);
+        taa_mat44_from_trs(&t, &r, &one, mats + i);
+        taa_dualquat_to_mat44(bones + i, &A);
+        assert(cmp_mat44(mats + i, &A, 1e-5f) == 0);
+        taa_dualquat_from_mat44(mats + i, &dq);
+        taa_dualquat_to_mat44(&dq, &A);
+        assert(cmp_mat44(mats + i, &A, 1e-5f) == 0);
+    }
+    for(i = 1; i < NUM_BONES; ++i)
+    {
+        taa_dualquat dq;
+        taa_mat44 A;
+        taa_mat44 B;
+        taa_vec4 v;
         taa_vec4 u;
+        taa_vec4 w;
+        taa_vec3 p;
+        taa_vec3 q;
+        taa_dualquat_multiply(bones + i - 1, bones + i, &dq);
+        taa_dualquat_normalize(&dq, &dq);
+        taa_mat44_multiply(mats + i - 1, mats + i, &A);
+        taa_dualquat_to_mat44(&dq, &B);
+        assert(cmp_mat44(&A, &B, 1e-5f) == 0);
+        rand_vec4(&v);
+        taa_mat44_transform_vec4(mats + i, &v, &u);
+        taa_dualquat_transform_vec4(bones + i, &v, &w);
+        assert(cmp_vec4(&u, &w, 1e-5f) == 0);
+        rand_vec3(&p);
+        taa_dualquat_transform_point(bones + i, &p, &q);
+        taa_vec4_set(p.x, p.y, p.z, 1.0f, &v);
+        taa_mat44_transform_vec4(mats + i, &v, &u);
+        assert(cmp_scalar(q.x, u.x, 1e-5f) == 0);
+        assert(cmp_scalar(q.y, u.y, 1e-5f) == 0);
+        assert(cmp_scalar(q.z, u.z, 1e-5f) == 0);
+    }
+    for(i = 0; i < N; ++i)
+    {
+        float sum;
+        rand_vec3(pos + i);
+        rand_vec3(nrm + i);
+        taa_vec3_normalize(nrm + i, nrm + i);
+        rand_vec4(weights + i);
+        // every fourth vertex is bound to a single bone
+        weights[i].y = ((i % 4) == 0) ? 0.0f : weights[i].y;
+        weights[i].z = ((i % 4) == 0) ? 0.0f : weights[i].z;
+        weights[i].w = ((i % 4) == 0) ? 0.0f : weights[i].w;
+        sum = weights[i].x + weights[i].y + weights[i].z + weights[i].w;
+        taa_vec4_scale(weights + i, 1.0f/sum, weights + i);
+        for(j = 0; j < 4; ++j)
+        {
+            indices[i*4 + j] = (uint16_t) (rand() % NUM_BONES);
+        }
+    }
+    taa_dualquat_skin_array(
+        bones,
+        indices,
+        weights,
+        pos,
+        nrm,
+        N,
+        pos2,
+        nrm2);
+    for(i = 0; i < N; ++i)
+    {
+        const float* w = &weights[i].x;
+        taa_dualquat b;
+        taa_vec3 p;
+        taa_vec3 q;
         taa_vec4 v;
+        taa_vec4 u;
+        taa_vec4_set(0.0f, 0.0f, 0.0f, 0.0f, &b.real);
+        taa_vec4_set(0.0f, 0.0f, 0.0f, 0.0f, &b.dual);
+        for(j = 0; j < 4; ++j)
+        {
+            const taa_dualquat* bone = bones + indices[i*4 + j];
+            float s = w[j];
+            s = (taa_vec4_dot(&b.real, &bone->real) < 0.0f) ? -s : s;
+            b.real.x += bone->real.x * s;
+            b.real.y += bone->real.y * s;
+            b.real.z += bone->real.z * s;
+            b.real.w += bone->real.w * s;
+            b.dual.x += bone->dual.x * s;
+            b.dual.y += bone->dual.y * s;
+            b.dual.z += bone->dual.z * s;
+            b.dual.w += bone->dual.w * s;
+        }
+        taa_dualquat_normalize(&b, &b);
+        taa_dualquat_transform_point(&b, pos + i, &p);
+        assert(cmp_vec3(&p, pos2 + i, 1e-5f) == 0);
+        taa_vec4_set(nrm[i].x, nrm[i].y, nrm[i].z, 0.0f, &v);
+        taa_dualquat_transform_vec4(&b, &v, &u);
+        taa_vec3_set(u.x, u.y, u.z, &q);
+        assert(cmp_vec3(&q, nrm2 + i, 1e-5f) == 0);
+        if((i % 4) == 0)
+        {
+            // single influence matches the bone matrix
+            taa_vec4_set(pos[i].x, pos[i].y, pos[i].z, 1.0f, &v);
+            taa_mat44_transform_vec4(mats + indices[i*4], &v, &u);
+            assert(cmp_scalar(u.x, pos2[i].x, 1e-5f) == 0);
+            assert(cmp_scalar(u.y, pos2[i].y, 1e-5f) == 0);
+            assert(cmp_scalar(u.z, pos2[i].z, 1e-5f) == 0);
+        }
+    }
+}
+
+static void test_skin_lbs()
+{
+    enum { N = 37, NUM_BONES = 8 };
+    taa_mat44 palette[NUM_BONES];
+    uint16_t indices[N*4];
+    uint8_t indices8[N*4];
+    taa_vec4 weights[N];
+    taa_vec3 pos[N];
+    taa_vec3 nrm[N];
+    taa_vec3 pos2[N];
+    taa_vec3 nrm2[N];
+    taa_vec3 pos3[N];
+    taa_vec3 nrm3[N];
+    taa_vec4 one;
+    int i;
+    int j;
+    taa_vec4_set(1.0f, 1.0f, 1.0f, 1.0f, &one);
+    for(i = 0; i < NUM_BONES; ++i)
+    {
+        taa_quat r;
+        taa_vec4 t;
+        rand_quat(&r);
         rand_vec4(&t);
-        rand_vec4(&axis);
-        axis.w = 0.0f;
-        taa_vec4_normalize(&axis, &axis);
-        taa_mat44_axisangle(rad, &axis, &M);
-        taa_quat_from_mat44(&M, &q);
-        taa_mat44_transform_vec4(&M, &t, &u);
-        taa_quat_transform_vec4(&q, &t, &v);
-        assert(cmp_vec4(&u, &v, TEST_EPSILON) == 0);
+        taa_mat44_from_trs(&t, &r, &one, palette + i);
+    }
+    for(i = 0; i < N; ++i)
+    {
+        float sum;
+        rand_vec3(pos + i);
+        rand_vec3(nrm + i);
+        taa_vec3_normalize(nrm + i, nrm + i);
+        rand_vec4(weights + i);
+        sum = weights[i].x + weights[i].y + weights[i].z + weights[i].w;
+        taa_vec4_scale(weights + i, 1.0f/sum, weights + i);
+        for(j = 0; j < 4; ++j)
+        {
+            indices[i*4 + j] = (uint16_t) (rand() % NUM_BONES);
+            indices8[i*4 + j] = (uint8_t) indices[i*4 + j];
+        }
+    }
+    taa_skin_lbs(palette, indices, weights, pos, nrm, N, pos2, nrm2);
+    for(i = 0; i < N; ++i)
+    {
+        const float* w = &weights[i].x;
+        taa_mat44 M;
+        taa_vec4 v;
+        taa_vec4 u;
+        taa_vec3 q;
+        memset(&M, 0, sizeof(M));
+        for(j = 0; j < 4; ++j)
+        {
+            taa_mat44 A;
+            taa_mat44_scale(palette + indices[i*4 + j], w[j], &A);
+            taa_mat44_add(&M, &A, &M);
+        }
+        taa_vec4_set(pos[i].x, pos[i].y, pos[i].z, 1.0f, &v);
+        taa_mat44_transform_vec4(&M, &v, &u);
+        taa_vec3_set(u.x, u.y, u.z, &q);
+        assert(cmp_vec3(&q, pos2 + i, 1e-5f) == 0);
+        taa_vec4_set(nrm[i].x, nrm[i].y, nrm[i].z, 0.0f, &v);
+        taa_mat44_transform_vec4(&M, &v, &u);
+        taa_vec3_set(u.x, u.y, u.z, &q);
+        taa_vec3_normalize(&q, &q);
+        assert(cmp_vec3(&q, nrm2 + i, 1e-5f) == 0);
     }
+    // 8 bit indices and split ranges produce identical results
+    taa_skin_lbs_u8(palette, indices8, weights, pos, nrm, N, pos3, nrm3);
+    assert(memcmp(pos2, pos3, sizeof(pos2)) == 0);
+    assert(memcmp(nrm2, nrm3, sizeof(nrm2)) == 0);
+    memset(pos3, 0, sizeof(pos3));
+    taa_skin_lbs_range(palette,indices,weights,pos,NULL,0,13,pos3,NULL);
+    taa_skin_lbs_range(palette,indices,weights,pos,NULL,13,N,pos3,NULL);
+    assert(memcmp(pos2, pos3, sizeof(pos2)) == 0);
+    memset(pos3, 0, sizeof(pos3));
+    memset(nrm3, 0, sizeof(nrm3));
+    taa_skin_lbs_u8_range(palette,indices8,weights,pos,nrm,0,13,pos3,nrm3);
+    taa_skin_lbs_u8_range(palette,indices8,weights,pos,nrm,13,N,pos3,nrm3);
+    assert(memcmp(pos2, pos3, sizeof(pos2)) == 0);
+    assert(memcmp(nrm2, nrm3, sizeof(nrm2)) == 0);
 }
 
-int main(int argc, char* argv[])
+static void test_hierarchy()
 {
-    printf("testing taa_vec3_normalize...");
-    fflush(stdout); 
-    test_vec3_normalize();
-    printf("pass\n");
-    printf("testing taa_vec4_normalize...");
-    fflush(stdout); 
-    test_vec4_normalize();
-    printf("pass\n");    
-    printf("testing taa_mat33_inverse...");
-    fflush(stdout);     
-    test_mat33_inverse();
-    printf("pass\n");
-    printf("testing taa_mat44_inverse...");
-    fflush(stdout);     
-    test_mat44_inverse();
-    printf("pass\n");
-    printf("testing taa_mat44_from_quat...");
-    fflush(stdout);     
-    test_mat44_from_quat();
-    printf("pass\n");
-    printf("testing taa_quat_from_mat44...");
-    fflush(stdout);     
-    test_quat_from_mat44();
-    printf("pass\n"); 
+    enum { N = 101 };
+    uint32_t perm[N];
+    uint32_t parents[N];
+    taa_vec4 t[N];
+    taa_quat r[N];
+    taa_vec4 s[N];
+    taa_mat44 world[N];
+    taa_mat44 expected[N];
+    taa_hierarchy h;
+    taa_mat44 M;
+    uint32_t subtree;
+    uint32_t count;
+    int err;
+    int i;
+    int j;
+    // random tree with parents stored after some of their children
+    for(i = 0; i < N; ++i)
+    {
+        perm[i] = i;
+    }
+    for(i = N - 1; i > 0; --i)
+    {
+        uint32_t tmp = perm[i];
+        j = rand() % (i + 1);
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    for(i = 0; i < N; ++i)
+    {
+        parents[perm[i]] = (i < 2) ? taa_HIERARCHY_ROOT : perm[rand() % i];
+        rand_vec4(t + i);
+        rand_quat(r + i);
+        taa_vec4_set(1.0f, 1.0f, 1.0f, 1.0f, s + i);
+    }
+    err = taa_hierarchy_create(parents, N, &h);
+    assert(err == 0);
+    assert(h.levels[h.numlevels] == N);
+    for(i = 0; i < N; ++i)
+    {
+        uint32_t node = h.order[i];
+        uint32_t p = parents[node];
+        // every parent is in an earlier level
+        for(j = 0; p != taa_HIERARCHY_ROOT && h.order[j] != p; ++j)
+        {
+            assert(j < i);
+        }
+    }
+    taa_hierarchy_set_local_trs_array(&h, t, r, s);
+    assert(taa_hierarchy_update(&h) == N);
+    assert(taa_hierarchy_update(&h) == 0);
+    for(i = 0; i < N; ++i)
+    {
+        uint32_t p = parents[i];
+        taa_mat44 A;
+        taa_mat44 B;
+        taa_mat44_from_trs(t + i, r + i, s + i, &A);
+        while(p != taa_HIERARCHY_ROOT)
+        {
+            taa_mat44_from_trs(t + p, r + p, s + p, &B);
+            taa_mat44_multiply(&B, &A, &M);
+            A = M;
+            p = parents[p];
+        }
+        assert(cmp_mat44(h.world + i, &A, 1e-4f) == 0);
+    }
+    // changing one node only recomputes its subtree
+    subtree = 0;
+    for(i = 0; i < N; ++i)
+    {
+        uint32_t p = i;
+        while(p != taa_HIERARCHY_ROOT && p != perm[5])
+        {
+            p = parents[p];
+        }
+        subtree += (p == perm[5]) ? 1 : 0;
+    }
+    taa_mat44_identity(&M);
+    taa_hierarchy_set_local(&h, perm[5], &M);
+    assert(taa_hierarchy_update(&h) == subtree);
+    assert(cmp_mat44(h.world + perm[5], h.world + parents[perm[5]], 0) == 0);
+    // updating each level in two ranges gives the same result
+    memcpy(world, h.world, sizeof(world));
+    rand_quat(r + perm[5]);
+    taa_mat44_from_trs(t + perm[5], r + perm[5], s + perm[5], &M);
+    taa_hierarchy_set_local(&h, perm[5], &M);
+    taa_hierarchy_update(&h);
+    memcpy(expected, h.world, sizeof(expected));
+    memcpy(h.world, world, sizeof(world));
+    taa_hierarchy_set_local(&h, perm[5], &M);
+    count = 0;
+    for(i = 0; i < (int) h.numlevels; ++i)
+    {
+        uint32_t mid = (h.levels[i] + h.levels[i + 1])/2;
+        count += taa_hierarchy_update_range(&h, mid, h.levels[i + 1]);
+        count += taa_hierarchy_update_range(&h, h.levels[i], mid);
+    }
+    taa_hierarchy_clear_dirty(&h);
+    assert(count == subtree);
+    assert(taa_hierarchy_update(&h) == 0);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_mat44(h.world + i, expected + i, 0.0f) == 0);
+    }
+    taa_hierarchy_destroy(&h);
+}
+
+static void test_frustum()
+{
+    enum { N = 203 };
+    taa_camera_desc desc[2];
+    taa_camera cam[2];
+    taa_frustum f;
+    taa_vec4 spheres[N];
+    taa_vec4 center[N];
+    taa_vec4 extent[N];
+    taa_mat44 obbs[N];
+    uint32_t smask[(N + 31)/32];
+    uint32_t amask[(N + 31)/32];
+    uint32_t omask[(N + 31)/32];
+    uint32_t indices[N];
+    uint32_t count;
+    int c;
+    int i;
+    int j;
+    for(c = 0; c < 2; ++c)
+    {
+        taa_vec4_set(1.0f, 2.0f, 3.0f, 1.0f, &desc[c].eye);
+        taa_vec4_set(1.0f, 2.0f, -7.0f, 1.0f, &desc[c].target);
+        taa_vec4_set(0.0f, 1.0f, 0.0f, 0.0f, &desc[c].up);
+        desc[c].fovy = 1.0f;
+        desc[c].aspect = 1.5f;
+        desc[c].znear = 0.5f;
+        desc[c].zfar = 20.0f;
+    }
+    desc[0].projection = taa_PROJECTION_PERSPECTIVE;
+    desc[1].projection = taa_PROJECTION_REVERSED;
+    taa_camera_build_array(desc, 2, cam);
+    for(i = 0; i < N; ++i)
+    {
+        taa_quat q;
+        taa_vec4 s;
+        taa_vec4_set(
+            (randf() - 0.5f) * 40.0f,
+            (randf() - 0.5f) * 40.0f,
+            (randf() - 0.5f) * 40.0f,
+            randf() * 2.0f,
+            spheres + i);
+        // every third sphere is a point
+        spheres[i].w = ((i % 3) == 0) ? 0.0f : spheres[i].w;
+        taa_vec4_set(spheres[i].x, spheres[i].y, spheres[i].z, 0.0f, center+i);
+        rand_vec4(extent + i);
+        extent[i].w = 0.0f;
+        rand_quat(&q);
+        taa_vec4_set(extent[i].x, extent[i].y, extent[i].z, 1.0f, &s);
+        taa_mat44_from_trs(center + i, &q, &s, obbs + i);
+    }
+    for(c = 0; c < 2; ++c)
+    {
+        taa_frustum_from_mat44(&cam[c].viewproj, c, &f);
+        taa_frustum_cull_spheres(&f, spheres, N, smask);
+        taa_frustum_cull_aabbs(&f, center, extent, N, amask);
+        taa_frustum_cull_obbs(&f, obbs, N, omask);
+        for(i = 0; i < N; ++i)
+        {
+            const taa_mat44* m = obbs + i;
+            int sbit = (smask[i >> 5] >> (i & 31)) & 1;
+            int abit = (amask[i >> 5] >> (i & 31)) & 1;
+            int obit = (omask[i >> 5] >> (i & 31)) & 1;
+            int svis = 1;
+            int avis = 1;
+            int ovis = 1;
+            float margin = FLT_MAX;
+            for(j = 0; j < taa_FRUSTUM_NUM_PLANES; ++j)
+            {
+                float d =
+                    f.x[j]*spheres[i].x +
+                    f.y[j]*spheres[i].y +
+                    f.z[j]*spheres[i].z +
+                    f.w[j];
+                float ra =
+                    fabsf(f.x[j])*extent[i].x +
+                    fabsf(f.y[j])*extent[i].y +
+                    fabsf(f.z[j])*extent[i].z;
+                float ro =
+                    fabsf(f.x[j]*m->x.x + f.y[j]*m->x.y + f.z[j]*m->x.z) +
+                    fabsf(f.x[j]*m->y.x + f.y[j]*m->y.y + f.z[j]*m->y.z) +
+                    fabsf(f.x[j]*m->z.x + f.y[j]*m->z.y + f.z[j]*m->z.z);
+                svis &= (-spheres[i].w > d) ? 0 : 1;
+                avis &= (d + ra >= 0.0f) ? 1 : 0;
+                ovis &= (d + ro >= 0.0f) ? 1 : 0;
+                margin = (fabsf(d + spheres[i].w) < margin) ?
+                    fabsf(d + spheres[i].w) : margin;
+            }
+            assert(sbit == svis);
+            assert(abit == avis);
+            assert(obit == ovis);
+            if(spheres[i].w == 0.0f && margin > 1e-3f)
+            {
+                // points agree with the clip space test
+                taa_vec4 v;
+                taa_vec4 p;
+                float zmin = (c == 0) ? -1.0f : 0.0f;
+                int clipvis;
+                taa_vec4_set(spheres[i].x,spheres[i].y,spheres[i].z,1.0f,&v);
+                taa_mat44_transform_vec4(&cam[c].viewproj, &v, &p);
+                clipvis =
+                    p.w > 0.0f &&
+                    fabsf(p.x) <= p.w &&
+                    fabsf(p.y) <= p.w &&
+                    p.z >= zmin*p.w && p.z <= p.w;
+                assert(sbit == clipvis);
+            }
+        }
+        count = taa_frustum_mask_to_indices(smask, N, indices);
+        for(i = 0, j = 0; i < N; ++i)
+        {
+            if((smask[i >> 5] >> (i & 31)) & 1)
+            {
+                assert(indices[j] == (uint32_t) i);
+                ++j;
+            }
+        }
+        assert(count == (uint32_t) j);
+        assert(count > 0 && count < N);
+    }
+    // the eye is outside, a point just in front of it is inside
+    taa_frustum_from_mat44(&cam[0].viewproj, 0, &f);
+    taa_vec4_set(1.0f, 2.0f, 3.0f, 0.0f, spheres);
+    taa_vec4_set(1.0f, 2.0f, 2.0f, 0.0f, spheres + 1);
+    taa_frustum_cull_spheres(&f, spheres, 2, smask);
+    assert(smask[0] == 2);
+}
+
+static void test_aabb()
+{
+    enum { N = 37 };
+    taa_mat44 m[N];
+    taa_aabb a[N];
+    taa_aabb b[N];
+    taa_aabb_minmax mm;
+    int i;
+    int j;
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 lo;
+        taa_vec4 hi;
+        rand_mat44(m + i);
+        for(j = 0; j < 16; ++j)
+        {
+            (&m[i].x.x)[j] = (&m[i].x.x)[j]*4.0f - 2.0f;
+        }
+        m[i].x.w = 0.0f;
+        m[i].y.w = 0.0f;
+        m[i].z.w = 0.0f;
+        m[i].w.w = 1.0f;
+        rand_vec4(&lo);
+        rand_vec4(&hi);
+        taa_vec4_set(lo.x - 1.0f, lo.y - 0.5f, lo.z - 2.0f, 0.0f, &mm.min);
+        taa_vec4_set(hi.x, hi.y + 0.5f, hi.z + 1.0f, 0.0f, &mm.max);
+        taa_aabb_from_minmax(&mm, a + i);
+        assert(a[i].center.w == 1.0f && a[i].extent.w == 0.0f);
+    }
+    taa_aabb_transform_array(m, a, N, b);
+    for(i = 0; i < N; ++i)
+    {
+        taa_aabb_minmax ref;
+        taa_aabb_minmax r;
+        taa_aabb single;
+        taa_aabb_to_minmax(a + i, &mm);
+        for(j = 0; j < 8; ++j)
+        {
+            taa_vec4 p;
+            taa_vec4 v;
+            p.x = (j & 1) ? mm.max.x : mm.min.x;
+            p.y = (j & 2) ? mm.max.y : mm.min.y;
+            p.z = (j & 4) ? mm.max.z : mm.min.z;
+            p.w = 1.0f;
+            taa_mat44_transform_vec4(m + i, &p, &v);
+            if(j == 0)
+            {
+                ref.min = v;
+                ref.max = v;
+            }
+            ref.min.x = (v.x < ref.min.x) ? v.x : ref.min.x;
+            ref.min.y = (v.y < ref.min.y) ? v.y : ref.min.y;
+            ref.min.z = (v.z < ref.min.z) ? v.z : ref.min.z;
+            ref.max.x = (v.x > ref.max.x) ? v.x : ref.max.x;
+            ref.max.y = (v.y > ref.max.y) ? v.y : ref.max.y;
+            ref.max.z = (v.z > ref.max.z) ? v.z : ref.max.z;
+        }
+        taa_aabb_to_minmax(b + i, &r);
+        ref.min.w = r.min.w;
+        ref.max.w = r.max.w;
+        assert(cmp_vec4(&r.min, &ref.min, 1e-4f) == 0);
+        assert(cmp_vec4(&r.max, &ref.max, 1e-4f) == 0);
+        assert(b[i].center.w == 1.0f && b[i].extent.w == 0.0f);
+        // the batched sums round differently from the single transform
+        taa_aabb_transform(m + i, a + i, &single);
+        assert(cmp_vec4(&single.center, &b[i].center, 1e-5f) == 0);
+        assert(cmp_vec4(&single.extent, &b[i].extent, 1e-5f) == 0);
+    }
+    // in place
+    taa_aabb_transform_array(m, a, N, a);
+    assert(memcmp(a, b, sizeof(a)) == 0);
+}
+
+static int ray_aabb_ref(
+    const taa_ray* r,
+    const taa_aabb_minmax* b,
+    float tmax,
+    float* t_out)
+{
+    float tn = 0.0f;
+    float tf = tmax;
+    int i;
+    for(i = 0; i < 3; ++i)
+    {
+        float t1 = ((&b->min.x)[i] - (&r->origin.x)[i]) * (&r->invdir.x)[i];
+        float t2 = ((&b->max.x)[i] - (&r->origin.x)[i]) * (&r->invdir.x)[i];
+        float tlo = (t1 < t2) ? t1 : t2;
+        float thi = (t1 > t2) ? t1 : t2;
+        tn = (tlo > tn) ? tlo : tn;
+        tf = (thi < tf) ? thi : tf;
+    }
+    *t_out = tn;
+    return tn <= tf;
+}
+
+static void test_ray_aabb()
+{
+    enum { N = 37 };
+    taa_ray rays[N];
+    taa_aabb_minmax boxes[N];
+    taa_aabbx4 boxes4[(N + 3)/4];
+    taa_rayx4 rays4[(N + 3)/4];
+    taa_vec4 t;
+    taa_vec4 tmax;
+    int nhits = 0;
+    int i;
+    int j;
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 o;
+        taa_vec4 d;
+        taa_vec4 lo;
+        taa_vec4 hi;
+        rand_vec4(&o);
+        rand_vec4(&d);
+        rand_vec4(&lo);
+        rand_vec4(&hi);
+        taa_vec4_set(o.x*8.0f-4.0f, o.y*8.0f-4.0f, o.z*8.0f-4.0f, 1.0f, &o);
+        taa_vec4_set(d.x-0.5f, d.y-0.5f, d.z-0.5f, 0.0f, &d);
+        if((i % 5) == 0)
+        {
+            // axis parallel rays exercise the zero direction reciprocal
+            d.y = 0.0f;
+        }
+        taa_ray_set(&o, &d, rays + i);
+        taa_vec4_set(lo.x*4-2.0f, lo.y*4-2.0f, lo.z*4-2.0f, 0.0f, &lo);
+        taa_vec4_set(lo.x+hi.x, lo.y+hi.y, lo.z+hi.z, 0.0f, &hi);
+        boxes[i].min = lo;
+        boxes[i].max = hi;
+    }
+    taa_aabbx4_from_minmax(boxes, N, boxes4);
+    taa_rayx4_from_rays(rays, N, rays4);
+    for(i = 0; i < N; ++i)
+    {
+        float tm = (i & 1) ? FLT_MAX : 3.0f;
+        for(j = 0; j < N; j += 4)
+        {
+            int nlanes = (N - j < 4) ? N - j : 4;
+            int mask = taa_ray_intersect_aabbx4(rays + i, boxes4 + j/4, tm, &t);
+            int k;
+            for(k = 0; k < nlanes; ++k)
+            {
+                float tref;
+                int hit = ray_aabb_ref(rays + i, boxes + j + k, tm, &tref);
+                assert(((mask >> k) & 1) == hit);
+                assert((&t.x)[k] == (hit ? tref : FLT_MAX));
+                nhits += hit;
+            }
+        }
+    }
+    assert(nhits > 0 && nhits < N*N);
+    taa_vec4_set(FLT_MAX, 3.0f, FLT_MAX, 2.0f, &tmax);
+    for(i = 0; i < N; i += 4)
+    {
+        int nlanes = (N - i < 4) ? N - i : 4;
+        for(j = 0; j < N; ++j)
+        {
+            int mask = taa_rayx4_intersect_aabb(rays4+i/4, boxes+j, &tmax, &t);
+            int k;
+            for(k = 0; k < nlanes; ++k)
+            {
+                float tref;
+                float tm = (&tmax.x)[k];
+                int hit = ray_aabb_ref(rays + i + k, boxes + j, tm, &tref);
+                assert(((mask >> k) & 1) == hit);
+                assert((&t.x)[k] == (hit ? tref : FLT_MAX));
+            }
+        }
+    }
+}
+
+static int ray_triangle_ref(
+    const taa_ray* r,
+    const taa_vec4* v0,
+    const taa_vec4* v1,
+    const taa_vec4* v2,
+    float* t_out,
+    float* u_out,
+    float* v_out)
+{
+    taa_vec3 e1;
+    taa_vec3 e2;
+    taa_vec3 d;
+    taa_vec3 tv;
+    taa_vec3 p;
+    taa_vec3 q;
+    float det;
+    float inv;
+    taa_vec3_set(v1->x - v0->x, v1->y - v0->y, v1->z - v0->z, &e1);
+    taa_vec3_set(v2->x - v0->x, v2->y - v0->y, v2->z - v0->z, &e2);
+    taa_vec3_set(r->dir.x, r->dir.y, r->dir.z, &d);
+    taa_vec3_set(
+        r->origin.x - v0->x,
+        r->origin.y - v0->y,
+        r->origin.z - v0->z,
+        &tv);
+    taa_vec3_cross(&d, &e2, &p);
+    taa_vec3_cross(&tv, &e1, &q);
+    det = taa_vec3_dot(&e1, &p);
+    inv = 1.0f/det;
+    *u_out = taa_vec3_dot(&tv, &p) * inv;
+    *v_out = taa_vec3_dot(&d, &q) * inv;
+    *t_out = taa_vec3_dot(&e2, &q) * inv;
+    return
+        fabs(det) >= FLT_MIN &&
+        *u_out >= 0.0f &&
+        *v_out >= 0.0f &&
+        *u_out + *v_out <= 1.0f &&
+        *t_out >= 0.0f;
+}
+
+static void test_ray_triangle()
+{
+    enum { N = 37 };
+    taa_vec4 pos[N*3];
+    uint32_t indices[N*3];
+    taa_trianglex4 tris[(N + 3)/4];
+    int nhits = 0;
+    int i;
+    int j;
+    for(i = 0; i < N*3; ++i)
+    {
+        rand_vec4(pos + i);
+        pos[i].x = pos[i].x*4.0f - 2.0f;
+        pos[i].y = pos[i].y*4.0f - 2.0f;
+        pos[i].z = pos[i].z*4.0f - 2.0f;
+        pos[i].w = 1.0f;
+        // reverse the winding of every other triangle
+        indices[i] = ((i/3) & 1) ? (i/3)*3 + 2 - (i%3) : i;
+    }
+    taa_trianglex4_from_indexed(pos, indices, N, tris);
+    for(i = 0; i < N; ++i)
+    {
+        const taa_vec4* a = pos + i*3;
+        taa_vec4 o;
+        taa_vec4 target;
+        taa_vec4 d;
+        taa_ray r;
+        taa_ray_hit hit;
+        taa_ray_hit ref;
+        float tmax = (i & 1) ? FLT_MAX : 2.0f;
+        int found;
+        int reffound = 0;
+        // aim at a point inside one of the triangles
+        taa_vec4_set(0.2f, 0.3f, 0.5f, 0.0f, &d);
+        taa_vec4_set(
+            a[0].x*d.x + a[1].x*d.y + a[2].x*d.z,
+            a[0].y*d.x + a[1].y*d.y + a[2].y*d.z,
+            a[0].z*d.x + a[1].z*d.y + a[2].z*d.z,
+            1.0f,
+            &target);
+        rand_vec4(&o);
+        taa_vec4_set(o.x*8-4.0f, o.y*8-4.0f, o.z*8-4.0f, 1.0f, &o);
+        taa_vec4_subtract(&target, &o, &d);
+        d.w = 0.0f;
+        taa_vec4_normalize(&d, &d);
+        taa_ray_set(&o, &d, &r);
+        memset(&ref, 0, sizeof(ref));
+        ref.t = tmax;
+        for(j = 0; j < N; ++j)
+        {
+            float t;
+            float u;
+            float v;
+            const taa_vec4* v0 = pos + indices[j*3 + 0];
+            const taa_vec4* v1 = pos + indices[j*3 + 1];
+            const taa_vec4* v2 = pos + indices[j*3 + 2];
+            if(ray_triangle_ref(&r, v0, v1, v2, &t, &u, &v) && t < ref.t)
+            {
+                ref.t = t;
+                ref.u = u;
+                ref.v = v;
+                ref.index = j;
+                reffound = 1;
+            }
+        }
+        memset(&hit, 0, sizeof(hit));
+        found = taa_ray_intersect_trianglex4(&r, tris, N, tmax, &hit);
+        assert(found == reffound);
+        if(found)
+        {
+            assert(hit.index == ref.index);
+            assert(cmp_scalar(hit.t, ref.t, 1e-4f) == 0);
+            assert(cmp_scalar(hit.u, ref.u, 1e-4f) == 0);
+            assert(cmp_scalar(hit.v, ref.v, 1e-4f) == 0);
+            ++nhits;
+        }
+        else
+        {
+            assert(hit.t == 0.0f && hit.index == 0);
+        }
+    }
+    assert(nhits > N/2);
+}
+
+static int cmp_uint32(
+    const void* a,
+    const void* b)
+{
+    uint32_t ua = *((const uint32_t*) a);
+    uint32_t ub = *((const uint32_t*) b);
+    return (ua > ub) - (ua < ub);
+}
+
+static void test_bvh()
+{
+    enum { N = 1000, Q = 50 };
+    taa_vec4* pos = (taa_vec4*) malloc(N*3*sizeof(*pos) + 16);
+    taa_aabb_minmax* bounds = (taa_aabb_minmax*) malloc(N*sizeof(*bounds)+16);
+    taa_bvh_task* tasks = (taa_bvh_task*) malloc(N*sizeof(*tasks));
+    uint32_t* tri = (uint32_t*) malloc(N*3*sizeof(*tri));
+    uint32_t* found = (uint32_t*) malloc(N*sizeof(*found));
+    uint32_t* ref = (uint32_t*) malloc(N*sizeof(*ref));
+    taa_bvh bvh[2];
+    uint32_t numtasks;
+    uint32_t nhits = 0;
+    uint32_t nfound = 0;
+    int b;
+    int i;
+    int j;
+    // align the arrays to 16 bytes
+    taa_vec4* p = (taa_vec4*) ((((size_t) pos) + 15) & ~((size_t) 15));
+    taa_aabb_minmax* bb = (taa_aabb_minmax*) (
+        (((size_t) bounds) + 15) & ~((size_t) 15));
+    // small triangles, clustered to give the heuristic something to do
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 c;
+        rand_vec4(&c);
+        c.x = c.x*c.x*20.0f - 10.0f;
+        c.y = c.y*20.0f - 10.0f;
+        c.z = (i & 1) ? c.z*2.0f : c.z*20.0f - 10.0f;
+        bb[i].min = c;
+        bb[i].max = c;
+        for(j = 0; j < 3; ++j)
+        {
+            taa_vec4* v = p + i*3 + j;
+            rand_vec4(v);
+            v->x = c.x + v->x - 0.5f;
+            v->y = c.y + v->y - 0.5f;
+            v->z = c.z + v->z - 0.5f;
+            v->w = 1.0f;
+            bb[i].min.x = (v->x < bb[i].min.x) ? v->x : bb[i].min.x;
+            bb[i].min.y = (v->y < bb[i].min.y) ? v->y : bb[i].min.y;
+            bb[i].min.z = (v->z < bb[i].min.z) ? v->z : bb[i].min.z;
+            bb[i].max.x = (v->x > bb[i].max.x) ? v->x : bb[i].max.x;
+            bb[i].max.y = (v->y > bb[i].max.y) ? v->y : bb[i].max.y;
+            bb[i].max.z = (v->z > bb[i].max.z) ? v->z : bb[i].max.z;
+            tri[i*3 + j] = i*3 + j;
+        }
+    }
+    assert(taa_bvh_create(N, 4, bvh + 0) == 0);
+    assert(taa_bvh_create(N, 3, bvh + 1) == 0);
+    taa_bvh_build(bvh + 0, bb);
+    // build the second hierarchy as tasks, in reverse order
+    numtasks = taa_bvh_build_top(bvh + 1, bb, 64, tasks);
+    assert(numtasks > 1);
+    for(i = (int) numtasks - 1; i >= 0; --i)
+    {
+        taa_bvh_build_task(bvh + 1, tasks + i);
+    }
+    for(b = 0; b < 2; ++b)
+    {
+        const taa_bvh* h = bvh + b;
+        // every primitive appears in exactly one leaf
+        memcpy(found, h->indices, N*sizeof(*found));
+        qsort(found, N, sizeof(*found), cmp_uint32);
+        for(i = 0; i < N; ++i)
+        {
+            assert(found[i] == (uint32_t) i);
+        }
+        for(i = 0; i < Q; ++i)
+        {
+            taa_aabb_minmax box;
+            taa_vec4 sphere;
+            taa_vec4 o;
+            taa_vec4 d;
+            taa_ray r;
+            taa_ray_hit hit;
+            taa_ray_hit hitref;
+            uint32_t count;
+            uint32_t nref;
+            int k;
+            rand_vec4(&o);
+            rand_vec4(&d);
+            taa_vec4_set(o.x*20-10.0f, o.y*20-10.0f, o.z*20-10.0f, 0.0f, &o);
+            box.min = o;
+            taa_vec4_set(o.x+d.x*4, o.y+d.y*4, o.z+d.z*4, 0.0f, &box.max);
+            sphere = o;
+            sphere.w = d.w * 3.0f;
+            // box query
+            count = taa_bvh_query_aabb(h, &box, found, N);
+            nref = 0;
+            for(j = 0; j < N; ++j)
+            {
+                if(!(bb[j].min.x > box.max.x || box.min.x > bb[j].max.x ||
+                     bb[j].min.y > box.max.y || box.min.y > bb[j].max.y ||
+                     bb[j].min.z > box.max.z || box.min.z > bb[j].max.z))
+                {
+                    ref[nref++] = j;
+                }
+            }
+            assert(count == nref);
+            qsort(found, count, sizeof(*found), cmp_uint32);
+            assert(memcmp(found, ref, count*sizeof(*found)) == 0);
+            // sphere query
+            count = taa_bvh_query_sphere(h, &sphere, found, N);
+            nref = 0;
+            for(j = 0; j < N; ++j)
+            {
+                float d2 = 0.0f;
+                for(k = 0; k < 3; ++k)
+                {
+                    float c = (&sphere.x)[k];
+                    float lo = (&bb[j].min.x)[k] - c;
+                    float hi = c - (&bb[j].max.x)[k];
+                    lo = (lo > 0.0f) ? lo : 0.0f;
+                    hi = (hi > 0.0f) ? hi : 0.0f;
+                    d2 += (lo + hi)*(lo + hi);
+                }
+                if(!(d2 > sphere.w*sphere.w))
+                {
+                    ref[nref++] = j;
+                }
+            }
+            assert(count == nref);
+            qsort(found, count, sizeof(*found), cmp_uint32);
+            assert(memcmp(found, ref, count*sizeof(*found)) == 0);
+            // ray queries
+            taa_vec4_set(d.x - 0.5f, d.y - 0.5f, d.z - 0.5f, 0.0f, &d);
+            taa_vec4_normalize(&d, &d);
+            taa_ray_set(&o, &d, &r);
+            count = taa_bvh_query_ray(h, &r, 15.0f, found, N);
+            nref = 0;
+            for(j = 0; j < N; ++j)
+            {
+                float t;
+                if(ray_aabb_ref(&r, bb + j, 15.0f, &t))
+                {
+                    ref[nref++] = j;
+                }
+            }
+            assert(count == nref);
+            qsort(found, count, sizeof(*found), cmp_uint32);
+            assert(memcmp(found, ref, count*sizeof(*found)) == 0);
+            nfound += count;
+            memset(&hitref, 0, sizeof(hitref));
+            hitref.t = 15.0f;
+            for(j = 0; j < N; ++j)
+            {
+                float t;
+                float u;
+                float v;
+                if(ray_triangle_ref(
+                    &r,
+                    p + j*3,
+                    p + j*3 + 1,
+                    p + j*3 + 2,
+                    &t,
+                    &u,
+                    &v) && t < hitref.t)
+                {
+                    hitref.t = t;
+                    hitref.index = j;
+                }
+            }
+            memset(&hit, 0, sizeof(hit));
+            hit.t = 15.0f;
+            nhits += taa_bvh_intersect_ray_triangles(h,&r,p,tri,15.0f,&hit);
+            assert(hit.index == hitref.index);
+            assert(cmp_scalar(hit.t, hitref.t, 1e-4f) == 0);
+        }
+    }
+    assert(nfound > 0 && nhits > 0);
+    // an empty hierarchy never reports anything
+    taa_bvh_destroy(bvh + 1);
+    assert(taa_bvh_create(0, 4, bvh + 1) == 0);
+    taa_bvh_build(bvh + 1, bb);
+    assert(taa_bvh_query_aabb(bvh + 1, bb, found, N) == 0);
+    taa_bvh_destroy(bvh + 0);
+    taa_bvh_destroy(bvh + 1);
+    free(pos);
+    free(bounds);
+    free(tasks);
+    free(tri);
+    free(found);
+    free(ref);
+}
+
+static void test_sphere()
+{
+    enum { N = 1001, C = 100 };
+    taa_vec3* v = (taa_vec3*) malloc(N * sizeof(*v));
+    taa_vec4 chunks[(N + C - 1)/C];
+    taa_vec4 s;
+    taa_vec4 m;
+    taa_vec3 mn;
+    taa_vec3 mx;
+    float boxr;
+    int n;
+    int i;
+    int j;
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 q;
+        rand_vec4(&q);
+        v[i].x = (q.x - 0.5f) * 10.0f + 3.0f;
+        v[i].y = (q.y - 0.5f) * 4.0f - 1.0f;
+        v[i].z = (q.z - 0.5f) * (q.w - 0.5f) * 6.0f;
+    }
+    // try several lengths to exercise partial blocks
+    for(n = 1; n <= N; n += 125)
+    {
+        taa_sphere_from_points(v, n, &s);
+        mn = v[0];
+        mx = v[0];
+        for(i = 0; i < n; ++i)
+        {
+            float dx = v[i].x - s.x;
+            float dy = v[i].y - s.y;
+            float dz = v[i].z - s.z;
+            assert(sqrtf(dx*dx + dy*dy + dz*dz) <= s.w*1.0001f + 1e-6f);
+            mn.x = (v[i].x < mn.x) ? v[i].x : mn.x;
+            mn.y = (v[i].y < mn.y) ? v[i].y : mn.y;
+            mn.z = (v[i].z < mn.z) ? v[i].z : mn.z;
+            mx.x = (v[i].x > mx.x) ? v[i].x : mx.x;
+            mx.y = (v[i].y > mx.y) ? v[i].y : mx.y;
+            mx.z = (v[i].z > mx.z) ? v[i].z : mx.z;
+        }
+        // never worse than the sphere around the bounding box
+        taa_vec3_subtract(&mx, &mn, &mx);
+        boxr = taa_vec3_length(&mx) * 0.5f;
+        assert(s.w <= boxr*1.0001f);
+    }
+    // bound chunks separately and merge them
+    for(i = 0; i < N; i += C)
+    {
+        taa_sphere_from_points(v + i, (N - i < C) ? N - i : C, chunks + i/C);
+    }
+    taa_sphere_merge_array(chunks, (N + C - 1)/C, &m);
+    for(i = 0; i < (N + C - 1)/C; ++i)
+    {
+        float dx = chunks[i].x - m.x;
+        float dy = chunks[i].y - m.y;
+        float dz = chunks[i].z - m.z;
+        assert(sqrtf(dx*dx+dy*dy+dz*dz) + chunks[i].w <= m.w*1.0001f);
+    }
+    for(i = 0; i < N; ++i)
+    {
+        float dx = v[i].x - m.x;
+        float dy = v[i].y - m.y;
+        float dz = v[i].z - m.z;
+        assert(sqrtf(dx*dx + dy*dy + dz*dz) <= m.w*1.0001f);
+    }
+    // merging with a contained sphere returns the outer sphere
+    taa_vec4_set(s.x + s.w*0.25f, s.y, s.z, s.w*0.5f, &m);
+    taa_sphere_merge(&s, &m, &m);
+    assert(memcmp(&m, &s, sizeof(m)) == 0);
+    // disjoint spheres touch the merged sphere on opposite sides
+    for(j = 0; j < NUM_TEST_LOOPS; ++j)
+    {
+        taa_vec4 a;
+        taa_vec4 b;
+        float da;
+        float db;
+        rand_vec4(&a);
+        rand_vec4(&b);
+        b.x += 2.0f;
+        taa_sphere_merge(&a, &b, &m);
+        da = sqrtf((a.x-m.x)*(a.x-m.x)+(a.y-m.y)*(a.y-m.y)+(a.z-m.z)*(a.z-m.z));
+        db = sqrtf((b.x-m.x)*(b.x-m.x)+(b.y-m.y)*(b.y-m.y)+(b.z-m.z)*(b.z-m.z));
+        assert(cmp_scalar(da + a.w, m.w, 1e-4f) == 0);
+        assert(cmp_scalar(db + b.w, m.w, 1e-4f) == 0);
+    }
+    free(v);
+}
+
+static void closest_point_triangle_ref(
+    const taa_vec3* p,
+    const taa_vec3* a,
+    const taa_vec3* b,
+    const taa_vec3* c,
+    taa_vec3* closest_out)
+{
+    taa_vec3 ab;
+    taa_vec3 ac;
+    taa_vec3 ap;
+    taa_vec3 bp;
+    taa_vec3 cp;
+    double d1;
+    double d2;
+    double d3;
+    double d4;
+    double d5;
+    double d6;
+    double va;
+    double vb;
+    double vc;
+    double s;
+    double t;
+    taa_vec3_subtract(b, a, &ab);
+    taa_vec3_subtract(c, a, &ac);
+    taa_vec3_subtract(p, a, &ap);
+    taa_vec3_subtract(p, b, &bp);
+    taa_vec3_subtract(p, c, &cp);
+    d1 = taa_vec3_dot(&ab, &ap);
+    d2 = taa_vec3_dot(&ac, &ap);
+    d3 = taa_vec3_dot(&ab, &bp);
+    d4 = taa_vec3_dot(&ac, &bp);
+    d5 = taa_vec3_dot(&ab, &cp);
+    d6 = taa_vec3_dot(&ac, &cp);
+    vc = d1*d4 - d3*d2;
+    vb = d5*d2 - d1*d6;
+    va = d3*d6 - d5*d4;
+    if(d1 <= 0.0 && d2 <= 0.0)
+    {
+        s = 0.0;
+        t = 0.0;
+    }
+    else if(d3 >= 0.0 && d4 <= d3)
+    {
+        s = 1.0;
+        t = 0.0;
+    }
+    else if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        s = d1/(d1 - d3);
+        t = 0.0;
+    }
+    else if(d6 >= 0.0 && d5 <= d6)
+    {
+        s = 0.0;
+        t = 1.0;
+    }
+    else if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        s = 0.0;
+        t = d2/(d2 - d6);
+    }
+    else if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+        t = (d4 - d3)/((d4 - d3) + (d5 - d6));
+        s = 1.0 - t;
+    }
+    else
+    {
+        s = vb/(va + vb + vc);
+        t = vc/(va + vb + vc);
+    }
+    closest_out->x = (float) (a->x + ab.x*s + ac.x*t);
+    closest_out->y = (float) (a->y + ab.y*s + ac.y*t);
+    closest_out->z = (float) (a->z + ab.z*s + ac.z*t);
+}
+
+static double closest_segment_segment_ref(
+    const taa_vec3* p1,
+    const taa_vec3* q1,
+    const taa_vec3* p2,
+    const taa_vec3* q2)
+{
+    double d1[3];
+    double d2[3];
+    double r[3];
+    double a = 0.0;
+    double b = 0.0;
+    double c = 0.0;
+    double e = 0.0;
+    double f = 0.0;
+    double s;
+    double t;
+    double dist2 = 0.0;
+    int i;
+    for(i = 0; i < 3; ++i)
+    {
+        d1[i] = (&q1->x)[i] - (&p1->x)[i];
+        d2[i] = (&q2->x)[i] - (&p2->x)[i];
+        r[i] = (&p1->x)[i] - (&p2->x)[i];
+        a += d1[i]*d1[i];
+        b += d1[i]*d2[i];
+        c += d1[i]*r[i];
+        e += d2[i]*d2[i];
+        f += d2[i]*r[i];
+    }
+    if(a <= 1e-12 && e <= 1e-12)
+    {
+        s = 0.0;
+        t = 0.0;
+    }
+    else if(a <= 1e-12)
+    {
+        s = 0.0;
+        t = f/e;
+        t = (t < 0.0) ? 0.0 : (t > 1.0) ? 1.0 : t;
+    }
+    else if(e <= 1e-12)
+    {
+        t = 0.0;
+        s = -c/a;
+        s = (s < 0.0) ? 0.0 : (s > 1.0) ? 1.0 : s;
+    }
+    else
+    {
+        double denom = a*e - b*b;
+        s = (denom > 1e-12*a*e) ? (b*f - c*e)/denom : 0.0;
+        s = (s < 0.0) ? 0.0 : (s > 1.0) ? 1.0 : s;
+        t = (b*s + f)/e;
+        if(t < 0.0 || t > 1.0)
+        {
+            t = (t < 0.0) ? 0.0 : 1.0;
+            s = (b*t - c)/a;
+            s = (s < 0.0) ? 0.0 : (s > 1.0) ? 1.0 : s;
+        }
+    }
+    for(i = 0; i < 3; ++i)
+    {
+        double d = r[i] + d1[i]*s - d2[i]*t;
+        dist2 += d*d;
+    }
+    return dist2;
+}
+
+static void test_closest()
+{
+    enum { N = 37 };
+    taa_vec4 pos[N*3];
+    uint32_t indices[N*3];
+    taa_vec4 sp[N];
+    taa_vec4 sq[N];
+    taa_trianglex4 tris[(N + 3)/4];
+    taa_segmentx4 segs[(N + 3)/4];
+    taa_vec3x4 c1;
+    taa_vec3x4 c2;
+    taa_vec4 dist2;
+    int i;
+    int j;
+    int k;
+    for(i = 0; i < N*3; ++i)
+    {
+        rand_vec4(pos + i);
+        pos[i].x = pos[i].x*4.0f - 2.0f;
+        pos[i].y = pos[i].y*4.0f - 2.0f;
+        pos[i].z = pos[i].z*4.0f - 2.0f;
+        pos[i].w = 1.0f;
+        indices[i] = i;
+    }
+    for(i = 0; i < N; ++i)
+    {
+        sp[i] = pos[i*3];
+        sq[i] = pos[i*3 + 1];
+    }
+    // a zero length segment and one parallel to the first
+    sq[3] = sp[3];
+    sq[5].x = sp[5].x + (sq[0].x - sp[0].x)*0.5f;
+    sq[5].y = sp[5].y + (sq[0].y - sp[0].y)*0.5f;
+    sq[5].z = sp[5].z + (sq[0].z - sp[0].z)*0.5f;
+    taa_trianglex4_from_indexed(pos, indices, N, tris);
+    taa_segmentx4_from_points(sp, sq, N, segs);
+    for(i = 0; i < N; ++i)
+    {
+        taa_vec4 p;
+        taa_vec3 p3;
+        rand_vec4(&p);
+        taa_vec4_set(p.x*6-3.0f, p.y*6-3.0f, p.z*6-3.0f, 1.0f, &p);
+        taa_vec3_set(p.x, p.y, p.z, &p3);
+        for(j = 0; j < N; j += 4)
+        {
+            int nlanes = (N - j < 4) ? N - j : 4;
+            taa_closest_point_trianglex4(&p, tris + j/4, &c1, &dist2);
+            for(k = 0; k < nlanes; ++k)
+            {
+                const taa_vec4* v = pos + (j + k)*3;
+                taa_vec3 a;
+                taa_vec3 b;
+                taa_vec3 c;
+                taa_vec3 ref;
+                taa_vec3 got;
+                taa_vec3 d;
+                float d2;
+                taa_vec3_set(v[0].x, v[0].y, v[0].z, &a);
+                taa_vec3_set(v[1].x, v[1].y, v[1].z, &b);
+                taa_vec3_set(v[2].x, v[2].y, v[2].z, &c);
+                closest_point_triangle_ref(&p3, &a, &b, &c, &ref);
+                taa_vec3_set(c1.x[k], c1.y[k], c1.z[k], &got);
+                assert(cmp_vec3(&got, &ref, 1e-4f) == 0);
+                taa_vec3_subtract(&p3, &got, &d);
+                d2 = taa_vec3_dot(&d, &d);
+                assert(cmp_scalar((&dist2.x)[k], d2, 1e-4f) == 0);
+            }
+        }
+    }
+    for(i = 0; i < N; ++i)
+    {
+        // include a zero length query
+        taa_vec4 q = (i == 7) ? sp[i] : sq[i];
+        taa_vec3 p1;
+        taa_vec3 q1;
+        taa_vec3_set(sp[i].x, sp[i].y, sp[i].z, &p1);
+        taa_vec3_set(q.x, q.y, q.z, &q1);
+        for(j = 0; j < N; j += 4)
+        {
+            int nlanes = (N - j < 4) ? N - j : 4;
+            taa_closest_segment_segmentx4(
+                sp + i,
+                &q,
+                segs + j/4,
+                &c1,
+                &c2,
+                &dist2);
+            for(k = 0; k < nlanes; ++k)
+            {
+                taa_vec3 p2;
+                taa_vec3 q2;
+                taa_vec3 d;
+                double ref;
+                taa_vec3_set(sp[j+k].x, sp[j+k].y, sp[j+k].z, &p2);
+                taa_vec3_set(sq[j+k].x, sq[j+k].y, sq[j+k].z, &q2);
+                ref = closest_segment_segment_ref(&p1, &q1, &p2, &q2);
+                assert(cmp_scalar((&dist2.x)[k], (float) ref, 1e-4f) == 0);
+                d.x = c1.x[k] - c2.x[k];
+                d.y = c1.y[k] - c2.y[k];
+                d.z = c1.z[k] - c2.z[k];
+                ref = taa_vec3_dot(&d, &d);
+                assert(cmp_scalar((&dist2.x)[k], (float) ref, 1e-4f) == 0);
+            }
+        }
+    }
+}
+
+static void test_mesh()
+{
+    enum { G = 9, NV = G*G, NT = (G - 1)*(G - 1)*2 };
+    taa_vec3 pos[NV];
+    taa_vec2 uv[NV];
+    uint32_t indices[NT*3];
+    taa_vec3 fn[NT];
+    taa_vec4 ft[NT];
+    taa_vec3 nrm[NV];
+    taa_vec3 nrm_range[NV];
+    taa_vec4 tan[NV];
+    taa_vec4 tan_range[NV];
+    taa_mesh_adjacency adj;
+    uint32_t i;
+    int loop;
+    int err;
+    for(i = 0; i < (G - 1)*(G - 1); ++i)
+    {
+        uint32_t v = (i/(G - 1))*G + (i%(G - 1));
+        indices[i*6 + 0] = v;
+        indices[i*6 + 1] = v + 1;
+        indices[i*6 + 2] = v + G + 1;
+        indices[i*6 + 3] = v;
+        indices[i*6 + 4] = v + G + 1;
+        indices[i*6 + 5] = v + G;
+    }
+    err = taa_mesh_adjacency_create(indices, NT, NV, &adj);
+    assert(err == 0);
+    for(i = 0; i < NV; ++i)
+    {
+        assert(adj.offsets[i] <= adj.offsets[i + 1]);
+    }
+    assert(adj.offsets[NV] == NT*3);
+    for(loop = 0; loop < 3; ++loop)
+    {
+        // flat, mirrored flat, then a random height field
+        for(i = 0; i < NV; ++i)
+        {
+            pos[i].x = (float) (i%G);
+            pos[i].y = (float) (i/G);
+            pos[i].z = (loop == 2) ? randf() : 0.0f;
+            uv[i].x = pos[i].x * ((loop == 1) ? -0.125f : 0.125f);
+            uv[i].y = pos[i].y * 0.125f;
+        }
+        taa_mesh_normals(pos, NV, indices, NT, nrm);
+        taa_mesh_tangents(pos, nrm, uv, NV, indices, NT, tan);
+        // compute the same result by face and vertex ranges
+        taa_mesh_face_normals(pos, indices, 37, fn);
+        taa_mesh_face_normals(pos, indices + 37*3, NT - 37, fn + 37);
+        taa_mesh_face_tangents(pos, uv, indices, 37, ft);
+        taa_mesh_face_tangents(pos, uv, indices + 37*3, NT - 37, ft + 37);
+        for(i = 0; i < NV; i += 7)
+        {
+            uint32_t end = (i + 7 < NV) ? i + 7 : NV;
+            taa_mesh_vertex_normals_range(fn, &adj, i, end, nrm_range);
+        }
+        for(i = 0; i < NV; i += 5)
+        {
+            uint32_t end = (i + 5 < NV) ? i + 5 : NV;
+            taa_mesh_vertex_tangents_range(
+                nrm_range,
+                ft,
+                &adj,
+                i,
+                end,
+                tan_range);
+        }
+        for(i = 0; i < NT; ++i)
+        {
+            // compare face normals against a scalar cross product
+            const taa_vec3* p0 = pos + indices[i*3 + 0];
+            const taa_vec3* p1 = pos + indices[i*3 + 1];
+            const taa_vec3* p2 = pos + indices[i*3 + 2];
+            float e1[3];
+            float e2[3];
+            e1[0] = p1->x - p0->x;
+            e1[1] = p1->y - p0->y;
+            e1[2] = p1->z - p0->z;
+            e2[0] = p2->x - p0->x;
+            e2[1] = p2->y - p0->y;
+            e2[2] = p2->z - p0->z;
+            assert(cmp_scalar(fn[i].x, e1[1]*e2[2] - e1[2]*e2[1], 1e-5f) == 0);
+            assert(cmp_scalar(fn[i].y, e1[2]*e2[0] - e1[0]*e2[2], 1e-5f) == 0);
+            assert(cmp_scalar(fn[i].z, e1[0]*e2[1] - e1[1]*e2[0], 1e-5f) == 0);
+        }
+        for(i = 0; i < NV; ++i)
+        {
+            const taa_vec3* n = nrm + i;
+            const taa_vec4* t = tan + i;
+            float len = sqrtf(n->x*n->x + n->y*n->y + n->z*n->z);
+            float d = n->x*t->x + n->y*t->y + n->z*t->z;
+            assert(cmp_scalar(len, 1.0f, 1e-5f) == 0);
+            assert(n->z > 0.0f);
+            len = sqrtf(t->x*t->x + t->y*t->y + t->z*t->z);
+            assert(cmp_scalar(len, 1.0f, 1e-5f) == 0);
+            assert(cmp_scalar(d, 0.0f, 1e-5f) == 0);
+            assert(t->w == 1.0f || t->w == -1.0f);
+            assert(cmp_scalar(nrm_range[i].x, n->x, 1e-5f) == 0);
+            assert(cmp_scalar(nrm_range[i].y, n->y, 1e-5f) == 0);
+            assert(cmp_scalar(nrm_range[i].z, n->z, 1e-5f) == 0);
+            assert(cmp_vec4(tan_range + i, t, 1e-5f) == 0);
+            if(loop < 2)
+            {
+                float s = (loop == 1) ? -1.0f : 1.0f;
+                assert(cmp_scalar(n->x, 0.0f, 1e-6f) == 0);
+                assert(cmp_scalar(n->y, 0.0f, 1e-6f) == 0);
+                assert(cmp_scalar(t->x, s, 1e-6f) == 0);
+                assert(cmp_scalar(t->y, 0.0f, 1e-6f) == 0);
+                assert(t->w == s);
+            }
+            else
+            {
+                // the u direction follows x on the height field
+                assert(t->x > 0.0f && t->w == 1.0f);
+            }
+        }
+    }
+    taa_mesh_adjacency_destroy(&adj);
+}
+
+static void test_hashgrid()
+{
+    enum { N = 2000, R = 3, Q = 64, CELLS = 1024 };
+    taa_vec3* points = (taa_vec3*) malloc(N * sizeof(*points));
+    uint32_t* counts = (uint32_t*) malloc(R * CELLS * sizeof(*counts));
+    uint32_t* counts1 = counts + CELLS;
+    uint32_t* counts2 = counts + CELLS*2;
+    uint32_t total = 0;
+    uint32_t found[N];
+    uint32_t ref[N];
+    taa_hashgrid grid;
+    taa_hashgrid grid_range;
+    uint32_t i;
+    int err;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec3(points + i);
+        points[i].x = points[i].x*2.0f - 1.0f;
+    }
+    err = taa_hashgrid_create(N, CELLS - 1, &grid);
+    assert(err == 0);
+    assert(grid.numcells == CELLS);
+    err = taa_hashgrid_create(N, CELLS, &grid_range);
+    assert(err == 0);
+    taa_hashgrid_build(&grid, points, N, 0.1f);
+    // build the same grid from unequal ranges
+    memset(counts, 0, R * CELLS * sizeof(*counts));
+    taa_hashgrid_reset(&grid_range, N, 0.1f);
+    taa_hashgrid_count_range(&grid_range, points, 0, 100, counts);
+    taa_hashgrid_count_range(&grid_range, points, 100, 1500, counts1);
+    taa_hashgrid_count_range(&grid_range, points, 1500, N, counts2);
+    taa_hashgrid_offsets(&grid_range, counts, R);
+    taa_hashgrid_scatter_range(&grid_range, points, 1500, N, counts2);
+    taa_hashgrid_scatter_range(&grid_range, points, 0, 100, counts);
+    taa_hashgrid_scatter_range(&grid_range, points, 100, 1500, counts1);
+    for(i = 0; i <= CELLS; ++i)
+    {
+        assert(grid.cellstart[i] == grid_range.cellstart[i]);
+    }
+    for(i = 0; i < N; ++i)
+    {
+        const taa_vec3* p = points + grid.indices[i];
+        assert(grid.indices[i] == grid_range.indices[i]);
+        assert(grid.points[i].x == p->x);
+        assert(grid.points[i].y == p->y);
+        assert(grid.points[i].z == p->z);
+    }
+    for(i = 0; i < Q; ++i)
+    {
+        float radius = (i & 1) ? 0.1f : 0.06f;
+        taa_vec3 p;
+        uint32_t numfound;
+        uint32_t numref = 0;
+        uint32_t j;
+        if(i < Q/2)
+        {
+            p = points[i*31];
+        }
+        else
+        {
+            rand_vec3(&p);
+            p.x = p.x*2.0f - 1.0f;
+        }
+        for(j = 0; j < N; ++j)
+        {
+            float dx = points[j].x - p.x;
+            float dy = points[j].y - p.y;
+            float dz = points[j].z - p.z;
+            if(dx*dx + dy*dy + dz*dz <= radius*radius)
+            {
+                ref[numref++] = j;
+            }
+        }
+        numfound = taa_hashgrid_query(&grid, &p, radius, found, N);
+        assert(numfound == numref);
+        total += numfound;
+        qsort(found, numfound, sizeof(*found), cmp_uint32);
+        for(j = 0; j < numref; ++j)
+        {
+            assert(found[j] == ref[j]);
+        }
+        if(numref > 1)
+        {
+            // results past maxresults are counted but not written
+            found[1] = 0xffffffff;
+            numfound = taa_hashgrid_query(&grid, &p, radius, found, 1);
+            assert(numfound == numref);
+            assert(found[1] == 0xffffffff);
+        }
+    }
+    assert(total > Q*2);
+    taa_hashgrid_destroy(&grid_range);
+    taa_hashgrid_destroy(&grid);
+    free(counts);
+    free(points);
+}
+
+static void test_mat44_from_quat()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS; ++i)
+    {
+        float rad = randf() * taa_PI * 0.5f;
+        taa_quat q;
+        taa_mat44 M;
+        taa_vec4 axis;
+        taa_vec4 t;
+        taa_vec4 u;
+        taa_vec4 v;
+        rand_vec4(&t);
+        rand_vec4(&axis);
+        axis.w = 0.0f;
+        taa_vec4_normalize(&axis, &axis);
+        taa_quat_axisangle(rad, &axis, &q);
+        taa_mat44_from_quat(&q, &M);
+        taa_quat_transform_vec4(&q, &t, &u);
+        taa_mat44_transform_vec4(&M, &t, &v);
+        assert(cmp_vec4(&u, &v, TEST_EPSILON) == 0);
+    }
+}
+
+static void test_quat_from_mat44()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS; ++i)
+    {
+        float rad = randf() * taa_PI * 0.5f;
+        taa_quat q;
+        taa_mat44 M;
+        taa_vec4 axis;
+        taa_vec4 t;
+        taa_vec4 u;
+        taa_vec4 v;
+        rand_vec4(&t);
+        rand_vec4(&axis);
+        axis.w = 0.0f;
+        taa_vec4_normalize(&axis, &axis);
+        taa_mat44_axisangle(rad, &axis, &M);
+        taa_quat_from_mat44(&M, &q);
+        taa_mat44_transform_vec4(&M, &t, &u);
+        taa_quat_transform_vec4(&q, &t, &v);
+        assert(cmp_vec4(&u, &v, TEST_EPSILON) == 0);
+    }
+}
+
+static void test_quat_mat_array()
+{
+    enum { N = 37 };
+    taa_quat q[N];
+    taa_quat p[N];
+    taa_mat33 A[N];
+    taa_mat44 B[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_quat(q + i);
+    }
+    taa_mat33_from_quat_array(q, N, A);
+    taa_mat44_from_quat_array(q, N, B);
+    for(i = 0; i < N; ++i)
+    {
+        taa_mat33 a;
+        taa_mat44 b;
+        taa_mat33_from_quat(q + i, &a);
+        taa_mat44_from_quat(q + i, &b);
+        assert(cmp_mat33(A + i, &a, TEST_EPSILON) == 0);
+        assert(cmp_mat44(B + i, &b, TEST_EPSILON) == 0);
+    }
+    // the rotations span every case of the conversion, and the result
+    // matches the single version, and the source rotation up to sign
+    taa_quat_from_mat33_array(A, N, p);
+    for(i = 0; i < N; ++i)
+    {
+        taa_quat r;
+        taa_quat_from_mat33(A + i, &r);
+        assert(cmp_vec4(p + i, &r, TEST_EPSILON) == 0);
+        assert(cmp_scalar(fabs(taa_vec4_dot(p+i, q+i)), 1.0f, 1e-5f) == 0);
+    }
+    taa_quat_from_mat44_array(B, N, p);
+    for(i = 0; i < N; ++i)
+    {
+        taa_quat r;
+        taa_quat_from_mat44(B + i, &r);
+        assert(cmp_vec4(p + i, &r, TEST_EPSILON) == 0);
+        assert(cmp_scalar(fabs(taa_vec4_dot(p+i, q+i)), 1.0f, 1e-5f) == 0);
+    }
+}
+
+static void test_quat_slerp()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS; ++i)
+    {
+        float t = randf();
+        taa_quat a;
+        taa_quat b;
+        taa_quat q;
+        taa_quat r;
+        taa_vec4 u;
+        taa_vec4 v;
+        taa_vec4 w;
+        rand_quat(&a);
+        rand_quat(&b);
+        rand_vec4(&u);
+        // end points rotate vectors the same as the inputs
+        taa_quat_slerp(&a, &b, 0.0f, &q);
+        taa_quat_transform_vec4(&a, &u, &v);
+        taa_quat_transform_vec4(&q, &u, &w);
+        assert(cmp_vec4(&v, &w, 1e-4f) == 0);
+        taa_quat_slerp(&a, &b, 1.0f, &q);
+        taa_quat_transform_vec4(&b, &u, &v);
+        taa_quat_transform_vec4(&q, &u, &w);
+        assert(cmp_vec4(&v, &w, 1e-4f) == 0);
+        // result is a unit quaternion on the shortest arc
+        taa_quat_slerp(&a, &b, t, &q);
+        assert(cmp_scalar(taa_vec4_length(&q), 1.0f, 1e-4f) == 0);
+        taa_quat_nlerp(&a, &b, t, &r);
+        assert(cmp_scalar(taa_vec4_length(&r), 1.0f, 1e-4f) == 0);
+        assert(taa_vec4_dot(&q, &r) > 0.9f);
+    }
+}
+
+static void test_quatx4_slerp()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS/4; ++i)
+    {
+        taa_quat a[4];
+        taa_quat b[4];
+        taa_quat q[4];
+        taa_quat r[4];
+        taa_quatx4 a4;
+        taa_quatx4 b4;
+        taa_quatx4 q4;
+        taa_vec4 t;
+        int j;
+        rand_vec4(&t);
+        for(j = 0; j < 4; ++j)
+        {
+            rand_quat(a + j);
+            rand_quat(b + j);
+        }
+        taa_quatx4_from_quat(a, 4, &a4);
+        taa_quatx4_from_quat(b, 4, &b4);
+        taa_quatx4_slerp(&a4, &b4, &t.x, &q4);
+        taa_quatx4_to_quat(&q4, 4, r);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_quat_slerp(a + j, b + j, (&t.x)[j], q + j);
+            assert(cmp_vec4(q + j, r + j, 1e-4f) == 0);
+        }
+        taa_quatx4_nlerp(&a4, &b4, &t.x, &q4);
+        taa_quatx4_to_quat(&q4, 4, r);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_quat_nlerp(a + j, b + j, (&t.x)[j], q + j);
+            assert(cmp_vec4(q + j, r + j, TEST_EPSILON) == 0);
+        }
+    }
+}
+
+static void test_vec3x4_from_vec3()
+{
+    enum { N = 11 };
+    taa_vec3 u[N];
+    taa_vec3 v[N];
+    taa_vec3x4 soa[(N + 3)/4];
+    void* buffer = NULL;
+    void* aligned = NULL;
+    taa_vec3* w;
+    int err;
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec3(u + i);
+    }
+    taa_vec3x4_from_vec3(u, N, soa);
+    for(i = 0; i < N; ++i)
+    {
+        assert(soa[i/4].x[i&3] == u[i].x);
+        assert(soa[i/4].y[i&3] == u[i].y);
+        assert(soa[i/4].z[i&3] == u[i].z);
+    }
+    assert(soa[N/4].x[3] == 0.0f);
+    taa_vec3x4_to_vec3(soa, N, v);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec3(u + i, v + i, 0.0f) == 0);
+    }
+    taa_vec3x4_from_vec3_stream(v, N, soa);
+    taa_vec3x4_to_vec3(soa, N, v);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec3(u + i, v + i, 0.0f) == 0);
+    }
+    // the streaming export needs 16 byte aligned output
+    err = taa_stream_realloc(&buffer, &aligned, 0, sizeof(v));
+    assert(err == 0);
+    w = (taa_vec3*) aligned;
+    taa_vec3x4_to_vec3_stream(soa, N, w);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec3(u + i, w + i, 0.0f) == 0);
+    }
+    free(buffer);
+}
+
+static void test_quatx4_from_quat()
+{
+    enum { N = 6 };
+    taa_quat p[N];
+    taa_quat q[N];
+    taa_quatx4 soa[(N + 3)/4];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec4(p + i);
+    }
+    taa_quatx4_from_quat(p, N, soa);
+    for(i = 0; i < N; ++i)
+    {
+        assert(soa[i/4].x[i&3] == p[i].x);
+        assert(soa[i/4].w[i&3] == p[i].w);
+    }
+    taa_quatx4_to_quat_stream(soa, N, q);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec4(p + i, q + i, 0.0f) == 0);
+    }
+}
+
+static void test_mat44x4_from_mat44()
+{
+    enum { N = 7 };
+    taa_mat44 A[N];
+    taa_mat44 B[N];
+    taa_mat44x4 soa[(N + 3)/4];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_mat44(A + i);
+    }
+    taa_mat44x4_from_mat44(A, N, soa);
+    for(i = 0; i < N; ++i)
+    {
+        assert(soa[i/4].x.x[i&3] == A[i].x.x);
+        assert(soa[i/4].y.z[i&3] == A[i].y.z);
+        assert(soa[i/4].w.w[i&3] == A[i].w.w);
+    }
+    taa_mat44x4_to_mat44(soa, N, B);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_mat44(A + i, B + i, 0.0f) == 0);
+    }
+    taa_mat44x4_from_mat44_stream(B, N, soa);
+    taa_mat44x4_to_mat44_stream(soa, N, B);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_mat44(A + i, B + i, 0.0f) == 0);
+    }
+}
+
+static void test_mat44x4_multiply()
+{
+    enum { N = 7 };
+    taa_mat44 A[N];
+    taa_mat44 B[N];
+    taa_mat44 C[N];
+    taa_mat44 R;
+    taa_mat44x4 a4;
+    taa_mat44x4 b4;
+    uint32_t ia[3] = { 6, 1, 4 };
+    uint32_t ib[3] = { 2, 5, 0 };
+    uint32_t ic[3] = { 3, 0, 6 };
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_mat44(A + i);
+        rand_mat44(B + i);
+        taa_mat44_identity(C + i);
+    }
+    taa_mat44x4_gather(A, ia, 3, &a4);
+    taa_mat44x4_gather(B, ib, 3, &b4);
+    // unused lanes repeat the last matrix
+    assert(a4.y.z[3] == A[4].y.z);
+    taa_mat44x4_multiply(&a4, &b4, &b4);
+    taa_mat44x4_scatter(&b4, ic, 3, C);
+    for(i = 0; i < 3; ++i)
+    {
+        taa_mat44_multiply(A + ia[i], B + ib[i], &R);
+        assert(cmp_mat44(C + ic[i], &R, 1e-5f) == 0);
+    }
+    // lanes past n are not written
+    taa_mat44_identity(&R);
+    assert(cmp_mat44(C + 1, &R, 0.0f) == 0);
+    assert(cmp_mat44(C + 2, &R, 0.0f) == 0);
+}
+
+static void test_mat33x4()
+{
+    int i;
+    for(i = 0; i < NUM_TEST_LOOPS/4; ++i)
+    {
+        taa_mat33 A[4];
+        taa_mat33 B[4];
+        taa_mat33 C[4];
+        taa_mat33 R[4];
+        taa_vec3 u[4];
+        taa_vec3 v[4];
+        taa_vec3 w[4];
+        taa_mat33x4 a4;
+        taa_mat33x4 b4;
+        taa_mat33x4 c4;
+        taa_vec3x4 u4;
+        taa_vec3x4 v4;
+        taa_vec4 d;
+        int j;
+        for(j = 0; j < 4; ++j)
+        {
+            // keep the matrices well conditioned by biasing the diagonal
+            rand_mat33(A + j);
+            rand_mat33(B + j);
+            A[j].x.x += 2.0f;
+            A[j].y.y += 2.0f;
+            A[j].z.z += 2.0f;
+            rand_vec3(u + j);
+        }
+        taa_mat33x4_from_mat33(A, 4, &a4);
+        taa_mat33x4_from_mat33(B, 4, &b4);
+        taa_vec3x4_from_vec3(u, 4, &u4);
+        taa_mat33x4_to_mat33(&a4, 4, R);
+        for(j = 0; j < 4; ++j)
+        {
+            assert(cmp_mat33(A + j, R + j, 0.0f) == 0);
+        }
+        // multiply
+        taa_mat33x4_multiply(&a4, &b4, &c4);
+        taa_mat33x4_to_mat33(&c4, 4, R);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_mat33_multiply(A + j, B + j, C + j);
+            assert(cmp_mat33(C + j, R + j, TEST_EPSILON) == 0);
+        }
+        // transpose
+        taa_mat33x4_transpose(&a4, &c4);
+        taa_mat33x4_to_mat33(&c4, 4, R);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_mat33_transpose(A + j, C + j);
+            assert(cmp_mat33(C + j, R + j, 0.0f) == 0);
+        }
+        taa_mat33x4_transpose(&c4, &c4);
+        taa_mat33x4_to_mat33(&c4, 4, R);
+        for(j = 0; j < 4; ++j)
+        {
+            assert(cmp_mat33(A + j, R + j, 0.0f) == 0);
+        }
+        // determinant
+        taa_mat33x4_determinant(&a4, &d.x);
+        for(j = 0; j < 4; ++j)
+        {
+            float dj = taa_mat33_determinant(A + j);
+            assert(fabs(dj - (&d.x)[j]) <= TEST_EPSILON*fabs(dj));
+        }
+        // inverse
+        taa_mat33x4_inverse(&a4, &c4);
+        taa_mat33x4_to_mat33(&c4, 4, R);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_mat33_inverse(A + j, C + j);
+            assert(cmp_mat33(C + j, R + j, TEST_EPSILON) == 0);
+        }
+        // transform
+        taa_mat33x4_transform_vec3x4(&a4, &u4, &v4);
+        taa_vec3x4_to_vec3(&v4, 4, v);
+        for(j = 0; j < 4; ++j)
+        {
+            taa_mat33_transform_vec3(A + j, u + j, w + j);
+            assert(cmp_vec3(v + j, w + j, TEST_EPSILON) == 0);
+        }
+    }
+    {
+        // partial conversion pads the unused lanes with zero
+        enum { N = 7 };
+        taa_mat33 A[N];
+        taa_mat33 B[N];
+        taa_mat33x4 soa[(N + 3)/4];
+        for(i = 0; i < N; ++i)
+        {
+            rand_mat33(A + i);
+        }
+        taa_mat33x4_from_mat33(A, N, soa);
+        taa_mat33x4_to_mat33(soa, N, B);
+        for(i = 0; i < N; ++i)
+        {
+            assert(soa[i/4].y.z[i&3] == A[i].y.z);
+            assert(cmp_mat33(A + i, B + i, 0.0f) == 0);
+        }
+        assert(soa[1].z.z[3] == 0.0f);
+    }
+}
+
+static void test_vec3_stream()
+{
+    enum { N = 37 };
+    taa_vec3_stream s;
+    taa_vec3 u[N];
+    taa_vec3 v[N];
+    taa_vec3 t;
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec3(u + i);
+    }
+    assert(taa_vec3_stream_create(0, &s) == 0);
+    assert(taa_vec3_stream_append(&s, u) == 0);
+    assert(taa_vec3_stream_append(&s, u + 1) == 0);
+    assert(taa_vec3_stream_import(&s, u + 2, N - 2) == 0);
+    assert(s.size == N);
+    assert(s.capacity >= N && (s.capacity % 16) == 0);
+    assert((((size_t) s.blocks) & 63) == 0);
+    assert(taa_vec3_stream_num_blocks(&s) == (N + 3)/4);
+    taa_vec3_stream_export(&s, v);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec3(u + i, v + i, 0.0f) == 0);
+    }
+    // remove the first element, the last should take its place
+    taa_vec3_stream_remove_swap(&s, 0);
+    assert(s.size == N - 1);
+    taa_vec3_stream_get(&s, 0, &t);
+    assert(cmp_vec3(&t, u + N - 1, 0.0f) == 0);
+    assert(s.blocks[(N - 1)/4].x[(N - 1)&3] == 0.0f);
+    taa_vec3_stream_clear(&s);
+    assert(s.size == 0);
+    assert(s.blocks[0].x[0] == 0.0f);
+    taa_vec3_stream_destroy(&s);
+}
+
+static void test_quat_stream()
+{
+    enum { N = 21 };
+    taa_quat_stream s;
+    taa_quat p[N];
+    taa_quat q[N];
+    int i;
+    for(i = 0; i < N; ++i)
+    {
+        rand_vec4(p + i);
+    }
+    assert(taa_quat_stream_create(4, &s) == 0);
+    assert(taa_quat_stream_import(&s, p, 3) == 0);
+    assert(taa_quat_stream_import(&s, p + 3, N - 4) == 0);
+    assert(taa_quat_stream_append(&s, p + N - 1) == 0);
+    assert((((size_t) s.blocks) & 63) == 0);
+    taa_quat_stream_export(&s, q);
+    for(i = 0; i < N; ++i)
+    {
+        assert(cmp_vec4(p + i, q + i, 0.0f) == 0);
+    }
+    taa_quat_stream_remove_swap(&s, N - 1);
+    assert(s.size == N - 1);
+    assert(s.blocks[(N - 1)/4].w[(N - 1)&3] == 0.0f);
+    taa_quat_stream_destroy(&s);
+}
+
+int main(int argc, char* argv[])
+{
+    printf("testing taa_vec3_normalize...");
+    fflush(stdout); 
+    test_vec3_normalize();
+    printf("pass\n");
+    printf("testing taa_vec3_array...");
+    fflush(stdout);
+    test_vec3_array();
+    printf("pass\n");
+    printf("testing taa_vec4_normalize...");
+    fflush(stdout); 
+    test_vec4_normalize();
+    printf("pass\n");    
+    printf("testing taa_mat33_inverse...");
+    fflush(stdout);     
+    test_mat33_inverse();
+    printf("pass\n");
+    printf("testing taa_mat33_orthonormalize...");
+    fflush(stdout);
+    test_mat33_orthonormalize();
+    printf("pass\n");
+    printf("testing taa_mat33_orthonormalize_array...");
+    fflush(stdout);
+    test_mat33_orthonormalize_array();
+    printf("pass\n");
+    printf("testing taa_mat33_polar_array...");
+    fflush(stdout);
+    test_mat33_polar_array();
+    printf("pass\n");
+    printf("testing taa_mat44_inverse...");
+    fflush(stdout);     
+    test_mat44_inverse();
+    printf("pass\n");
+    printf("testing taa_mat44_inverse_affine...");
+    fflush(stdout);
+    test_mat44_inverse_affine();
+    printf("pass\n");
+    printf("testing taa_mat44_inverse_rigid...");
+    fflush(stdout);
+    test_mat44_inverse_rigid();
+    printf("pass\n");
+    printf("testing taa_mat44_from_quat...");
+    fflush(stdout);     
+    test_mat44_from_quat();
+    printf("pass\n");
+    printf("testing taa_quat_from_mat44...");
+    fflush(stdout);     
+    test_quat_from_mat44();
+    printf("pass\n");
+    printf("testing taa_quat_mat_array...");
+    fflush(stdout);
+    test_quat_mat_array();
+    printf("pass\n");
+    printf("testing taa_mat44_trs...");
+    fflush(stdout);
+    test_mat44_trs();
+    printf("pass\n");
+    printf("testing taa_camera_build_array...");
+    fflush(stdout);
+    test_camera_build_array();
+    printf("pass\n");
+    printf("testing taa_dualquat...");
+    fflush(stdout);
+    test_dualquat();
+    printf("pass\n");
+    printf("testing taa_skin_lbs...");
+    fflush(stdout);
+    test_skin_lbs();
+    printf("pass\n");
+    printf("testing taa_hierarchy...");
+    fflush(stdout);
+    test_hierarchy();
+    printf("pass\n");
+    printf("testing taa_frustum...");
+    fflush(stdout);
+    test_frustum();
+    printf("pass\n");
+    printf("testing taa_aabb...");
+    fflush(stdout);
+    test_aabb();
+    printf("pass\n");
+    printf("testing taa_ray_intersect_aabb...");
+    fflush(stdout);
+    test_ray_aabb();
+    printf("pass\n");
+    printf("testing taa_ray_intersect_trianglex4...");
+    fflush(stdout);
+    test_ray_triangle();
+    printf("pass\n");
+    printf("testing taa_bvh...");
+    fflush(stdout);
+    test_bvh();
+    printf("pass\n");
+    printf("testing taa_sphere...");
+    fflush(stdout);
+    test_sphere();
+    printf("pass\n");
+    printf("testing taa_closest...");
+    fflush(stdout);
+    test_closest();
+    printf("pass\n");
+    printf("testing taa_mesh...");
+    fflush(stdout);
+    test_mesh();
+    printf("pass\n");
+    printf("testing taa_hashgrid...");
+    fflush(stdout);
+    test_hashgrid();
+    printf("pass\n");
+    printf("testing taa_quat_slerp...");
+    fflush(stdout);
+    test_quat_slerp();
+    printf("pass\n");
+    printf("testing taa_quatx4_slerp...");
+    fflush(stdout);
+    test_quatx4_slerp();
+    printf("pass\n");
+    printf("testing taa_vec3x4_from_vec3...");
+    fflush(stdout);
+    test_vec3x4_from_vec3();
+    printf("pass\n");
+    printf("testing taa_quatx4_from_quat...");
+    fflush(stdout);
+    test_quatx4_from_quat();
+    printf("pass\n");
+    printf("testing taa_mat44x4_from_mat44...");
+    fflush(stdout);
+    test_mat44x4_from_mat44();
+    printf("pass\n");
+    printf("testing taa_mat44x4_multiply...");
+    fflush(stdout);
+    test_mat44x4_multiply();
+    printf("pass\n");
+    printf("testing taa_mat33x4...");
+    fflush(stdout);
+    test_mat33x4();
+    printf("pass\n");
+    printf("testing taa_vec3_stream...");
+    fflush(stdout);
+    test_vec3_stream();
+    printf("pass\n");
+    printf("testing taa_quat_stream...");
+    fflush(stdout);
+    test_quat_stream();
+    printf("pass\n");
           
 #if defined(_DEBUG) && defined(_MSC_FULL_VER)
     _CrtSetReportMode(_CRT_ERROR, _CRTDBG_MODE_FILE);
@@ -1,10 +1,27 @@
 #ifndef TESTUTIL_H_
 #define TESTUTIL_H_
 
+#include <taa/aabb.h>
+#include <taa/bvh.h>
+#include <taa/camera.h>
+#include <taa/closest.h>
+#include <taa/dualquat.h>
+#include <taa/frustum.h>
+#include <taa/hashgrid.h>
+#include <taa/hierarchy.h>
 #include <taa/log.h>
 #include <taa/mat33.h>
+#include <taa/mat33x4.h>
 #include <taa/mat44.h>
+#include <taa/mat44x4.h>
+#include <taa/mesh.h>
 #include <taa/quat.h>
+#include <taa/quatx4.h>
+#include <taa/ray.h>
+#include <taa/skin.h>
+#include <taa/sphere.h>
+#include <taa/stream.h>
+#include <taa/vec3x4.h>
 #include <float.h>
 #include <stdlib.h>
 
@@ -54,6 +71,21 @@ static void rand_mat44(
     rand_vec4(&m_out->w);
 }
 
+//****************************************************************************
+static void rand_quat(
+    taa_quat* q_out)
+{
+    float rad = (randf() - 0.5f) * taa_PI * 4.0f;
+    taa_vec4 axis;
+    rand_vec4(&axis);
+    axis.x -= 0.5f;
+    axis.y -= 0.5f;
+    axis.z -= 0.5f;
+    axis.w = 0.0f;
+    taa_vec4_normalize(&axis, &axis);
+    taa_quat_axisangle(rad, &axis, q_out);
+}
+
 //****************************************************************************
 static int cmp_scalar(
     float a,
@@ -36,6 +36,105 @@ void test_mat33_transpose()
     assert(!cmp_mat44(pb, pc, TEST_EPSILON));
 }
 
+//****************************************************************************
+void test_load3()
+{
+    float a[5];
+    float b[5];
+    taa_vec4 c;
+    taa_vec4 d;
+    taa_fpu_vec4* fc = (taa_fpu_vec4*) &c;
+    taa_vpu_vec4* vd = (taa_vpu_vec4*) &d;
+    int i;
+    for(i = 0; i < 5; ++i)
+    {
+        a[i] = randf();
+        b[i] = -1.0f;
+    }
+    // fpu macros, offset by one float to test unaligned access
+    taa_fpu_load3(a + 1, *fc);
+    // vpu macros
+    taa_vpu_load3(a + 1, *vd);
+    assert(!cmp_vec4(&c, &d, TEST_EPSILON));
+    assert(d.x == a[1] && d.y == a[2] && d.z == a[3] && d.w == 0.0f);
+    // only three floats are written
+    taa_vpu_store3(*vd, b + 1);
+    assert(b[0] == -1.0f);
+    assert(b[1] == a[1] && b[2] == a[2] && b[3] == a[3]);
+    assert(b[4] == -1.0f);
+}
+
+//****************************************************************************
+void test_load3x4()
+{
+    float a[13];
+    float b[12];
+    taa_mat44 mc;
+    taa_mat44 md;
+    taa_mat44* pc = &mc;
+    taa_mat44* pd = &md;
+    taa_fpu_vec4* fc = (taa_fpu_vec4*) pc;
+    taa_vpu_vec4* vd = (taa_vpu_vec4*) pd;
+    int i;
+    for(i = 0; i < 13; ++i)
+    {
+        a[i] = randf();
+    }
+    rand_mat44(pc);
+    pd->w = pc->w;
+    // fpu macros, offset by one float to test unaligned access
+    taa_fpu_load3x4(a + 1, fc[0], fc[1], fc[2]);
+    // vpu macros
+    taa_vpu_load3x4(a + 1, vd[0], vd[1], vd[2]);
+    assert(!cmp_mat44(pc, pd, TEST_EPSILON));
+    for(i = 0; i < 4; ++i)
+    {
+        assert(!cmp_float((&pd->x.x)[i], a[1 + i*3], TEST_EPSILON));
+        assert(!cmp_float((&pd->y.x)[i], a[2 + i*3], TEST_EPSILON));
+        assert(!cmp_float((&pd->z.x)[i], a[3 + i*3], TEST_EPSILON));
+    }
+    // round trip
+    taa_vpu_store3x4(vd[0], vd[1], vd[2], b);
+    for(i = 0; i < 12; ++i)
+    {
+        assert(!cmp_float(b[i], a[1 + i], TEST_EPSILON));
+    }
+    // stream to the aligned storage of mc
+    taa_vpu_stream3x4(vd[0], vd[1], vd[2], &pc->x.x);
+    taa_vpu_stream_fence();
+    for(i = 0; i < 12; ++i)
+    {
+        assert(!cmp_float((&pc->x.x)[i], a[1 + i], TEST_EPSILON));
+    }
+}
+
+//****************************************************************************
+void test_load4x4()
+{
+    taa_mat44 ma;
+    taa_mat44 mb;
+    taa_mat44 mc;
+    taa_mat44 md;
+    taa_mat44* pa = &ma;
+    taa_mat44* pb = &mb;
+    taa_mat44* pc = &mc;
+    taa_mat44* pd = &md;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_vpu_vec4* vc = (taa_vpu_vec4*) pc;
+    rand_mat44(pa);
+    // fpu macros
+    taa_fpu_load4x4(&pa->x.x, fb[0], fb[1], fb[2], fb[3]);
+    // vpu macros
+    taa_vpu_load4x4(&pa->x.x, vc[0], vc[1], vc[2], vc[3]);
+    assert(!cmp_mat44(pb, pc, TEST_EPSILON));
+    // function api
+    taa_mat44_transpose(pa, pd);
+    assert(!cmp_mat44(pc, pd, TEST_EPSILON));
+    // round trip
+    taa_vpu_store4x4(vc[0], vc[1], vc[2], vc[3], &pd->x.x);
+    assert(!cmp_mat44(pa, pd, TEST_EPSILON));
+}
+
 //****************************************************************************
 void test_mat44_add()
 {
@@ -71,6 +170,85 @@ void test_mat44_add()
     assert(!cmp_mat44(pc, pd, TEST_EPSILON));
 }
 
+//****************************************************************************
+void test_mat44_inverse()
+{
+    taa_mat44 ma;
+    taa_mat44 mb;
+    taa_mat44 mc;
+    taa_mat44 md;
+    taa_mat44 mi;
+    taa_vec4 fdet;
+    taa_vec4 vdet;
+    taa_mat44* pa = &ma;
+    taa_mat44* pb = &mb;
+    taa_mat44* pc = &mc;
+    taa_mat44* pd = &md;
+    taa_fpu_vec4 fa[4];
+    taa_fpu_vec4 fb[4];
+    taa_fpu_vec4 fd;
+    taa_vpu_vec4 va[4];
+    taa_vpu_vec4 vc[4];
+    taa_vpu_vec4 vd;
+    int i;
+    taa_mat44_identity(&mi);
+    for(i = 0; i < 64; ++i)
+    {
+        // bias the diagonal to keep the matrix well conditioned
+        rand_mat44(pa);
+        pa->x.x += 2.0f;
+        pa->y.y += 2.0f;
+        pa->z.z += 2.0f;
+        pa->w.w += 2.0f;
+        taa_fpu_load(&pa->x.x, fa[0]);
+        taa_fpu_load(&pa->y.x, fa[1]);
+        taa_fpu_load(&pa->z.x, fa[2]);
+        taa_fpu_load(&pa->w.x, fa[3]);
+        taa_vpu_load(&pa->x.x, va[0]);
+        taa_vpu_load(&pa->y.x, va[1]);
+        taa_vpu_load(&pa->z.x, va[2]);
+        taa_vpu_load(&pa->w.x, va[3]);
+        // fpu macros
+        taa_fpu_mat44_inverse(
+            fa[0], fa[1], fa[2], fa[3],
+            fb[0], fb[1], fb[2], fb[3],
+            fd);
+        taa_fpu_store(fb[0], &pb->x.x);
+        taa_fpu_store(fb[1], &pb->y.x);
+        taa_fpu_store(fb[2], &pb->z.x);
+        taa_fpu_store(fb[3], &pb->w.x);
+        taa_fpu_store(fd, &fdet.x);
+        // vpu macros
+        taa_vpu_mat44_inverse(
+            va[0], va[1], va[2], va[3],
+            vc[0], vc[1], vc[2], vc[3],
+            vd);
+        taa_vpu_store(vc[0], &pc->x.x);
+        taa_vpu_store(vc[1], &pc->y.x);
+        taa_vpu_store(vc[2], &pc->z.x);
+        taa_vpu_store(vc[3], &pc->w.x);
+        taa_vpu_store(vd, &vdet.x);
+        assert(!cmp_mat44(pb, pc, TEST_EPSILON));
+        assert(!cmp_vec4(&fdet, &vdet, TEST_EPSILON*fabs(fdet.x)));
+        assert(fdet.x == fdet.y && fdet.x == fdet.z && fdet.x == fdet.w);
+        assert(vdet.x == vdet.y && vdet.x == vdet.z && vdet.x == vdet.w);
+        taa_fpu_mat44_determinant(fa[0], fa[1], fa[2], fa[3], fd);
+        taa_vpu_mat44_determinant(va[0], va[1], va[2], va[3], vd);
+        taa_fpu_store(fd, &fdet.x);
+        taa_vpu_store(vd, &vdet.x);
+        assert(!cmp_vec4(&fdet, &vdet, TEST_EPSILON*fabs(fdet.x)));
+        // function api
+        taa_mat44_inverse(pa, pd);
+        assert(!cmp_mat44(pc, pd, TEST_EPSILON));
+        assert(!cmp_float(
+            taa_mat44_determinant(pa),
+            vdet.x,
+            TEST_EPSILON*fabs(vdet.x)));
+        taa_mat44_multiply(pa, pd, pc);
+        assert(!cmp_mat44(pc, &mi, TEST_EPSILON));
+    }
+}
+
 //****************************************************************************
 void test_mat44_multiply()
 {
@@ -159,6 +337,104 @@ void test_mat44_transpose()
     assert(!cmp_mat44(pb, pc, TEST_EPSILON));
 }
 
+//****************************************************************************
+void test_quat_mul()
+{
+    taa_quat a;
+    taa_quat b;
+    taa_quat c;
+    taa_quat d;
+    taa_quat* pa = &a;
+    taa_quat* pb = &b;
+    taa_quat* pc = &c;
+    taa_quat* pd = &d;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_fpu_vec4* fc = (taa_fpu_vec4*) pc;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vb = (taa_vpu_vec4*) pb;
+    taa_vpu_vec4* vd = (taa_vpu_vec4*) pd;
+    taa_vec3 v;
+    rand_vec4(pa);
+    rand_vec4(pb);
+    // fpu macros
+    taa_fpu_quat_mul(*fa, *fb, *fc);
+    // vpu macros
+    taa_vpu_quat_mul(*va, *vb, *vd);
+    assert(!cmp_vec4(pc, pd, TEST_EPSILON));
+    // scalar reference
+    assert(!cmp_float(
+        c.x,
+        a.y*b.z - a.z*b.y + a.w*b.x + a.x*b.w,
+        TEST_EPSILON));
+    assert(!cmp_float(
+        c.y,
+        a.z*b.x - a.x*b.z + a.w*b.y + a.y*b.w,
+        TEST_EPSILON));
+    assert(!cmp_float(
+        c.z,
+        a.x*b.y - a.y*b.x + a.w*b.z + a.z*b.w,
+        TEST_EPSILON));
+    assert(!cmp_float(
+        c.w,
+        a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z,
+        TEST_EPSILON));
+    // function api
+    taa_quat_multiply(pa, pb, pd);
+    assert(!cmp_vec4(pc, pd, TEST_EPSILON));
+    taa_vec3_set(b.x, b.y, b.z, &v);
+    b.w = 0.0f;
+    taa_fpu_quat_mul(*fa, *fb, *fc);
+    taa_quat_multiply_vec3(pa, &v, pd);
+    assert(!cmp_vec4(pc, pd, TEST_EPSILON));
+    // in place
+    taa_vpu_quat_mul(*va, *vb, *va);
+    assert(!cmp_vec4(pc, pa, TEST_EPSILON));
+}
+
+//****************************************************************************
+void test_quat_rotate()
+{
+    taa_quat q;
+    taa_vec4 a;
+    taa_vec4 c;
+    taa_vec4 d;
+    taa_quat* pq = &q;
+    taa_vec4* pa = &a;
+    taa_vec4* pc = &c;
+    taa_vec4* pd = &d;
+    taa_fpu_vec4* fq = (taa_fpu_vec4*) pq;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fc = (taa_fpu_vec4*) pc;
+    taa_vpu_vec4* vq = (taa_vpu_vec4*) pq;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vd = (taa_vpu_vec4*) pd;
+    taa_vec3 u;
+    taa_vec3 v;
+    rand_vec4(pq);
+    taa_vec4_normalize(pq, pq);
+    rand_vec4(pa);
+    // fpu macros
+    taa_fpu_quat_rotate(*fq, *fa, *fc);
+    // vpu macros
+    taa_vpu_quat_rotate(*vq, *va, *vd);
+    assert(!cmp_vec4(pc, pd, TEST_EPSILON));
+    assert(c.w == a.w);
+    // rotation preserves length
+    assert(!cmp_float(
+        taa_vec4_dot(pc, pc),
+        taa_vec4_dot(pa, pa),
+        TEST_EPSILON));
+    // function api
+    taa_quat_transform_vec4(pq, pa, pd);
+    assert(!cmp_vec4(pc, pd, TEST_EPSILON));
+    taa_vec3_set(a.x, a.y, a.z, &u);
+    taa_quat_transform_vec3(pq, &u, &v);
+    assert(!cmp_float(c.x, v.x, TEST_EPSILON));
+    assert(!cmp_float(c.y, v.y, TEST_EPSILON));
+    assert(!cmp_float(c.z, v.z, TEST_EPSILON));
+}
+
 //****************************************************************************
 void test_vec4_abs()
 {
@@ -181,6 +457,42 @@ void test_vec4_abs()
     assert(!cmp_vec4(pb, pc, TEST_EPSILON));
 }
 
+//****************************************************************************
+void test_vec4_cmpagt()
+{
+    taa_vec4 a;
+    taa_vec4 b;
+    taa_vec4* pa = &a;
+    taa_vec4* pb = &b;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_fpu_vec4 fm;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vb = (taa_vpu_vec4*) pb;
+    taa_vpu_vec4 vm;
+    int e;
+    int fr;
+    int vr;
+    rand_vec4(pa);
+    rand_vec4(pb);
+    a.x = -a.x;
+    b.z = -b.z;
+    b.w = -a.w;
+    // expected
+    e  = (fabs(a.x) > fabs(b.x)) ? 1 : 0;
+    e |= (fabs(a.y) > fabs(b.y)) ? 2 : 0;
+    e |= (fabs(a.z) > fabs(b.z)) ? 4 : 0;
+    e |= (fabs(a.w) > fabs(b.w)) ? 8 : 0;
+    // fpu macros
+    taa_fpu_cmpagt(*fa, *fb, fm);
+    taa_fpu_movemask(fm, fr);
+    // vpu macros
+    taa_vpu_cmpagt(*va, *vb, vm);
+    taa_vpu_movemask(vm, vr);
+    assert(fr == e);
+    assert(vr == e);
+}
+
 //****************************************************************************
 void test_vec4_cross3()
 {
@@ -296,6 +608,103 @@ void test_vec4_normalize()
     assert(!cmp_vec4(pb, pc, TEST_EPSILON));
 }
 
+//****************************************************************************
+void test_vec4_select()
+{
+    taa_vec4 a;
+    taa_vec4 b;
+    taa_vec4 c;
+    taa_vec4 d;
+    taa_vec4 e;
+    taa_vec4* pa = &a;
+    taa_vec4* pb = &b;
+    taa_vec4* pc = &c;
+    taa_vec4* pd = &d;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_fpu_vec4* fc = (taa_fpu_vec4*) pc;
+    taa_fpu_vec4 fm;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vb = (taa_vpu_vec4*) pb;
+    taa_vpu_vec4* vd = (taa_vpu_vec4*) pd;
+    taa_vpu_vec4 vm;
+    rand_vec4(pa);
+    rand_vec4(pb);
+    // expected
+    e.x = (a.x > b.x) ? b.x : a.x;
+    e.y = (a.y > b.y) ? b.y : a.y;
+    e.z = (a.z > b.z) ? b.z : a.z;
+    e.w = (a.w > b.w) ? b.w : a.w;
+    // fpu macros
+    taa_fpu_cmpgt(*fa, *fb, fm);
+    taa_fpu_select(*fa, *fb, fm, *fc);
+    // vpu macros
+    taa_vpu_cmpgt(*va, *vb, vm);
+    taa_vpu_select(*va, *vb, vm, *vd);
+    assert(!cmp_vec4(&e, pc, 0.0f));
+    assert(!cmp_vec4(&e, pd, 0.0f));
+}
+
+//****************************************************************************
+void test_vec4_movemask()
+{
+    taa_vec4 a;
+    taa_vec4 b;
+    taa_vec4* pa = &a;
+    taa_vec4* pb = &b;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_fpu_vec4 fm;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vb = (taa_vpu_vec4*) pb;
+    taa_vpu_vec4 vm;
+    int e;
+    int fr;
+    int vr;
+    rand_vec4(pa);
+    rand_vec4(pb);
+    b.y = a.y;
+    // expected
+    e  = (a.x > b.x) ? 1 : 0;
+    e |= (a.y > b.y) ? 2 : 0;
+    e |= (a.z > b.z) ? 4 : 0;
+    e |= (a.w > b.w) ? 8 : 0;
+    // fpu macros
+    taa_fpu_cmpgt(*fa, *fb, fm);
+    taa_fpu_movemask(fm, fr);
+    // vpu macros
+    taa_vpu_cmpgt(*va, *vb, vm);
+    taa_vpu_movemask(vm, vr);
+    assert(fr == e);
+    assert(vr == e);
+    // sign bits of plain values
+    taa_vpu_set(-1.0f, 2.0f, -0.0f, 3.0f, vm);
+    taa_vpu_movemask(vm, vr);
+    assert(vr == 5);
+}
+
+//****************************************************************************
+void test_vec4_sqrt()
+{
+    taa_vec4 a;
+    taa_vec4 b;
+    taa_vec4 c;
+    taa_vec4* pa = &a;
+    taa_vec4* pb = &b;
+    taa_vec4* pc = &c;
+    taa_fpu_vec4* fa = (taa_fpu_vec4*) pa;
+    taa_fpu_vec4* fb = (taa_fpu_vec4*) pb;
+    taa_vpu_vec4* va = (taa_vpu_vec4*) pa;
+    taa_vpu_vec4* vc = (taa_vpu_vec4*) pc;
+    rand_vec4(pa);
+    pa->w = 0.0f;
+    // fpu macros
+    taa_fpu_sqrt(*fa, *fb);
+    // vpu macros
+    taa_vpu_sqrt(*va, *vc);
+    assert(!cmp_vec4(pb, pc, TEST_EPSILON));
+}
+
 //****************************************************************************
 void test_shuf_ax_ay_az_bx()
 {
@@ -373,10 +782,26 @@ int main(int argc, char* argv[])
     fflush(stdout);
     test_mat33_transpose();
     printf("pass\n");
+    printf("testing taa_vpu_load3...");
+    fflush(stdout);
+    test_load3();
+    printf("pass\n");
+    printf("testing taa_vpu_load3x4...");
+    fflush(stdout);
+    test_load3x4();
+    printf("pass\n");
+    printf("testing taa_vpu_load4x4...");
+    fflush(stdout);
+    test_load4x4();
+    printf("pass\n");
     printf("testing taa_mat44_add...");
     fflush(stdout);
     test_mat44_add();
     printf("pass\n");
+    printf("testing taa_mat44_inverse...");
+    fflush(stdout);
+    test_mat44_inverse();
+    printf("pass\n");
     printf("testing taa_mat44_multiply...");
     fflush(stdout);    
     test_mat44_multiply();
@@ -389,10 +814,22 @@ int main(int argc, char* argv[])
     fflush(stdout);          
     test_mat44_transpose();
     printf("pass\n");
+    printf("testing taa_quat_mul...");
+    fflush(stdout);
+    test_quat_mul();
+    printf("pass\n");
+    printf("testing taa_quat_rotate...");
+    fflush(stdout);
+    test_quat_rotate();
+    printf("pass\n");
     printf("testing taa_vec4_abs...");
     fflush(stdout);  
     test_vec4_abs();
     printf("pass\n");
+    printf("testing taa_vec4_cmpagt...");
+    fflush(stdout);
+    test_vec4_cmpagt();
+    printf("pass\n");
     printf("testing taa_vec4_cross3...");
     fflush(stdout);  
     test_vec4_cross3();
@@ -409,6 +846,18 @@ int main(int argc, char* argv[])
     fflush(stdout);  
     test_vec4_normalize();
     printf("pass\n");
+    printf("testing taa_vec4_select...");
+    fflush(stdout);
+    test_vec4_select();
+    printf("pass\n");
+    printf("testing taa_vec4_movemask...");
+    fflush(stdout);
+    test_vec4_movemask();
+    printf("pass\n");
+    printf("testing taa_vec4_sqrt...");
+    fflush(stdout);
+    test_vec4_sqrt();
+    printf("pass\n");
     printf("testing taa_shuf_ax_ay_az_bx...");
     fflush(stdout);  
     test_shuf_ax_ay_az_bx();